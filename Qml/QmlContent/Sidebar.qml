@@ -9,6 +9,8 @@ Rectangle {
     property string currentScreen: "chat"
     property var chatBackend: null
     property var sessions: []
+    property int sessionPageSize: 50
+    property bool hasMoreSessions: false
 
     signal navigateToChat()
     signal navigateToSettings()
@@ -24,7 +26,16 @@ Rectangle {
 
     function refreshSessions() {
         if (chatBackend) {
-            sessions = chatBackend.getSessions()
+            sessions = chatBackend.getSessions(0, sessionPageSize)
+            hasMoreSessions = sessions.length === sessionPageSize
+        }
+    }
+
+    function loadMoreSessions() {
+        if (chatBackend && hasMoreSessions) {
+            var page = chatBackend.getSessions(sessions.length, sessionPageSize)
+            hasMoreSessions = page.length === sessionPageSize
+            sessions = sessions.concat(page)
         }
     }
 
@@ -177,6 +188,13 @@ Rectangle {
             spacing: 4
             clip: true
 
+            // Fetch the next page when scrolled to the end
+            onAtYEndChanged: {
+                if (atYEnd && contentHeight > height) {
+                    root.loadMoreSessions()
+                }
+            }
+
             delegate: Rectangle {
                 width: sessionList.width
                 height: 48
@@ -27,6 +27,7 @@ enum class AgentEvent {
     Thinking,           // Agent is processing
     ToolSelected,       // Tool was selected
     ToolExecuting,      // Tool is executing
+    ToolOutput,         // Partial output from a running tool
     ToolCompleted,      // Tool completed
     ToolFailed,         // Tool failed
     ResponseReady,      // Response to user ready
@@ -44,6 +44,7 @@ struct SearchConfig {
     int max_results = 10;
     int timeout_ms = 30000;
     bool safe_search = true;
+    int cache_ttl_hours = 6;  // Reuse results for the same query; 0 disables
 };
 
 // Memory configuration
@@ -107,6 +108,12 @@ struct ToolConfig {
 struct ToolsConfig {
     std::map<std::string, ToolConfig> builtin;
     std::vector<Json> mcp_servers;
+    bool search_index = true;  // Per-project trigram index for grep
+    bool persistent_shell = true;  // One long-lived bash per session for the bash tool
+    bool warm_interpreters = true;  // Reusable Python/Node workers for code_execute
+    bool http_cache = true;  // On-disk cache for web_fetch and web_search responses
+    int http_cache_max_mb = 256;
+    bool http_cache_offline = false;  // Serve web tools from the cache only, never the network
 
     ToolsConfig() {
         // Default builtin tools
@@ -118,6 +125,7 @@ struct ToolsConfig {
         builtin["glob"] = {true, 0, false, 60000};
         builtin["web_search"] = {true, 0, false, 30000};
         builtin["web_fetch"] = {true, 0, false, 30000};
+        builtin["web_fetch_batch"] = {true, 0, false, 120000};
     }
 };
 
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+namespace gpagent::core {
+
+// Lowercase hex SHA-256 of the concatenated parts, which are hashed in
+// place rather than joined first
+std::string sha256_hex(std::initializer_list<std::string_view> parts);
+
+}  // namespace gpagent::core
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -102,17 +103,24 @@ struct ToolResult {
 
 // Image content for multimodal messages
 struct ImageContent {
-    std::string data;       // Base64 encoded image data
+    // Base64 encoded image data, immutable and shared by every copy of the
+    // message (history, context windows, requests)
+    std::shared_ptr<const std::string> data;
     std::string media_type; // e.g., "image/jpeg", "image/png"
     std::string source_path; // Original file path (for reference)
 
+    const std::string& base64() const {
+        static const std::string empty;
+        return data ? *data : empty;
+    }
+
     Json to_json() const {
         return Json{
             {"type", "image"},
             {"source", {
                 {"type", "base64"},
                 {"media_type", media_type},
-                {"data", data}
+                {"data", base64()}
             }}
         };
     }
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/core/types.hpp"
+
+#include "checkpointer.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+
+// Writes checkpoints on a background thread. The caller captures a job
+// (copies of the session state and history, and the thread as either a
+// full copy or the messages appended since its previous job) and goes on;
+// the writer hands it to the Checkpointer. Jobs run in order. submit()
+// blocks while max_pending jobs are waiting, so a slow disk holds the
+// caller back rather than piling up copies. The Checkpointer is not
+// thread-safe: callers flush() before using it directly. The destructor
+// flushes, so no submitted checkpoint is lost on shutdown.
+class CheckpointWriter {
+public:
+    struct Job {
+        SessionState session;
+        CompressedHistory history;
+        std::optional<ThreadMemory> full_thread;  // set: checkpoint this thread
+        ThreadDelta delta;                        // otherwise: extend the last one
+        std::string description;
+        std::string trigger;
+    };
+
+    explicit CheckpointWriter(Checkpointer& checkpointer, size_t max_pending = 2);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void submit(Job job);
+
+    // Wait for every submitted job; returns the first failure since the
+    // last flush
+    Result<void, Error> flush();
+
+    // A job failed, so the next delta may not extend what was written:
+    // the caller should send a full thread. Cleared when one succeeds.
+    bool needs_full_thread() const;
+
+private:
+    void run();
+
+    Checkpointer& checkpointer_;
+    size_t max_pending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;   // jobs queued or stopping
+    std::condition_variable space_cv_;  // queue shrank or went idle
+    std::deque<Job> queue_;
+    bool busy_ = false;                 // a job is being written
+    bool needs_full_ = false;
+    std::optional<Error> error_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+}  // namespace gpagent::memory
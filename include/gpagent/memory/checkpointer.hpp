@@ -4,8 +4,11 @@
 #include "gpagent/core/result.hpp"
 #include "session_state.hpp"
 #include "thread_memory.hpp"
+#include "chunk_store.hpp"
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <string>
 #include <vector>
@@ -42,7 +45,25 @@ struct Checkpoint {
     static Checkpoint from_json(const Json& j);
 };
 
-// Checkpointer - manages state checkpoints for branching/restoring
+// Messages appended to a thread since an earlier checkpoint of it: those
+// from index `base` on. Enough to checkpoint the thread when its earlier
+// messages were checkpointed last, without copying the whole thread.
+struct ThreadDelta {
+    ThreadId thread_id;
+    uint64_t revision = 0;  // ThreadMemory::revision() when captured
+    size_t base = 0;
+    std::vector<Message> messages;
+};
+
+// Checkpointer - manages state checkpoints for branching/restoring.
+// A checkpoint is its info.json plus a manifest of chunk hashes: one chunk
+// per message, one for the session state and one for the history, kept in
+// a shared ChunkStore. Messages already stored by an earlier checkpoint
+// are referenced rather than copied, and the hashes of the last thread
+// checkpointed are remembered, so a checkpoint costs only the messages
+// added since. remove() releases the checkpoint's chunks and deletes those
+// no other checkpoint uses. Checkpoints written before the chunk store
+// (full copies of the files) still restore and remove.
 class Checkpointer {
 public:
     explicit Checkpointer(const fs::path& storage_path);
@@ -66,6 +87,17 @@ public:
         const std::string& trigger
     );
 
+    // Create a checkpoint of the last thread checkpointed, given only what
+    // was appended to it since; fails with InvalidState if the delta does
+    // not start within that thread (another thread or a trim came between)
+    Result<CheckpointId, Error> create(
+        const SessionState& session,
+        const ThreadDelta& thread,
+        const CompressedHistory& history,
+        const std::string& description,
+        const std::string& trigger
+    );
+
     // Restore from checkpoint
     Result<Checkpoint, Error> restore(const CheckpointId& id) const;
 
@@ -87,11 +119,51 @@ public:
     // Check if checkpoint exists
     bool exists(const CheckpointId& id) const;
 
+    // Chunks currently stored, shared between checkpoints
+    size_t chunk_count() const { return chunks_.chunk_count(); }
+
 private:
     fs::path storage_path_;
+    ChunkStore chunks_;
+
+    // Message hashes of the last thread checkpointed: a later checkpoint of
+    // the same thread, with no trim in between, only hashes what was added
+    struct ThreadChunks {
+        ThreadId thread_id;
+        uint64_t revision = 0;
+        std::vector<std::string> hashes;
+    };
+    std::optional<ThreadChunks> last_thread_;
+
+    // Replace the cached hashes, moving their references over
+    void set_last_thread(ThreadChunks chunks);
+
+    // A thread as create() sees it: messages before `base` are unavailable
+    struct ThreadView {
+        ThreadId id;
+        uint64_t revision;
+        size_t base;
+        size_t size;
+        std::function<const Message&(size_t)> at;
+    };
+    Result<CheckpointId, Error> create(
+        const SessionState& session,
+        const ThreadView& thread,
+        const CompressedHistory& history,
+        const CheckpointId& parent_id,
+        const std::string& description,
+        const std::string& trigger
+    );
 
     fs::path checkpoint_path(const CheckpointId& id) const;
     fs::path info_path(const CheckpointId& id) const;
+    fs::path manifest_path(const CheckpointId& id) const;
+
+    // Every chunk hash a checkpoint's manifest references
+    std::optional<std::vector<std::string>> manifest_chunks(const CheckpointId& id) const;
+
+    // Take references for all manifests and drop unreferenced chunks
+    void rebuild_refs();
 
     Result<void, Error> load_index();
     Result<void, Error> save_index() const;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Content-addressed blob store used by the checkpointer. Each chunk is
+// stored once under its SHA-256 (objects/ab/cdef...), however many
+// checkpoints reference it. Reference counts live in memory: the owner
+// rebuilds them from its manifests on startup with retain(), then calls
+// sweep() to drop chunks no manifest references (left by a crash between
+// writing chunks and the manifest naming them). A release() that brings
+// a count to zero deletes the chunk.
+class ChunkStore {
+public:
+    explicit ChunkStore(const fs::path& dir);
+
+    // Store a chunk (if not already present) and take a reference to it
+    Result<std::string, Error> put(std::string_view data);
+
+    // Take or drop a reference to a chunk already stored
+    void retain(const std::string& hash);
+    // Returns true if the chunk was deleted
+    bool release(const std::string& hash);
+
+    std::optional<std::string> get(const std::string& hash) const;
+    bool contains(const std::string& hash) const;
+
+    // Delete chunks that nothing retains
+    size_t sweep();
+
+    size_t chunk_count() const { return refs_.size(); }
+
+    static std::string hash(std::string_view data);
+
+private:
+    fs::path dir_;
+    std::unordered_map<std::string, uint64_t> refs_;
+
+    fs::path chunk_path(const std::string& hash) const;
+};
+
+}  // namespace gpagent::memory
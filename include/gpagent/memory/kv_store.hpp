@@ -0,0 +1,112 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include "sqlite_db.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Namespaced key-value store in an SQLite database (WAL journal, one
+// connection with prepared statements). Lookups and prefix scans go through
+// the (namespace, key) index, and every write is its own transaction, so
+// nothing needs saving and a crash loses at most the write in flight.
+// Values are opaque text; the memory tools and CrossThreadMemory store JSON.
+// An FTS5 index over keys and values is updated by triggers with each write.
+class KvStore {
+public:
+    struct Item {
+        std::string key;
+        std::string value;
+        int64_t updated_at = 0;  // unix milliseconds
+    };
+
+    // Shared store for a database file, created if missing
+    static Result<std::shared_ptr<KvStore>, Error> open(const fs::path& path);
+
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    Result<void, Error> put(const std::string& ns, const std::string& key, const std::string& value);
+    Result<std::optional<std::string>, Error> get(const std::string& ns, const std::string& key);
+    // Whether the key existed
+    Result<bool, Error> remove(const std::string& ns, const std::string& key);
+
+    // Items of a namespace whose key starts with prefix, in key order
+    Result<std::vector<Item>, Error> scan(const std::string& ns, const std::string& prefix = "",
+                                          size_t limit = SIZE_MAX);
+    Result<std::vector<std::string>, Error> namespaces();
+
+    struct SearchHit {
+        std::string ns;
+        std::string key;
+        std::string snippet;  // matched terms in [brackets]
+        double score = 0;     // higher is better
+    };
+
+    // Full-text search over keys and values, best matches first, in one
+    // namespace or (empty ns) all of them
+    Result<std::vector<SearchHit>, Error> search(const std::string& query, const std::string& ns = "",
+                                                 size_t limit = 10);
+
+    // FTS5 query for free text, requiring all or any of its words
+    static std::string match_expression(const std::string& query, bool all_terms);
+
+    // Several writes in one transaction (e.g. imports); fn returns false or
+    // throws to roll back
+    template <typename Fn>
+    Result<void, Error> batch(Fn&& fn);
+
+    const fs::path& path() const { return path_; }
+
+private:
+    explicit KvStore(fs::path path);
+
+    Result<void, Error> open_db();
+
+    fs::path path_;
+    std::recursive_mutex mutex_;  // batch() calls back into the store
+    SqliteDb db_;
+    sqlite3_stmt* put_ = nullptr;
+    sqlite3_stmt* get_ = nullptr;
+    sqlite3_stmt* remove_ = nullptr;
+    sqlite3_stmt* scan_ = nullptr;
+    sqlite3_stmt* namespaces_ = nullptr;
+    sqlite3_stmt* search_ = nullptr;
+};
+
+// The memory database under a storage directory
+inline fs::path memory_db_path(const fs::path& storage_path) {
+    return storage_path / "memory.db";
+}
+
+template <typename Fn>
+Result<void, Error> KvStore::batch(Fn&& fn) {
+    std::lock_guard lock(mutex_);
+    if (auto begun = db_.exec("BEGIN IMMEDIATE"); begun.is_err()) return begun;
+    bool keep = false;
+    try {
+        keep = fn(*this);
+    } catch (...) {
+        // Otherwise the connection stays inside the transaction and no
+        // later write is ever committed
+        db_.exec("ROLLBACK");
+        throw;
+    }
+    if (!keep) return db_.exec("ROLLBACK");
+    auto committed = db_.exec("COMMIT");
+    if (committed.is_err()) db_.exec("ROLLBACK");
+    return committed;
+}
+
+}  // namespace gpagent::memory
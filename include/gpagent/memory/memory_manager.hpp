@@ -6,8 +6,13 @@
 
 #include "session_state.hpp"
 #include "thread_memory.hpp"
+#include "message_journal.hpp"
+#include "transcript.hpp"
 #include "episodic_memory.hpp"
 #include "checkpointer.hpp"
+#include "checkpoint_writer.hpp"
+#include "kv_store.hpp"
+#include "session_catalog.hpp"
 
 #include <filesystem>
 #include <memory>
@@ -19,7 +24,8 @@ namespace gpagent::memory {
 using namespace gpagent::core;
 namespace fs = std::filesystem;
 
-// Cross-thread memory - facts that persist across sessions
+// Cross-thread memory - facts that persist across sessions, kept in the
+// memory database shared with the memory tools
 class CrossThreadMemory {
 public:
     explicit CrossThreadMemory(const fs::path& storage_path);
@@ -36,13 +42,16 @@ public:
     // Delete a fact
     void remove(const std::string& ns, const std::string& key);
 
-    // Persistence
+    // Persistence: writes are committed as they happen, so save() only
+    // reports whether the database is usable; load() imports the JSON
+    // file used by earlier versions
     Result<void, Error> save() const;
     Result<void, Error> load();
 
 private:
     fs::path storage_path_;
-    std::map<std::string, std::map<std::string, Json>> data_;
+    std::shared_ptr<KvStore> store_;
+    std::optional<Error> open_error_;
 };
 
 // Main memory manager - coordinates all memory subsystems
@@ -63,8 +72,14 @@ public:
         TimePoint created_at;
         TimePoint updated_at;
         std::string preview;  // First message or description
+        size_t message_count = 0;
+        uint64_t tokens = 0;  // estimated
     };
     std::vector<SessionInfo> list_sessions() const;
+    // One page of sessions in the catalog's order (most recently updated
+    // first by default)
+    std::vector<SessionInfo> list_sessions(const SessionCatalog::Query& query) const;
+    size_t session_count() const;
 
     // Session state access
     SessionState& session_state();
@@ -118,9 +133,9 @@ public:
     EpisodicMemory& episodic_memory() { return *episodic_; }
     const EpisodicMemory& episodic_memory() const { return *episodic_; }
 
-    // Direct access to checkpointer
-    Checkpointer& checkpointer() { return *checkpointer_; }
-    const Checkpointer& checkpointer() const { return *checkpointer_; }
+    // Direct access to checkpointer, once queued auto checkpoints are written
+    Checkpointer& checkpointer();
+    const Checkpointer& checkpointer() const;
 
     // Get config
     const MemoryConfig& config() const { return config_; }
@@ -135,16 +150,62 @@ private:
     std::optional<ThreadMemory> thread_memory_;
     std::optional<CompressedHistory> compressed_history_;
 
+    // Write-ahead journal of the session's thread; null when it cannot be
+    // opened, and save_all then rewrites thread.jsonl as a whole
+    std::unique_ptr<MessageJournal> journal_;
+    uint64_t journaled_revision_ = 0;  // thread revision the journal extends
+    bool snapshot_needed_ = false;     // the journal missed a change
+
+    // Side-car metadata of the thread, updated as messages are appended and
+    // recomputed when the thread changed otherwise
+    TranscriptMeta transcript_meta_;
+    uint64_t meta_revision_ = 0;  // thread revision transcript_meta_ describes
+
     // Persistent components
     std::unique_ptr<CrossThreadMemory> cross_thread_;
     std::unique_ptr<EpisodicMemory> episodic_;
     std::unique_ptr<Checkpointer> checkpointer_;
+    // Null when the database cannot be opened: listing then scans the
+    // session directories
+    std::unique_ptr<SessionCatalog> catalog_;
+    // Writes auto checkpoints off the append path; declared after the
+    // checkpointer so that it flushes before the checkpointer goes away
+    std::unique_ptr<CheckpointWriter> checkpoint_writer_;
+
+    // The thread as last handed to the checkpointer, so that the next auto
+    // checkpoint only copies the messages appended since
+    struct CheckpointedThread {
+        ThreadId thread_id;
+        uint64_t revision = 0;
+        size_t size = 0;
+    };
+    std::optional<CheckpointedThread> checkpointed_thread_;
 
     // Paths
     fs::path session_path(const SessionId& id) const;
     fs::path user_memory_path() const;
     fs::path project_memory_path() const;
 
+    // Open the session's journal, returning the thread it recovered
+    std::optional<ThreadMemory> open_journal(const SessionId& id);
+    // Fold the journal into a snapshot of the current thread
+    Result<void, Error> compact_journal();
+
+    // Read every session directory (state.json and the side-car), for when
+    // the catalog is unavailable
+    std::vector<SessionInfo> scan_sessions() const;
+    SessionInfo scan_session(const fs::path& dir) const;
+    // Bring the catalog in line with the session directories on disk
+    void reconcile_catalog();
+    // Write the current session's entry to the catalog
+    void update_catalog();
+
+    // Recompute transcript_meta_ from the whole thread
+    void reset_transcript_meta();
+
+    // Queue an auto checkpoint of the current session
+    void submit_auto_checkpoint();
+
     // Helper to ensure directories exist
     void ensure_directories();
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/core/types.hpp"
+
+#include "thread_memory.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Write-ahead journal of a session's messages. The thread lives in a
+// snapshot (thread.bin, a Transcript; thread.jsonl in sessions from before
+// transcripts) plus a journal file (thread.wal) of the messages appended
+// since; each append is one length-prefixed, CRC-checked record written
+// straight through to the file, so a save costs only what was added. A
+// background thread fsyncs the journal at most once per commit interval,
+// batching the appends of a turn into one flush: a machine crash loses at
+// most that interval, a process crash nothing. snapshot() folds the journal
+// back into the snapshot once it grows large or after changes a journal of
+// appends cannot express (trims, restores). Recovery replays records up to
+// the first torn or corrupt one and cuts the journal there.
+class MessageJournal {
+public:
+    struct Options {
+        std::chrono::milliseconds commit_interval{500};
+        uint64_t snapshot_bytes = 16 * 1024 * 1024;  // journal size that asks for a snapshot
+    };
+
+    struct Recovery {
+        std::unique_ptr<MessageJournal> journal;
+        ThreadMemory thread;
+        size_t replayed = 0;            // journal records applied on top of the snapshot
+        uint64_t discarded_bytes = 0;   // torn or corrupt tail cut from the journal
+    };
+
+    // Open (creating if needed) the journal of a session directory and
+    // recover its thread
+    static Result<Recovery, Error> open(const fs::path& dir, const Options& options);
+    static Result<Recovery, Error> open(const fs::path& dir) { return open(dir, Options{}); }
+
+    // Read a session's thread without opening the journal for writing
+    static Result<ThreadMemory, Error> read(const fs::path& dir);
+
+    ~MessageJournal();
+
+    MessageJournal(const MessageJournal&) = delete;
+    MessageJournal& operator=(const MessageJournal&) = delete;
+
+    // Append one message; durable once the next commit flushes it
+    Result<void, Error> append(const Message& message);
+
+    // Flush everything appended so far now
+    Result<void, Error> sync();
+
+    // Replace the snapshot with this thread and empty the journal
+    Result<void, Error> snapshot(const ThreadMemory& thread);
+
+    // The journal has outgrown Options::snapshot_bytes
+    bool wants_snapshot() const;
+    uint64_t journal_bytes() const;
+
+    const fs::path& dir() const { return dir_; }
+
+    static constexpr const char* kSnapshotFile = "thread.bin";
+    static constexpr const char* kLegacySnapshotFile = "thread.jsonl";
+    static constexpr const char* kJournalFile = "thread.wal";
+
+private:
+    MessageJournal(fs::path dir, const Options& options, int fd, uint64_t journal_bytes);
+
+    void run();
+
+    fs::path dir_;
+    Options options_;
+
+    // Lock order: sync_mutex_, then mutex_. Flushes hold only sync_mutex_
+    // so appends are not blocked behind an fsync.
+    std::mutex sync_mutex_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    int fd_ = -1;
+    uint64_t journal_bytes_ = 0;
+    uint64_t appended_ = 0;  // records written
+    uint64_t synced_ = 0;    // records known to be on disk
+    std::optional<Error> sync_error_;
+    bool stopping_ = false;
+    std::thread flusher_;
+};
+
+}  // namespace gpagent::memory
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/core/types.hpp"
+
+#include "sqlite_db.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Catalog of sessions in an SQLite database (a SqliteDb, as KvStore): one
+// row per session with what the session list shows. MemoryManager updates
+// a session's row whenever it saves the session and adds or drops rows for
+// directories that changed without it on startup, so listing is an
+// indexed, paginated query that never opens a session directory.
+class SessionCatalog {
+public:
+    struct Entry {
+        SessionId id;
+        TimePoint created_at;
+        TimePoint updated_at;
+        std::string preview;
+        size_t message_count = 0;
+        uint64_t tokens = 0;
+    };
+
+    enum class SortKey {
+        UpdatedAt,
+        CreatedAt,
+        MessageCount
+    };
+
+    struct Query {
+        SortKey sort = SortKey::UpdatedAt;
+        bool descending = true;
+        size_t offset = 0;
+        size_t limit = SIZE_MAX;
+    };
+
+    static Result<std::unique_ptr<SessionCatalog>, Error> open(const fs::path& path);
+
+    SessionCatalog(const SessionCatalog&) = delete;
+    SessionCatalog& operator=(const SessionCatalog&) = delete;
+
+    // Insert or replace a session's entry
+    Result<void, Error> put(const Entry& entry);
+    // Several entries in one transaction (e.g. importing existing sessions)
+    Result<void, Error> put_all(const std::vector<Entry>& entries);
+    Result<bool, Error> remove(const SessionId& id);
+
+    Result<std::vector<Entry>, Error> list(const Query& query);
+    Result<std::vector<Entry>, Error> list() { return list(Query{}); }
+    Result<size_t, Error> count();
+
+    const fs::path& path() const { return path_; }
+
+private:
+    explicit SessionCatalog(fs::path path);
+
+    Result<void, Error> open_db();
+    Result<void, Error> put_locked(const Entry& entry);
+    Result<sqlite3_stmt*, Error> list_statement(const Query& query);
+
+    fs::path path_;
+    std::mutex mutex_;
+    SqliteDb db_;
+    sqlite3_stmt* put_ = nullptr;
+    sqlite3_stmt* remove_ = nullptr;
+    sqlite3_stmt* count_ = nullptr;
+    // One list statement per sort key and direction, prepared on first use
+    std::array<sqlite3_stmt*, 6> list_{};
+};
+
+// The session catalog under a storage directory
+inline fs::path session_catalog_path(const fs::path& storage_path) {
+    return storage_path / "sessions.db";
+}
+
+}  // namespace gpagent::memory
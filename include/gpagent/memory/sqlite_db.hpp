@@ -0,0 +1,78 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// One SQLite connection as the memory stores use it: WAL journal, schema
+// kept current by numbered migrations, and statements prepared once for
+// the connection's lifetime. Not thread-safe; owners serialize access.
+class SqliteDb {
+public:
+    SqliteDb() = default;
+    ~SqliteDb();
+
+    SqliteDb(const SqliteDb&) = delete;
+    SqliteDb& operator=(const SqliteDb&) = delete;
+
+    // Opens (creating) the database and applies the migrations it has not
+    // seen yet. migrations[i] upgrades the schema from version i to i + 1;
+    // the version is kept in PRAGMA user_version, so steps are only ever
+    // appended.
+    Result<void, Error> open(const fs::path& path, std::span<const char* const> migrations);
+
+    Result<void, Error> exec(const char* sql);
+    // Finalized when the connection closes
+    Result<sqlite3_stmt*, Error> prepare(const std::string& sql);
+    // Rows changed by the last statement
+    int changes() const;
+
+    // The connection's last error, prefixed with what failed
+    Error error(ErrorCode code, const std::string& what) const;
+
+    const fs::path& path() const { return path_; }
+
+private:
+    Result<void, Error> migrate(std::span<const char* const> migrations);
+
+    fs::path path_;
+    sqlite3* db_ = nullptr;
+    std::vector<sqlite3_stmt*> statements_;
+};
+
+// Resets and unbinds a prepared statement when the call using it returns
+class StatementScope {
+public:
+    explicit StatementScope(sqlite3_stmt* stmt) : stmt_(stmt) {}
+    ~StatementScope();
+
+    StatementScope(const StatementScope&) = delete;
+    StatementScope& operator=(const StatementScope&) = delete;
+
+    // Text is bound without a copy; it must outlive the scope
+    void bind(int index, const std::string& text);
+    void bind(int index, int64_t value);
+
+    std::string text(int column) const;
+    int64_t integer(int column) const;
+    double real(int column) const;
+
+    int step();
+
+private:
+    sqlite3_stmt* stmt_;
+};
+
+}  // namespace gpagent::memory
@@ -3,6 +3,7 @@
 #include "gpagent/core/types.hpp"
 #include "gpagent/core/result.hpp"
 
+#include <cstdint>
 #include <deque>
 #include <filesystem>
 #include <string>
@@ -40,6 +41,12 @@ public:
     // Clear old messages (keep last n)
     void trim(size_t keep_last);
 
+    // Changed by every change other than an append (trims), which a
+    // journal of appends cannot replay. Unique per thread instance as well
+    // (copies share it), so a thread rebuilt from a checkpoint or a file
+    // never passes for one that was only appended to.
+    uint64_t revision() const { return revision_; }
+
     // Serialization - JSONL format (one message per line)
     Result<void, Error> save(const fs::path& path) const;
     static Result<ThreadMemory, Error> load(const fs::path& path);
@@ -50,6 +57,7 @@ public:
 private:
     ThreadId thread_id_;
     std::deque<Message> messages_;
+    uint64_t revision_ = 0;
 };
 
 // Compressed history - summaries of older conversation turns
@@ -77,6 +85,8 @@ public:
     std::string get_combined() const;
 
     // Serialization
+    Json to_json() const;
+    static CompressedHistory from_json(const Json& j);
     Result<void, Error> save(const fs::path& path) const;
     static Result<CompressedHistory, Error> load(const fs::path& path);
 
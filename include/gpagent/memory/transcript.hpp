@@ -0,0 +1,78 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/core/types.hpp"
+#include "gpagent/tools/search_engine.hpp"
+
+#include "thread_memory.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace gpagent::memory {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Binary session transcript (thread.bin), the snapshot the message journal
+// extends. Layout, integers in native byte order:
+//
+//   magic | string arena | records | offset index | trailer
+//
+// Every string (content, names, tool call ids and arguments) lives in the
+// arena, short ones deduplicated; a record is a length-prefixed fixed part
+// referencing its strings by offset and length. The index holds each
+// record's offset and the trailer the section offsets, the record count
+// and a random id that the journal header names. Opening maps the file and
+// checks the trailer only; messages are decoded on request, without JSON
+// parsing except for tool call arguments.
+class Transcript {
+public:
+    static Result<Transcript, Error> open(const fs::path& path);
+
+    // Write a thread, returning the new transcript's id
+    static Result<uint64_t, Error> write(const fs::path& path, const ThreadMemory& thread);
+
+    size_t size() const { return count_; }
+    uint64_t id() const { return id_; }
+
+    Result<Message, Error> message(size_t index) const;
+
+    // Decode every message into a thread
+    Result<ThreadMemory, Error> read_all() const;
+
+private:
+    tools::MappedFile file_;
+    fs::path path_;
+    // Offsets rather than pointers, which a move of a small unmapped file
+    // would invalidate
+    uint64_t arena_offset_ = 0;
+    uint64_t arena_size_ = 0;
+    uint64_t index_offset_ = 0;
+    size_t count_ = 0;
+    uint64_t id_ = 0;
+};
+
+// Side-car metadata of a session's thread (thread.meta.json), kept current
+// on every save so that listing sessions never opens a transcript
+struct TranscriptMeta {
+    size_t message_count = 0;
+    std::string preview;       // start of the first user message
+    TimePoint first_message;   // meaningful when message_count > 0
+    TimePoint last_message;
+    uint64_t tokens = 0;       // rough estimate, ~3.5 characters per token
+
+    void add(const Message& message);
+    static TranscriptMeta of(const ThreadMemory& thread);
+
+    Json to_json() const;
+    static TranscriptMeta from_json(const Json& j);
+
+    Result<void, Error> save(const fs::path& path) const;
+    static Result<TranscriptMeta, Error> load(const fs::path& path);
+
+    static constexpr const char* kFile = "thread.meta.json";
+};
+
+}  // namespace gpagent::memory
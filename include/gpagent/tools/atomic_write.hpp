@@ -0,0 +1,22 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Replace a file's contents crash-safely: write a temp file in the same
+// directory, fsync it and rename it over the target. Symlinks are resolved
+// and the original permissions kept; a dangling symlink is an error rather
+// than a request to create its target. Files with several hard links are
+// rewritten in place instead, since a rename would detach the other links.
+Result<void, Error> write_file_atomic(const fs::path& path,
+                                      const std::vector<std::string_view>& chunks);
+
+}  // namespace gpagent::tools
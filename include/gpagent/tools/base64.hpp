@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace gpagent::tools {
+
+// Standard base64 (RFC 4648, padded). Encodes 12 input bytes per step with
+// SSSE3 when the CPU has it, otherwise 3 bytes per step through a 4096-entry
+// table of character pairs.
+std::string base64_encode(std::string_view data);
+
+constexpr size_t base64_encoded_size(size_t bytes) {
+    return (bytes + 2) / 3 * 4;
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "gpagent/tools/dir_watcher.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// Per-project log of filesystem changes, fed by one inotify watcher that a
+// background thread keeps drained. Every change gets a sequence number, so
+// each cache or index remembers where it last synced and asks for what
+// changed since, instead of rescanning the tree; several consumers share
+// one set of kernel watches. Consumers add watches for the directories
+// they track (typically from a FileWalker dir_filter). Only the most recent
+// changes are kept: a consumer that fell further behind, or any lost
+// events, get overflow and must rescan.
+class ChangeJournal {
+public:
+    struct Changes : DirWatcher::Changes {
+        uint64_t sequence = 0;  // position reached: pass to the next since()
+    };
+
+    using Listener = std::function<void(const Changes&)>;
+
+    // Shared journal for a project root, kept while any consumer holds it;
+    // nullptr where inotify is unavailable
+    static std::shared_ptr<ChangeJournal> for_project(const fs::path& root);
+
+    // Unshared journal (the registry uses this)
+    static std::unique_ptr<ChangeJournal> create(const fs::path& root,
+                                                 size_t max_records = kDefaultMaxRecords);
+    ~ChangeJournal();
+
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    // As DirWatcher::watch: false once out of watches. Thread-safe.
+    bool watch(std::string_view rel_dir) { return watcher_->watch(rel_dir); }
+    bool watching(std::string_view rel_dir) const { return watcher_->watching(rel_dir); }
+
+    // Current position; take it before a full scan so that changes made
+    // during the scan are reported by the next since()
+    uint64_t sequence();
+
+    // Paths changed after a position, deduplicated
+    Changes since(uint64_t sequence);
+
+    // Called with each batch of new changes, from the journal's thread or
+    // whichever caller drained them; a batch already being delivered can
+    // still arrive after unsubscribe. Returns an id for unsubscribe.
+    size_t subscribe(Listener listener);
+    void unsubscribe(size_t id);
+
+    const fs::path& root() const { return watcher_->root(); }
+
+    static constexpr size_t kDefaultMaxRecords = 65536;
+    static constexpr int kPollIntervalMs = 200;
+
+private:
+    struct Record {
+        uint64_t sequence;
+        std::string path;
+        bool dir;
+    };
+
+    ChangeJournal(std::unique_ptr<DirWatcher> watcher, size_t max_records);
+
+    // Move pending watcher events into the journal; returns them as a batch
+    Changes drain_locked();
+    void notify(const Changes& batch);
+    void run();
+
+    std::unique_ptr<DirWatcher> watcher_;
+    size_t max_records_;
+
+    std::mutex mutex_;
+    std::deque<Record> records_;
+    uint64_t last_sequence_ = 0;
+    uint64_t lost_through_ = 0;  // changes up to here are unknown (overflow or trimmed)
+
+    std::mutex listeners_mutex_;
+    std::map<size_t, Listener> listeners_;
+    size_t next_listener_ = 1;
+
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+}  // namespace gpagent::tools
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// Options for list_directory_tree
+struct DirListOptions {
+    bool recursive = false;
+    bool include_hidden = false;
+    int max_depth = 3;          // deepest level listed when recursive (root's children are 0)
+    size_t max_entries = 500;
+    size_t num_threads = 0;     // for stat fan-out; 0 = hardware concurrency (capped)
+};
+
+struct DirListEntry {
+    enum class Type { File, Directory, Symlink };
+
+    std::string rel_path;  // relative to the listed directory ('/' separated)
+    Type type = Type::File;
+    uint64_t size = 0;     // regular files only
+    int depth = 0;
+
+    std::string_view name() const {
+        size_t slash = rel_path.rfind('/');
+        return slash == std::string::npos ? std::string_view(rel_path)
+                                          : std::string_view(rel_path).substr(slash + 1);
+    }
+};
+
+struct DirListing {
+    std::vector<DirListEntry> entries;  // pre-order, each directory followed by its contents
+    bool truncated = false;             // max_entries was reached with more to list
+};
+
+// List a directory (optionally its subtree) for display. On Linux entries
+// come from getdents64 in large batches with their d_type, so only regular
+// files are stat'ed (for their size), and those stats run in parallel once
+// the listing is complete. Depth and entry caps stop the walk as soon as
+// they are hit. Symlinks are reported, never followed; other special files
+// are skipped.
+DirListing list_directory_tree(const fs::path& root, const DirListOptions& options = {});
+
+}  // namespace gpagent::tools
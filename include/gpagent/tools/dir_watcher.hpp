@@ -0,0 +1,66 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// Recursive inotify watch over a directory tree, drained by polling (there
+// is no background thread). Directories are added explicitly, typically
+// from a FileWalker dir_filter, so ignored trees need not be watched.
+class DirWatcher {
+public:
+    // nullptr where inotify is unavailable
+    static std::unique_ptr<DirWatcher> create(const fs::path& root,
+                                              size_t max_watches = kDefaultMaxWatches);
+    ~DirWatcher();
+
+    DirWatcher(const DirWatcher&) = delete;
+    DirWatcher& operator=(const DirWatcher&) = delete;
+
+    // Watch a directory ("" for the root, otherwise '/' separated and
+    // relative to it). Returns false once the watch limit is reached, after
+    // which the caller can no longer rely on events. Thread-safe.
+    bool watch(std::string_view rel_dir);
+    bool watching(std::string_view rel_dir) const;
+    size_t watch_count() const;
+
+    struct Changes {
+        std::vector<std::string> files;  // entries created, modified, deleted or moved
+        std::vector<std::string> dirs;   // directories created, deleted or moved
+        bool overflow = false;           // events were lost: rescan everything
+    };
+
+    // Drain pending events without blocking; paths are deduplicated
+    Changes poll();
+
+    // Block until events are pending or timeout_ms passes; true if pending
+    bool wait(int timeout_ms);
+
+    const fs::path& root() const { return root_; }
+
+    static constexpr size_t kDefaultMaxWatches = 16384;
+
+private:
+    DirWatcher(fs::path root, int fd, size_t max_watches);
+
+    fs::path root_;
+    int fd_ = -1;
+    size_t max_watches_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, std::string> paths_;  // watch descriptor -> rel dir
+    std::unordered_map<std::string, int> wds_;    // rel dir -> watch descriptor
+
+    // Stop watching a directory and everything below it
+    void forget(const std::string& rel_dir);
+};
+
+}  // namespace gpagent::tools
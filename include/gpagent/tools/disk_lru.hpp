@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// Size accounting and least-recently-used eviction for an on-disk cache
+// directory. Entries are the files or subdirectories directly under it,
+// by name. Access times are meant to be kept in an mtime (see stamp()) so
+// that the order survives restarts. Not synchronized: the owning cache
+// calls it under its own lock.
+class DiskLru {
+public:
+    DiskLru(fs::path dir, uint64_t max_bytes);
+
+    const fs::path& dir() const { return dir_; }
+    uint64_t max_bytes() const { return max_bytes_; }
+    uint64_t total_bytes() const { return total_bytes_; }
+
+    bool contains(const std::string& name) const { return entries_.contains(name); }
+
+    // Record an entry's size, replacing what was known about it
+    void set(const std::string& name, uint64_t bytes, int64_t last_used = now_ns());
+    // Account for bytes added to an entry, creating it if needed
+    void grow(const std::string& name, uint64_t bytes);
+    // Mark an entry as just used
+    void used(const std::string& name);
+    // Delete an entry from disk and forget it
+    void erase(const std::string& name);
+
+    // Once over the budget, delete least recently used entries other than
+    // keep until 90% of it is left, so a full cache does not evict on every
+    // store
+    void evict(const std::string& keep = "");
+
+    // Remove a temp file left behind by an interrupted write; true if path
+    // was one
+    static bool discard_temp(const fs::path& path);
+
+    // Record an access in the mtime of path, so it survives restarts
+    static void stamp(const fs::path& path);
+
+    // Access times, in nanoseconds so that entries used within the same
+    // second keep their order
+    static int64_t now_ns();
+    static int64_t to_unix_ns(fs::file_time_type time);
+
+private:
+    struct Entry {
+        uint64_t bytes = 0;
+        int64_t last_used = 0;
+    };
+
+    fs::path dir_;
+    uint64_t max_bytes_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t total_bytes_ = 0;
+};
+
+// One shared cache per directory; max_bytes of the first caller wins
+template <typename Cache>
+std::shared_ptr<Cache> shared_disk_cache(const fs::path& dir, uint64_t max_bytes) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::shared_ptr<Cache>> registry;
+
+    std::lock_guard lock(registry_mutex);
+    auto& cache = registry[dir.string()];
+    if (!cache) cache = std::make_shared<Cache>(dir, max_bytes);
+    return cache;
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "gpagent/tools/glob_matcher.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// Compiled rules from one .gitignore-style file
+class IgnoreRules {
+public:
+    enum class Verdict {
+        None,     // no rule matched
+        Ignore,   // excluded
+        Include   // re-included by a negated rule
+    };
+
+    // Parse gitignore syntax
+    static IgnoreRules parse(std::string_view content);
+
+    // Load and parse a file (nullopt if missing or unreadable)
+    static std::optional<IgnoreRules> load(const fs::path& path);
+
+    // Match a path relative to the ignore file's directory ('/' separated)
+    Verdict match(std::string_view rel_path, bool is_dir) const;
+
+    bool empty() const { return rules_.empty(); }
+
+private:
+    struct Rule {
+        GlobMatcher glob;
+        bool negated = false;
+        bool dir_only = false;
+        bool anchored = false;  // contains a slash: match the full relative path
+    };
+
+    std::vector<Rule> rules_;
+
+    static bool rule_matches(const Rule& rule, std::string_view rel_path,
+                             std::string_view basename, bool is_dir);
+};
+
+// Options for a directory walk
+struct WalkOptions {
+    bool respect_ignore_files = true;    // .gitignore, .ignore, .git/info/exclude
+    bool include_hidden = false;         // dotfiles and dot-directories
+    uint64_t max_file_size = 0;          // skip larger files (0 = no limit)
+    bool stat_files = false;             // fill size/mtime for every entry
+    size_t num_threads = 0;              // 0 = hardware concurrency (capped)
+    bool recursive = true;               // false: only files directly under the root
+
+    // Directory names that are never descended into
+    std::vector<std::string> skip_dirs = {".git", ".hg", ".svn", "node_modules"};
+
+    // Optional pruning hook: return false to skip a directory (relative path,
+    // no trailing slash). Called concurrently from worker threads.
+    std::function<bool(std::string_view)> dir_filter;
+};
+
+// A regular file found by the walker
+struct WalkEntry {
+    fs::path path;                // root / relative path
+    std::string_view rel_path;    // relative to the walk root ('/' separated)
+    uint64_t size = 0;            // valid if stat_files or max_file_size is set
+    int64_t mtime_ns = 0;         // valid if stat_files is set
+    size_t worker = 0;            // index of the worker thread (< num_threads())
+};
+
+// Parallel recursive directory walker shared by grep and glob.
+// Each worker owns a deque of directories and steals from the others when
+// idle. Ignore files are compiled once per directory and inherited by
+// subdirectories.
+class FileWalker {
+public:
+    explicit FileWalker(WalkOptions options = {});
+
+    // Called concurrently from worker threads; return false to stop the walk
+    using Visitor = std::function<bool(const WalkEntry&)>;
+
+    // Walk the tree under root (root itself is never filtered)
+    void walk(const fs::path& root, const Visitor& visit);
+
+    // Number of workers walk() will use
+    size_t num_threads() const { return num_threads_; }
+
+    // Request early termination (safe from inside a visitor)
+    void stop() { stopped_.store(true); }
+    bool stopped() const { return stopped_.load(); }
+
+private:
+    struct Impl;
+
+    WalkOptions options_;
+    size_t num_threads_;
+    std::atomic<bool> stopped_{false};
+};
+
+}  // namespace gpagent::tools
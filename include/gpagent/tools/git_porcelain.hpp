@@ -0,0 +1,157 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/tools/git_repository.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace gpagent::tools::git {
+
+// ============================================================================
+// Changes
+// ============================================================================
+
+enum class ChangeKind { Added, Modified, Deleted, Renamed, TypeChanged };
+
+struct FileChange {
+    ChangeKind kind = ChangeKind::Modified;
+    std::string path;
+    std::string old_path;          // renames only
+    uint32_t old_mode = 0;
+    uint32_t new_mode = 0;
+    ObjectId old_id{};
+    ObjectId new_id{};             // null for worktree content that wasn't hashed
+    bool submodule_dirty = false;  // gitlinks: tracked changes inside
+    bool submodule_untracked = false;
+};
+
+// A path with entries in merge stages 1-3; bit (stage - 1) set per stage
+struct Conflict {
+    std::string path;
+    uint8_t stages = 0;
+};
+
+struct Status {
+    std::string branch;                 // empty when detached
+    std::optional<ObjectId> head;       // nullopt before the first commit
+    std::string upstream;               // "origin/main", empty if not configured
+    bool upstream_gone = false;
+    bool merging = false;               // MERGE_HEAD exists
+    size_t ahead = 0;
+    size_t behind = 0;
+    std::vector<FileChange> staged;     // HEAD vs index
+    std::vector<FileChange> unstaged;   // index vs worktree
+    std::vector<Conflict> unmerged;
+    std::vector<std::string> untracked; // collapsed to "dir/" where possible
+};
+
+// ============================================================================
+// Worktree
+// ============================================================================
+
+// The parts of lstat() the index records. mode is a git mode (kModeFile,
+// kModeExecutable, kModeSymlink, kModeTree) or 0 for other file types.
+struct FileStat {
+    uint32_t mode = 0;
+    uint64_t size = 0;
+    int64_t mtime_s = 0, mtime_ns = 0;
+    int64_t ctime_s = 0, ctime_ns = 0;
+    uint64_t ino = 0;
+    uint32_t uid = 0, gid = 0;
+
+    bool operator==(const FileStat&) const = default;
+};
+
+std::optional<FileStat> stat_worktree(const fs::path& path);
+
+// True if an entry's stat data still vouches for its content (never for
+// racily clean entries, modified in the instant the index was written)
+bool stat_matches(const IndexEntry& entry, const FileStat& st, const Index& index);
+
+// Worktree content of a file or symlink as git would hash it
+struct WorktreeContent {
+    bool exists = false;
+    uint32_t mode = 0;
+    std::string data;
+};
+
+// Fails with NotImplemented when git could hash the content differently
+// (clean filters, CRLF conversion)
+Result<WorktreeContent, Error> read_worktree(const Repository& repo, const std::string& rel);
+
+// Blob id of an entry's worktree content, for callers that cache hashes
+using ContentHasher = std::function<Result<ObjectId, Error>(const IndexEntry&, const FileStat&)>;
+
+// Compare one stage-0 index entry with the worktree: nullopt when clean.
+// Entries whose stat data doesn't match are re-hashed (through `hash` if given).
+Result<std::optional<FileChange>, Error> compare_worktree_entry(Repository& repo, const Index& index,
+                                                                const IndexEntry& entry,
+                                                                const ContentHasher& hash = {});
+
+// Index paths, and every directory containing one. Views into the index.
+struct TrackedPaths {
+    explicit TrackedPaths(const Index& index);
+
+    std::unordered_set<std::string_view> files;
+    std::unordered_set<std::string_view> dirs;
+    std::unordered_set<std::string_view> gitlinks;
+};
+
+// An untracked file as status lists it: its outermost ancestor directory
+// without tracked files ("build/"), or the file itself
+std::string collapse_untracked(std::string_view path, const TrackedPaths& tracked);
+
+// ============================================================================
+// Status
+// ============================================================================
+
+// HEAD vs stage-0 index entries, with exact-content renames
+Result<std::vector<FileChange>, Error> staged_changes(Repository& repo, const Index& index);
+
+// Index vs worktree, with every entry compared by compare_worktree_entry
+Result<std::vector<FileChange>, Error> unstaged_changes(Repository& repo, const Index& index);
+
+// Untracked, non-ignored files, with wholly untracked directories collapsed
+std::vector<std::string> untracked_files(Repository& repo, const Index& index);
+
+// Paths with merge stages, from the index
+std::vector<Conflict> unmerged_paths(const Index& index);
+
+// Branch, HEAD, upstream tracking and merge state
+Result<void, Error> read_head_state(Repository& repo, Status& status);
+
+// Uncached status; see StatusEngine for repeated calls
+Result<Status, Error> read_status(Repository& repo, bool include_untracked = true);
+
+// `git status` long format, without the advice hints
+std::string format_status(const Status& status);
+
+// ============================================================================
+// Diff and log
+// ============================================================================
+
+enum class DiffTarget {
+    Worktree,  // index vs worktree (`git diff`)
+    Staged     // HEAD vs index (`git diff --staged`)
+};
+
+// Unified diff in git's format, limited to `path` (a file or directory,
+// relative to the work tree) when non-empty
+Result<std::string, Error> format_diff(Repository& repo, DiffTarget target, std::string_view path = {});
+
+// The last `max_count` commits reachable from HEAD, newest first by commit
+// date. oneline: "<hash> <subject>", otherwise "<hash> <date> | <subject> [<author>]"
+Result<std::string, Error> format_log(Repository& repo, size_t max_count, bool oneline);
+
+// Commits only on `a` and only on `b`
+Result<std::pair<size_t, size_t>, Error> ahead_behind(Repository& repo, const ObjectId& a,
+                                                      const ObjectId& b);
+
+}  // namespace gpagent::tools::git
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/tools/search_engine.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gpagent::tools::git {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Object ids and objects
+// ============================================================================
+
+using ObjectId = std::array<uint8_t, 20>;
+
+struct ObjectIdHash {
+    size_t operator()(const ObjectId& id) const;
+};
+
+std::string to_hex(const ObjectId& id);
+std::optional<ObjectId> from_hex(std::string_view hex);
+bool is_null(const ObjectId& id);
+
+enum class ObjectType : uint8_t { None = 0, Commit = 1, Tree = 2, Blob = 3, Tag = 4 };
+
+// SHA-1 of "<type> <size>\0<data>", i.e. what `git hash-object` prints
+ObjectId hash_object(ObjectType type, std::string_view data);
+
+struct Object {
+    ObjectType type = ObjectType::None;
+    std::string data;
+};
+
+// File modes as stored in trees and the index
+constexpr uint32_t kModeTree = 0040000;
+constexpr uint32_t kModeFile = 0100644;
+constexpr uint32_t kModeExecutable = 0100755;
+constexpr uint32_t kModeSymlink = 0120000;
+constexpr uint32_t kModeGitlink = 0160000;
+
+struct TreeEntry {
+    uint32_t mode = 0;
+    std::string name;
+    ObjectId id{};
+};
+
+struct Signature {
+    std::string name;
+    std::string email;
+    int64_t time = 0;
+    int tz_minutes = 0;  // offset east of UTC
+};
+
+struct Commit {
+    ObjectId tree{};
+    std::vector<ObjectId> parents;
+    Signature author;
+    Signature committer;
+    std::string message;
+
+    // First paragraph joined into one line, like %s
+    std::string subject() const;
+};
+
+// All blobs (and gitlinks) of a tree, recursively, sorted by path
+struct FlatEntry {
+    std::string path;
+    uint32_t mode = 0;
+    ObjectId id{};
+};
+using FlatTree = std::vector<FlatEntry>;
+
+const FlatEntry* find_entry(const FlatTree& tree, std::string_view path);
+
+// ============================================================================
+// Index (.git/index, versions 2-4)
+// ============================================================================
+
+struct IndexEntry {
+    std::string path;
+    ObjectId id{};
+    uint32_t mode = 0;
+    uint32_t ctime_s = 0, ctime_ns = 0;
+    uint32_t mtime_s = 0, mtime_ns = 0;
+    uint32_t dev = 0, ino = 0, uid = 0, gid = 0;
+    uint32_t size = 0;
+    uint8_t stage = 0;  // 0 normally, 1-3 for merge conflicts
+    bool assume_valid = false;
+    bool skip_worktree = false;
+    bool intent_to_add = false;
+};
+
+struct Index {
+    std::vector<IndexEntry> entries;  // sorted by path, then stage
+    int64_t mtime_s = 0;              // of the index file, for racy-clean checks
+    int64_t mtime_ns = 0;
+};
+
+// ============================================================================
+// Packfiles
+// ============================================================================
+
+// A pack and its v2 .idx, both memory-mapped
+class PackFile {
+public:
+    bool open(const fs::path& idx_path);
+
+    // Offset of an object in the pack, if present
+    std::optional<uint64_t> find(const ObjectId& id) const;
+
+    std::string_view pack_data() const { return pack_.data(); }
+    const fs::path& path() const { return pack_path_; }
+
+private:
+    MappedFile idx_;
+    MappedFile pack_;
+    fs::path pack_path_;
+    uint32_t count_ = 0;
+    const uint8_t* fanout_ = nullptr;
+    const uint8_t* ids_ = nullptr;
+    const uint8_t* offsets32_ = nullptr;
+    const uint8_t* offsets64_ = nullptr;
+    size_t offsets64_count_ = 0;
+};
+
+// ============================================================================
+// Repository
+// ============================================================================
+
+// Read-only, in-process access to a repository's objects, refs and index.
+// Anything it doesn't understand (SHA-256 repos, reftable, split or sparse
+// indexes) is reported as an error so callers can fall back to the git CLI.
+class Repository {
+public:
+    // Open the repository whose work tree root is `work_tree`
+    static Result<std::shared_ptr<Repository>, Error> open(const fs::path& work_tree);
+
+    // Shared instance per work tree, keeping packs mapped and trees cached
+    static Result<std::shared_ptr<Repository>, Error> for_work_tree(const fs::path& work_tree);
+
+    const fs::path& work_tree() const { return work_tree_; }
+    const fs::path& git_dir() const { return git_dir_; }
+
+    // True when git might hash this worktree content differently from its
+    // raw bytes: clean filters (e.g. LFS) anywhere, or CRLF conversion of
+    // content that contains CRs
+    bool content_ambiguous(std::string_view content) const {
+        return clean_filters_ || (eol_conversion_ && content.find('\r') != std::string_view::npos);
+    }
+
+    Result<Object, Error> read_object(const ObjectId& id);
+    Result<Commit, Error> read_commit(const ObjectId& id);
+    Result<std::vector<TreeEntry>, Error> read_tree(const ObjectId& id);
+
+    // Flattened tree of a commit, cached by commit id
+    Result<std::shared_ptr<const FlatTree>, Error> commit_tree(const ObjectId& commit);
+
+    // Resolve a ref name ("HEAD", "refs/heads/main") to an object id.
+    // Ok(nullopt) for an unborn branch.
+    Result<std::optional<ObjectId>, Error> resolve_ref(const std::string& name);
+
+    // Branch HEAD points at ("main"), or empty when detached
+    std::string head_branch();
+
+    // Remote-tracking ref configured as a branch's upstream
+    // ("refs/remotes/origin/main"), if any
+    std::optional<std::string> upstream_ref(const std::string& branch) const;
+
+    Result<Index, Error> read_index();
+
+    static constexpr size_t kTreeCacheSize = 8;
+    static constexpr size_t kDeltaCacheBytes = 32 * 1024 * 1024;
+
+private:
+    fs::path work_tree_;
+    fs::path git_dir_;      // per-worktree dir (HEAD, index)
+    fs::path common_dir_;   // shared dir (objects, refs) for linked worktrees
+    std::vector<fs::path> object_dirs_;  // objects/ plus alternates
+    bool clean_filters_ = false;
+    bool eol_conversion_ = false;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<PackFile>> packs_;
+    std::vector<fs::path> known_packs_;
+
+    // Inflated delta bases keyed by (pack, offset)
+    struct DeltaKey {
+        const PackFile* pack;
+        uint64_t offset;
+        bool operator==(const DeltaKey&) const = default;
+    };
+    struct DeltaKeyHash {
+        size_t operator()(const DeltaKey& key) const;
+    };
+    std::unordered_map<DeltaKey, std::shared_ptr<const Object>, DeltaKeyHash> delta_cache_;
+    size_t delta_cache_bytes_ = 0;
+
+    // Most recently used first
+    std::list<std::pair<ObjectId, std::shared_ptr<const FlatTree>>> tree_cache_;
+
+    Result<void, Error> check_format();
+    void scan_packs();
+    Result<Object, Error> read_loose(const ObjectId& id, bool& found);
+    Result<Object, Error> read_packed(PackFile& pack, uint64_t offset);
+    void cache_delta_base(const DeltaKey& key, std::shared_ptr<const Object> base);
+    Result<Object, Error> read_object_locked(const ObjectId& id);
+    Result<void, Error> flatten(const ObjectId& tree, const std::string& prefix, FlatTree& out);
+    std::optional<std::string> read_ref_file(const std::string& name) const;
+};
+
+}  // namespace gpagent::tools::git
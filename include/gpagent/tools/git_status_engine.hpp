@@ -0,0 +1,87 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/tools/change_journal.hpp"
+#include "gpagent/tools/git_porcelain.hpp"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gpagent::tools::git {
+
+// Keeps a work tree's status warm between calls: the parsed index, content
+// hashes verified against stat data, and the set of non-ignored worktree
+// files. With the project's change journal (inotify), a call re-checks only
+// the paths that changed since the previous one, plus the entries an index
+// rewrite added or changed (blob, mode or flags). Without it (or after an
+// event overflow) every entry is lstat'ed across threads and only files
+// whose stat data changed are re-hashed.
+class StatusEngine {
+public:
+    explicit StatusEngine(std::shared_ptr<Repository> repo);
+
+    // Shared engine per work tree (least recently used ones are dropped)
+    static Result<std::shared_ptr<StatusEngine>, Error> for_work_tree(const fs::path& work_tree);
+
+    Result<Status, Error> status();
+
+    Repository& repository() { return *repo_; }
+
+    // Worktree files read and hashed so far; reused hashes are not counted
+    size_t hashed_files() const { return hashed_files_; }
+
+    static constexpr size_t kMaxEngines = 8;
+
+private:
+    // A content hash and the stat data it was taken under
+    struct Verified {
+        FileStat stat;
+        ObjectId id{};
+        int64_t hashed_s = 0;   // coarse clock when hashing started
+        int64_t hashed_ns = 0;
+    };
+
+    std::shared_ptr<Repository> repo_;
+    std::mutex mutex_;
+
+    std::shared_ptr<ChangeJournal> journal_;
+    uint64_t journal_sequence_ = 0;
+    bool journal_failed_ = false;
+
+    std::optional<FileStat> index_stat_;
+    std::optional<FileStat> exclude_stat_;
+    std::unique_ptr<Index> index_;
+    std::unique_ptr<TrackedPaths> tracked_;
+    std::unordered_map<std::string_view, size_t> entry_pos_;
+    std::vector<size_t> unwatched_;  // entries whose directory has no watch
+
+    std::unordered_map<std::string, Verified> verified_;
+    std::atomic<size_t> hashed_files_{0};
+    std::map<std::string, FileChange> unstaged_;
+    std::set<std::string> files_;  // non-ignored worktree files, tracked or not
+    bool files_valid_ = false;
+
+    uint64_t index_fingerprint_ = 0;
+    bool staged_valid_ = false;
+    std::optional<ObjectId> staged_head_;
+    std::vector<FileChange> staged_;
+
+    Result<void, Error> refresh();
+    // Collects positions of entries that need rechecking after a reload
+    Result<void, Error> load_index(std::vector<size_t>& changed);
+    // Both return false when the journal ran out of inotify watches
+    bool scan_files(const std::string& dir, const std::set<std::string>& subdirs, bool recursive);
+    bool refresh_files(const DirWatcher::Changes& changes);
+    Result<void, Error> check_entries(const std::vector<size_t>& positions);
+    void find_unwatched();
+    void invalidate();
+};
+
+}  // namespace gpagent::tools::git
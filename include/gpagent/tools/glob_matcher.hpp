@@ -0,0 +1,80 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+
+// Glob pattern compiled into a segment automaton.
+// Supports '*' and '?' (within one path segment), '**' (any number of
+// segments), '[...]' classes and '{a,b}' alternatives. Paths are relative and
+// '/' separated. Matching walks the path one segment at a time, so a
+// directory whose prefix already fails can be pruned without descending.
+class GlobMatcher {
+public:
+    // Compile a pattern (fails on empty patterns or too many brace alternatives)
+    static Result<GlobMatcher, Error> compile(std::string_view pattern);
+
+    // Test a relative file path
+    bool matches(std::string_view rel_path) const;
+
+    // False if nothing under rel_dir can match (the walker may skip it)
+    bool could_match_within(std::string_view rel_dir) const;
+
+    // Leading directories shared by every alternative ("src/include/" or "")
+    const std::string& literal_prefix() const { return literal_prefix_; }
+
+    // True if the pattern has a '/' (match full paths rather than file names)
+    bool has_separator() const { return has_separator_; }
+
+    const std::string& source() const { return source_; }
+
+    // Maximum number of alternatives after brace expansion
+    static constexpr size_t kMaxAlternatives = 1024;
+
+private:
+    struct Segment {
+        enum class Kind : uint8_t {
+            Literal,     // exact text
+            Suffix,      // "*text"
+            Prefix,      // "text*"
+            Star,        // "*"
+            DoubleStar,  // "**"
+            Wild         // anything else with wildcards
+        };
+
+        Kind kind = Kind::Literal;
+        std::string text;
+    };
+
+    std::string source_;
+    std::string literal_prefix_;
+    bool has_separator_ = false;
+    bool linear_ = false;  // one alternative without '**'
+
+    // All alternatives flattened: segments_[offsets_[a] .. offsets_[a + 1])
+    // belong to alternative a. Automaton states are indices into segments_
+    // plus one accepting state per alternative.
+    std::vector<Segment> segments_;
+    std::vector<uint32_t> offsets_;
+
+    using StateSet = std::vector<uint32_t>;
+
+    StateSet initial_states() const;
+    void add_state(StateSet& states, uint32_t alt, uint32_t state) const;
+    StateSet step(const StateSet& states, std::string_view component) const;
+    bool is_accepting(uint32_t alt, uint32_t state) const;
+
+    static bool match_segment(const Segment& segment, std::string_view component);
+};
+
+// Match one path segment against a wildcard pattern ('*', '?', '[...]', '\')
+bool wildcard_match(std::string_view pattern, std::string_view text);
+
+}  // namespace gpagent::tools
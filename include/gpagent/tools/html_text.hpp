@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+// Converts HTML to compact, markdown-flavoured text in a single pass over
+// input that may arrive in arbitrary chunks (e.g. straight from the HTTP
+// body). Headings, list items, code blocks, quotes and table rows keep their
+// structure; scripts, styles, hidden and non-text elements are dropped and
+// character references are decoded. The tokenizer keeps its state in fixed
+// buffers, so the only growing allocations are the extracted text and one
+// small record per element.
+//
+// With main_content, text blocks are scored readability-style (length,
+// commas, link density, class/id hints) into their enclosing elements and
+// only the best subtree and its strong siblings are returned, leaving out
+// navigation, sidebars and footers.
+class HtmlTextExtractor {
+public:
+    explicit HtmlTextExtractor(bool main_content = true);
+
+    void feed(std::string_view chunk);
+
+    // Flush pending input and render the text (the <title> as a heading,
+    // then the selected blocks). Call once, after the last feed().
+    std::string finish();
+
+    const std::string& title() const { return title_; }
+
+private:
+    enum class State : uint8_t {
+        Text, Entity, TagOpen, TagName, EndTagName, EndTagRest, BeforeAttr, AttrName,
+        AfterAttrName, BeforeValue, ValueQuoted, ValueUnquoted, MarkupDecl, Comment, Bogus, RawText
+    };
+
+    enum class Kind : uint8_t {
+        Inline, Void, Break, Rule, Container, Paragraph, Heading, List, ListItem, Pre, Code,
+        Quote, Row, Cell, Anchor, Skip, Raw
+    };
+
+    enum class BlockKind : uint8_t { Paragraph, Heading, Item, Pre, Row, Rule };
+
+    static constexpr size_t kMaxName = 16;
+
+    struct Element {
+        char name[kMaxName];
+        uint8_t name_len;
+        Kind kind;
+        bool skip;          // inside a dropped subtree
+        bool ordered;       // lists: <ol>
+        uint32_t counter;   // lists: items so far; items: their ordinal
+        uint32_t node;      // innermost scoring node
+    };
+
+    // A block-level element, for scoring
+    struct Node {
+        uint32_t parent;
+        Kind kind;
+        bool unlikely;      // navigation, sidebars and the like
+        int weight;         // tag and class/id bias
+        double score = 0;
+        bool scored = false;
+        uint32_t chars = 0;       // text in the subtree
+        uint32_t link_chars = 0;  // ...of it inside links
+    };
+
+    struct Block {
+        BlockKind kind;
+        uint8_t level;        // heading level, list depth
+        uint8_t quote_depth;
+        uint32_t ordinal;     // ordered list items; 0 for bullets
+        uint32_t node;
+        uint32_t start, size; // in text_
+        uint32_t chars, link_chars, commas;
+        std::string lang;     // code blocks
+    };
+
+    bool main_content_;
+    State state_ = State::Text;
+
+    // Current tag
+    char tag_[kMaxName];
+    size_t tag_len_ = 0;
+    bool self_closing_ = false;
+    char attr_[kMaxName];
+    size_t attr_len_ = 0;
+    char quote_ = 0;
+    std::string attr_value_;  // value of a recognised attribute
+    std::string hints_;       // class, id and role of the current tag
+    std::string code_lang_;
+    bool hidden_ = false;
+
+    // Entities, comments and raw text
+    char entity_[32];
+    size_t entity_len_ = 0;
+    int dashes_ = 0;
+    char raw_name_[kMaxName];
+    size_t raw_len_ = 0;
+    size_t raw_match_ = 0;
+    bool raw_title_ = false;
+
+    std::vector<Element> stack_;
+    std::vector<Node> nodes_;
+    std::vector<Block> blocks_;
+    std::string text_;        // text of all blocks, back to back
+    std::string title_;
+
+    // Block being built
+    size_t block_start_ = 0;
+    uint32_t block_chars_ = 0;
+    uint32_t block_link_chars_ = 0;
+    uint32_t block_commas_ = 0;
+    bool pending_space_ = false;
+    bool pre_start_ = false;  // drop a newline right after <pre>
+    int pre_depth_ = 0;
+    int link_depth_ = 0;
+    int cells_in_row_ = 0;
+
+    static Kind classify(std::string_view name);
+
+    void step(char c);
+    void put_text(char c);
+    void put_str(std::string_view s);
+    void end_entity(bool terminated);
+    void end_attr_value();
+    void emit_start_tag();
+    void emit_end_tag(std::string_view name);
+    void open_element(std::string_view name, Kind kind);
+    void close_element(size_t index);
+    void end_block();
+    bool skipping() const;
+    // Which blocks to render (scores nodes_ on the way)
+    std::vector<bool> select_blocks();
+};
+
+// One-shot conversion of a complete document
+std::string html_to_text(std::string_view html, bool main_content = true);
+
+}  // namespace gpagent::tools
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "gpagent/tools/disk_lru.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// On-disk cache of HTTP responses for the web tools, one file per entry
+// (a JSON metadata line followed by the body). Freshness follows the
+// response's Cache-Control, Expires and Last-Modified headers; stale entries
+// keep their ETag/Last-Modified so they can be revalidated with a
+// conditional request. Total size is bounded, evicting least recently used
+// entries first.
+class HttpCache {
+public:
+    struct Entry {
+        int status = 200;
+        std::string content_type;
+        std::string etag;
+        std::string last_modified;
+        int64_t stored_at = 0;   // unix seconds
+        int64_t fresh_until = 0; // served without asking the server until then
+        std::string body;
+
+        bool fresh(int64_t now) const { return now < fresh_until; }
+        bool has_validators() const { return !etag.empty() || !last_modified.empty(); }
+    };
+
+    // Response header by (case-insensitive) name, empty when absent
+    using HeaderLookup = std::function<std::string(const std::string& name)>;
+
+    HttpCache(fs::path dir, uint64_t max_bytes);
+
+    // Process-wide cache for a directory (see shared_disk_cache)
+    static std::shared_ptr<HttpCache> open(const fs::path& dir, uint64_t max_bytes);
+
+    // Stored entry for a key, fresh or not
+    std::optional<Entry> get(const std::string& key);
+    void put(const std::string& key, const Entry& entry);
+    void remove(const std::string& key);
+
+    uint64_t size_bytes();
+
+    // Entry for a response according to its caching headers, or nullopt when
+    // it must not be stored (no-store, Vary: *, status other than 200)
+    static std::optional<Entry> from_response(int status, const HeaderLookup& header,
+                                              std::string body, int64_t now);
+
+    // Apply the headers of a 304 Not Modified to a revalidated entry
+    static void refresh(Entry& entry, const HeaderLookup& header, int64_t now);
+
+    static int64_t now();
+
+    // Heuristic lifetime cap for responses with only Last-Modified
+    static constexpr int64_t kMaxHeuristicSeconds = 24 * 3600;
+
+private:
+    std::mutex mutex_;
+    bool loaded_ = false;
+    DiskLru lru_;  // entry files by name
+
+    std::string file_name(const std::string& key) const;
+    void load();
+};
+
+// HTTP-date (IMF-fixdate, RFC 850 or asctime) as unix seconds
+std::optional<int64_t> parse_http_date(std::string_view value);
+
+std::string format_http_date(int64_t time);
+
+}  // namespace gpagent::tools
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// In-memory cache of images prepared for the model (decoded, resized,
+// re-encoded and base64'd), keyed by a SHA-256 of the file content and the
+// size limit. Re-reading an unchanged file is answered from its path, size
+// and mtime without reading it; a renamed or copied file costs one read and
+// hash. The base64 payload is immutable and shared, so the messages that
+// carry it across turns never copy it. Bounded by total payload size,
+// evicting least recently used images first.
+class ImageCache {
+public:
+    // Output of the encoder for one image
+    struct Encoded {
+        std::string bytes;
+        std::string media_type;
+        int width = 0;
+        int height = 0;
+        bool was_resized = false;
+    };
+
+    // Decode, resize to max_dimension and re-encode file content; nullopt
+    // when the content is not a readable image
+    using Encoder = std::function<std::optional<Encoded>(const std::string& content, int max_dimension)>;
+
+    struct Image {
+        std::string id;  // content hash, valid for find()
+        std::shared_ptr<const std::string> base64;
+        std::string media_type;
+        int width = 0;
+        int height = 0;
+        bool was_resized = false;
+        size_t encoded_size = 0;  // bytes before base64
+    };
+
+    static constexpr size_t kDefaultMaxBytes = 128ull * 1024 * 1024;
+
+    explicit ImageCache(size_t max_bytes = kDefaultMaxBytes);
+
+    // Process-wide cache shared by the image tools and the orchestrator
+    static ImageCache& shared();
+
+    // Prepared image for a file, running encode only on a miss
+    Result<std::shared_ptr<const Image>, Error> load(const fs::path& path, int max_dimension,
+                                                     const Encoder& encode);
+
+    // Image by id, nullptr once evicted
+    std::shared_ptr<const Image> find(const std::string& id);
+
+    size_t size_bytes();
+
+    // Content key for file bytes at a size limit
+    static std::string content_id(const std::string& content, int max_dimension);
+
+private:
+    struct Slot {
+        std::shared_ptr<const Image> image;
+        std::list<std::string>::iterator lru;
+    };
+
+    std::shared_ptr<const Image> lookup_locked(const std::string& id);
+    void insert_locked(std::shared_ptr<const Image> image);
+
+    size_t max_bytes_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Slot> images_;
+    std::list<std::string> lru_;  // most recent first
+    std::unordered_map<std::string, std::string> by_stat_;  // path, size, mtime, limit -> id
+    size_t total_bytes_ = 0;
+};
+
+}  // namespace gpagent::tools
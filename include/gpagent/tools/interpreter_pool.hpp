@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace gpagent::tools {
+
+// Warm Python and Node processes for code_execute. Each worker runs a small
+// driver that reads length-prefixed JSON requests from a socketpair on fd 3
+// and executes every snippet in a fresh module namespace, so interpreter
+// startup and already imported modules are paid for once rather than per
+// call. The driver restores the working directory, environment and globals
+// after a run and forgets modules loaded from the project; changes a snippet
+// makes inside installed libraries it imported stay for the worker's life.
+// Workers run in their own process group, die with the agent, and are
+// replaced after kMaxRunsPerWorker snippets, when their resident memory grows
+// past kMaxWorkerRssBytes, or when a snippet times out, ends the interpreter
+// or leaves threads or processes running.
+class InterpreterPool {
+public:
+    enum class Language { Python, JavaScript };
+
+    using OutputCallback = std::function<void(std::string_view chunk)>;
+
+    struct RunResult {
+        int exit_code = -1;
+        std::string output;     // stdout and stderr interleaved
+        bool timed_out = false;
+    };
+
+    static InterpreterPool& instance();
+
+    InterpreterPool();
+    ~InterpreterPool();
+
+    InterpreterPool(const InterpreterPool&) = delete;
+    InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+    // Run a snippet with the given working directory and extra environment.
+    // nullopt when no worker can be started for the language (callers fall
+    // back to a one-shot interpreter process).
+    std::optional<RunResult> run(Language language, const std::string& code,
+                                 const std::string& working_dir,
+                                 const std::map<std::string, std::string>& env,
+                                 int timeout_ms, const OutputCallback& on_output = {});
+
+    // Idle workers kept per language; concurrent calls beyond this start
+    // extra workers that are closed when they finish
+    static constexpr size_t kIdleWorkers = 2;
+    static constexpr int kMaxRunsPerWorker = 100;
+    static constexpr int64_t kMaxWorkerRssBytes = 512ll * 1024 * 1024;
+
+    struct Worker;  // one interpreter process; defined with the platform code
+
+private:
+    struct SpawnRequest {
+        Language language;
+        std::optional<std::promise<std::unique_ptr<Worker>>> caller;  // empty: a spare for idle_
+    };
+
+    std::mutex mutex_;
+    std::map<Language, std::vector<std::unique_ptr<Worker>>> idle_;
+    std::map<Language, bool> unavailable_;  // the interpreter failed to start
+    std::map<Language, size_t> spares_pending_;
+
+    // Workers are forked from one long-lived thread: their parent-death
+    // signal follows the thread that forked them, not the process
+    std::thread spawner_;
+    std::condition_variable spawn_cv_;
+    std::deque<SpawnRequest> spawn_queue_;
+    bool stopping_ = false;
+
+    void spawner_loop();
+    std::unique_ptr<Worker> acquire(Language language);
+    void release(Language language, std::unique_ptr<Worker> worker);
+};
+
+}  // namespace gpagent::tools
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+// Line-level diff (Myers, linear space) between two texts.
+// deleted[i] is set for lines of a not in the LCS, inserted[j] likewise for b.
+struct LineDiff {
+    std::vector<std::string_view> a;
+    std::vector<std::string_view> b;
+    std::vector<bool> deleted;
+    std::vector<bool> inserted;
+
+    bool empty() const;
+};
+
+// Split into lines, keeping each line's trailing '\n'
+std::vector<std::string_view> split_lines(std::string_view text);
+
+LineDiff diff_lines(std::string_view a, std::string_view b);
+
+// Unified diff hunks ("@@ -l,n +l,n @@ ..." onwards) in git's format,
+// including the function-context heading and "\ No newline at end of file".
+// Returns an empty string when the texts are equal.
+std::string unified_diff(std::string_view a, std::string_view b, int context = 3);
+
+}  // namespace gpagent::tools
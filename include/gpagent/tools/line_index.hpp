@@ -0,0 +1,71 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/tools/search_engine.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Memory-mapped text file with a sparse line-offset index.
+// The offset of every kStride-th line is recorded while scanning, so reading
+// lines [first, first + count) costs O(count + kStride) once the index covers
+// first. The index is extended lazily: reading the head of a huge file only
+// scans the head.
+class LineIndex {
+public:
+    // Lines between recorded offsets
+    static constexpr size_t kStride = 1024;
+
+    // Identity of the file an index was built from. Device and inode catch
+    // a same-size replacement (e.g. an atomic rename) within one mtime tick.
+    struct Stamp {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t dev = 0;
+        uint64_t ino = 0;
+
+        bool operator==(const Stamp&) const = default;
+    };
+
+    // Cached index for a file, rebuilt when its stamp changes
+    static Result<std::shared_ptr<LineIndex>, Error> open(const fs::path& path);
+
+    LineIndex(MappedFile file, const Stamp& stamp);
+
+    LineIndex(const LineIndex&) = delete;
+    LineIndex& operator=(const LineIndex&) = delete;
+
+    // Callback for each line: (0-based line number, text without '\n').
+    // Return false to stop.
+    using LineCallback = std::function<bool(size_t, std::string_view)>;
+
+    // Visit up to count lines starting at first. Returns the number visited.
+    size_t read_lines(size_t first, size_t count, const LineCallback& on_line);
+
+    size_t size() const { return file_.size(); }
+    const Stamp& stamp() const { return stamp_; }
+
+private:
+    MappedFile file_;
+    Stamp stamp_;
+
+    std::mutex mutex_;
+    std::vector<uint64_t> checkpoints_{0};  // offset of line k * kStride
+    uint64_t scanned_ = 0;                  // bytes scanned so far
+    uint64_t newlines_ = 0;                 // newlines in [0, scanned_)
+
+    // Scan until the checkpoint for line is known (or the file ends)
+    void extend_to(size_t line);
+};
+
+}  // namespace gpagent::tools
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace gpagent::tools {
+
+// Captures a command's output keeping only the first head_limit and last
+// tail_limit bytes, so a runaway build log uses bounded memory while the
+// errors at the end stay visible.
+class OutputBuffer {
+public:
+    OutputBuffer(size_t head_limit, size_t tail_limit);
+
+    void append(std::string_view data);
+
+    // Bytes appended in total / bytes dropped from the middle
+    size_t total_size() const { return total_; }
+    size_t omitted() const;
+
+    bool empty() const { return total_ == 0; }
+
+    // Head, an omission marker if anything was dropped, then tail.
+    // Cuts are moved to UTF-8 character boundaries.
+    std::string str() const;
+
+private:
+    size_t head_limit_;
+    size_t tail_limit_;
+    std::string head_;
+    std::string tail_;       // ring buffer once full
+    size_t tail_pos_ = 0;    // oldest byte in the ring
+    size_t total_ = 0;
+};
+
+// Batches streamed output for a callback so a chatty command produces a few
+// updates per second rather than one per read. Only the newest max_pending
+// bytes of a batch are kept.
+class OutputBatcher {
+public:
+    using Callback = std::function<void(std::string_view chunk)>;
+
+    explicit OutputBatcher(Callback callback,
+                           std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+                           size_t max_pending = 64 * 1024);
+
+    bool enabled() const { return static_cast<bool>(callback_); }
+
+    void append(std::string_view data);
+
+    // Milliseconds until the pending batch is due, or -1 if nothing is pending
+    int due_in_ms() const;
+
+    void flush_if_due();
+    void flush();
+
+private:
+    Callback callback_;
+    std::chrono::milliseconds interval_;
+    size_t max_pending_;
+    std::string pending_;
+    std::chrono::steady_clock::time_point last_flush_;
+};
+
+}  // namespace gpagent::tools
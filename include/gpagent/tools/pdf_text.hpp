@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+#include "gpagent/tools/disk_lru.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// A parsed PDF. Instances are used by one thread at a time; parallel
+// extraction opens one per thread.
+class PdfSource {
+public:
+    virtual ~PdfSource() = default;
+    virtual int page_count() const = 0;
+    virtual std::string page_text(int page) = 0;  // 0-based, UTF-8
+};
+
+// Parses PDF bytes, which outlive the source; nullptr when unreadable
+using PdfOpener = std::function<std::unique_ptr<PdfSource>(const std::string& content)>;
+
+#ifdef HAVE_POPPLER
+std::unique_ptr<PdfSource> open_poppler_pdf(const std::string& content);
+#endif
+
+// Text of PDF pages, extracted on first request and kept on disk as one
+// file per page under a directory named by the SHA-256 of the document, so
+// paging through a long document parses each page once, even across
+// restarts, renames and copies. An unchanged path, size and mtime skips
+// reading and hashing the PDF. Pages missing from a request are extracted
+// in parallel. Total size is bounded, evicting least recently read
+// documents first. With an empty directory nothing is stored and only the
+// requested pages are extracted.
+class PdfTextCache {
+public:
+    struct Page {
+        int number = 0;  // 0-based
+        std::string text;
+    };
+
+    struct Range {
+        int total_pages = 0;
+        std::vector<Page> pages;
+        int extracted = 0;  // pages that were not cached
+    };
+
+    static constexpr uint64_t kDefaultMaxBytes = 256ull * 1024 * 1024;
+    static constexpr int kMaxThreads = 8;
+
+    PdfTextCache(fs::path dir, uint64_t max_bytes);
+
+    // Process-wide cache for a directory (see shared_disk_cache)
+    static std::shared_ptr<PdfTextCache> open(const fs::path& dir, uint64_t max_bytes = kDefaultMaxBytes);
+
+    // Pages [first, first + count) clamped to the document
+    Result<Range, Error> read(const fs::path& pdf, int first, int count, const PdfOpener& opener);
+
+    uint64_t size_bytes();
+
+private:
+    fs::path doc_dir(const std::string& hash) const { return lru_.dir() / hash; }
+    std::optional<std::string> cached_page(const std::string& hash, int page) const;
+    std::optional<int> cached_page_count(const std::string& hash) const;
+    void store(const std::string& hash, const std::string& name, const std::string& content);
+    void touch(const std::string& hash);
+    void load();
+
+    std::mutex mutex_;
+    bool loaded_ = false;
+    DiskLru lru_;  // document directories by hash
+    std::unordered_map<std::string, std::string> by_stat_;  // path, size, mtime -> hash
+};
+
+}  // namespace gpagent::tools
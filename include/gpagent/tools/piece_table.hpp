@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gpagent::tools {
+
+// Editable view over an immutable buffer.
+// The document is a sequence of pieces referencing either the original text
+// or an append-only buffer of inserted text, so edits never copy the file;
+// the result is produced in one pass by chunks(). The original buffer must
+// outlive the table.
+class PieceTable {
+public:
+    explicit PieceTable(std::string_view original);
+
+    // Document length in bytes
+    size_t size() const { return size_; }
+
+    // Offset of the first occurrence of needle at or after from (npos if none).
+    // Matches may span pieces.
+    size_t find(std::string_view needle, size_t from = 0) const;
+
+    // Replace [pos, pos + len) with text
+    void replace(size_t pos, size_t len, std::string_view text);
+
+    // Replace every non-overlapping occurrence; returns the number replaced
+    size_t replace_all(std::string_view needle, std::string_view text);
+
+    // Document contents as consecutive chunks (valid until the next edit)
+    std::vector<std::string_view> chunks() const;
+
+    std::string to_string() const;
+
+private:
+    struct Piece {
+        bool added;    // false: original buffer, true: add buffer
+        size_t start;
+        size_t length;
+    };
+
+    std::string_view original_;
+    std::string added_;
+    std::vector<Piece> pieces_;
+    size_t size_ = 0;
+
+    std::string_view view(const Piece& piece) const;
+
+    // Copy up to n bytes starting at offset within piece index
+    std::string collect(size_t index, size_t offset, size_t n) const;
+
+    // Replace each range [start, start + len) (sorted, non-overlapping) with text
+    void replace_ranges(const std::vector<size_t>& starts, size_t len, std::string_view text);
+};
+
+}  // namespace gpagent::tools
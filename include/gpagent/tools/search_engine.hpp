@@ -0,0 +1,148 @@
+#pragma once
+
+#include "gpagent/core/result.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct stat;
+
+namespace gpagent::tools {
+
+using namespace gpagent::core;
+namespace fs = std::filesystem;
+
+// Compiled NFA program for the grep engine.
+// Byte-oriented like std::regex over std::string, but matched with a lazy DFA
+// so matching time is linear in the input (no backtracking).
+struct RegexProgram {
+    enum class Op : uint8_t {
+        Class,      // consume one byte in classes[arg]
+        Split,      // fork to x and y
+        Jump,       // goto x
+        Assert,     // zero-width assertion (AssertKind in arg)
+        Match
+    };
+
+    enum AssertKind : int {
+        LineStart = 0,
+        LineEnd = 1,
+        WordBoundary = 2,
+        NotWordBoundary = 3
+    };
+
+    struct Inst {
+        Op op;
+        int x = -1;
+        int y = -1;
+        int arg = 0;
+    };
+
+    std::vector<Inst> insts;
+    std::vector<std::bitset<256>> classes;
+    int start = 0;
+};
+
+// A search pattern compiled once per grep call and shared by all searchers
+class SearchPattern {
+public:
+    // Compile an ECMAScript-style regex. Patterns using features the DFA
+    // cannot express (backreferences, lookaround) fall back to std::regex.
+    static Result<SearchPattern, Error> compile(const std::string& pattern);
+
+    const std::string& source() const { return source_; }
+
+    // Literal that every match must contain (used as a memchr prefilter)
+    const std::string& required_literal() const { return required_literal_; }
+
+    // True if the whole pattern is a plain literal (no DFA needed)
+    bool is_literal() const { return is_literal_; }
+
+    // True if matching uses the std::regex fallback
+    bool uses_fallback() const { return fallback_ != nullptr; }
+
+private:
+    friend class Searcher;
+
+    std::string source_;
+    std::string required_literal_;
+    bool is_literal_ = false;
+    bool anchored_start_ = false;
+    std::shared_ptr<const RegexProgram> program_;
+    std::shared_ptr<const std::regex> fallback_;
+};
+
+// Line searcher. Holds the lazily-built DFA cache, so it is cheap to create
+// but must not be shared between threads; create one per worker.
+class Searcher {
+public:
+    explicit Searcher(const SearchPattern& pattern);
+    ~Searcher();
+
+    Searcher(Searcher&&) noexcept;
+    Searcher& operator=(Searcher&&) noexcept;
+
+    // Callback for each matching line: (1-based line number, line text).
+    // Return false to stop the search.
+    using LineCallback = std::function<bool(size_t, std::string_view)>;
+
+    // Search a buffer line by line. Returns the number of matching lines reported.
+    size_t search(std::string_view data, const LineCallback& on_match);
+
+    // Test a single line (no trailing newline)
+    bool matches(std::string_view line);
+
+private:
+    struct Dfa;
+
+    const SearchPattern* pattern_;
+    std::unique_ptr<Dfa> dfa_;
+
+    bool line_matches(std::string_view line);
+};
+
+// Read-only view of a file's contents. Large files are mmap'd, small files
+// are read into a buffer (cheaper than setting up a mapping).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Open a file; returns false if it cannot be read. Pass sequential =
+    // false for random access (e.g. packfiles) to skip the readahead hint.
+    // info, if given, receives the status of the descriptor that was read.
+    bool open(const fs::path& path, bool sequential = true, struct stat* info = nullptr);
+
+    std::string_view data() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+    bool is_mapped() const { return mapped_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+
+    void reset();
+};
+
+// Heuristic binary detection (NUL byte in the first 8 KB, like git and ripgrep)
+bool is_binary_content(std::string_view data);
+
+// Find the next occurrence of a literal using a memchr scan on its rarest byte
+size_t find_literal(std::string_view haystack, std::string_view needle, size_t from = 0);
+
+}  // namespace gpagent::tools
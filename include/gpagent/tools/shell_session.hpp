@@ -0,0 +1,84 @@
+#pragma once
+
+#include "gpagent/tools/output_buffer.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+// A long-lived interactive bash on a pseudo-terminal, so cd, exports and
+// activated virtualenvs carry over between bash tool calls and shell startup
+// is paid once per agent session. Each command is sourced from a script file
+// and followed by a sentinel line carrying its exit status. A timeout sends
+// ^C to the foreground job and keeps the shell. Commands read stdin from
+// /dev/null and see TERM=dumb, cat as pager and NO_COLOR, so the terminal
+// doesn't turn on paging, colors or prompts.
+class ShellSession {
+public:
+    using OutputCallback = std::function<void(std::string_view chunk)>;
+
+    struct RunResult {
+        int exit_code = -1;
+        std::string output;         // stdout and stderr interleaved (one terminal)
+        bool timed_out = false;
+        bool session_lost = false;  // the shell exited or had to be killed
+    };
+
+    ShellSession(std::string working_dir, std::map<std::string, std::string> env);
+    ~ShellSession();
+
+    ShellSession(const ShellSession&) = delete;
+    ShellSession& operator=(const ShellSession&) = delete;
+
+    // Spawn the shell; false if no PTY is available
+    bool start();
+    bool alive() const;
+
+    // Run one command in the shell (calls are serialized). A lost session
+    // is restarted by the next call.
+    RunResult run(const std::string& command, int timeout_ms,
+                  const OutputCallback& on_output = {});
+
+    // Shell for an agent session, started on first use. Returns nullptr when
+    // a PTY shell can't be started (callers fall back to bash -c).
+    static std::shared_ptr<ShellSession> for_session(const std::string& session_id,
+                                                     const std::string& working_dir,
+                                                     const std::map<std::string, std::string>& env);
+
+    // Sessions kept alive at once; the least recently used is closed beyond this
+    static constexpr size_t kMaxSessions = 8;
+
+private:
+    enum class WaitStatus { Done, TimedOut, Lost };
+
+    std::string working_dir_;
+    std::map<std::string, std::string> env_;
+
+    mutable std::mutex mutex_;
+    int master_fd_ = -1;
+    int pid_ = -1;
+    std::string marker_;   // "__GPAGENT_<nonce>_", unguessable by command output
+    uint64_t seq_ = 0;
+    fs::path script_path_;
+
+    bool start_locked();
+    int stop_locked();  // returns the shell's exit code
+    bool send(std::string_view text);
+    bool send_marker(uint64_t seq, std::string_view status, std::string_view prefix = {});
+
+    // Read until the marker for seq arrives. Output before it goes to output
+    // and stream when given, and is discarded otherwise.
+    WaitStatus wait_for_marker(uint64_t seq, int timeout_ms, int& exit_code,
+                               OutputBuffer* output, OutputBatcher* stream);
+};
+
+}  // namespace gpagent::tools
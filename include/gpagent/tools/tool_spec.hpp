@@ -5,6 +5,7 @@
 #include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declaration
@@ -135,6 +136,10 @@ struct ToolContext {
 
     // Pointer to application config (for accessing API keys, search settings, etc.)
     const gpagent::core::Config* config = nullptr;
+
+    // Receives output while a long-running tool is still executing (e.g. bash).
+    // Called on the tool's thread; may be empty.
+    std::function<void(std::string_view chunk)> on_output;
 };
 
 // Tool handler function type
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gpagent::tools {
+
+namespace fs = std::filesystem;
+
+class ChangeJournal;
+
+// Per-project trigram index used to narrow grep candidates.
+// Maps every 3-byte sequence (within a line) to the files containing it, so a
+// pattern's required literal selects a small set of files to verify. Kept
+// fresh by comparing size/mtime on each refresh, or, while the project's
+// change journal covers every indexed directory, by re-checking only the
+// files it reports. Persisted to disk so it survives restarts.
+class TrigramIndex : public std::enable_shared_from_this<TrigramIndex> {
+public:
+    TrigramIndex(fs::path root, fs::path index_path);
+    ~TrigramIndex();
+
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    // Bring the index up to date with the tree. Returns false if the tree is
+    // too large to index (the caller should scan instead).
+    bool refresh();
+
+    // True once the index has been built or loaded from disk
+    bool ready() const { return ready_.load(); }
+
+    // Build the index on a background thread (no-op if already running)
+    void build_async();
+
+    // Files under rel_prefix that may contain literal, relative to root.
+    // Returns nullopt when the index cannot narrow the search (literal
+    // shorter than 3 bytes, or rel_prefix is outside the indexed files).
+    std::optional<std::vector<std::string>> candidates(std::string_view literal,
+                                                       std::string_view rel_prefix = {}) const;
+
+    // Persist to index_path (written atomically)
+    bool save();
+
+    const fs::path& root() const { return root_; }
+    size_t file_count() const;
+
+    // Shared index for a project root, loaded from storage_dir on first use
+    static std::shared_ptr<TrigramIndex> for_project(const fs::path& root,
+                                                     const fs::path& storage_dir);
+
+    // Walk limits (files above max_file_size are neither indexed nor grepped)
+    static constexpr uint64_t kMaxFileSize = 10 * 1024 * 1024;
+    static constexpr size_t kMaxFiles = 200000;
+
+private:
+    enum FileFlags : uint8_t {
+        Dead = 1,    // removed or replaced; purged on compaction
+        Binary = 2,  // indexed but never a candidate
+        Racy = 4     // modified too close to indexing to trust mtime
+    };
+
+    struct FileInfo {
+        std::string path;   // relative to root
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint8_t flags = 0;
+    };
+
+    // Delta-varint encoded, ascending file ids
+    struct Posting {
+        std::vector<uint8_t> bytes;
+        uint32_t last = 0;
+        uint32_t count = 0;
+    };
+
+    fs::path root_;
+    fs::path index_path_;
+
+    mutable std::mutex mutex_;
+    std::vector<FileInfo> files_;
+    std::unordered_map<std::string, uint32_t> by_path_;
+    std::unordered_map<uint32_t, Posting> postings_;
+    size_t dead_count_ = 0;
+    size_t unsaved_changes_ = 0;
+    bool too_large_ = false;
+    std::atomic<bool> ready_{false};
+    std::atomic<bool> building_{false};
+    std::chrono::steady_clock::time_point last_save_;
+
+    std::shared_ptr<ChangeJournal> journal_;
+    uint64_t journal_sequence_ = 0;
+    bool journal_complete_ = false;  // the last walk watched every directory it entered
+
+    bool load();
+    // Files changed since the last refresh per the journal, or nullopt when
+    // a stat walk is needed (no journal, lost events, new paths)
+    std::optional<std::vector<std::string>> journaled_changes();
+    bool save_locked();
+    void compact();
+
+    static void append(Posting& posting, uint32_t id);
+    static std::vector<uint32_t> decode(const Posting& posting);
+};
+
+}  // namespace gpagent::tools
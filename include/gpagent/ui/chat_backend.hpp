@@ -59,8 +59,9 @@ public:
     // Create new chat session
     Q_INVOKABLE void newChat();
 
-    // Get list of available sessions (returns JSON array)
-    Q_INVOKABLE QVariantList getSessions();
+    // Get a page of available sessions, most recently updated first
+    // (returns JSON array)
+    Q_INVOKABLE QVariantList getSessions(int offset = 0, int limit = 50);
 
     // Switch to a specific session
     Q_INVOKABLE bool switchSession(const QString& sessionId);
@@ -1,4 +1,5 @@
 #include "gpagent/agent/orchestrator.hpp"
+#include "gpagent/tools/image_cache.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -273,10 +274,20 @@ Result<void, Error> Orchestrator::execute_tool_calls(
 
         // Create tool context
         tools::ToolContext ctx;
+        if (memory_.has_active_session()) {
+            ctx.session_id = memory_.current_session_id();
+        }
         ctx.working_directory = std::filesystem::current_path().string();
         ctx.timeout_ms = 120000;  // 2 minutes
         ctx.config = app_config_;  // Pass app config to tools
 
+        // Stream partial output (e.g. a running build) to the UI
+        if (event_cb) {
+            ctx.on_output = [event_cb, tool = call.tool_name](std::string_view chunk) {
+                event_cb({AgentEvent::ToolOutput, std::string(chunk), {{"tool", tool}}});
+            };
+        }
+
         // Set allowed paths for sandbox - include home directory and common locations
         const char* home = std::getenv("HOME");
         if (home) {
@@ -306,18 +317,29 @@ Result<void, Error> Orchestrator::execute_tool_calls(
             spdlog::info("Processing image result...");
             try {
                 Json img_json = Json::parse(output);
-                spdlog::info("Parsed image JSON, has data={}, has media_type={}",
-                             img_json.contains("data"), img_json.contains("media_type"));
-                if (img_json.contains("data") && img_json.contains("media_type")) {
-                    ImageContent img;
-                    img.data = img_json["data"].get<std::string>();
+                spdlog::info("Parsed image JSON, has image_id={}, has data={}, has media_type={}",
+                             img_json.contains("image_id"), img_json.contains("data"),
+                             img_json.contains("media_type"));
+                ImageContent img;
+                if (img_json.contains("image_id")) {
+                    // Share the cached payload instead of copying it
+                    auto id = img_json["image_id"].get<std::string>();
+                    if (auto cached = tools::ImageCache::shared().find(id)) {
+                        img.data = cached->base64;
+                    } else {
+                        spdlog::warn("Image {} no longer cached", id);
+                    }
+                } else if (img_json.contains("data")) {
+                    img.data = std::make_shared<const std::string>(img_json["data"].get<std::string>());
+                }
+                if (img.data && img_json.contains("media_type")) {
                     img.media_type = img_json["media_type"].get<std::string>();
                     img.source_path = img_json.value("file_path", "");
                     tool_msg.images.push_back(std::move(img));
                     // Set content to a descriptive text instead of the base64 blob
                     tool_msg.content = "Image loaded from: " + img_json.value("file_path", "unknown");
                     spdlog::info("Added image to tool result: {} (data_len={})",
-                                 img.source_path, tool_msg.images.back().data.size());
+                                 tool_msg.images.back().source_path, tool_msg.images.back().base64().size());
                 }
             } catch (const std::exception& e) {
                 spdlog::warn("Failed to parse image result: {}", e.what());
@@ -172,6 +172,7 @@ Result<Config, Error> Config::load(const fs::path& path) {
             config.search.max_results = search_node["max_results"].as<int>(config.search.max_results);
             config.search.timeout_ms = search_node["timeout_ms"].as<int>(config.search.timeout_ms);
             config.search.safe_search = search_node["safe_search"].as<bool>(config.search.safe_search);
+            config.search.cache_ttl_hours = search_node["cache_ttl_hours"].as<int>(config.search.cache_ttl_hours);
         }
 
         // Parse memory config
@@ -215,6 +216,12 @@ Result<Config, Error> Config::load(const fs::path& path) {
 
         // Parse tools config
         if (auto tools_node = root["tools"]) {
+            config.tools.search_index = tools_node["search_index"].as<bool>(config.tools.search_index);
+            config.tools.persistent_shell = tools_node["persistent_shell"].as<bool>(config.tools.persistent_shell);
+            config.tools.warm_interpreters = tools_node["warm_interpreters"].as<bool>(config.tools.warm_interpreters);
+            config.tools.http_cache = tools_node["http_cache"].as<bool>(config.tools.http_cache);
+            config.tools.http_cache_max_mb = tools_node["http_cache_max_mb"].as<int>(config.tools.http_cache_max_mb);
+            config.tools.http_cache_offline = tools_node["http_cache_offline"].as<bool>(config.tools.http_cache_offline);
             if (auto builtin_node = tools_node["builtin"]) {
                 for (const auto& tool : builtin_node) {
                     std::string name = tool.first.as<std::string>();
@@ -373,6 +380,7 @@ Result<void, Error> Config::save(const fs::path& path) const {
         out << YAML::Key << "max_results" << YAML::Value << search.max_results;
         out << YAML::Key << "timeout_ms" << YAML::Value << search.timeout_ms;
         out << YAML::Key << "safe_search" << YAML::Value << search.safe_search;
+        out << YAML::Key << "cache_ttl_hours" << YAML::Value << search.cache_ttl_hours;
         out << YAML::EndMap;
 
         // Memory config
@@ -0,0 +1,30 @@
+#include "gpagent/core/sha256.hpp"
+
+#include <openssl/evp.h>
+
+#include <array>
+
+namespace gpagent::core {
+
+std::string sha256_hex(std::initializer_list<std::string_view> parts) {
+    std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+    unsigned int len = 0;
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    for (std::string_view part : parts) {
+        EVP_DigestUpdate(ctx, part.data(), part.size());
+    }
+    EVP_DigestFinal_ex(ctx, digest.data(), &len);
+    EVP_MD_CTX_free(ctx);
+
+    static constexpr char hex[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+    for (unsigned int i = 0; i < len; ++i) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xf];
+    }
+    return out;
+}
+
+}  // namespace gpagent::core
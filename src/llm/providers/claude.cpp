@@ -72,7 +72,7 @@ Json ClaudeProvider::format_messages(const std::vector<Message>& messages) const
                         {"source", {
                             {"type", "base64"},
                             {"media_type", img.media_type},
-                            {"data", img.data}
+                            {"data", img.base64()}
                         }}
                     });
                 }
@@ -124,7 +124,7 @@ Json ClaudeProvider::format_messages(const std::vector<Message>& messages) const
                     {"source", {
                         {"type", "base64"},
                         {"media_type", img.media_type},
-                        {"data", img.data}
+                        {"data", img.base64()}
                     }}
                 });
             }
@@ -53,7 +53,7 @@ Json GeminiProvider::format_messages(const std::vector<Message>& messages) const
                 parts.push_back(Json{
                     {"inline_data", {
                         {"mime_type", img.media_type},
-                        {"data", img.data}
+                        {"data", img.base64()}
                     }}
                 });
             }
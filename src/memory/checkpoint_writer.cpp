@@ -0,0 +1,75 @@
+#include "gpagent/memory/checkpoint_writer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace gpagent::memory {
+
+CheckpointWriter::CheckpointWriter(Checkpointer& checkpointer, size_t max_pending)
+    : checkpointer_(checkpointer)
+    , max_pending_(std::max<size_t>(max_pending, 1))
+{
+    worker_ = std::thread([this] { run(); });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    flush();
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void CheckpointWriter::submit(Job job) {
+    {
+        std::unique_lock lock(mutex_);
+        space_cv_.wait(lock, [this] { return queue_.size() < max_pending_; });
+        queue_.push_back(std::move(job));
+    }
+    work_cv_.notify_one();
+}
+
+Result<void, Error> CheckpointWriter::flush() {
+    std::unique_lock lock(mutex_);
+    space_cv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+    auto error = std::exchange(error_, std::nullopt);
+    if (error) return *error;
+    return Result<void, Error>::ok();
+}
+
+bool CheckpointWriter::needs_full_thread() const {
+    std::lock_guard lock(mutex_);
+    return needs_full_;
+}
+
+void CheckpointWriter::run() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) return;  // stopping, and flushed
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+        space_cv_.notify_all();
+
+        auto result = job.full_thread
+            ? checkpointer_.create(job.session, *job.full_thread, job.history, job.description, job.trigger)
+            : checkpointer_.create(job.session, job.delta, job.history, job.description, job.trigger);
+
+        lock.lock();
+        busy_ = false;
+        if (result.is_err()) {
+            needs_full_ = true;
+            if (!error_) error_ = result.error();
+        } else if (job.full_thread) {
+            needs_full_ = false;
+        }
+        space_cv_.notify_all();
+    }
+}
+
+}  // namespace gpagent::memory
@@ -1,8 +1,10 @@
 #include "gpagent/memory/checkpointer.hpp"
 #include "gpagent/core/uuid.hpp"
+#include "gpagent/tools/atomic_write.hpp"
 
 #include <algorithm>
 #include <fstream>
+#include <stdexcept>
 
 namespace gpagent::memory {
 
@@ -70,12 +72,21 @@ Checkpoint Checkpoint::from_json(const Json& j) {
     return cp;
 }
 
+namespace {
+
+constexpr const char* kObjectsDir = "objects";
+constexpr int kManifestVersion = 1;
+
+}  // namespace
+
 // Checkpointer
 Checkpointer::Checkpointer(const fs::path& storage_path)
     : storage_path_(storage_path)
+    , chunks_(storage_path / kObjectsDir)
 {
     fs::create_directories(storage_path_);
     load_index();
+    rebuild_refs();
 }
 
 fs::path Checkpointer::checkpoint_path(const CheckpointId& id) const {
@@ -86,6 +97,42 @@ fs::path Checkpointer::info_path(const CheckpointId& id) const {
     return checkpoint_path(id) / "info.json";
 }
 
+fs::path Checkpointer::manifest_path(const CheckpointId& id) const {
+    return checkpoint_path(id) / "manifest.json";
+}
+
+std::optional<std::vector<std::string>> Checkpointer::manifest_chunks(const CheckpointId& id) const {
+    try {
+        std::ifstream file(manifest_path(id));
+        if (!file) {
+            return std::nullopt;
+        }
+
+        Json j = Json::parse(file);
+        std::vector<std::string> hashes = j.value("messages", std::vector<std::string>{});
+        hashes.push_back(j.value("session", ""));
+        hashes.push_back(j.value("history", ""));
+        return hashes;
+
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+void Checkpointer::rebuild_refs() {
+    std::error_code ec;
+    for (fs::directory_iterator it(storage_path_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory() || it->path().filename() == kObjectsDir) continue;
+
+        if (auto hashes = manifest_chunks(it->path().filename().string())) {
+            for (const auto& hash : *hashes) {
+                chunks_.retain(hash);
+            }
+        }
+    }
+    chunks_.sweep();
+}
+
 Result<CheckpointId, Error> Checkpointer::create(
     const SessionState& session,
     const ThreadMemory& thread,
@@ -104,6 +151,61 @@ Result<CheckpointId, Error> Checkpointer::create(
     const std::string& description,
     const std::string& trigger)
 {
+    const auto& messages = thread.messages();
+    ThreadView view{thread.id(), thread.revision(), 0, messages.size(),
+                    [&](size_t i) -> const Message& { return messages[i]; }};
+    return create(session, view, history, parent_id, description, trigger);
+}
+
+Result<CheckpointId, Error> Checkpointer::create(
+    const SessionState& session,
+    const ThreadDelta& thread,
+    const CompressedHistory& history,
+    const std::string& description,
+    const std::string& trigger)
+{
+    ThreadView view{thread.thread_id, thread.revision, thread.base, thread.base + thread.messages.size(),
+                    [&](size_t i) -> const Message& { return thread.messages[i - thread.base]; }};
+    return create(session, view, history, "", description, trigger);
+}
+
+void Checkpointer::set_last_thread(ThreadChunks chunks) {
+    // The cached hashes hold references, so remove() never deletes a chunk
+    // a later checkpoint of this thread will reuse
+    for (const auto& hash : chunks.hashes) {
+        chunks_.retain(hash);
+    }
+    if (last_thread_) {
+        for (const auto& hash : last_thread_->hashes) {
+            chunks_.release(hash);
+        }
+    }
+    last_thread_ = std::move(chunks);
+}
+
+Result<CheckpointId, Error> Checkpointer::create(
+    const SessionState& session,
+    const ThreadView& thread,
+    const CompressedHistory& history,
+    const CheckpointId& parent_id,
+    const std::string& description,
+    const std::string& trigger)
+{
+    // Messages before thread.base are only known through the cache
+    size_t reused = 0;
+    if (last_thread_ && last_thread_->thread_id == thread.id &&
+        last_thread_->revision == thread.revision &&
+        last_thread_->hashes.size() <= thread.size) {
+        reused = last_thread_->hashes.size();
+    }
+    if (reused < thread.base) {
+        return Result<CheckpointId, Error>::err(
+            ErrorCode::InvalidState,
+            "Thread delta does not extend the last checkpointed thread",
+            thread.id
+        );
+    }
+
     try {
         CheckpointId id = generate_checkpoint_id();
         fs::path cp_path = checkpoint_path(id);
@@ -113,7 +215,7 @@ Result<CheckpointId, Error> Checkpointer::create(
         CheckpointInfo info;
         info.id = id;
         info.session_id = session.id();
-        info.thread_id = thread.id();
+        info.thread_id = thread.id;
         info.timestamp = Clock::now();
         info.parent_id = parent_id.empty() ? std::nullopt : std::make_optional(parent_id);
         info.description = description;
@@ -133,23 +235,64 @@ Result<CheckpointId, Error> Checkpointer::create(
             file << info.to_json().dump(2);
         }
 
-        // Save session state
-        auto session_result = session.save(cp_path / "session.json");
-        if (session_result.is_err()) {
-            return Result<CheckpointId, Error>::err(std::move(session_result).error());
+        // Store the thread as one chunk per message, reusing the hashes of
+        // the last checkpoint of this thread for the messages it already had
+        std::vector<std::string> taken;
+        auto release_taken = [&] {
+            for (const auto& hash : taken) {
+                chunks_.release(hash);
+            }
+        };
+
+        std::vector<std::string> message_hashes;
+        message_hashes.reserve(thread.size);
+        for (size_t i = 0; i < reused; ++i) {
+            chunks_.retain(last_thread_->hashes[i]);
+            taken.push_back(last_thread_->hashes[i]);
+            message_hashes.push_back(last_thread_->hashes[i]);
         }
 
-        // Save thread memory
-        auto thread_result = thread.save(cp_path / "thread.jsonl");
-        if (thread_result.is_err()) {
-            return Result<CheckpointId, Error>::err(std::move(thread_result).error());
+        for (size_t i = reused; i < thread.size; ++i) {
+            auto put = chunks_.put(thread.at(i).to_json().dump());
+            if (put.is_err()) {
+                release_taken();
+                return Result<CheckpointId, Error>::err(std::move(put).error());
+            }
+            taken.push_back(put.value());
+            message_hashes.push_back(std::move(put).value());
         }
 
-        // Save compressed history
-        auto history_result = history.save(cp_path / "history.json");
-        if (history_result.is_err()) {
-            return Result<CheckpointId, Error>::err(std::move(history_result).error());
+        // Save session state and compressed history
+        auto session_put = chunks_.put(session.to_json().dump());
+        if (session_put.is_err()) {
+            release_taken();
+            return Result<CheckpointId, Error>::err(std::move(session_put).error());
         }
+        taken.push_back(session_put.value());
+
+        auto history_put = chunks_.put(history.to_json().dump());
+        if (history_put.is_err()) {
+            release_taken();
+            return Result<CheckpointId, Error>::err(std::move(history_put).error());
+        }
+        taken.push_back(history_put.value());
+
+        // Save manifest
+        Json manifest{
+            {"version", kManifestVersion},
+            {"messages", message_hashes},
+            {"session", session_put.value()},
+            {"history", history_put.value()}
+        };
+        std::string manifest_text = manifest.dump();
+        auto manifest_result = tools::write_file_atomic(manifest_path(id), {manifest_text});
+        if (manifest_result.is_err()) {
+            release_taken();
+            fs::remove_all(cp_path);
+            return Result<CheckpointId, Error>::err(std::move(manifest_result).error());
+        }
+
+        set_last_thread(ThreadChunks{thread.id, thread.revision, std::move(message_hashes)});
 
         // Update index
         index_.push_back(info);
@@ -186,29 +329,60 @@ Result<Checkpoint, Error> Checkpointer::restore(const CheckpointId& id) const {
         }
         cp.info = std::move(info_result).value();
 
-        // Load session state
-        auto session_result = SessionState::load(cp_path / "session.json");
-        if (session_result.is_err()) {
-            return Result<Checkpoint, Error>::err(std::move(session_result).error());
+        // Checkpoints from before the chunk store hold full copies
+        if (!fs::exists(manifest_path(id))) {
+            auto session_result = SessionState::load(cp_path / "session.json");
+            if (session_result.is_err()) {
+                return Result<Checkpoint, Error>::err(std::move(session_result).error());
+            }
+            cp.session_state = std::move(session_result).value();
+
+            auto thread_result = ThreadMemory::load(cp_path / "thread.jsonl");
+            if (thread_result.is_err()) {
+                return Result<Checkpoint, Error>::err(std::move(thread_result).error());
+            }
+            cp.thread_memory = std::move(thread_result).value();
+
+            auto history_result = CompressedHistory::load(cp_path / "history.json");
+            if (history_result.is_err()) {
+                return Result<Checkpoint, Error>::err(std::move(history_result).error());
+            }
+            cp.compressed_history = std::move(history_result).value();
+
+            return Result<Checkpoint, Error>::ok(std::move(cp));
         }
-        cp.session_state = std::move(session_result).value();
+
+        std::ifstream file(manifest_path(id));
+        Json manifest = Json::parse(file);
+
+        auto load_chunk = [&](const std::string& hash) -> Json {
+            auto chunk = chunks_.get(hash);
+            if (!chunk) {
+                throw std::runtime_error("Checkpoint chunk missing: " + hash);
+            }
+            return Json::parse(*chunk);
+        };
+
+        // Load session state
+        cp.session_state = SessionState::from_json(load_chunk(manifest.value("session", "")));
 
         // Load thread memory
-        auto thread_result = ThreadMemory::load(cp_path / "thread.jsonl");
-        if (thread_result.is_err()) {
-            return Result<Checkpoint, Error>::err(std::move(thread_result).error());
+        cp.thread_memory = cp.info.thread_id.empty() ? ThreadMemory() : ThreadMemory(cp.info.thread_id);
+        for (const auto& hash : manifest.value("messages", std::vector<std::string>{})) {
+            cp.thread_memory.append(Message::from_json(load_chunk(hash)));
         }
-        cp.thread_memory = std::move(thread_result).value();
 
         // Load compressed history
-        auto history_result = CompressedHistory::load(cp_path / "history.json");
-        if (history_result.is_err()) {
-            return Result<Checkpoint, Error>::err(std::move(history_result).error());
-        }
-        cp.compressed_history = std::move(history_result).value();
+        cp.compressed_history = CompressedHistory::from_json(load_chunk(manifest.value("history", "")));
 
         return Result<Checkpoint, Error>::ok(std::move(cp));
 
+    } catch (const Json::exception& e) {
+        return Result<Checkpoint, Error>::err(
+            ErrorCode::MemoryCorrupted,
+            std::string("JSON parse error: ") + e.what(),
+            id
+        );
     } catch (const std::exception& e) {
         return Result<Checkpoint, Error>::err(
             ErrorCode::FileReadFailed,
@@ -288,6 +462,14 @@ Result<void, Error> Checkpointer::remove(const CheckpointId& id) {
             );
         }
 
+        // Release the checkpoint's chunks, deleting those no other
+        // checkpoint uses
+        if (auto hashes = manifest_chunks(id)) {
+            for (const auto& hash : *hashes) {
+                chunks_.release(hash);
+            }
+        }
+
         fs::remove_all(cp_path);
 
         // Update index
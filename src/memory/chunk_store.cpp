@@ -0,0 +1,111 @@
+#include "gpagent/memory/chunk_store.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+#include "gpagent/core/sha256.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace gpagent::memory {
+
+namespace {
+
+constexpr size_t kHashLength = 64;
+
+bool valid_hash(const std::string& hash) {
+    return hash.size() == kHashLength &&
+           std::all_of(hash.begin(), hash.end(), [](char c) {
+               return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+           });
+}
+
+}  // namespace
+
+ChunkStore::ChunkStore(const fs::path& dir)
+    : dir_(dir)
+{
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+}
+
+std::string ChunkStore::hash(std::string_view data) {
+    return sha256_hex({data});
+}
+
+fs::path ChunkStore::chunk_path(const std::string& hash) const {
+    return dir_ / hash.substr(0, 2) / hash.substr(2);
+}
+
+Result<std::string, Error> ChunkStore::put(std::string_view data) {
+    std::string h = hash(data);
+
+    auto it = refs_.find(h);
+    if (it != refs_.end()) {
+        ++it->second;
+        return Result<std::string, Error>::ok(std::move(h));
+    }
+
+    fs::path path = chunk_path(h);
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        fs::create_directories(path.parent_path(), ec);
+        auto written = tools::write_file_atomic(path, {data});
+        if (written.is_err()) {
+            return Result<std::string, Error>::err(std::move(written).error());
+        }
+    }
+    refs_[h] = 1;
+    return Result<std::string, Error>::ok(std::move(h));
+}
+
+void ChunkStore::retain(const std::string& hash) {
+    ++refs_[hash];
+}
+
+bool ChunkStore::release(const std::string& hash) {
+    auto it = refs_.find(hash);
+    if (it == refs_.end()) return false;
+    if (--it->second > 0) return false;
+
+    refs_.erase(it);
+    if (!valid_hash(hash)) return false;
+    std::error_code ec;
+    return fs::remove(chunk_path(hash), ec);
+}
+
+std::optional<std::string> ChunkStore::get(const std::string& hash) const {
+    if (!valid_hash(hash)) return std::nullopt;
+    std::ifstream in(chunk_path(hash), std::ios::binary);
+    if (!in) return std::nullopt;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) return std::nullopt;
+    return content;
+}
+
+bool ChunkStore::contains(const std::string& hash) const {
+    std::error_code ec;
+    return valid_hash(hash) && fs::exists(chunk_path(hash), ec);
+}
+
+size_t ChunkStore::sweep() {
+    size_t removed = 0;
+    std::error_code ec;
+    for (fs::directory_iterator prefix(dir_, ec), end; !ec && prefix != end; prefix.increment(ec)) {
+        if (!prefix->is_directory()) continue;
+        std::string head = prefix->path().filename().string();
+
+        std::error_code inner_ec;
+        for (fs::directory_iterator chunk(prefix->path(), inner_ec); !inner_ec && chunk != end;
+             chunk.increment(inner_ec)) {
+            std::string h = head + chunk->path().filename().string();
+            // Temp files of an interrupted write have no valid name either
+            if (refs_.count(h) == 0) {
+                std::error_code remove_ec;
+                if (fs::remove(chunk->path(), remove_ec)) ++removed;
+            }
+        }
+    }
+    return removed;
+}
+
+}  // namespace gpagent::memory
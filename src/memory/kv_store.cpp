@@ -0,0 +1,242 @@
+#include "gpagent/memory/kv_store.hpp"
+
+#include <sqlite3.h>
+
+#include <cctype>
+#include <chrono>
+#include <map>
+
+namespace gpagent::memory {
+
+namespace {
+
+// Steps for SqliteDb::open, in order; only ever append
+constexpr const char* kMigrations[] = {
+    // 1: the key-value table
+    R"(
+CREATE TABLE IF NOT EXISTS kv (
+    id INTEGER PRIMARY KEY,
+    ns TEXT NOT NULL,
+    key TEXT NOT NULL,
+    value TEXT NOT NULL,
+    updated_at INTEGER NOT NULL,
+    UNIQUE (ns, key)
+);
+)",
+    // 2: full-text index over keys and values, kept current by triggers.
+    // JSON strings are indexed unescaped; other JSON as its text.
+    R"(
+CREATE VIRTUAL TABLE kv_fts USING fts5(
+    ns UNINDEXED, key, text, tokenize = 'unicode61 remove_diacritics 2'
+);
+CREATE TRIGGER kv_fts_insert AFTER INSERT ON kv BEGIN
+    INSERT INTO kv_fts (rowid, ns, key, text) VALUES (new.id, new.ns, new.key,
+        CASE WHEN json_valid(new.value) THEN json_extract(new.value, '$') ELSE new.value END);
+END;
+CREATE TRIGGER kv_fts_delete AFTER DELETE ON kv BEGIN
+    DELETE FROM kv_fts WHERE rowid = old.id;
+END;
+CREATE TRIGGER kv_fts_update AFTER UPDATE ON kv BEGIN
+    UPDATE kv_fts SET ns = new.ns, key = new.key,
+        text = CASE WHEN json_valid(new.value) THEN json_extract(new.value, '$') ELSE new.value END
+    WHERE rowid = new.id;
+END;
+INSERT INTO kv_fts (rowid, ns, key, text)
+    SELECT id, ns, key, CASE WHEN json_valid(value) THEN json_extract(value, '$') ELSE value END FROM kv;
+)",
+};
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Smallest string greater than every string with the prefix, or nullopt
+// when there is none (empty or all 0xff)
+std::optional<std::string> prefix_end(std::string prefix) {
+    while (!prefix.empty()) {
+        auto last = static_cast<unsigned char>(prefix.back());
+        if (last < 0xff) {
+            prefix.back() = static_cast<char>(last + 1);
+            return prefix;
+        }
+        prefix.pop_back();
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+Result<std::shared_ptr<KvStore>, Error> KvStore::open(const fs::path& path) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::weak_ptr<KvStore>> registry;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    if (ec) canonical = path;
+
+    std::lock_guard lock(registry_mutex);
+    if (auto existing = registry[canonical.string()].lock()) {
+        return existing;
+    }
+
+    std::shared_ptr<KvStore> store(new KvStore(canonical));
+    if (auto opened = store->open_db(); opened.is_err()) {
+        return opened.error();
+    }
+    registry[canonical.string()] = store;
+    return store;
+}
+
+KvStore::KvStore(fs::path path) : path_(std::move(path)) {}
+
+Result<void, Error> KvStore::open_db() {
+    if (auto opened = db_.open(path_, kMigrations); opened.is_err()) return opened;
+
+    struct {
+        sqlite3_stmt** stmt;
+        const char* sql;
+    } statements[] = {
+        {&put_, "INSERT INTO kv (ns, key, value, updated_at) VALUES (?1, ?2, ?3, ?4) "
+                "ON CONFLICT (ns, key) DO UPDATE SET value = excluded.value, updated_at = excluded.updated_at"},
+        {&get_, "SELECT value FROM kv WHERE ns = ?1 AND key = ?2"},
+        {&remove_, "DELETE FROM kv WHERE ns = ?1 AND key = ?2"},
+        {&scan_, "SELECT key, value, updated_at FROM kv WHERE ns = ?1 AND key >= ?2 "
+                 "AND (?3 IS NULL OR key < ?3) ORDER BY key LIMIT ?4"},
+        {&namespaces_, "SELECT DISTINCT ns FROM kv ORDER BY ns"},
+        // Keys weigh twice as much as values
+        {&search_, "SELECT ns, key, snippet(kv_fts, 2, '[', ']', '...', 24), bm25(kv_fts, 0.0, 2.0, 1.0) AS score "
+                   "FROM kv_fts WHERE kv_fts MATCH ?1 AND (?2 = '' OR ns = ?2) ORDER BY score LIMIT ?3"},
+    };
+    for (const auto& [stmt, sql] : statements) {
+        auto prepared = db_.prepare(sql);
+        if (prepared.is_err()) return std::move(prepared).error();
+        *stmt = prepared.value();
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<void, Error> KvStore::put(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(put_);
+    stmt.bind(1, ns);
+    stmt.bind(2, key);
+    stmt.bind(3, value);
+    stmt.bind(4, now_ms());
+    if (stmt.step() != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemorySaveFailed, "Failed to store " + ns + "/" + key);
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<std::optional<std::string>, Error> KvStore::get(const std::string& ns, const std::string& key) {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(get_);
+    stmt.bind(1, ns);
+    stmt.bind(2, key);
+    int rc = stmt.step();
+    if (rc == SQLITE_ROW) return std::optional<std::string>(stmt.text(0));
+    if (rc == SQLITE_DONE) return std::optional<std::string>();
+    return db_.error(ErrorCode::MemoryLoadFailed, "Failed to read " + ns + "/" + key);
+}
+
+Result<bool, Error> KvStore::remove(const std::string& ns, const std::string& key) {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(remove_);
+    stmt.bind(1, ns);
+    stmt.bind(2, key);
+    if (stmt.step() != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemorySaveFailed, "Failed to delete " + ns + "/" + key);
+    }
+    return db_.changes() > 0;
+}
+
+Result<std::vector<KvStore::Item>, Error> KvStore::scan(const std::string& ns, const std::string& prefix,
+                                                        size_t limit) {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(scan_);
+    stmt.bind(1, ns);
+    stmt.bind(2, prefix);
+    auto end = prefix_end(prefix);
+    if (end) stmt.bind(3, *end);
+    stmt.bind(4, static_cast<int64_t>(std::min<size_t>(limit, INT64_MAX)));
+
+    std::vector<Item> items;
+    int rc;
+    while ((rc = stmt.step()) == SQLITE_ROW) {
+        items.push_back(Item{stmt.text(0), stmt.text(1), stmt.integer(2)});
+    }
+    if (rc != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemoryLoadFailed, "Failed to list " + ns);
+    }
+    return items;
+}
+
+Result<std::vector<std::string>, Error> KvStore::namespaces() {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(namespaces_);
+    std::vector<std::string> names;
+    int rc;
+    while ((rc = stmt.step()) == SQLITE_ROW) {
+        names.push_back(stmt.text(0));
+    }
+    if (rc != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemoryLoadFailed, "Failed to list namespaces");
+    }
+    return names;
+}
+
+std::string KvStore::match_expression(const std::string& query, bool all_terms) {
+    // Words of the query as quoted terms, so FTS5 operators and punctuation
+    // in it are not parsed; words of three or more characters also match as
+    // prefixes (plurals, longer identifiers)
+    std::string expression;
+    std::string word;
+    auto flush = [&] {
+        if (word.empty()) return;
+        if (!expression.empty()) expression += all_terms ? " AND " : " OR ";
+        expression += "\"" + word + "\"";
+        if (word.size() >= 3) expression += "*";
+        word.clear();
+    };
+    for (char c : query) {
+        auto u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || u >= 0x80) {
+            word += c;
+        } else {
+            flush();
+        }
+    }
+    flush();
+    return expression;
+}
+
+Result<std::vector<KvStore::SearchHit>, Error> KvStore::search(const std::string& query, const std::string& ns,
+                                                               size_t limit) {
+    std::lock_guard lock(mutex_);
+
+    // Memories with every word, or failing that any of them; bm25 ranks
+    // those matching more (and rarer) words first
+    std::vector<SearchHit> hits;
+    for (bool all_terms : {true, false}) {
+        std::string expression = match_expression(query, all_terms);
+        if (expression.empty()) break;
+
+        StatementScope stmt(search_);
+        stmt.bind(1, expression);
+        stmt.bind(2, ns);
+        stmt.bind(3, static_cast<int64_t>(std::min<size_t>(limit, INT64_MAX)));
+
+        int rc;
+        while ((rc = stmt.step()) == SQLITE_ROW) {
+            hits.push_back(SearchHit{stmt.text(0), stmt.text(1), stmt.text(2), -stmt.real(3)});
+        }
+        if (rc != SQLITE_DONE) {
+            return db_.error(ErrorCode::MemoryLoadFailed, "Failed to search memories");
+        }
+        if (!hits.empty()) break;
+    }
+    return hits;
+}
+
+}  // namespace gpagent::memory
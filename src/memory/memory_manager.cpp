@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <unordered_set>
 
 namespace gpagent::memory {
 
@@ -12,35 +13,44 @@ namespace gpagent::memory {
 CrossThreadMemory::CrossThreadMemory(const fs::path& storage_path)
     : storage_path_(storage_path)
 {
-    fs::create_directories(storage_path_);
+    auto opened = KvStore::open(memory_db_path(storage_path_));
+    if (opened.is_err()) {
+        open_error_ = opened.error();
+        return;
+    }
+    store_ = std::move(opened).value();
     load();
 }
 
 void CrossThreadMemory::store(const std::string& ns, const std::string& key, const Json& value) {
-    data_[ns][key] = value;
+    if (store_) {
+        store_->put(ns, key, value.dump());
+    }
 }
 
 std::optional<Json> CrossThreadMemory::retrieve(const std::string& ns, const std::string& key) const {
-    auto ns_it = data_.find(ns);
-    if (ns_it == data_.end()) {
+    if (!store_) {
         return std::nullopt;
     }
 
-    auto key_it = ns_it->second.find(key);
-    if (key_it == ns_it->second.end()) {
+    auto value = store_->get(ns, key);
+    if (value.is_err() || !value.value()) {
         return std::nullopt;
     }
 
-    return key_it->second;
+    // Plain text stored before values were JSON
+    Json parsed = Json::parse(*value.value(), nullptr, false);
+    return parsed.is_discarded() ? Json(*value.value()) : parsed;
 }
 
 std::vector<std::string> CrossThreadMemory::list_keys(const std::string& ns) const {
     std::vector<std::string> keys;
 
-    auto ns_it = data_.find(ns);
-    if (ns_it != data_.end()) {
-        for (const auto& [key, _] : ns_it->second) {
-            keys.push_back(key);
+    if (store_) {
+        if (auto items = store_->scan(ns); items.is_ok()) {
+            for (const auto& item : items.value()) {
+                keys.push_back(item.key);
+            }
         }
     }
 
@@ -48,68 +58,54 @@ std::vector<std::string> CrossThreadMemory::list_keys(const std::string& ns) con
 }
 
 void CrossThreadMemory::remove(const std::string& ns, const std::string& key) {
-    auto ns_it = data_.find(ns);
-    if (ns_it != data_.end()) {
-        ns_it->second.erase(key);
+    if (store_) {
+        store_->remove(ns, key);
     }
 }
 
 Result<void, Error> CrossThreadMemory::save() const {
-    try {
-        fs::path path = storage_path_ / "cross_thread.json";
-
-        std::ofstream file(path);
-        if (!file) {
-            return Result<void, Error>::err(
-                ErrorCode::FileWriteFailed,
-                "Failed to save cross-thread memory",
-                path.string()
-            );
-        }
-
-        Json j = Json::object();
-        for (const auto& [ns, entries] : data_) {
-            j[ns] = entries;
-        }
-
-        file << j.dump(2);
-        return Result<void, Error>::ok();
-
-    } catch (const std::exception& e) {
-        return Result<void, Error>::err(
-            ErrorCode::FileWriteFailed,
-            e.what()
-        );
+    if (open_error_) {
+        return *open_error_;
     }
+    return Result<void, Error>::ok();
 }
 
 Result<void, Error> CrossThreadMemory::load() {
-    try {
-        fs::path path = storage_path_ / "cross_thread.json";
+    if (!store_) {
+        return save();
+    }
 
-        if (!fs::exists(path)) {
-            return Result<void, Error>::ok();
-        }
+    fs::path path = storage_path_ / "cross_thread" / "cross_thread.json";
+    if (!fs::exists(path)) {
+        return Result<void, Error>::ok();
+    }
 
+    try {
         std::ifstream file(path);
-        if (!file) {
-            return Result<void, Error>::ok();
-        }
-
         Json j = Json::parse(file);
-        data_.clear();
 
-        for (auto& [ns, entries] : j.items()) {
-            for (auto& [key, value] : entries.items()) {
-                data_[ns][key] = value;
+        auto imported = store_->batch([&](KvStore& store) {
+            for (auto& [ns, entries] : j.items()) {
+                for (auto& [key, value] : entries.items()) {
+                    if (store.put(ns, key, value.dump()).is_err()) return false;
+                }
             }
+            return true;
+        });
+        if (imported.is_err()) {
+            return imported;
         }
 
+        file.close();
+        fs::rename(path, fs::path(path) += ".imported");
         return Result<void, Error>::ok();
 
-    } catch (const std::exception&) {
-        data_.clear();
-        return Result<void, Error>::ok();
+    } catch (const std::exception& e) {
+        return Result<void, Error>::err(
+            ErrorCode::MemoryLoadFailed,
+            e.what(),
+            path.string()
+        );
     }
 }
 
@@ -120,15 +116,20 @@ MemoryManager::MemoryManager(const MemoryConfig& config)
 {
     ensure_directories();
 
-    cross_thread_ = std::make_unique<CrossThreadMemory>(storage_path_ / "cross_thread");
+    cross_thread_ = std::make_unique<CrossThreadMemory>(storage_path_);
     episodic_ = std::make_unique<EpisodicMemory>(storage_path_ / "episodic");
     checkpointer_ = std::make_unique<Checkpointer>(storage_path_ / "checkpoints");
+    checkpoint_writer_ = std::make_unique<CheckpointWriter>(*checkpointer_);
+
+    if (auto opened = SessionCatalog::open(session_catalog_path(storage_path_)); opened.is_ok()) {
+        catalog_ = std::move(opened).value();
+        reconcile_catalog();
+    }
 }
 
 void MemoryManager::ensure_directories() {
     fs::create_directories(storage_path_);
     fs::create_directories(storage_path_ / "sessions");
-    fs::create_directories(storage_path_ / "cross_thread");
     fs::create_directories(storage_path_ / "episodic");
     fs::create_directories(storage_path_ / "checkpoints");
 }
@@ -145,6 +146,34 @@ fs::path MemoryManager::project_memory_path() const {
     return storage_path_ / "project_memory.md";
 }
 
+std::optional<ThreadMemory> MemoryManager::open_journal(const SessionId& id) {
+    // The previous session's journal flushes as it closes
+    journal_.reset();
+    snapshot_needed_ = false;
+
+    auto opened = MessageJournal::open(session_path(id));
+    if (opened.is_err()) {
+        return std::nullopt;
+    }
+    auto recovery = std::move(opened).value();
+    journal_ = std::move(recovery.journal);
+    return std::move(recovery.thread);
+}
+
+Result<void, Error> MemoryManager::compact_journal() {
+    auto result = journal_->snapshot(*thread_memory_);
+    snapshot_needed_ = result.is_err();
+    if (result.is_ok()) {
+        journaled_revision_ = thread_memory_->revision();
+    }
+    return result;
+}
+
+void MemoryManager::reset_transcript_meta() {
+    transcript_meta_ = thread_memory_ ? TranscriptMeta::of(*thread_memory_) : TranscriptMeta{};
+    meta_revision_ = thread_memory_ ? thread_memory_->revision() : 0;
+}
+
 Result<void, Error> MemoryManager::start_session(const SessionId& id) {
     current_session_id_ = id;
     session_state_.emplace(id);
@@ -154,6 +183,15 @@ Result<void, Error> MemoryManager::start_session(const SessionId& id) {
     // Create session directory
     fs::create_directories(session_path(id));
 
+    // A new session starts with an empty thread whatever the directory held
+    auto recovered = open_journal(id);
+    journaled_revision_ = thread_memory_->revision();
+    if (journal_ && recovered && !recovered->empty()) {
+        compact_journal();
+    }
+    reset_transcript_meta();
+    update_catalog();
+
     return Result<void, Error>::ok();
 }
 
@@ -175,13 +213,16 @@ Result<void, Error> MemoryManager::resume_session(const SessionId& id) {
     }
     session_state_ = std::move(state_result).value();
 
-    // Load thread memory
-    auto thread_result = ThreadMemory::load(sess_path / "thread.jsonl");
-    if (thread_result.is_ok()) {
+    // Load thread memory: the snapshot plus the journal's messages
+    if (auto recovered = open_journal(id)) {
+        thread_memory_ = std::move(*recovered);
+    } else if (auto thread_result = ThreadMemory::load(sess_path / "thread.jsonl"); thread_result.is_ok()) {
         thread_memory_ = std::move(thread_result).value();
     } else {
         thread_memory_.emplace(generate_thread_id());
     }
+    journaled_revision_ = thread_memory_->revision();
+    reset_transcript_meta();
 
     // Load compressed history
     auto history_result = CompressedHistory::load(sess_path / "history.json");
@@ -203,6 +244,7 @@ Result<void, Error> MemoryManager::end_session() {
     // Save everything
     auto save_result = save_all();
 
+    journal_.reset();
     current_session_id_ = std::nullopt;
     session_state_ = std::nullopt;
     thread_memory_ = std::nullopt;
@@ -221,6 +263,51 @@ const SessionId& MemoryManager::current_session_id() const {
 }
 
 std::vector<MemoryManager::SessionInfo> MemoryManager::list_sessions() const {
+    return list_sessions(SessionCatalog::Query{});
+}
+
+std::vector<MemoryManager::SessionInfo> MemoryManager::list_sessions(const SessionCatalog::Query& query) const {
+    if (catalog_) {
+        if (auto entries = catalog_->list(query); entries.is_ok()) {
+            std::vector<SessionInfo> sessions;
+            sessions.reserve(entries.value().size());
+            for (auto& entry : entries.value()) {
+                sessions.push_back(SessionInfo{std::move(entry.id), entry.created_at, entry.updated_at,
+                                               std::move(entry.preview), entry.message_count, entry.tokens});
+            }
+            return sessions;
+        }
+    }
+
+    auto sessions = scan_sessions();
+    auto key = [&](const SessionInfo& info) {
+        switch (query.sort) {
+            case SessionCatalog::SortKey::CreatedAt: return info.created_at.time_since_epoch().count();
+            case SessionCatalog::SortKey::MessageCount: return static_cast<Clock::rep>(info.message_count);
+            case SessionCatalog::SortKey::UpdatedAt: break;
+        }
+        return info.updated_at.time_since_epoch().count();
+    };
+    std::sort(sessions.begin(), sessions.end(),
+              [&](const SessionInfo& a, const SessionInfo& b) {
+                  return query.descending ? key(a) > key(b) : key(a) < key(b);
+              });
+
+    size_t begin = std::min(query.offset, sessions.size());
+    size_t end = begin + std::min(query.limit, sessions.size() - begin);
+    return {std::make_move_iterator(sessions.begin() + begin), std::make_move_iterator(sessions.begin() + end)};
+}
+
+size_t MemoryManager::session_count() const {
+    if (catalog_) {
+        if (auto count = catalog_->count(); count.is_ok()) {
+            return count.value();
+        }
+    }
+    return scan_sessions().size();
+}
+
+std::vector<MemoryManager::SessionInfo> MemoryManager::scan_sessions() const {
     std::vector<SessionInfo> sessions;
 
     fs::path sessions_dir = storage_path_ / "sessions";
@@ -229,52 +316,92 @@ std::vector<MemoryManager::SessionInfo> MemoryManager::list_sessions() const {
     }
 
     for (const auto& entry : fs::directory_iterator(sessions_dir)) {
-        if (!entry.is_directory()) continue;
-
-        SessionInfo info;
-        info.id = entry.path().filename().string();
-
-        // Try to load state.json for metadata
-        fs::path state_path = entry.path() / "state.json";
-        if (fs::exists(state_path)) {
-            auto state_result = SessionState::load(state_path);
-            if (state_result.is_ok()) {
-                auto& state = state_result.value();
-                info.created_at = state.created_at();
-                info.updated_at = state.updated_at();
-            }
+        if (entry.is_directory()) {
+            sessions.push_back(scan_session(entry.path()));
         }
+    }
 
-        // Try to load thread.jsonl for first message preview
-        fs::path thread_path = entry.path() / "thread.jsonl";
-        if (fs::exists(thread_path)) {
-            auto thread_result = ThreadMemory::load(thread_path);
-            if (thread_result.is_ok()) {
-                auto& thread = thread_result.value();
-                auto messages = thread.messages();
-                for (const auto& msg : messages) {
-                    if (msg.role == core::Role::User && !msg.content.empty()) {
-                        // Truncate preview to 50 chars
-                        info.preview = msg.content.substr(0, std::min(size_t(50), msg.content.size()));
-                        if (msg.content.size() > 50) {
-                            info.preview += "...";
-                        }
-                        break;
-                    }
-                }
-            }
+    return sessions;
+}
+
+MemoryManager::SessionInfo MemoryManager::scan_session(const fs::path& dir) const {
+    SessionInfo info;
+    info.id = dir.filename().string();
+
+    // Try to load state.json for metadata
+    fs::path state_path = dir / "state.json";
+    if (fs::exists(state_path)) {
+        auto state_result = SessionState::load(state_path);
+        if (state_result.is_ok()) {
+            auto& state = state_result.value();
+            info.created_at = state.created_at();
+            info.updated_at = state.updated_at();
         }
+    }
 
-        sessions.push_back(std::move(info));
+    // Preview and counts come from the thread's side-car metadata. A
+    // session saved before it existed has its thread read once to
+    // write one.
+    fs::path meta_path = dir / TranscriptMeta::kFile;
+    auto meta_result = TranscriptMeta::load(meta_path);
+    if (meta_result.is_err()) {
+        if (auto thread_result = MessageJournal::read(dir); thread_result.is_ok()) {
+            auto meta = TranscriptMeta::of(thread_result.value());
+            meta.save(meta_path);
+            meta_result = Result<TranscriptMeta, Error>::ok(std::move(meta));
+        }
+    }
+    if (meta_result.is_ok()) {
+        const auto& meta = meta_result.value();
+        info.preview = meta.preview;
+        info.message_count = meta.message_count;
+        info.tokens = meta.tokens;
     }
 
-    // Sort by updated_at descending (most recent first)
-    std::sort(sessions.begin(), sessions.end(),
-              [](const SessionInfo& a, const SessionInfo& b) {
-                  return a.updated_at > b.updated_at;
-              });
+    return info;
+}
 
-    return sessions;
+// Sessions saved by this process update their entry as they go; sessions
+// written without the catalog (an older build, a copied-in directory) or
+// deleted by hand are picked up here. Only those are read in full.
+void MemoryManager::reconcile_catalog() {
+    auto listed = catalog_->list();
+    if (listed.is_err()) {
+        return;
+    }
+    std::unordered_set<SessionId> stale;
+    for (auto& entry : listed.value()) {
+        stale.insert(std::move(entry.id));
+    }
+
+    std::error_code ec;
+    fs::directory_iterator sessions_dir(storage_path_ / "sessions", ec);
+    if (ec) {
+        return;
+    }
+
+    std::vector<SessionCatalog::Entry> added;
+    for (const auto& entry : sessions_dir) {
+        if (!entry.is_directory() || stale.erase(entry.path().filename().string()) > 0) continue;
+        auto info = scan_session(entry.path());
+        added.push_back(SessionCatalog::Entry{std::move(info.id), info.created_at, info.updated_at,
+                                              std::move(info.preview), info.message_count, info.tokens});
+    }
+    if (!added.empty()) {
+        catalog_->put_all(added);
+    }
+    for (const auto& id : stale) {
+        catalog_->remove(id);
+    }
+}
+
+void MemoryManager::update_catalog() {
+    if (!catalog_ || !current_session_id_ || !session_state_) {
+        return;
+    }
+    catalog_->put(SessionCatalog::Entry{*current_session_id_, session_state_->created_at(),
+                                        session_state_->updated_at(), transcript_meta_.preview,
+                                        transcript_meta_.message_count, transcript_meta_.tokens});
 }
 
 SessionState& MemoryManager::session_state() {
@@ -323,6 +450,17 @@ void MemoryManager::append_message(const Message& message) {
     if (!thread_memory_) return;
 
     thread_memory_->append(message);
+    if (meta_revision_ == thread_memory_->revision()) {
+        transcript_meta_.add(message);
+    }
+
+    if (journal_) {
+        // A failed append is made up for by a snapshot, now or at save_all
+        auto journaled = journal_->append(message);
+        if (journaled.is_err() || journal_->wants_snapshot()) {
+            compact_journal();
+        }
+    }
 
     if (session_state_) {
         session_state_->increment_turn();
@@ -330,7 +468,7 @@ void MemoryManager::append_message(const Message& message) {
         // Auto-checkpoint if enabled
         if (config_.auto_checkpoint &&
             session_state_->conversation_turn() % config_.checkpoint_interval == 0) {
-            create_checkpoint("auto");
+            submit_auto_checkpoint();
         }
     }
 }
@@ -348,7 +486,6 @@ std::string MemoryManager::get_compressed_history() const {
 void MemoryManager::store_fact(const std::string& ns, const std::string& key, const Json& value) {
     if (cross_thread_) {
         cross_thread_->store(ns, key, value);
-        cross_thread_->save();
     }
 }
 
@@ -379,6 +516,37 @@ size_t MemoryManager::successful_episode_count() const {
     return episodic_->count_successful();
 }
 
+void MemoryManager::submit_auto_checkpoint() {
+    if (!session_state_ || !thread_memory_ || !compressed_history_ || !checkpoint_writer_) {
+        return;
+    }
+
+    // Copy what the writer needs now, so the thread can move on: the
+    // messages since the last checkpoint when they extend it, the whole
+    // thread otherwise (a new session, a trim, a restore or a failed write)
+    const ThreadMemory& thread = *thread_memory_;
+    CheckpointWriter::Job job{*session_state_, *compressed_history_, std::nullopt, {}, "auto", "auto"};
+
+    bool extends = checkpointed_thread_ &&
+                   checkpointed_thread_->thread_id == thread.id() &&
+                   checkpointed_thread_->revision == thread.revision() &&
+                   checkpointed_thread_->size <= thread.size() &&
+                   !checkpoint_writer_->needs_full_thread();
+    if (extends) {
+        const auto& messages = thread.messages();
+        job.delta.thread_id = thread.id();
+        job.delta.revision = thread.revision();
+        job.delta.base = checkpointed_thread_->size;
+        job.delta.messages.assign(messages.begin() + checkpointed_thread_->size, messages.end());
+    } else {
+        job.full_thread = thread;
+    }
+    checkpointed_thread_ = CheckpointedThread{thread.id(), thread.revision(), thread.size()};
+
+    // Blocks only while earlier checkpoints are still being written
+    checkpoint_writer_->submit(std::move(job));
+}
+
 Result<CheckpointId, Error> MemoryManager::create_checkpoint(const std::string& description) {
     if (!session_state_ || !thread_memory_ || !compressed_history_ || !checkpointer_) {
         return Result<CheckpointId, Error>::err(
@@ -387,7 +555,14 @@ Result<CheckpointId, Error> MemoryManager::create_checkpoint(const std::string&
         );
     }
 
-    return checkpointer_->create(*session_state_, *thread_memory_, *compressed_history_, description, "manual");
+    // The checkpointer is the writer's until its queue drains
+    checkpoint_writer_->flush();
+
+    auto result = checkpointer_->create(*session_state_, *thread_memory_, *compressed_history_, description, "manual");
+    if (result.is_ok()) {
+        checkpointed_thread_ = CheckpointedThread{thread_memory_->id(), thread_memory_->revision(), thread_memory_->size()};
+    }
+    return result;
 }
 
 Result<void, Error> MemoryManager::restore_checkpoint(const CheckpointId& id) {
@@ -395,6 +570,8 @@ Result<void, Error> MemoryManager::restore_checkpoint(const CheckpointId& id) {
         return Result<void, Error>::err(ErrorCode::InternalError, "Checkpointer not initialized");
     }
 
+    checkpoint_writer_->flush();
+
     auto result = checkpointer_->restore(id);
     if (result.is_err()) {
         return Result<void, Error>::err(std::move(result).error());
@@ -406,14 +583,36 @@ Result<void, Error> MemoryManager::restore_checkpoint(const CheckpointId& id) {
     compressed_history_ = std::move(checkpoint.compressed_history);
     current_session_id_ = checkpoint.info.session_id;
 
+    // The journal cannot express going back: restart it from the restored thread
+    open_journal(*current_session_id_);
+    if (journal_) {
+        auto compacted = compact_journal();
+        if (compacted.is_err()) {
+            return compacted;
+        }
+    }
+    journaled_revision_ = thread_memory_->revision();
+    reset_transcript_meta();
+
     return Result<void, Error>::ok();
 }
 
 std::vector<CheckpointInfo> MemoryManager::list_checkpoints() const {
     if (!checkpointer_ || !current_session_id_) return {};
+    checkpoint_writer_->flush();
     return checkpointer_->list(*current_session_id_);
 }
 
+Checkpointer& MemoryManager::checkpointer() {
+    checkpoint_writer_->flush();
+    return *checkpointer_;
+}
+
+const Checkpointer& MemoryManager::checkpointer() const {
+    checkpoint_writer_->flush();
+    return *checkpointer_;
+}
+
 std::string MemoryManager::get_user_memory() const {
     fs::path path = user_memory_path();
     if (!fs::exists(path)) return "";
@@ -459,6 +658,10 @@ Result<void, Error> MemoryManager::save_all() {
 
     fs::path sess_path = session_path(*current_session_id_);
 
+    // Wait for queued auto checkpoints. Like the synchronous ones before
+    // them they are best effort, and a failure does not fail the save.
+    checkpoint_writer_->flush();
+
     // Save session state
     if (session_state_) {
         auto result = session_state_->save(sess_path / "state.json");
@@ -467,14 +670,36 @@ Result<void, Error> MemoryManager::save_all() {
         }
     }
 
-    // Save thread memory
-    if (thread_memory_) {
+    // Save thread memory: appends are already journaled, so this only
+    // flushes them, unless a trim or a failed append needs a snapshot
+    if (thread_memory_ && journal_) {
+        bool snapshot = snapshot_needed_ || thread_memory_->revision() != journaled_revision_;
+        auto result = snapshot ? compact_journal() : journal_->sync();
+        if (result.is_err()) {
+            return result;
+        }
+    } else if (thread_memory_) {
         auto result = thread_memory_->save(sess_path / "thread.jsonl");
         if (result.is_err()) {
             return result;
         }
     }
 
+    // Save the thread's side-car metadata for the session list
+    if (thread_memory_) {
+        if (meta_revision_ != thread_memory_->revision()) {
+            reset_transcript_meta();
+        }
+        auto result = transcript_meta_.save(sess_path / TranscriptMeta::kFile);
+        if (result.is_err()) {
+            return result;
+        }
+    }
+
+    // Keep the session list current; the catalog can be rebuilt from the
+    // side-cars, so a failure here does not fail the save
+    update_catalog();
+
     // Save compressed history
     if (compressed_history_) {
         auto result = compressed_history_->save(sess_path / "history.json");
@@ -0,0 +1,378 @@
+#include "gpagent/memory/message_journal.hpp"
+#include "gpagent/memory/transcript.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace gpagent::memory {
+
+namespace {
+
+// Journal header: magic, then the size and tag of the snapshot its records
+// extend: the transcript's id, or the CRC of a thread.jsonl from before
+// transcripts. A snapshot rewritten without the journal being reset (a
+// crash in between) no longer matches, and the journal's records, already
+// part of the snapshot, are dropped instead of being applied twice.
+constexpr char kMagic[8] = {'G', 'P', 'W', 'A', 'L', '\0', '\0', '\1'};
+constexpr size_t kHeaderSize = 24;
+
+// Record: payload length and CRC, then the message as JSON. Integers are in
+// native byte order; journals never leave the machine that wrote them.
+constexpr size_t kRecordHeaderSize = 8;
+constexpr uint32_t kMaxRecordSize = 1u << 30;
+
+constexpr std::array<uint32_t, 256> kCrcTable = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+uint32_t crc32(std::string_view data) {
+    uint32_t c = 0xFFFFFFFFu;
+    for (unsigned char byte : data) {
+        c = kCrcTable[(c ^ byte) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+std::string journal_header(uint64_t snapshot_size, uint64_t snapshot_tag) {
+    std::string header(kMagic, sizeof(kMagic));
+    put<uint64_t>(header, snapshot_size);
+    put<uint64_t>(header, snapshot_tag);
+    return header;
+}
+
+std::optional<std::string> read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) return std::nullopt;
+    return content;
+}
+
+bool parse_message(std::string_view text, ThreadMemory& thread) {
+    try {
+        thread.append(Message::from_json(Json::parse(text)));
+        return true;
+    } catch (const Json::exception&) {
+        return false;
+    }
+}
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+int flush_fd(int fd) {
+#ifdef __linux__
+    return ::fdatasync(fd);
+#else
+    return ::fsync(fd);
+#endif
+}
+
+struct Replay {
+    ThreadMemory thread;
+    bool found = false;          // snapshot or journal exists
+    uint64_t snapshot_size = 0;
+    uint64_t snapshot_tag = 0;
+    bool journal_valid = false;  // header present and extends this snapshot
+    uint64_t journal_size = 0;
+    uint64_t good_end = 0;       // end of the last intact record
+    size_t replayed = 0;
+};
+
+Replay replay(const fs::path& dir) {
+    Replay r;
+
+    std::error_code ec;
+    fs::path transcript_path = dir / MessageJournal::kSnapshotFile;
+    auto transcript = Transcript::open(transcript_path);
+    auto thread = transcript.is_ok() ? transcript.value().read_all()
+                                     : Result<ThreadMemory, Error>::err(std::move(transcript).error());
+    if (thread.is_ok()) {
+        r.found = true;
+        r.snapshot_size = fs::file_size(transcript_path, ec);
+        r.snapshot_tag = transcript.value().id();
+        r.thread = std::move(thread).value();
+    } else if (auto snapshot = read_file(dir / MessageJournal::kLegacySnapshotFile)) {
+        r.found = true;
+        r.snapshot_size = snapshot->size();
+        r.snapshot_tag = crc32(*snapshot);
+
+        // Unparseable lines are skipped, as ThreadMemory::load does
+        std::string_view rest(*snapshot);
+        while (!rest.empty()) {
+            size_t eol = rest.find('\n');
+            std::string_view line = rest.substr(0, eol);
+            rest = eol == std::string_view::npos ? std::string_view() : rest.substr(eol + 1);
+            if (!line.empty()) parse_message(line, r.thread);
+        }
+    }
+
+    auto journal = read_file(dir / MessageJournal::kJournalFile);
+    if (!journal) return r;
+    r.found = true;
+    r.journal_size = journal->size();
+
+    std::string_view data(*journal);
+    r.journal_valid = data.size() >= kHeaderSize &&
+                      data.substr(0, sizeof(kMagic)) == std::string_view(kMagic, sizeof(kMagic)) &&
+                      get<uint64_t>(data.data() + 8) == r.snapshot_size &&
+                      get<uint64_t>(data.data() + 16) == r.snapshot_tag;
+    if (!r.journal_valid) return r;
+
+    // Stop at the first record that is cut short or fails its checksum:
+    // nothing after a torn write can be trusted
+    size_t offset = kHeaderSize;
+    while (data.size() - offset >= kRecordHeaderSize) {
+        uint32_t length = get<uint32_t>(data.data() + offset);
+        uint32_t crc = get<uint32_t>(data.data() + offset + 4);
+        if (length > kMaxRecordSize || data.size() - offset - kRecordHeaderSize < length) break;
+        std::string_view payload = data.substr(offset + kRecordHeaderSize, length);
+        if (crc32(payload) != crc || !parse_message(payload, r.thread)) break;
+        offset += kRecordHeaderSize + length;
+        ++r.replayed;
+    }
+    r.good_end = offset;
+    return r;
+}
+
+}  // namespace
+
+Result<MessageJournal::Recovery, Error> MessageJournal::open(const fs::path& dir, const Options& options) {
+    using R = Result<Recovery, Error>;
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        return R::err(ErrorCode::MemoryLoadFailed, ec.message(), dir.string());
+    }
+
+    Replay r = replay(dir);
+    fs::path journal_path = dir / kJournalFile;
+
+    Recovery recovery;
+    if (!r.journal_valid) {
+        // New session, a thread.jsonl from before journaling, or a journal
+        // already folded into the snapshot: start an empty one on top of it
+        auto written = tools::write_file_atomic(journal_path, {journal_header(r.snapshot_size, r.snapshot_tag)});
+        if (written.is_err()) {
+            return R::err(std::move(written).error());
+        }
+        r.good_end = kHeaderSize;
+    } else if (r.good_end < r.journal_size) {
+        if (::truncate(journal_path.c_str(), static_cast<off_t>(r.good_end)) != 0) {
+            return R::err(ErrorCode::MemoryLoadFailed, std::strerror(errno), journal_path.string());
+        }
+        recovery.discarded_bytes = r.journal_size - r.good_end;
+    }
+
+    int fd = ::open(journal_path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) {
+        return R::err(ErrorCode::MemoryLoadFailed, std::strerror(errno), journal_path.string());
+    }
+
+    recovery.journal.reset(new MessageJournal(dir, options, fd, r.good_end));
+    recovery.thread = std::move(r.thread);
+    recovery.replayed = r.replayed;
+    return R::ok(std::move(recovery));
+}
+
+Result<ThreadMemory, Error> MessageJournal::read(const fs::path& dir) {
+    Replay r = replay(dir);
+    if (!r.found) {
+        return Result<ThreadMemory, Error>::err(ErrorCode::FileNotFound, "Thread memory file not found",
+                                                (dir / kSnapshotFile).string());
+    }
+    return Result<ThreadMemory, Error>::ok(std::move(r.thread));
+}
+
+MessageJournal::MessageJournal(fs::path dir, const Options& options, int fd, uint64_t journal_bytes)
+    : dir_(std::move(dir)), options_(options), fd_(fd), journal_bytes_(journal_bytes) {
+    flusher_ = std::thread([this] { run(); });
+}
+
+MessageJournal::~MessageJournal() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+
+    sync();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void MessageJournal::run() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || appended_ > synced_; });
+        if (stopping_) return;
+
+        // Let the rest of the turn's appends join this flush
+        cv_.wait_for(lock, options_.commit_interval, [this] { return stopping_; });
+        if (stopping_) return;
+
+        lock.unlock();
+        sync();
+        lock.lock();
+    }
+}
+
+Result<void, Error> MessageJournal::append(const Message& message) {
+    std::string payload = message.to_json().dump();
+    if (payload.size() > kMaxRecordSize) {
+        return Result<void, Error>::err(ErrorCode::MemorySaveFailed, "Message too large to journal",
+                                        (dir_ / kJournalFile).string());
+    }
+
+    std::string record;
+    record.reserve(kRecordHeaderSize + payload.size());
+    put<uint32_t>(record, static_cast<uint32_t>(payload.size()));
+    put<uint32_t>(record, crc32(payload));
+    record += payload;
+
+    {
+        std::lock_guard lock(mutex_);
+        if (fd_ < 0) {
+            return Result<void, Error>::err(ErrorCode::MemorySaveFailed, "Journal unavailable until the next snapshot",
+                                            (dir_ / kJournalFile).string());
+        }
+        if (!write_all(fd_, record)) {
+            int saved_errno = errno;
+            // Drop a partial record so that later ones stay reachable
+            if (::ftruncate(fd_, static_cast<off_t>(journal_bytes_)) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+            return Result<void, Error>::err(ErrorCode::MemorySaveFailed, std::strerror(saved_errno),
+                                            (dir_ / kJournalFile).string());
+        }
+        journal_bytes_ += record.size();
+        ++appended_;
+    }
+    cv_.notify_one();
+    return Result<void, Error>::ok();
+}
+
+Result<void, Error> MessageJournal::sync() {
+    std::lock_guard sync_lock(sync_mutex_);
+
+    int fd;
+    uint64_t target;
+    {
+        std::lock_guard lock(mutex_);
+        fd = fd_;
+        target = appended_;
+        if (target == synced_ || fd < 0) {
+            // Report a failed background flush once
+            auto error = std::exchange(sync_error_, std::nullopt);
+            if (error) return *error;
+            return Result<void, Error>::ok();
+        }
+    }
+
+    // The fd stays open while sync_mutex_ is held: snapshot() swaps it under it
+    int rc = flush_fd(fd);
+    int saved_errno = errno;
+
+    std::lock_guard lock(mutex_);
+    // Not retried: the background flush would otherwise spin on a bad disk
+    synced_ = std::max(synced_, target);
+    if (rc != 0) {
+        sync_error_ = Error{ErrorCode::MemorySaveFailed, std::strerror(saved_errno), (dir_ / kJournalFile).string()};
+    }
+    auto error = std::exchange(sync_error_, std::nullopt);
+    if (error) return *error;
+    return Result<void, Error>::ok();
+}
+
+Result<void, Error> MessageJournal::snapshot(const ThreadMemory& thread) {
+    std::lock_guard sync_lock(sync_mutex_);
+
+    // Snapshot first: until the journal is reset its header names the old
+    // snapshot, so a crash in between drops records the new one already has
+    fs::path transcript_path = dir_ / kSnapshotFile;
+    auto written = Transcript::write(transcript_path, thread);
+    if (written.is_err()) {
+        return Result<void, Error>::err(std::move(written).error());
+    }
+    std::error_code ec;
+    uint64_t snapshot_size = fs::file_size(transcript_path, ec);
+
+    fs::path journal_path = dir_ / kJournalFile;
+    auto reset = tools::write_file_atomic(journal_path, {journal_header(snapshot_size, written.value())});
+    if (reset.is_ok()) {
+        // The transcript supersedes a thread.jsonl from before it
+        fs::remove(dir_ / kLegacySnapshotFile, ec);
+    }
+    int fd = reset.is_ok() ? ::open(journal_path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC) : -1;
+    int saved_errno = errno;
+
+    std::lock_guard lock(mutex_);
+    if (fd_ >= 0) ::close(fd_);
+    // On failure the old journal no longer extends the snapshot: appending
+    // to it would be lost, so appends fail until a snapshot succeeds
+    fd_ = fd;
+    journal_bytes_ = kHeaderSize;
+    synced_ = appended_;
+    if (reset.is_err()) {
+        return reset;
+    }
+    if (fd < 0) {
+        return Result<void, Error>::err(ErrorCode::MemorySaveFailed, std::strerror(saved_errno), journal_path.string());
+    }
+    return Result<void, Error>::ok();
+}
+
+bool MessageJournal::wants_snapshot() const {
+    std::lock_guard lock(mutex_);
+    return journal_bytes_ >= options_.snapshot_bytes;
+}
+
+uint64_t MessageJournal::journal_bytes() const {
+    std::lock_guard lock(mutex_);
+    return journal_bytes_;
+}
+
+}  // namespace gpagent::memory
@@ -0,0 +1,178 @@
+#include "gpagent/memory/session_catalog.hpp"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace gpagent::memory {
+
+namespace {
+
+// Steps for SqliteDb::open, in order; only ever append
+constexpr const char* kMigrations[] = {
+    // 1: the catalog, indexed for each sort order
+    R"(
+CREATE TABLE IF NOT EXISTS sessions (
+    id TEXT PRIMARY KEY,
+    created_at INTEGER NOT NULL,
+    updated_at INTEGER NOT NULL,
+    preview TEXT NOT NULL,
+    message_count INTEGER NOT NULL,
+    tokens INTEGER NOT NULL
+);
+CREATE INDEX IF NOT EXISTS sessions_updated ON sessions (updated_at, id);
+CREATE INDEX IF NOT EXISTS sessions_created ON sessions (created_at, id);
+CREATE INDEX IF NOT EXISTS sessions_messages ON sessions (message_count, id);
+)",
+};
+
+int64_t to_ms(TimePoint t) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+TimePoint from_ms(int64_t ms) {
+    return TimePoint{std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds{ms})};
+}
+
+const char* sort_column(SessionCatalog::SortKey key) {
+    switch (key) {
+        case SessionCatalog::SortKey::UpdatedAt: return "updated_at";
+        case SessionCatalog::SortKey::CreatedAt: return "created_at";
+        case SessionCatalog::SortKey::MessageCount: return "message_count";
+    }
+    return "updated_at";
+}
+
+}  // namespace
+
+Result<std::unique_ptr<SessionCatalog>, Error> SessionCatalog::open(const fs::path& path) {
+    std::unique_ptr<SessionCatalog> catalog(new SessionCatalog(path));
+    if (auto opened = catalog->open_db(); opened.is_err()) {
+        return opened.error();
+    }
+    return catalog;
+}
+
+SessionCatalog::SessionCatalog(fs::path path) : path_(std::move(path)) {}
+
+Result<void, Error> SessionCatalog::open_db() {
+    if (auto opened = db_.open(path_, kMigrations); opened.is_err()) return opened;
+
+    struct {
+        sqlite3_stmt** stmt;
+        const char* sql;
+    } statements[] = {
+        {&put_, "INSERT INTO sessions (id, created_at, updated_at, preview, message_count, tokens) "
+                "VALUES (?1, ?2, ?3, ?4, ?5, ?6) "
+                "ON CONFLICT (id) DO UPDATE SET created_at = excluded.created_at, "
+                "updated_at = excluded.updated_at, preview = excluded.preview, "
+                "message_count = excluded.message_count, tokens = excluded.tokens"},
+        {&remove_, "DELETE FROM sessions WHERE id = ?1"},
+        {&count_, "SELECT COUNT(*) FROM sessions"},
+    };
+    for (const auto& [stmt, sql] : statements) {
+        auto prepared = db_.prepare(sql);
+        if (prepared.is_err()) return std::move(prepared).error();
+        *stmt = prepared.value();
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<void, Error> SessionCatalog::put_locked(const Entry& entry) {
+    StatementScope stmt(put_);
+    stmt.bind(1, entry.id);
+    stmt.bind(2, to_ms(entry.created_at));
+    stmt.bind(3, to_ms(entry.updated_at));
+    stmt.bind(4, entry.preview);
+    stmt.bind(5, static_cast<int64_t>(entry.message_count));
+    stmt.bind(6, static_cast<int64_t>(entry.tokens));
+    if (stmt.step() != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemorySaveFailed, "Failed to catalog session " + entry.id);
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<void, Error> SessionCatalog::put(const Entry& entry) {
+    std::lock_guard lock(mutex_);
+    return put_locked(entry);
+}
+
+Result<void, Error> SessionCatalog::put_all(const std::vector<Entry>& entries) {
+    std::lock_guard lock(mutex_);
+    if (auto begun = db_.exec("BEGIN IMMEDIATE"); begun.is_err()) return begun;
+    for (const auto& entry : entries) {
+        if (auto done = put_locked(entry); done.is_err()) {
+            db_.exec("ROLLBACK");
+            return done;
+        }
+    }
+    auto committed = db_.exec("COMMIT");
+    if (committed.is_err()) db_.exec("ROLLBACK");
+    return committed;
+}
+
+Result<bool, Error> SessionCatalog::remove(const SessionId& id) {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(remove_);
+    stmt.bind(1, id);
+    if (stmt.step() != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemorySaveFailed, "Failed to remove session " + id);
+    }
+    return db_.changes() > 0;
+}
+
+Result<sqlite3_stmt*, Error> SessionCatalog::list_statement(const Query& query) {
+    size_t slot = static_cast<size_t>(query.sort) * 2 + (query.descending ? 1 : 0);
+    if (!list_[slot]) {
+        // The id breaks ties, so pages neither repeat nor skip sessions
+        const char* direction = query.descending ? "DESC" : "ASC";
+        std::string sql = std::string("SELECT id, created_at, updated_at, preview, message_count, tokens "
+                                      "FROM sessions ORDER BY ") +
+                          sort_column(query.sort) + " " + direction + ", id " + direction + " LIMIT ?1 OFFSET ?2";
+        auto prepared = db_.prepare(sql);
+        if (prepared.is_err()) return prepared;
+        list_[slot] = prepared.value();
+    }
+    return list_[slot];
+}
+
+Result<std::vector<SessionCatalog::Entry>, Error> SessionCatalog::list(const Query& query) {
+    std::lock_guard lock(mutex_);
+    auto prepared = list_statement(query);
+    if (prepared.is_err()) {
+        return std::move(prepared).error();
+    }
+
+    StatementScope stmt(prepared.value());
+    stmt.bind(1, static_cast<int64_t>(std::min<size_t>(query.limit, INT64_MAX)));
+    stmt.bind(2, static_cast<int64_t>(std::min<size_t>(query.offset, INT64_MAX)));
+
+    std::vector<Entry> entries;
+    int rc;
+    while ((rc = stmt.step()) == SQLITE_ROW) {
+        entries.push_back(Entry{
+            stmt.text(0),
+            from_ms(stmt.integer(1)),
+            from_ms(stmt.integer(2)),
+            stmt.text(3),
+            static_cast<size_t>(stmt.integer(4)),
+            static_cast<uint64_t>(stmt.integer(5))
+        });
+    }
+    if (rc != SQLITE_DONE) {
+        return db_.error(ErrorCode::MemoryLoadFailed, "Failed to list sessions");
+    }
+    return entries;
+}
+
+Result<size_t, Error> SessionCatalog::count() {
+    std::lock_guard lock(mutex_);
+    StatementScope stmt(count_);
+    if (stmt.step() != SQLITE_ROW) {
+        return db_.error(ErrorCode::MemoryLoadFailed, "Failed to count sessions");
+    }
+    return static_cast<size_t>(stmt.integer(0));
+}
+
+}  // namespace gpagent::memory
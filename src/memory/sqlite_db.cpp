@@ -0,0 +1,119 @@
+#include "gpagent/memory/sqlite_db.hpp"
+
+#include <sqlite3.h>
+
+namespace gpagent::memory {
+
+// SqliteDb
+SqliteDb::~SqliteDb() {
+    for (sqlite3_stmt* stmt : statements_) {
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db_);
+}
+
+Result<void, Error> SqliteDb::open(const fs::path& path, std::span<const char* const> migrations) {
+    path_ = path;
+    std::error_code ec;
+    fs::create_directories(path_.parent_path(), ec);
+
+    if (sqlite3_open_v2(path_.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                        nullptr) != SQLITE_OK) {
+        return error(ErrorCode::MemoryLoadFailed, "Failed to open database");
+    }
+    sqlite3_busy_timeout(db_, 5000);
+
+    // WAL: readers never block the writer, and a commit is one append.
+    // synchronous=NORMAL keeps the database consistent after a crash; only
+    // the last commits before a power loss can be lost.
+    for (const char* sql : {"PRAGMA journal_mode=WAL", "PRAGMA synchronous=NORMAL"}) {
+        if (auto done = exec(sql); done.is_err()) return done;
+    }
+    return migrate(migrations);
+}
+
+Result<void, Error> SqliteDb::migrate(std::span<const char* const> migrations) {
+    // Read and upgrade under the write lock, in case another process is
+    // opening the same database
+    if (auto begun = exec("BEGIN IMMEDIATE"); begun.is_err()) return begun;
+
+    int version = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    const int latest = static_cast<int>(migrations.size());
+    for (int v = version; v < latest; ++v) {
+        if (auto done = exec(migrations[v]); done.is_err()) {
+            exec("ROLLBACK");
+            return done;
+        }
+    }
+    if (version < latest) {
+        exec(("PRAGMA user_version = " + std::to_string(latest)).c_str());
+    }
+    return exec("COMMIT");
+}
+
+Result<void, Error> SqliteDb::exec(const char* sql) {
+    char* message = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &message) != SQLITE_OK) {
+        std::string text = message ? message : "unknown error";
+        sqlite3_free(message);
+        return Result<void, Error>::err(ErrorCode::MemorySaveFailed, text, path_.string());
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<sqlite3_stmt*, Error> SqliteDb::prepare(const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db_, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        return error(ErrorCode::MemoryLoadFailed, "Failed to prepare query");
+    }
+    statements_.push_back(stmt);
+    return stmt;
+}
+
+int SqliteDb::changes() const {
+    return sqlite3_changes(db_);
+}
+
+Error SqliteDb::error(ErrorCode code, const std::string& what) const {
+    return Error{code, what + ": " + (db_ ? sqlite3_errmsg(db_) : "no database"), path_.string()};
+}
+
+// StatementScope
+StatementScope::~StatementScope() {
+    sqlite3_reset(stmt_);
+    sqlite3_clear_bindings(stmt_);
+}
+
+void StatementScope::bind(int index, const std::string& text) {
+    sqlite3_bind_text(stmt_, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+void StatementScope::bind(int index, int64_t value) {
+    sqlite3_bind_int64(stmt_, index, value);
+}
+
+std::string StatementScope::text(int column) const {
+    const auto* data = static_cast<const char*>(sqlite3_column_blob(stmt_, column));
+    return data ? std::string(data, static_cast<size_t>(sqlite3_column_bytes(stmt_, column))) : std::string();
+}
+
+int64_t StatementScope::integer(int column) const {
+    return sqlite3_column_int64(stmt_, column);
+}
+
+double StatementScope::real(int column) const {
+    return sqlite3_column_double(stmt_, column);
+}
+
+int StatementScope::step() {
+    return sqlite3_step(stmt_);
+}
+
+}  // namespace gpagent::memory
@@ -1,19 +1,31 @@
 #include "gpagent/memory/thread_memory.hpp"
 #include "gpagent/core/uuid.hpp"
 
+#include <atomic>
 #include <fstream>
 #include <sstream>
 
 namespace gpagent::memory {
 
+namespace {
+
+uint64_t next_revision() {
+    static std::atomic<uint64_t> revisions{0};
+    return ++revisions;
+}
+
+}  // namespace
+
 // ThreadMemory
 ThreadMemory::ThreadMemory()
     : thread_id_(generate_thread_id())
+    , revision_(next_revision())
 {
 }
 
 ThreadMemory::ThreadMemory(const ThreadId& id)
     : thread_id_(id)
+    , revision_(next_revision())
 {
 }
 
@@ -44,6 +56,7 @@ void ThreadMemory::trim(size_t keep_last) {
         for (size_t i = 0; i < to_remove; ++i) {
             messages_.pop_front();
         }
+        revision_ = next_revision();
     }
 }
 
@@ -189,6 +202,22 @@ std::string CompressedHistory::get_combined() const {
     return ss.str();
 }
 
+Json CompressedHistory::to_json() const {
+    Json j = Json::array();
+    for (const auto& s : summaries_) {
+        j.push_back(s.to_json());
+    }
+    return j;
+}
+
+CompressedHistory CompressedHistory::from_json(const Json& j) {
+    CompressedHistory history;
+    for (const auto& item : j) {
+        history.summaries_.push_back(Summary::from_json(item));
+    }
+    return history;
+}
+
 Result<void, Error> CompressedHistory::save(const fs::path& path) const {
     try {
         if (path.has_parent_path()) {
@@ -204,12 +233,7 @@ Result<void, Error> CompressedHistory::save(const fs::path& path) const {
             );
         }
 
-        Json j = Json::array();
-        for (const auto& s : summaries_) {
-            j.push_back(s.to_json());
-        }
-
-        file << j.dump(2);
+        file << to_json().dump(2);
         return Result<void, Error>::ok();
 
     } catch (const std::exception& e) {
@@ -238,13 +262,7 @@ Result<CompressedHistory, Error> CompressedHistory::load(const fs::path& path) {
         }
 
         Json j = Json::parse(file);
-        CompressedHistory history;
-
-        for (const auto& item : j) {
-            history.summaries_.push_back(Summary::from_json(item));
-        }
-
-        return Result<CompressedHistory, Error>::ok(std::move(history));
+        return Result<CompressedHistory, Error>::ok(from_json(j));
 
     } catch (const Json::exception& e) {
         return Result<CompressedHistory, Error>::err(
@@ -0,0 +1,362 @@
+#include "gpagent/memory/transcript.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+
+namespace gpagent::memory {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'P', 'T', 'R', 'N', '\0', '\0', '\1'};
+
+// Trailer: arena offset and size, index offset, record count, id, magic
+constexpr size_t kTrailerSize = 5 * sizeof(uint64_t) + sizeof(kMagic);
+
+// Fixed part of a record: role, flags, padding, tool call count,
+// timestamp (ns), then references to content, name and tool call id.
+// Each tool call follows as references to its id, name and arguments.
+constexpr size_t kRefSize = 2 * sizeof(uint64_t);
+constexpr size_t kRecordFixedSize = 4 + sizeof(uint32_t) + sizeof(int64_t) + 3 * kRefSize;
+constexpr size_t kToolCallSize = 3 * kRefSize;
+
+constexpr uint8_t kHasName = 1;
+constexpr uint8_t kHasToolCallId = 2;
+
+// Strings up to this size are stored once however often they occur
+constexpr size_t kDedupLimit = 256;
+
+constexpr size_t kPreviewLength = 50;
+
+// Longest prefix of at most `limit` bytes that does not split a UTF-8 sequence
+std::string utf8_prefix(const std::string& text, size_t limit) {
+    if (text.size() <= limit) return text;
+    size_t end = limit;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) --end;
+    return text.substr(0, end);
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+uint8_t role_code(Role role) {
+    switch (role) {
+        case Role::System: return 0;
+        case Role::User: return 1;
+        case Role::Assistant: return 2;
+        case Role::Tool: return 3;
+    }
+    return 1;
+}
+
+Role role_from_code(uint8_t code) {
+    switch (code) {
+        case 0: return Role::System;
+        case 2: return Role::Assistant;
+        case 3: return Role::Tool;
+        default: return Role::User;
+    }
+}
+
+class ArenaBuilder {
+public:
+    // Append a string, returning its reference
+    std::pair<uint64_t, uint64_t> add(std::string_view text) {
+        if (text.size() <= kDedupLimit) {
+            if (auto it = seen_.find(std::string(text)); it != seen_.end()) {
+                return {it->second, text.size()};
+            }
+        }
+        uint64_t offset = data_.size();
+        data_.append(text);
+        if (text.size() <= kDedupLimit) {
+            seen_.emplace(std::string(text), offset);
+        }
+        return {offset, text.size()};
+    }
+
+    const std::string& data() const { return data_; }
+
+private:
+    std::string data_;
+    std::unordered_map<std::string, uint64_t> seen_;
+};
+
+void put_ref(std::string& out, std::pair<uint64_t, uint64_t> ref) {
+    put<uint64_t>(out, ref.first);
+    put<uint64_t>(out, ref.second);
+}
+
+int estimate_tokens(size_t chars) {
+    return static_cast<int>(chars / 3.5);
+}
+
+}  // namespace
+
+Result<uint64_t, Error> Transcript::write(const fs::path& path, const ThreadMemory& thread) {
+    ArenaBuilder arena;
+    std::string records;
+    std::vector<uint64_t> offsets;
+    offsets.reserve(thread.size());
+
+    for (const auto& msg : thread.messages()) {
+        std::string record;
+        record.reserve(kRecordFixedSize + msg.tool_calls.size() * kToolCallSize);
+
+        uint8_t flags = (msg.name ? kHasName : 0) | (msg.tool_call_id ? kHasToolCallId : 0);
+        put<uint8_t>(record, role_code(msg.role));
+        put<uint8_t>(record, flags);
+        put<uint16_t>(record, 0);
+        put<uint32_t>(record, static_cast<uint32_t>(msg.tool_calls.size()));
+        put<int64_t>(record, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            msg.timestamp.time_since_epoch()).count());
+        put_ref(record, arena.add(msg.content));
+        put_ref(record, arena.add(msg.name.value_or("")));
+        put_ref(record, arena.add(msg.tool_call_id.value_or("")));
+        for (const auto& tc : msg.tool_calls) {
+            put_ref(record, arena.add(tc.id));
+            put_ref(record, arena.add(tc.tool_name));
+            put_ref(record, arena.add(tc.arguments.dump()));
+        }
+
+        offsets.push_back(records.size());
+        put<uint32_t>(records, static_cast<uint32_t>(record.size()));
+        records += record;
+    }
+
+    uint64_t arena_offset = sizeof(kMagic);
+    uint64_t records_offset = arena_offset + arena.data().size();
+    uint64_t index_offset = records_offset + records.size();
+
+    std::string index;
+    index.reserve(offsets.size() * sizeof(uint64_t));
+    for (uint64_t offset : offsets) {
+        put<uint64_t>(index, records_offset + offset);
+    }
+
+    std::random_device rd;
+    uint64_t id = (static_cast<uint64_t>(rd()) << 32) | rd();
+
+    std::string trailer;
+    put<uint64_t>(trailer, arena_offset);
+    put<uint64_t>(trailer, arena.data().size());
+    put<uint64_t>(trailer, index_offset);
+    put<uint64_t>(trailer, offsets.size());
+    put<uint64_t>(trailer, id);
+    trailer.append(kMagic, sizeof(kMagic));
+
+    auto written = tools::write_file_atomic(
+        path, {std::string_view(kMagic, sizeof(kMagic)), arena.data(), records, index, trailer});
+    if (written.is_err()) {
+        return Result<uint64_t, Error>::err(std::move(written).error());
+    }
+    return Result<uint64_t, Error>::ok(id);
+}
+
+Result<Transcript, Error> Transcript::open(const fs::path& path) {
+    using R = Result<Transcript, Error>;
+
+    Transcript transcript;
+    transcript.path_ = path;
+    if (!transcript.file_.open(path, false)) {
+        return R::err(ErrorCode::FileNotFound, "Transcript not found", path.string());
+    }
+
+    std::string_view data = transcript.file_.data();
+    auto corrupted = [&] { return R::err(ErrorCode::MemoryCorrupted, "Transcript is corrupted", path.string()); };
+    if (data.size() < sizeof(kMagic) + kTrailerSize ||
+        data.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic)) ||
+        data.substr(data.size() - sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic))) {
+        return corrupted();
+    }
+
+    const char* trailer = data.data() + data.size() - kTrailerSize;
+    transcript.arena_offset_ = get<uint64_t>(trailer);
+    transcript.arena_size_ = get<uint64_t>(trailer + 8);
+    transcript.index_offset_ = get<uint64_t>(trailer + 16);
+    uint64_t count = get<uint64_t>(trailer + 24);
+    transcript.id_ = get<uint64_t>(trailer + 32);
+
+    uint64_t trailer_offset = data.size() - kTrailerSize;
+    if (transcript.arena_offset_ > trailer_offset ||
+        transcript.arena_size_ > trailer_offset - transcript.arena_offset_ ||
+        transcript.index_offset_ > trailer_offset ||
+        count > (trailer_offset - transcript.index_offset_) / sizeof(uint64_t)) {
+        return corrupted();
+    }
+    transcript.count_ = static_cast<size_t>(count);
+
+    return R::ok(std::move(transcript));
+}
+
+Result<Message, Error> Transcript::message(size_t index) const {
+    using R = Result<Message, Error>;
+    auto corrupted = [&] { return R::err(ErrorCode::MemoryCorrupted, "Transcript record is corrupted", path_.string()); };
+
+    if (index >= count_) {
+        return R::err(ErrorCode::InvalidArgument, "Transcript index out of range", path_.string());
+    }
+
+    std::string_view data = file_.data();
+    uint64_t offset = get<uint64_t>(data.data() + index_offset_ + index * sizeof(uint64_t));
+    if (offset > index_offset_ || index_offset_ - offset < sizeof(uint32_t)) {
+        return corrupted();
+    }
+    uint32_t length = get<uint32_t>(data.data() + offset);
+    if (length < kRecordFixedSize || length > index_offset_ - offset - sizeof(uint32_t)) {
+        return corrupted();
+    }
+    const char* record = data.data() + offset + sizeof(uint32_t);
+
+    uint32_t tool_calls = get<uint32_t>(record + 4);
+    if (tool_calls > (length - kRecordFixedSize) / kToolCallSize) {
+        return corrupted();
+    }
+
+    std::string_view arena = data.substr(arena_offset_, arena_size_);
+    bool ok = true;
+    auto string_at = [&](const char* ref) -> std::string {
+        uint64_t start = get<uint64_t>(ref);
+        uint64_t size = get<uint64_t>(ref + 8);
+        if (start > arena.size() || size > arena.size() - start) {
+            ok = false;
+            return {};
+        }
+        return std::string(arena.substr(start, size));
+    };
+
+    Message m;
+    m.role = role_from_code(get<uint8_t>(record));
+    uint8_t flags = get<uint8_t>(record + 1);
+    m.timestamp = TimePoint{std::chrono::duration_cast<Clock::duration>(
+        std::chrono::nanoseconds{get<int64_t>(record + 8)})};
+
+    const char* refs = record + 16;
+    m.content = string_at(refs);
+    if (flags & kHasName) m.name = string_at(refs + kRefSize);
+    if (flags & kHasToolCallId) m.tool_call_id = string_at(refs + 2 * kRefSize);
+
+    const char* call = record + kRecordFixedSize;
+    for (uint32_t i = 0; i < tool_calls; ++i, call += kToolCallSize) {
+        ToolCall tc;
+        tc.id = string_at(call);
+        tc.tool_name = string_at(call + kRefSize);
+        tc.arguments = Json::parse(string_at(call + 2 * kRefSize), nullptr, false);
+        if (tc.arguments.is_discarded()) {
+            tc.arguments = Json::object();
+        }
+        m.tool_calls.push_back(std::move(tc));
+    }
+
+    if (!ok) {
+        return corrupted();
+    }
+    return R::ok(std::move(m));
+}
+
+Result<ThreadMemory, Error> Transcript::read_all() const {
+    ThreadMemory thread;
+    for (size_t i = 0; i < count_; ++i) {
+        auto msg = message(i);
+        if (msg.is_err()) {
+            return Result<ThreadMemory, Error>::err(std::move(msg).error());
+        }
+        thread.append(std::move(msg).value());
+    }
+    return Result<ThreadMemory, Error>::ok(std::move(thread));
+}
+
+// TranscriptMeta
+void TranscriptMeta::add(const Message& message) {
+    if (message_count == 0) {
+        first_message = message.timestamp;
+    }
+    last_message = message.timestamp;
+    ++message_count;
+
+    if (preview.empty() && message.role == Role::User && !message.content.empty()) {
+        preview = utf8_prefix(message.content, kPreviewLength);
+        if (message.content.size() > kPreviewLength) {
+            preview += "...";
+        }
+    }
+
+    tokens += 3 + estimate_tokens(message.content.size());
+    for (const auto& tc : message.tool_calls) {
+        tokens += 10 + estimate_tokens(tc.tool_name.size()) + estimate_tokens(tc.arguments.dump().size());
+    }
+}
+
+TranscriptMeta TranscriptMeta::of(const ThreadMemory& thread) {
+    TranscriptMeta meta;
+    for (const auto& msg : thread.messages()) {
+        meta.add(msg);
+    }
+    return meta;
+}
+
+Json TranscriptMeta::to_json() const {
+    auto seconds = [](TimePoint t) {
+        return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+    };
+    return Json{
+        {"message_count", message_count},
+        {"preview", preview},
+        {"first_message", seconds(first_message)},
+        {"last_message", seconds(last_message)},
+        {"tokens", tokens}
+    };
+}
+
+TranscriptMeta TranscriptMeta::from_json(const Json& j) {
+    TranscriptMeta meta;
+    meta.message_count = j.value("message_count", size_t(0));
+    meta.preview = j.value("preview", "");
+    meta.first_message = TimePoint{std::chrono::seconds{j.value("first_message", int64_t(0))}};
+    meta.last_message = TimePoint{std::chrono::seconds{j.value("last_message", int64_t(0))}};
+    meta.tokens = j.value("tokens", uint64_t(0));
+    return meta;
+}
+
+Result<void, Error> TranscriptMeta::save(const fs::path& path) const {
+    // Message content is not validated; invalid UTF-8 must not make the dump throw
+    std::string content = to_json().dump(2, ' ', false, Json::error_handler_t::replace);
+    return tools::write_file_atomic(path, {content});
+}
+
+Result<TranscriptMeta, Error> TranscriptMeta::load(const fs::path& path) {
+    try {
+        std::ifstream file(path);
+        if (!file) {
+            return Result<TranscriptMeta, Error>::err(
+                ErrorCode::FileNotFound,
+                "Transcript metadata not found",
+                path.string()
+            );
+        }
+        return Result<TranscriptMeta, Error>::ok(from_json(Json::parse(file)));
+
+    } catch (const Json::exception& e) {
+        return Result<TranscriptMeta, Error>::err(
+            ErrorCode::MemoryCorrupted,
+            std::string("JSON parse error: ") + e.what(),
+            path.string()
+        );
+    }
+}
+
+}  // namespace gpagent::memory
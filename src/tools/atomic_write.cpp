@@ -0,0 +1,144 @@
+#include "gpagent/tools/atomic_write.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+#ifdef __linux__
+
+bool write_all(int fd, const std::vector<std::string_view>& chunks) {
+    for (std::string_view chunk : chunks) {
+        while (!chunk.empty()) {
+            ssize_t n = ::write(fd, chunk.data(), chunk.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            chunk.remove_prefix(static_cast<size_t>(n));
+        }
+    }
+    return true;
+}
+
+Result<void, Error> write_in_place(const fs::path& path, const std::vector<std::string_view>& chunks) {
+    // Chunks may point into a mapping of this very file: copy before truncating
+    std::string content;
+    for (std::string_view chunk : chunks) {
+        content.append(chunk);
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) {
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, std::strerror(errno), path.string());
+    }
+    bool ok = write_all(fd, {content}) && ::fsync(fd) == 0;
+    int saved_errno = errno;
+    ::close(fd);
+    if (!ok) {
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, std::strerror(saved_errno), path.string());
+    }
+    return Result<void, Error>::ok();
+}
+
+#endif
+
+}  // namespace
+
+Result<void, Error> write_file_atomic(const fs::path& path,
+                                      const std::vector<std::string_view>& chunks) {
+    std::error_code ec;
+    // symlink_status() reports a missing file through ec as well; that is
+    // not an error, the file is simply created
+    auto link = fs::symlink_status(path, ec);
+    if (ec && link.type() != fs::file_type::not_found) {
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, ec.message(), path.string());
+    }
+    ec.clear();
+    fs::path target = path;
+    if (fs::is_symlink(link)) {
+        target = fs::canonical(path, ec);
+        if (ec) {
+            return Result<void, Error>::err(ErrorCode::FileWriteFailed, ec.message(), path.string());
+        }
+    }
+
+#ifdef __linux__
+    struct stat st;
+    bool exists = ::stat(target.c_str(), &st) == 0;
+    if (exists && st.st_nlink > 1) {
+        return write_in_place(target, chunks);
+    }
+
+    fs::path tmp = target;
+    tmp += ".gpagent-" + std::to_string(std::random_device{}()) + ".tmp";
+
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                    exists ? (st.st_mode & 07777) : 0644);
+    if (fd < 0) {
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, std::strerror(errno), tmp.string());
+    }
+    if (exists) {
+        // Best effort: the create mode is filtered by umask, and chown
+        // needs privileges when the file belongs to someone else
+        if (::fchmod(fd, st.st_mode & 07777) != 0 || ::fchown(fd, st.st_uid, st.st_gid) != 0) {
+            spdlog::debug("Could not keep the mode or owner of {}: {}", target.string(), std::strerror(errno));
+        }
+    }
+
+    bool ok = write_all(fd, chunks) && ::fsync(fd) == 0;
+    int saved_errno = errno;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), target.c_str()) != 0) {
+        if (ok) saved_errno = errno;
+        ::unlink(tmp.c_str());
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, std::strerror(saved_errno), target.string());
+    }
+
+    // Persist the rename itself
+    int dir_fd = ::open(target.parent_path().empty() ? "." : target.parent_path().c_str(),
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return Result<void, Error>::ok();
+#else
+    fs::path tmp = target;
+    tmp += ".gpagent.tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        for (std::string_view chunk : chunks) {
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        }
+        if (!out) {
+            fs::remove(tmp, ec);
+            return Result<void, Error>::err(ErrorCode::FileWriteFailed, "Failed to write temp file", tmp.string());
+        }
+    }
+    if (fs::exists(target, ec)) {
+        fs::permissions(tmp, fs::status(target, ec).permissions(), ec);
+    }
+    fs::rename(tmp, target, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return Result<void, Error>::err(ErrorCode::FileWriteFailed, ec.message(), target.string());
+    }
+    return Result<void, Error>::ok();
+#endif
+}
+
+}  // namespace gpagent::tools
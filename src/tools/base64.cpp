@@ -0,0 +1,116 @@
+#include "gpagent/tools/base64.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GPAGENT_BASE64_SSSE3 1
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// The two output characters for every 12-bit group
+struct PairTable {
+    std::array<char, 2 * 4096> chars{};
+
+    constexpr PairTable() {
+        for (size_t i = 0; i < 4096; ++i) {
+            chars[2 * i] = kAlphabet[i >> 6];
+            chars[2 * i + 1] = kAlphabet[i & 63];
+        }
+    }
+};
+
+constexpr PairTable kPairs;
+
+// Whole 3-byte groups from in[0, n - n % 3)
+void encode_scalar(const unsigned char* in, size_t n, char* out) {
+    const char* pairs = kPairs.chars.data();
+    for (size_t i = 0; i + 3 <= n; i += 3, out += 4) {
+        uint32_t v = (uint32_t{in[i]} << 16) | (uint32_t{in[i + 1]} << 8) | in[i + 2];
+        std::memcpy(out, pairs + 2 * (v >> 12), 2);
+        std::memcpy(out + 2, pairs + 2 * (v & 0xfff), 2);
+    }
+}
+
+#if defined(GPAGENT_BASE64_SSSE3)
+
+// 12 input bytes to 16 characters per iteration (Mula and Lemire's
+// multiply-shift reshuffle and range-based translation). Loads 16 bytes,
+// so it stops while at least 16 remain; returns the bytes consumed.
+__attribute__((target("ssse3")))
+size_t encode_ssse3(const unsigned char* in, size_t n, char* out) {
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shift_lut = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 12, out += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        v = _mm_shuffle_epi8(v, shuffle);
+
+        // Spread each 24-bit group into four 6-bit indices
+        const __m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t1, t3);
+
+        // Offset to add per index range: A-Z, a-z, 0-9, '+', '/'
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i below_26 = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(below_26, _mm_set1_epi8(13)));
+        const __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, range), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+    }
+    return i;
+}
+
+bool has_ssse3() {
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+
+#endif
+
+}  // namespace
+
+std::string base64_encode(std::string_view data) {
+    const auto* in = reinterpret_cast<const unsigned char*>(data.data());
+    size_t n = data.size();
+
+    std::string out(base64_encoded_size(n), '\0');
+    char* dst = out.data();
+
+    size_t done = 0;
+#if defined(GPAGENT_BASE64_SSSE3)
+    if (has_ssse3()) {
+        done = encode_ssse3(in, n, dst);
+    }
+#endif
+    size_t whole = n - n % 3;
+    encode_scalar(in + done, whole - done, dst + done / 3 * 4);
+
+    // Final partial group, padded
+    size_t rest = n - whole;
+    if (rest > 0) {
+        char* tail = dst + whole / 3 * 4;
+        uint32_t v = uint32_t{in[whole]} << 16;
+        if (rest == 2) v |= uint32_t{in[whole + 1]} << 8;
+        tail[0] = kAlphabet[(v >> 18) & 63];
+        tail[1] = kAlphabet[(v >> 12) & 63];
+        tail[2] = rest == 2 ? kAlphabet[(v >> 6) & 63] : '=';
+        tail[3] = '=';
+    }
+    return out;
+}
+
+}  // namespace gpagent::tools
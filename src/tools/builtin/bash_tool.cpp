@@ -1,17 +1,22 @@
 #include "gpagent/tools/tool_registry.hpp"
+#include "gpagent/tools/output_buffer.hpp"
+#include "gpagent/tools/shell_session.hpp"
+#include "gpagent/core/config.hpp"
 
 #include <array>
 #include <cstdio>
 #include <memory>
-#include <regex>
 #include <sstream>
 #include <chrono>
 
 #ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <signal.h>
-#include <poll.h>
 #endif
 
 namespace gpagent::tools::builtin {
@@ -34,18 +39,69 @@ struct CommandResult {
     bool timed_out = false;
 };
 
+using OutputCallback = std::function<void(std::string_view chunk)>;
+
+namespace {
+
+// Per-stream retention: the start of the output plus its last lines,
+// which is where compilers and test runners put their errors
+constexpr size_t kOutputHeadBytes = 10000;
+constexpr size_t kOutputTailBytes = 5000;
+
+#ifdef __linux__
+
+int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Read whatever is available on a non-blocking pipe.
+// Returns false once the write end is closed.
+bool drain_pipe(int fd, OutputBuffer& out, OutputBatcher& stream) {
+    std::array<char, 65536> buffer;
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n > 0) {
+            std::string_view chunk(buffer.data(), static_cast<size_t>(n));
+            out.append(chunk);
+            stream.append(chunk);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+#endif
+
+}  // namespace
+
 CommandResult execute_command(const std::string& command, int timeout_ms,
                                const std::string& working_dir,
-                               const std::map<std::string, std::string>& env) {
+                               const std::map<std::string, std::string>& env,
+                               const OutputCallback& on_output = {}) {
     CommandResult result;
     result.exit_code = -1;
 
+    OutputBuffer stdout_buf(kOutputHeadBytes, kOutputTailBytes);
+    OutputBuffer stderr_buf(kOutputHeadBytes, kOutputTailBytes);
+
 #ifdef __linux__
     // Create pipes for stdout and stderr
     int stdout_pipe[2];
     int stderr_pipe[2];
 
-    if (pipe(stdout_pipe) != 0 || pipe(stderr_pipe) != 0) {
+    if (pipe2(stdout_pipe, O_CLOEXEC) != 0) {
+        result.stderr_output = "Failed to create pipes";
+        return result;
+    }
+    if (pipe2(stderr_pipe, O_CLOEXEC) != 0) {
+        close(stdout_pipe[0]); close(stdout_pipe[1]);
         result.stderr_output = "Failed to create pipes";
         return result;
     }
@@ -60,16 +116,12 @@ CommandResult execute_command(const std::string& command, int timeout_ms,
     }
 
     if (pid == 0) {
-        // Child process
-        close(stdout_pipe[0]);
-        close(stderr_pipe[0]);
+        // Child process: own process group so a timeout kills the whole tree
+        setpgid(0, 0);
 
         dup2(stdout_pipe[1], STDOUT_FILENO);
         dup2(stderr_pipe[1], STDERR_FILENO);
 
-        close(stdout_pipe[1]);
-        close(stderr_pipe[1]);
-
         // Change directory
         if (!working_dir.empty()) {
             if (chdir(working_dir.c_str()) != 0) {
@@ -88,86 +140,106 @@ CommandResult execute_command(const std::string& command, int timeout_ms,
     }
 
     // Parent process
+    setpgid(pid, pid);
     close(stdout_pipe[1]);
     close(stderr_pipe[1]);
+    fcntl(stdout_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(stderr_pipe[0], F_SETFL, O_NONBLOCK);
+
+    // Wake up on output or on child exit instead of polling. Without
+    // pidfd (kernel < 5.3) fall back to checking waitpid periodically.
+    int pidfd = open_pidfd(pid);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+    auto watch = [epfd](int fd) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    };
+    watch(stdout_pipe[0]);
+    watch(stderr_pipe[0]);
+    if (pidfd >= 0) {
+        watch(pidfd);
+    }
 
-    // Set up poll for reading
-    struct pollfd fds[2];
-    fds[0].fd = stdout_pipe[0];
-    fds[0].events = POLLIN;
-    fds[1].fd = stderr_pipe[0];
-    fds[1].events = POLLIN;
-
-    std::ostringstream stdout_ss, stderr_ss;
-    std::array<char, 4096> buffer;
+    OutputBatcher stream(on_output);
     auto start = std::chrono::steady_clock::now();
 
-    while (true) {
-        auto elapsed = std::chrono::steady_clock::now() - start;
-        int remaining_ms = timeout_ms - std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    bool exited = false;
+    bool reaped = false;
+    int status = 0;
+
+    while (!exited) {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+        int wait_ms = timeout_ms - static_cast<int>(elapsed);
 
-        if (remaining_ms <= 0) {
-            // Timeout - kill the process
+        if (wait_ms <= 0) {
+            // Timeout - kill the process group
+            kill(-pid, SIGKILL);
             kill(pid, SIGKILL);
             result.timed_out = true;
             break;
         }
 
-        int ret = poll(fds, 2, std::min(remaining_ms, 100));
+        if (int due = stream.due_in_ms(); due >= 0) {
+            wait_ms = std::min(wait_ms, due);
+        }
+        if (pidfd < 0) {
+            wait_ms = std::min(wait_ms, 100);
+        }
 
-        if (ret < 0) {
+        epoll_event events[3];
+        int n = epoll_wait(epfd, events, 3, wait_ms);
+        if (n < 0 && errno != EINTR) {
             break;
         }
 
-        if (ret > 0) {
-            if (fds[0].revents & POLLIN) {
-                ssize_t n = read(stdout_pipe[0], buffer.data(), buffer.size());
-                if (n > 0) {
-                    stdout_ss.write(buffer.data(), n);
-                }
-            }
-            if (fds[1].revents & POLLIN) {
-                ssize_t n = read(stderr_pipe[0], buffer.data(), buffer.size());
-                if (n > 0) {
-                    stderr_ss.write(buffer.data(), n);
-                }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == pidfd) {
+                exited = true;
+                continue;
             }
-
-            // Check if both pipes are closed
-            if ((fds[0].revents & POLLHUP) && (fds[1].revents & POLLHUP)) {
-                break;
+            OutputBuffer& out = fd == stdout_pipe[0] ? stdout_buf : stderr_buf;
+            if (!drain_pipe(fd, out, stream)) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
             }
         }
 
-        // Check if child has exited
-        int status;
-        pid_t wpid = waitpid(pid, &status, WNOHANG);
-        if (wpid == pid) {
-            // Read any remaining data
-            ssize_t n;
-            while ((n = read(stdout_pipe[0], buffer.data(), buffer.size())) > 0) {
-                stdout_ss.write(buffer.data(), n);
-            }
-            while ((n = read(stderr_pipe[0], buffer.data(), buffer.size())) > 0) {
-                stderr_ss.write(buffer.data(), n);
-            }
-
-            if (WIFEXITED(status)) {
-                result.exit_code = WEXITSTATUS(status);
-            }
-            break;
+        if (pidfd < 0 && waitpid(pid, &status, WNOHANG) == pid) {
+            exited = true;
+            reaped = true;
         }
+
+        stream.flush_if_due();
     }
 
+    // Collect what the child wrote before exiting. Background jobs may
+    // still hold the pipes open, so don't wait for EOF.
+    drain_pipe(stdout_pipe[0], stdout_buf, stream);
+    drain_pipe(stderr_pipe[0], stderr_buf, stream);
+    stream.flush();
+
+    close(epfd);
+    if (pidfd >= 0) {
+        close(pidfd);
+    }
     close(stdout_pipe[0]);
     close(stderr_pipe[0]);
 
     // Ensure child is reaped
-    int status;
-    waitpid(pid, &status, 0);
-
-    result.stdout_output = stdout_ss.str();
-    result.stderr_output = stderr_ss.str();
+    if (!reaped) {
+        waitpid(pid, &status, 0);
+    }
+    if (!result.timed_out) {
+        if (WIFEXITED(status)) {
+            result.exit_code = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            result.exit_code = 128 + WTERMSIG(status);
+        }
+    }
 
 #else
     // Fallback for non-Linux (Windows, macOS)
@@ -181,16 +253,25 @@ CommandResult execute_command(const std::string& command, int timeout_ms,
     }
 
     std::array<char, 4096> buffer;
-    std::ostringstream output;
 
     while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-        output << buffer.data();
+        std::string_view line(buffer.data());
+        stdout_buf.append(line);
+        if (on_output) {
+            on_output(line);
+        }
     }
 
     result.exit_code = pclose(pipe);
-    result.stdout_output = output.str();
 #endif
 
+    if (!stdout_buf.empty()) {
+        result.stdout_output = stdout_buf.str();
+    }
+    if (!stderr_buf.empty()) {
+        result.stderr_output = stderr_buf.str();
+    }
+
     return result;
 }
 
@@ -218,8 +299,37 @@ ToolResult bash_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    // Prefer the session's persistent shell so cd/export state carries over
+    bool persistent = !ctx.config || ctx.config->tools.persistent_shell;
+    if (auto shell = persistent ? ShellSession::for_session(ctx.session_id, ctx.working_directory, ctx.env)
+                                : nullptr) {
+        auto run = shell->run(command, timeout_ms, ctx.on_output);
+
+        if (run.timed_out) {
+            return ToolResult{
+                .success = false,
+                .content = run.output,
+                .error_message = "Command timed out after " + std::to_string(timeout_ms) + "ms" +
+                    (run.session_lost ? " and the shell was restarted" : " and was interrupted")
+            };
+        }
+
+        std::string content = run.output;
+        if (run.session_lost) {
+            content += "\n[shell exited; the next command starts a new shell]";
+        }
+
+        return ToolResult{
+            .success = run.exit_code == 0,
+            .content = content,
+            .error_message = run.exit_code != 0 ?
+                std::make_optional("Command exited with code " + std::to_string(run.exit_code)) :
+                std::nullopt
+        };
+    }
+
     // Execute
-    auto cmd_result = execute_command(command, timeout_ms, ctx.working_directory, ctx.env);
+    auto cmd_result = execute_command(command, timeout_ms, ctx.working_directory, ctx.env, ctx.on_output);
 
     if (cmd_result.timed_out) {
         return ToolResult{
@@ -241,14 +351,9 @@ ToolResult bash_handler(const Json& args, const ToolContext& ctx) {
         output << "[stderr]\n" << cmd_result.stderr_output;
     }
 
+    // Already bounded: each stream keeps only its head and tail
     std::string content = output.str();
 
-    // Truncate if too long
-    const size_t max_output = 30000;
-    if (content.length() > max_output) {
-        content = content.substr(0, max_output) + "\n... [output truncated]";
-    }
-
     return ToolResult{
         .success = cmd_result.exit_code == 0,
         .content = content,
@@ -262,7 +367,8 @@ void register_bash_tool(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "bash",
-            .description = "Execute a bash command in the shell. Use for git, npm, docker, and other system commands.",
+            .description = "Execute a bash command in the shell. Use for git, npm, docker, and other system commands. "
+                           "The shell persists across calls, so cd, exported variables and activated environments carry over.",
             .parameters = {
                 {"command", "The bash command to execute", ParamType::String, true},
                 {"timeout", "Timeout in milliseconds (default: 120000)", ParamType::Integer, false},
@@ -1,17 +1,47 @@
+#include "gpagent/core/config.hpp"
+#include "gpagent/tools/interpreter_pool.hpp"
 #include "gpagent/tools/tool_registry.hpp"
 
 #include <array>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <map>
 
 namespace gpagent::tools::builtin {
 
 namespace fs = std::filesystem;
 
-// Execute a command and capture output with timeout
-std::pair<int, std::string> exec_with_timeout(const std::string& cmd, int timeout_sec) {
-    std::string full_cmd = "timeout " + std::to_string(timeout_sec) + " " + cmd + " 2>&1";
+namespace {
+
+std::string shell_quote(const std::string& s) {
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'') {
+            out += "'\\''";
+        } else {
+            out += c;
+        }
+    }
+    return out + "'";
+}
+
+}  // namespace
+
+// Execute a command in the tool's working directory and environment and
+// capture output with timeout
+std::pair<int, std::string> exec_with_timeout(const std::string& cmd, int timeout_sec,
+                                              const std::string& working_dir,
+                                              const std::map<std::string, std::string>& env) {
+    std::string full_cmd = "(";
+    if (!working_dir.empty()) {
+        full_cmd += "cd " + shell_quote(working_dir) + " && ";
+    }
+    full_cmd += "env";
+    for (const auto& [key, value] : env) {
+        full_cmd += " " + shell_quote(key + "=" + value);
+    }
+    full_cmd += " timeout " + std::to_string(timeout_sec) + " " + cmd + ") 2>&1";
 
     std::array<char, 4096> buffer;
     std::string result;
@@ -41,7 +71,44 @@ std::pair<int, std::string> exec_with_timeout(const std::string& cmd, int timeou
     return {exit_code, result};
 }
 
+// Run the snippet in a warm worker; nullopt when the pool is disabled or the
+// interpreter can't be started, leaving the caller to run it one-shot
+std::optional<ToolResult> execute_in_pool(InterpreterPool::Language language, const std::string& name,
+                                          const Json& args, const ToolContext& ctx) {
+    if (ctx.config && !ctx.config->tools.warm_interpreters) return std::nullopt;
+
+    std::string code = args.at("code").get<std::string>();
+    int timeout = args.value("timeout", 30);
+    auto run = InterpreterPool::instance().run(language, code, ctx.working_directory, ctx.env,
+                                               timeout * 1000, ctx.on_output);
+    if (!run) return std::nullopt;
+
+    std::string output = run->output;
+    if (run->timed_out) {
+        output += "\n[Execution timed out after " + std::to_string(timeout) + " seconds]";
+        return ToolResult{
+            .success = false,
+            .content = output
+        };
+    }
+    if (run->exit_code != 0) {
+        return ToolResult{
+            .success = false,
+            .content = output,
+            .error_message = name + " execution failed with exit code " + std::to_string(run->exit_code)
+        };
+    }
+    return ToolResult{
+        .success = true,
+        .content = output.empty() ? "(no output)" : output
+    };
+}
+
 ToolResult code_execute_python_handler(const Json& args, const ToolContext& ctx) {
+    if (auto result = execute_in_pool(InterpreterPool::Language::Python, "Python", args, ctx)) {
+        return *result;
+    }
+
     std::string code = args.at("code").get<std::string>();
     int timeout = args.value("timeout", 30);
 
@@ -63,8 +130,8 @@ ToolResult code_execute_python_handler(const Json& args, const ToolContext& ctx)
         script.close();
 
         // Execute with Python
-        std::string cmd = "python3 " + script_path.string();
-        auto [exit_code, output] = exec_with_timeout(cmd, timeout);
+        std::string cmd = "python3 " + shell_quote(script_path.string());
+        auto [exit_code, output] = exec_with_timeout(cmd, timeout, ctx.working_directory, ctx.env);
 
         // Clean up
         fs::remove(script_path);
@@ -96,6 +163,10 @@ ToolResult code_execute_python_handler(const Json& args, const ToolContext& ctx)
 }
 
 ToolResult code_execute_javascript_handler(const Json& args, const ToolContext& ctx) {
+    if (auto result = execute_in_pool(InterpreterPool::Language::JavaScript, "JavaScript", args, ctx)) {
+        return *result;
+    }
+
     std::string code = args.at("code").get<std::string>();
     int timeout = args.value("timeout", 30);
 
@@ -117,14 +188,14 @@ ToolResult code_execute_javascript_handler(const Json& args, const ToolContext&
         script.close();
 
         // Try node first, then deno
-        std::string cmd = "node " + script_path.string();
-        auto [exit_code, output] = exec_with_timeout(cmd, timeout);
+        std::string cmd = "node " + shell_quote(script_path.string());
+        auto [exit_code, output] = exec_with_timeout(cmd, timeout, ctx.working_directory, ctx.env);
 
         // If node not found, try deno
         if (output.find("command not found") != std::string::npos ||
             output.find("not found") != std::string::npos) {
-            cmd = "deno run " + script_path.string();
-            std::tie(exit_code, output) = exec_with_timeout(cmd, timeout);
+            cmd = "deno run " + shell_quote(script_path.string());
+            std::tie(exit_code, output) = exec_with_timeout(cmd, timeout, ctx.working_directory, ctx.env);
         }
 
         // Clean up
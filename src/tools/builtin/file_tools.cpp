@@ -1,5 +1,14 @@
 #include "gpagent/tools/tool_registry.hpp"
 #include "gpagent/core/config.hpp"
+#include "gpagent/tools/file_walker.hpp"
+#include "gpagent/tools/glob_matcher.hpp"
+#include "gpagent/tools/line_index.hpp"
+#include "gpagent/tools/search_engine.hpp"
+#include "gpagent/tools/piece_table.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+#include "gpagent/tools/dir_lister.hpp"
+#include "gpagent/tools/image_cache.hpp"
+#include "gpagent/tools/pdf_text.hpp"
 
 #include <spdlog/spdlog.h>
 #include <QImage>
@@ -9,49 +18,44 @@
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <sstream>
-#include <regex>
-
-#ifdef HAVE_POPPLER
-#include <poppler/cpp/poppler-document.h>
-#include <poppler/cpp/poppler-page.h>
-#endif
 
 namespace gpagent::tools::builtin {
 
 namespace fs = std::filesystem;
 
 #ifdef HAVE_POPPLER
-// Read text content from a PDF file
-std::string read_pdf_content(const fs::path& path, int max_pages = 100) {
-    auto doc = poppler::document::load_from_file(path.string());
-    if (!doc) {
+// Pages returned by file_read on a PDF when no limit is given
+constexpr int kDefaultPdfPages = 100;
+
+// Text of a page range of a PDF, extracting only pages not in the page cache
+std::string read_pdf_content(const fs::path& path, int first_page, int max_pages, const ToolContext& ctx) {
+    fs::path cache_dir = ctx.config ? ctx.config->memory.storage_path / "pdf_cache" : fs::path();
+    auto range = PdfTextCache::open(cache_dir)->read(path, first_page, max_pages, open_poppler_pdf);
+    if (range.is_err()) {
         return "";
     }
+    const auto& doc = range.value();
+    spdlog::debug("PDF {}: {} pages read, {} extracted", path.string(), doc.pages.size(), doc.extracted);
 
     std::ostringstream result;
-    int total_pages = doc->pages();
-    int pages_to_read = std::min(total_pages, max_pages);
-
-    result << "PDF Document: " << total_pages << " pages\n";
+    result << "PDF Document: " << doc.total_pages << " pages\n";
     result << std::string(50, '-') << "\n\n";
 
-    for (int i = 0; i < pages_to_read; ++i) {
-        auto page = doc->create_page(i);
-        if (!page) continue;
-
-        result << "[Page " << (i + 1) << "]\n";
-
-        // Get text with proper layout
-        auto text = page->text().to_latin1();
-        if (!text.empty()) {
-            result << std::string(text.data(), text.size());
-        }
+    for (const auto& page : doc.pages) {
+        result << "[Page " << (page.number + 1) << "]\n";
+        result << page.text;
         result << "\n\n";
     }
 
-    if (pages_to_read < total_pages) {
-        result << "\n... (showing " << pages_to_read << " of " << total_pages << " pages)\n";
+    if (doc.pages.empty()) {
+        result << "(no pages at offset " << first_page << ")\n";
+    } else if (doc.pages.size() < static_cast<size_t>(doc.total_pages)) {
+        int first = doc.pages.front().number;
+        int last = doc.pages.back().number;
+        result << "\n... (showing pages " << (first + 1) << "-" << (last + 1) << " of " << doc.total_pages
+               << "; use offset=" << (last + 1) << " for the next pages)\n";
     }
 
     return result.str();
@@ -127,7 +131,9 @@ ToolResult file_read_handler(const Json& args, const ToolContext& ctx) {
     if (is_pdf_file(path)) {
 #ifdef HAVE_POPPLER
         try {
-            std::string pdf_content = read_pdf_content(path, 100);
+            // offset and limit count pages for PDFs
+            int pages = args.contains("limit") ? limit : kDefaultPdfPages;
+            std::string pdf_content = read_pdf_content(path, offset, pages, ctx);
             if (pdf_content.empty()) {
                 return ToolResult{
                     .success = false,
@@ -155,10 +161,10 @@ ToolResult file_read_handler(const Json& args, const ToolContext& ctx) {
 #endif
     }
 
-    // Read text file
+    // Read text file (mmap'd, line offsets cached across calls)
     try {
-        std::ifstream file(path);
-        if (!file) {
+        auto index = LineIndex::open(path);
+        if (index.is_err()) {
             return ToolResult{
                 .success = false,
                 .content = "",
@@ -167,21 +173,20 @@ ToolResult file_read_handler(const Json& args, const ToolContext& ctx) {
         }
 
         std::ostringstream result;
-        std::string line;
-        int line_num = 0;
-        int lines_read = 0;
-
-        while (std::getline(file, line) && lines_read < limit) {
-            if (line_num >= offset) {
-                // Truncate long lines
-                if (line.length() > 2000) {
-                    line = line.substr(0, 2000) + "... [truncated]";
-                }
-                result << std::setw(6) << (line_num + 1) << "\t" << line << "\n";
-                lines_read++;
+        size_t first = static_cast<size_t>(std::max(offset, 0));
+        size_t count = static_cast<size_t>(std::max(limit, 0));
+
+        index.value()->read_lines(first, count, [&](size_t line_num, std::string_view line) {
+            result << std::setw(6) << (line_num + 1) << "\t";
+            // Truncate long lines
+            if (line.length() > 2000) {
+                result << line.substr(0, 2000) << "... [truncated]";
+            } else {
+                result << line;
             }
-            line_num++;
-        }
+            result << "\n";
+            return true;
+        });
 
         return ToolResult{
             .success = true,
@@ -245,9 +250,6 @@ ToolResult file_write_handler(const Json& args, const ToolContext& ctx) {
 
 ToolResult file_edit_handler(const Json& args, const ToolContext& ctx) {
     std::string file_path = args.at("file_path").get<std::string>();
-    std::string old_string = args.at("old_string").get<std::string>();
-    std::string new_string = args.at("new_string").get<std::string>();
-    bool replace_all = args.value("replace_all", false);
 
     fs::path path(file_path);
 
@@ -270,58 +272,103 @@ ToolResult file_edit_handler(const Json& args, const ToolContext& ctx) {
     }
 
     try {
-        // Read current content
-        std::ifstream in_file(path);
-        if (!in_file) {
+        // A single old_string/new_string pair, or a batch applied in order
+        struct Edit {
+            std::string old_string;
+            std::string new_string;
+            bool replace_all;
+        };
+
+        std::vector<Edit> edits;
+        bool batch = args.contains("edits");
+        if (batch) {
+            for (const auto& edit : args.at("edits")) {
+                edits.push_back(Edit{
+                    edit.at("old_string").get<std::string>(),
+                    edit.at("new_string").get<std::string>(),
+                    edit.value("replace_all", false)
+                });
+            }
+        } else if (args.contains("old_string") && args.contains("new_string")) {
+            edits.push_back(Edit{
+                args.at("old_string").get<std::string>(),
+                args.at("new_string").get<std::string>(),
+                args.value("replace_all", false)
+            });
+        }
+
+        if (edits.empty()) {
             return ToolResult{
                 .success = false,
                 .content = "",
-                .error_message = "Failed to open file for reading: " + file_path
+                .error_message = "Provide old_string and new_string, or a non-empty edits list"
             };
         }
 
-        std::ostringstream ss;
-        ss << in_file.rdbuf();
-        std::string content = ss.str();
-        in_file.close();
-
-        // Find and replace
-        size_t pos = content.find(old_string);
-        if (pos == std::string::npos) {
+        // Read current content
+        MappedFile file;
+        if (!file.open(path)) {
             return ToolResult{
                 .success = false,
                 .content = "",
-                .error_message = "old_string not found in file. Make sure it matches exactly."
+                .error_message = "Failed to open file for reading: " + file_path
             };
         }
 
+        // Apply edits to a piece table over the original; nothing is copied
+        // until the result is written
+        PieceTable doc(file.data());
         int replacements = 0;
-        if (replace_all) {
-            while ((pos = content.find(old_string, pos)) != std::string::npos) {
-                content.replace(pos, old_string.length(), new_string);
-                pos += new_string.length();
-                replacements++;
+
+        for (size_t i = 0; i < edits.size(); ++i) {
+            const Edit& edit = edits[i];
+            std::string label = batch ? "Edit " + std::to_string(i + 1) + ": " : "";
+
+            if (edit.old_string.empty()) {
+                return ToolResult{
+                    .success = false,
+                    .content = "",
+                    .error_message = label + "old_string must not be empty"
+                };
             }
-        } else {
-            content.replace(pos, old_string.length(), new_string);
-            replacements = 1;
+
+            // Find and replace
+            size_t count = 0;
+            if (edit.replace_all) {
+                count = doc.replace_all(edit.old_string, edit.new_string);
+            } else if (size_t pos = doc.find(edit.old_string); pos != std::string::npos) {
+                doc.replace(pos, edit.old_string.size(), edit.new_string);
+                count = 1;
+            }
+
+            if (count == 0) {
+                return ToolResult{
+                    .success = false,
+                    .content = "",
+                    .error_message = label + "old_string not found in file. Make sure it matches exactly."
+                };
+            }
+            replacements += static_cast<int>(count);
         }
 
-        // Write back
-        std::ofstream out_file(path);
-        if (!out_file) {
+        // Write back atomically (temp file + rename)
+        auto written = write_file_atomic(path, doc.chunks());
+        if (written.is_err()) {
             return ToolResult{
                 .success = false,
                 .content = "",
-                .error_message = "Failed to open file for writing: " + file_path
+                .error_message = "Failed to write file: " + file_path + " (" + written.error().message + ")"
             };
         }
 
-        out_file << content;
+        std::string summary = batch ?
+            "Applied " + std::to_string(edits.size()) + " edit(s) with " +
+                std::to_string(replacements) + " replacement(s) to " + file_path :
+            "Made " + std::to_string(replacements) + " replacement(s) in " + file_path;
 
         return ToolResult{
             .success = true,
-            .content = "Made " + std::to_string(replacements) + " replacement(s) in " + file_path
+            .content = summary
         };
 
     } catch (const std::exception& e) {
@@ -336,6 +383,7 @@ ToolResult file_edit_handler(const Json& args, const ToolContext& ctx) {
 ToolResult glob_handler(const Json& args, const ToolContext& ctx) {
     std::string pattern = args.at("pattern").get<std::string>();
     std::string base_path = args.value("path", ctx.working_directory);
+    bool include_hidden = args.value("include_hidden", false);
 
     fs::path base(base_path);
 
@@ -348,58 +396,70 @@ ToolResult glob_handler(const Json& args, const ToolContext& ctx) {
             };
         }
 
-        std::vector<std::string> matches;
-
-        // Simple glob implementation (supports ** and *)
-        std::regex glob_regex;
-        try {
-            // Convert glob to regex
-            std::string regex_str = pattern;
-
-            // Escape special regex characters except * and ?
-            regex_str = std::regex_replace(regex_str, std::regex(R"([\.\+\^\$\|\(\)\[\]\{\}\\])"), R"(\$&)");
-
-            // Convert ** to match any path
-            regex_str = std::regex_replace(regex_str, std::regex(R"(\*\*)"), ".*");
-
-            // Convert * to match any filename (not /)
-            regex_str = std::regex_replace(regex_str, std::regex(R"(\*)"), "[^/]*");
-
-            // Convert ? to match single character
-            regex_str = std::regex_replace(regex_str, std::regex(R"(\?)"), ".");
+        // Absolute patterns are matched from the filesystem root
+        std::string rel_pattern = pattern;
+        if (fs::path(pattern).is_absolute()) {
+            base = fs::path(pattern).root_path();
+            rel_pattern = fs::path(pattern).relative_path().generic_string();
+        }
 
-            glob_regex = std::regex(regex_str);
-        } catch (const std::regex_error&) {
+        auto compiled = GlobMatcher::compile(rel_pattern);
+        if (compiled.is_err()) {
             return ToolResult{
                 .success = false,
                 .content = "",
-                .error_message = "Invalid glob pattern: " + pattern
+                .error_message = "Invalid glob pattern: " + compiled.error().message
             };
         }
+        const GlobMatcher& glob = compiled.value();
 
-        // Walk directory
-        for (const auto& entry : fs::recursive_directory_iterator(base,
-                fs::directory_options::skip_permission_denied)) {
-            if (!entry.is_regular_file()) continue;
+        // Start the walk below the pattern's literal directories and prune
+        // subtrees the pattern cannot reach
+        const std::string& prefix = glob.literal_prefix();
+        fs::path walk_root = base / prefix;
+        if (!fs::is_directory(walk_root)) {
+            return ToolResult{
+                .success = true,
+                .content = "No files found matching pattern"
+            };
+        }
 
-            std::string rel_path = fs::relative(entry.path(), base).string();
-            if (std::regex_match(rel_path, glob_regex)) {
-                matches.push_back(entry.path().string());
-            }
+        WalkOptions walk_options;
+        walk_options.include_hidden = include_hidden;
+        walk_options.stat_files = true;
+        auto full_path = [&](std::string_view rel) {
+            return prefix.empty() ? std::string(rel) : prefix + std::string(rel);
+        };
+        walk_options.dir_filter = [&](std::string_view dir) {
+            return glob.could_match_within(full_path(dir));
+        };
 
-            // Limit results
-            if (matches.size() >= 1000) break;
-        }
+        std::vector<std::pair<int64_t, std::string>> found;
+        std::mutex found_mutex;
+        const size_t max_results = 1000;
 
-        // Sort by modification time (newest first)
-        std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
-            try {
-                return fs::last_write_time(a) > fs::last_write_time(b);
-            } catch (...) {
-                return false;
+        FileWalker walker(walk_options);
+        walker.walk(walk_root, [&](const WalkEntry& entry) {
+            if (!glob.matches(full_path(entry.rel_path))) {
+                return true;
             }
+            std::lock_guard lock(found_mutex);
+            if (found.size() >= max_results) return false;
+            found.emplace_back(entry.mtime_ns, entry.path.string());
+            return found.size() < max_results;
         });
 
+        // Sort by modification time (newest first), path as tie-breaker
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+
+        std::vector<std::string> matches;
+        matches.reserve(found.size());
+        for (auto& [_, path] : found) {
+            matches.push_back(std::move(path));
+        }
+
         std::ostringstream result;
         for (const auto& m : matches) {
             result << m << "\n";
@@ -571,55 +631,41 @@ ToolResult list_directory_handler(const Json& args, const ToolContext& ctx) {
     }
 
     try {
-        std::ostringstream result;
-        int count = 0;
-        const int max_entries = 500;
+        DirListOptions options;
+        options.recursive = recursive;
+        options.include_hidden = show_hidden;
+        options.max_depth = max_depth;
+        auto listing = list_directory_tree(path, options);
 
-        std::function<void(const fs::path&, int)> list_dir = [&](const fs::path& p, int depth) {
-            if (count >= max_entries) return;
-            if (recursive && depth > max_depth) return;
-
-            std::string indent(depth * 2, ' ');
-
-            for (const auto& entry : fs::directory_iterator(p, fs::directory_options::skip_permission_denied)) {
-                if (count >= max_entries) break;
-
-                std::string name = entry.path().filename().string();
-
-                // Skip hidden files unless requested
-                if (!show_hidden && !name.empty() && name[0] == '.') {
-                    continue;
-                }
+        std::ostringstream result;
+        for (const auto& entry : listing.entries) {
+            std::string indent(entry.depth * 2, ' ');
+            std::string name(entry.name());
 
-                if (entry.is_directory()) {
+            switch (entry.type) {
+                case DirListEntry::Type::Directory:
                     result << indent << "[DIR]  " << name << "/\n";
-                    count++;
-                    if (recursive) {
-                        list_dir(entry.path(), depth + 1);
-                    }
-                } else if (entry.is_regular_file()) {
-                    auto size = fs::file_size(entry.path());
+                    break;
+                case DirListEntry::Type::File: {
                     std::string size_str;
-                    if (size < 1024) {
-                        size_str = std::to_string(size) + " B";
-                    } else if (size < 1024 * 1024) {
-                        size_str = std::to_string(size / 1024) + " KB";
+                    if (entry.size < 1024) {
+                        size_str = std::to_string(entry.size) + " B";
+                    } else if (entry.size < 1024 * 1024) {
+                        size_str = std::to_string(entry.size / 1024) + " KB";
                     } else {
-                        size_str = std::to_string(size / (1024 * 1024)) + " MB";
+                        size_str = std::to_string(entry.size / (1024 * 1024)) + " MB";
                     }
                     result << indent << "[FILE] " << name << " (" << size_str << ")\n";
-                    count++;
-                } else if (entry.is_symlink()) {
-                    result << indent << "[LINK] " << name << "\n";
-                    count++;
+                    break;
                 }
+                case DirListEntry::Type::Symlink:
+                    result << indent << "[LINK] " << name << "\n";
+                    break;
             }
-        };
-
-        list_dir(path, 0);
+        }
 
-        if (count >= max_entries) {
-            result << "\n... (truncated, " << max_entries << " entries shown)\n";
+        if (listing.truncated) {
+            result << "\n... (truncated, " << listing.entries.size() << " entries shown)\n";
         }
 
         return ToolResult{
@@ -654,52 +700,6 @@ ToolResult get_working_dir_handler(const Json& args, const ToolContext& ctx) {
     }
 }
 
-// Base64 encoding helper
-static const std::string base64_chars =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/";
-
-std::string base64_encode(const std::vector<unsigned char>& data) {
-    std::string ret;
-    int i = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-    size_t data_len = data.size();
-    const unsigned char* bytes_to_encode = data.data();
-
-    while (data_len--) {
-        char_array_3[i++] = *(bytes_to_encode++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for (i = 0; i < 4; i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
-    }
-
-    if (i) {
-        for (int j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-
-        for (int j = 0; j < i + 1; j++)
-            ret += base64_chars[char_array_4[j]];
-
-        while (i++ < 3)
-            ret += '=';
-    }
-
-    return ret;
-}
-
 // Check if file is an image based on extension
 bool is_image_file(const fs::path& path) {
     std::string ext = path.extension().string();
@@ -723,22 +723,14 @@ std::string get_image_mime_type(const fs::path& path) {
 
 // Compress and resize image to reduce latency
 // Target: ~1.15 megapixels (1092x1092 for 1:1 aspect ratio)
-struct CompressedImage {
-    std::vector<unsigned char> data;
-    std::string mime_type;
-    int width;
-    int height;
-    bool was_resized;
-};
-
-CompressedImage compress_image(const fs::path& path, int max_dimension = 1568) {
-    CompressedImage result;
-    result.was_resized = false;
-
-    QImage image(QString::fromStdString(path.string()));
+std::optional<ImageCache::Encoded> compress_image(const std::string& content, int max_dimension) {
+    ImageCache::Encoded result;
+
+    QImage image = QImage::fromData(reinterpret_cast<const uchar*>(content.data()),
+                                    static_cast<int>(content.size()));
     if (image.isNull()) {
-        spdlog::warn("Failed to load image with Qt: {}", path.string());
-        return result;
+        spdlog::warn("Failed to decode image with Qt ({} bytes)", content.size());
+        return std::nullopt;
     }
 
     result.width = image.width();
@@ -790,14 +782,15 @@ CompressedImage compress_image(const fs::path& path, int max_dimension = 1568) {
 
     // Use JPEG for compression (except for PNG with transparency)
     const char* format = "JPEG";
-    result.mime_type = "image/jpeg";
+    result.media_type = "image/jpeg";
 
-    // Check if original was PNG and might have transparency
-    std::string ext = path.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    if ((ext == ".png" || ext == ".gif") && image.hasAlphaChannel()) {
+    // Check if original was PNG/GIF and might have transparency (by content,
+    // so the cached result does not depend on the file name)
+    std::string_view magic(content.data(), std::min<size_t>(content.size(), 8));
+    bool png_or_gif = magic.starts_with("\x89PNG") || magic.starts_with("GIF8");
+    if (png_or_gif && image.hasAlphaChannel()) {
         format = "PNG";
-        result.mime_type = "image/png";
+        result.media_type = "image/png";
         image.save(&buffer, format);
     } else {
         // Convert to RGB if needed (remove alpha for JPEG)
@@ -809,10 +802,9 @@ CompressedImage compress_image(const fs::path& path, int max_dimension = 1568) {
 
     buffer.close();
 
-    result.data.resize(ba.size());
-    std::memcpy(result.data.data(), ba.constData(), ba.size());
+    result.bytes.assign(ba.constData(), static_cast<size_t>(ba.size()));
 
-    spdlog::info("Compressed image size: {} bytes", result.data.size());
+    spdlog::info("Compressed image size: {} bytes", result.bytes.size());
 
     return result;
 }
@@ -863,35 +855,34 @@ ToolResult image_read_handler(const Json& args, const ToolContext& ctx) {
     }
 
     try {
-        // Compress and resize image for optimal API performance
-        auto compressed = compress_image(path);
-
-        if (compressed.data.empty()) {
+        // Compress and resize image for optimal API performance, once per
+        // distinct content
+        auto loaded = ImageCache::shared().load(path, 1568, compress_image);
+        if (loaded.is_err()) {
             return ToolResult{
                 .success = false,
                 .content = "",
                 .error_message = "Failed to process image file: " + file_path
             };
         }
+        const auto& image = *loaded.value();
 
-        // Encode to base64
-        std::string base64_data = base64_encode(compressed.data);
-
-        // Return as JSON with image data
+        // The base64 payload stays in the image cache; the orchestrator
+        // attaches it to the message by id
         Json result = {
             {"type", "image"},
-            {"media_type", compressed.mime_type},
-            {"data", base64_data},
+            {"media_type", image.media_type},
+            {"image_id", image.id},
             {"file_path", file_path},
             {"original_size", file_size},
-            {"compressed_size", compressed.data.size()},
-            {"width", compressed.width},
-            {"height", compressed.height},
-            {"was_resized", compressed.was_resized}
+            {"compressed_size", image.encoded_size},
+            {"width", image.width},
+            {"height", image.height},
+            {"was_resized", image.was_resized}
         };
 
         spdlog::info("Image ready: {}x{}, {} bytes base64",
-                     compressed.width, compressed.height, base64_data.size());
+                     image.width, image.height, image.base64->size());
 
         return ToolResult{
             .success = true,
@@ -913,11 +904,11 @@ void register_file_tools(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "file_read",
-            .description = "Read the contents of a file. Supports text files (returns lines with line numbers) and PDF files (extracts text content).",
+            .description = "Read the contents of a file. Supports text files (returns lines with line numbers) and PDF files (extracts text content page by page).",
             .parameters = {
                 {"file_path", "The absolute path to the file to read (supports .txt, .pdf, and other text files)", ParamType::String, true},
-                {"offset", "Line number to start reading from (0-indexed, text files only)", ParamType::Integer, false},
-                {"limit", "Maximum number of lines to read (default: 2000, text files only)", ParamType::Integer, false}
+                {"offset", "Line number to start reading from (0-indexed); for PDFs, the page to start from (0-indexed)", ParamType::Integer, false},
+                {"limit", "Maximum number of lines to read (default: 2000); for PDFs, the number of pages (default: 100)", ParamType::Integer, false}
             },
             .keywords = {"read", "file", "content", "view", "cat", "open", "pdf"}
         },
@@ -956,12 +947,15 @@ void register_file_tools(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "file_edit",
-            .description = "Edit a file by replacing exact text. The old_string must match exactly.",
+            .description = "Edit a file by replacing exact text. The old_string must match exactly. "
+                           "Use edits to apply several replacements in one call; they are applied in order "
+                           "and the file is only written if all of them succeed.",
             .parameters = {
                 {"file_path", "The absolute path to the file to edit", ParamType::String, true},
-                {"old_string", "The exact string to replace (must be unique or use replace_all)", ParamType::String, true},
-                {"new_string", "The replacement string", ParamType::String, true},
-                {"replace_all", "Replace all occurrences (default: false)", ParamType::Boolean, false}
+                {"old_string", "The exact string to replace (must be unique or use replace_all)", ParamType::String, false},
+                {"new_string", "The replacement string", ParamType::String, false},
+                {"replace_all", "Replace all occurrences (default: false)", ParamType::Boolean, false},
+                {"edits", "Batch of edits: list of {old_string, new_string, replace_all} objects", ParamType::Array, false}
             },
             .keywords = {"edit", "file", "modify", "replace", "change", "update"},
             .requires_confirmation = true
@@ -973,10 +967,11 @@ void register_file_tools(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "glob",
-            .description = "Find files matching a glob pattern. Supports ** for recursive matching.",
+            .description = "Find files matching a glob pattern. Supports **, *, ?, [abc] and {a,b}. Skips files ignored by .gitignore.",
             .parameters = {
                 {"pattern", "The glob pattern to match (e.g., **/*.cpp, src/**/*.hpp)", ParamType::String, true},
-                {"path", "Base directory to search in (default: working directory)", ParamType::String, false}
+                {"path", "Base directory to search in (default: working directory)", ParamType::String, false},
+                {"include_hidden", "Include hidden files and directories (default: false)", ParamType::Boolean, false}
             },
             .keywords = {"find", "file", "glob", "pattern", "search", "list"}
         },
@@ -1,5 +1,8 @@
 #include "gpagent/tools/tool_registry.hpp"
+#include "gpagent/tools/git_porcelain.hpp"
+#include "gpagent/tools/git_status_engine.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdio>
 #include <filesystem>
@@ -42,6 +45,14 @@ bool is_git_repo(const std::string& path) {
     return fs::exists(git_dir);
 }
 
+// In-process reader for the repository, or nullptr to use the git CLI.
+// Read calls fall back to the CLI on any error (unsupported repository
+// format, content filters, pathspec magic, ...).
+std::shared_ptr<git::Repository> open_repository(const std::string& path) {
+    auto repo = git::Repository::for_work_tree(path);
+    return repo.is_ok() ? repo.value() : nullptr;
+}
+
 ToolResult git_status_handler(const Json& args, const ToolContext& ctx) {
     std::string repo_path = args.value("path", ctx.working_directory);
 
@@ -53,6 +64,17 @@ ToolResult git_status_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    // Kept warm across calls: only paths changed since the last call are rechecked
+    if (auto engine = git::StatusEngine::for_work_tree(repo_path); engine.is_ok()) {
+        auto status = engine.value()->status();
+        if (status.is_ok()) {
+            return ToolResult{
+                .success = true,
+                .content = git::format_status(status.value())
+            };
+        }
+    }
+
     auto [exit_code, output] = exec_command("git status", repo_path);
 
     if (exit_code != 0) {
@@ -82,6 +104,17 @@ ToolResult git_diff_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    if (auto repo = open_repository(repo_path)) {
+        auto diff = git::format_diff(*repo, staged ? git::DiffTarget::Staged : git::DiffTarget::Worktree,
+                                     file_path);
+        if (diff.is_ok()) {
+            return ToolResult{
+                .success = true,
+                .content = diff.value().empty() ? "No changes" : diff.value()
+            };
+        }
+    }
+
     std::string cmd = "git diff";
     if (staged) {
         cmd += " --staged";
@@ -126,6 +159,16 @@ ToolResult git_log_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    if (auto repo = open_repository(repo_path)) {
+        auto log = git::format_log(*repo, static_cast<size_t>(std::max(num_commits, 0)), oneline);
+        if (log.is_ok()) {
+            return ToolResult{
+                .success = true,
+                .content = log.value()
+            };
+        }
+    }
+
     std::string cmd = "git log -n " + std::to_string(num_commits);
     if (oneline) {
         cmd += " --oneline";
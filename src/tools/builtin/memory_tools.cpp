@@ -1,22 +1,81 @@
 #include "gpagent/tools/tool_registry.hpp"
+#include "gpagent/memory/kv_store.hpp"
+#include "gpagent/core/config.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
+#include <sstream>
 
 namespace gpagent::tools::builtin {
 
 namespace fs = std::filesystem;
+using memory::KvStore;
+
+// Memories live in the memory database under the configured storage path,
+// shared with the MemoryManager's cross-thread facts. Values are stored as
+// JSON strings.
+
+// Import the per-key text files written by earlier versions, once
+static void import_legacy_memories(KvStore& store) {
+    const char* home = std::getenv("HOME");
+    if (!home) return;
+    fs::path legacy = fs::path(home) / ".gpagent" / "memory";
+
+    std::error_code ec;
+    if (!fs::is_directory(legacy, ec)) return;
+
+    auto imported = store.batch([&](KvStore& kv) {
+        for (const auto& ns_dir : fs::directory_iterator(legacy, ec)) {
+            if (!ns_dir.is_directory()) continue;
+            for (const auto& entry : fs::directory_iterator(ns_dir.path(), ec)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+                std::ifstream file(entry.path(), std::ios::binary);
+                std::ostringstream ss;
+                ss << file.rdbuf();
+                std::string ns = ns_dir.path().filename().string();
+                std::string key = entry.path().stem().string();
+                // Legacy files were written as-is; invalid UTF-8 becomes U+FFFD
+                std::string value = Json(ss.str()).dump(-1, ' ', false, Json::error_handler_t::replace);
+                if (kv.put(ns, key, value).is_err()) return false;
+            }
+        }
+        return true;
+    });
+    if (imported.is_ok()) {
+        fs::rename(legacy, fs::path(legacy) += ".imported", ec);
+    }
+}
 
-// Note: These tools use a simple file-based storage.
-// In production, they would integrate with the MemoryManager.
+static Result<std::shared_ptr<KvStore>, Error> get_memory_store(const ToolContext& ctx) {
+    fs::path storage = ctx.config ? ctx.config->memory.storage_path : fs::path();
+    if (storage.empty()) {
+        const char* home = std::getenv("HOME");
+        storage = fs::path(home ? home : ctx.working_directory) / ".gpagent" / "storage";
+    }
 
-static fs::path get_memory_path(const ToolContext& ctx) {
-    fs::path base = ctx.working_directory;
-    if (const char* home = std::getenv("HOME")) {
-        base = fs::path(home) / ".gpagent" / "memory";
+    auto store = KvStore::open(memory::memory_db_path(storage));
+    if (store.is_ok()) {
+        static std::once_flag imported;
+        std::call_once(imported, [&] { import_legacy_memories(*store.value()); });
     }
-    fs::create_directories(base);
-    return base;
+    return store;
+}
+
+// Stored JSON as text for the model: strings verbatim, anything else as JSON
+static std::string memory_text(const std::string& stored) {
+    Json value = Json::parse(stored, nullptr, false);
+    if (value.is_discarded()) return stored;
+    return value.is_string() ? value.get<std::string>() : value.dump(2);
+}
+
+static ToolResult memory_error(const std::string& what, const Error& error) {
+    return ToolResult{
+        .success = false,
+        .content = "",
+        .error_message = what + ": " + error.message
+    };
 }
 
 ToolResult memory_store_handler(const Json& args, const ToolContext& ctx) {
@@ -35,144 +94,144 @@ ToolResult memory_store_handler(const Json& args, const ToolContext& ctx) {
         }
     }
 
-    try {
-        fs::path memory_dir = get_memory_path(ctx) / ns;
-        fs::create_directories(memory_dir);
-
-        fs::path file_path = memory_dir / (key + ".txt");
-        std::ofstream file(file_path);
-        if (!file) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "Failed to write memory file"
-            };
-        }
-
-        file << value;
-
-        return ToolResult{
-            .success = true,
-            .content = "Stored '" + key + "' in namespace '" + ns + "'"
-        };
+    auto store = get_memory_store(ctx);
+    if (store.is_err()) {
+        return memory_error("Error storing memory", store.error());
+    }
 
-    } catch (const std::exception& e) {
-        return ToolResult{
-            .success = false,
-            .content = "",
-            .error_message = std::string("Error storing memory: ") + e.what()
-        };
+    auto stored = store.value()->put(ns, key, Json(value).dump());
+    if (stored.is_err()) {
+        return memory_error("Error storing memory", stored.error());
     }
+
+    return ToolResult{
+        .success = true,
+        .content = "Stored '" + key + "' in namespace '" + ns + "'"
+    };
 }
 
 ToolResult memory_retrieve_handler(const Json& args, const ToolContext& ctx) {
     std::string key = args.at("key").get<std::string>();
     std::string ns = args.value("namespace", "default");
 
-    try {
-        fs::path file_path = get_memory_path(ctx) / ns / (key + ".txt");
-
-        if (!fs::exists(file_path)) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "Key not found: " + key + " in namespace " + ns
-            };
-        }
-
-        std::ifstream file(file_path);
-        if (!file) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "Failed to read memory file"
-            };
-        }
-
-        std::ostringstream ss;
-        ss << file.rdbuf();
+    auto store = get_memory_store(ctx);
+    if (store.is_err()) {
+        return memory_error("Error retrieving memory", store.error());
+    }
 
-        return ToolResult{
-            .success = true,
-            .content = ss.str()
-        };
+    auto value = store.value()->get(ns, key);
+    if (value.is_err()) {
+        return memory_error("Error retrieving memory", value.error());
+    }
 
-    } catch (const std::exception& e) {
+    if (!value.value()) {
         return ToolResult{
             .success = false,
             .content = "",
-            .error_message = std::string("Error retrieving memory: ") + e.what()
+            .error_message = "Key not found: " + key + " in namespace " + ns
         };
     }
+
+    return ToolResult{
+        .success = true,
+        .content = memory_text(*value.value())
+    };
 }
 
 ToolResult memory_list_handler(const Json& args, const ToolContext& ctx) {
     std::string ns = args.value("namespace", "default");
+    std::string prefix = args.value("prefix", "");
 
-    try {
-        fs::path memory_dir = get_memory_path(ctx) / ns;
-
-        if (!fs::exists(memory_dir)) {
-            return ToolResult{
-                .success = true,
-                .content = "No memories stored in namespace '" + ns + "'"
-            };
-        }
-
-        std::ostringstream result;
-        result << "Memories in namespace '" << ns << "':\n";
+    auto store = get_memory_store(ctx);
+    if (store.is_err()) {
+        return memory_error("Error listing memories", store.error());
+    }
 
-        for (const auto& entry : fs::directory_iterator(memory_dir)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".txt") {
-                std::string key = entry.path().stem().string();
-                auto size = fs::file_size(entry.path());
-                result << "  - " << key << " (" << size << " bytes)\n";
-            }
-        }
+    auto items = store.value()->scan(ns, prefix);
+    if (items.is_err()) {
+        return memory_error("Error listing memories", items.error());
+    }
 
+    if (items.value().empty()) {
         return ToolResult{
             .success = true,
-            .content = result.str()
+            .content = "No memories stored in namespace '" + ns + "'" +
+                       (prefix.empty() ? "" : " with prefix '" + prefix + "'")
         };
+    }
 
-    } catch (const std::exception& e) {
-        return ToolResult{
-            .success = false,
-            .content = "",
-            .error_message = std::string("Error listing memories: ") + e.what()
-        };
+    std::ostringstream result;
+    result << "Memories in namespace '" << ns << "':\n";
+    for (const auto& item : items.value()) {
+        result << "  - " << item.key << " (" << memory_text(item.value).size() << " bytes)\n";
     }
+
+    return ToolResult{
+        .success = true,
+        .content = result.str()
+    };
 }
 
 ToolResult memory_delete_handler(const Json& args, const ToolContext& ctx) {
     std::string key = args.at("key").get<std::string>();
     std::string ns = args.value("namespace", "default");
 
-    try {
-        fs::path file_path = get_memory_path(ctx) / ns / (key + ".txt");
-
-        if (!fs::exists(file_path)) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "Key not found: " + key
-            };
-        }
+    auto store = get_memory_store(ctx);
+    if (store.is_err()) {
+        return memory_error("Error deleting memory", store.error());
+    }
 
-        fs::remove(file_path);
+    auto removed = store.value()->remove(ns, key);
+    if (removed.is_err()) {
+        return memory_error("Error deleting memory", removed.error());
+    }
 
+    if (!removed.value()) {
         return ToolResult{
-            .success = true,
-            .content = "Deleted '" + key + "' from namespace '" + ns + "'"
+            .success = false,
+            .content = "",
+            .error_message = "Key not found: " + key
         };
+    }
+
+    return ToolResult{
+        .success = true,
+        .content = "Deleted '" + key + "' from namespace '" + ns + "'"
+    };
+}
+
+ToolResult memory_search_handler(const Json& args, const ToolContext& ctx) {
+    std::string query = args.at("query").get<std::string>();
+    std::string ns = args.value("namespace", "");
+    int limit = std::clamp(args.value("limit", 10), 1, 100);
+
+    auto store = get_memory_store(ctx);
+    if (store.is_err()) {
+        return memory_error("Error searching memories", store.error());
+    }
+
+    auto hits = store.value()->search(query, ns, static_cast<size_t>(limit));
+    if (hits.is_err()) {
+        return memory_error("Error searching memories", hits.error());
+    }
 
-    } catch (const std::exception& e) {
+    if (hits.value().empty()) {
         return ToolResult{
-            .success = false,
-            .content = "",
-            .error_message = std::string("Error deleting memory: ") + e.what()
+            .success = true,
+            .content = "No memories match '" + query + "'"
         };
     }
+
+    std::ostringstream result;
+    result << "Memories matching '" << query << "' (best first):\n";
+    for (const auto& hit : hits.value()) {
+        result << "  - " << hit.key << " [" << hit.ns << "]: " << hit.snippet << "\n";
+    }
+
+    return ToolResult{
+        .success = true,
+        .content = result.str()
+    };
 }
 
 // Register memory tools
@@ -211,7 +270,8 @@ void register_memory_tools(ToolRegistry& registry) {
             .name = "memory_list",
             .description = "List all stored memories in a namespace.",
             .parameters = {
-                {"namespace", "Namespace to list (default: 'default')", ParamType::String, false}
+                {"namespace", "Namespace to list (default: 'default')", ParamType::String, false},
+                {"prefix", "Only list keys starting with this prefix", ParamType::String, false}
             },
             .keywords = {"memory", "list", "show", "keys"}
         },
@@ -219,6 +279,21 @@ void register_memory_tools(ToolRegistry& registry) {
         "builtin"
     );
 
+    registry.register_tool(
+        ToolSpec{
+            .name = "memory_search",
+            .description = "Search stored memories by content when the key is not known. Returns matching keys with excerpts, best matches first.",
+            .parameters = {
+                {"query", "Words to look for in memory keys and values", ParamType::String, true},
+                {"namespace", "Only search this namespace (default: all)", ParamType::String, false},
+                {"limit", "Maximum number of results (default: 10)", ParamType::Integer, false}
+            },
+            .keywords = {"memory", "search", "find", "recall", "lookup"}
+        },
+        memory_search_handler,
+        "builtin"
+    );
+
     registry.register_tool(
         ToolSpec{
             .name = "memory_delete",
@@ -1,104 +1,190 @@
 #include "gpagent/tools/tool_registry.hpp"
+#include "gpagent/tools/file_walker.hpp"
+#include "gpagent/tools/glob_matcher.hpp"
+#include "gpagent/tools/search_engine.hpp"
+#include "gpagent/tools/trigram_index.hpp"
+#include "gpagent/core/config.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
-#include <fstream>
-#include <regex>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 namespace gpagent::tools::builtin {
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Files that may match according to the project's trigram index (relative to
+// search_path), or nullopt if the index does not apply and the tree must be
+// walked. The index covers the working directory with default walk options.
+std::optional<std::vector<std::string>> indexed_candidates(const SearchPattern& pattern,
+                                                        const fs::path& search_path,
+                                                        const ToolContext& ctx) {
+    if (!ctx.config || !ctx.config->tools.search_index) return std::nullopt;
+    if (pattern.required_literal().size() < 3 || ctx.working_directory.empty()) {
+        return std::nullopt;
+    }
+
+    std::error_code ec;
+    fs::path project = fs::weakly_canonical(ctx.working_directory, ec);
+    if (ec) return std::nullopt;
+    fs::path target = fs::weakly_canonical(search_path, ec);
+    if (ec) return std::nullopt;
+
+    std::string prefix = target.lexically_relative(project).generic_string();
+    if (prefix.empty() || prefix.starts_with("..")) return std::nullopt;
+    prefix = prefix == "." ? "" : prefix + "/";
+
+    // The first build reads every file; scan this time and index in the background
+    auto index = TrigramIndex::for_project(project, ctx.config->memory.storage_path / "projects");
+    if (!index->ready()) {
+        index->build_async();
+        return std::nullopt;
+    }
+    if (!index->refresh()) return std::nullopt;
+
+    auto rel_paths = index->candidates(pattern.required_literal(), prefix);
+    if (!rel_paths) return std::nullopt;
+
+    for (auto& rel : *rel_paths) {
+        rel.erase(0, prefix.size());
+    }
+    return rel_paths;
+}
+
+}  // namespace
+
 ToolResult grep_handler(const Json& args, const ToolContext& ctx) {
     std::string pattern_str = args.at("pattern").get<std::string>();
     std::string path = args.value("path", ctx.working_directory);
     std::string glob_filter = args.value("glob", "");
     std::string output_mode = args.value("output_mode", "files_with_matches");
+    bool include_hidden = args.value("include_hidden", false);
 
     fs::path search_path(path);
 
-    // Build regex
-    std::regex pattern;
-    try {
-        pattern = std::regex(pattern_str, std::regex::ECMAScript);
-    } catch (const std::regex_error& e) {
+    // Compile pattern (lazy DFA with literal prefilter, std::regex fallback)
+    auto compiled = SearchPattern::compile(pattern_str);
+    if (compiled.is_err()) {
         return ToolResult{
             .success = false,
             .content = "",
-            .error_message = std::string("Invalid regex pattern: ") + e.what()
+            .error_message = "Invalid regex pattern: " + compiled.error().message
         };
     }
+    const SearchPattern& pattern = compiled.value();
 
-    // Build glob filter regex if provided
-    std::regex glob_regex;
-    bool has_glob = !glob_filter.empty();
-    if (has_glob) {
-        try {
-            std::string glob_regex_str = glob_filter;
-            glob_regex_str = std::regex_replace(glob_regex_str, std::regex(R"([\.\+\^\$\|\(\)\[\]\{\}\\])"), R"(\$&)");
-            glob_regex_str = std::regex_replace(glob_regex_str, std::regex(R"(\*\*)"), ".*");
-            glob_regex_str = std::regex_replace(glob_regex_str, std::regex(R"(\*)"), "[^/]*");
-            glob_regex = std::regex(glob_regex_str);
-        } catch (...) {
-            has_glob = false;
+    // Compile glob filter if provided. Globs without '/' match file names,
+    // otherwise paths relative to the search directory.
+    std::optional<GlobMatcher> glob;
+    if (!glob_filter.empty()) {
+        auto compiled_glob = GlobMatcher::compile(glob_filter);
+        if (compiled_glob.is_err()) {
+            return ToolResult{
+                .success = false,
+                .content = "",
+                .error_message = "Invalid glob pattern: " + compiled_glob.error().message
+            };
         }
+        glob = std::move(compiled_glob).value();
     }
 
-    std::vector<std::pair<std::string, std::vector<std::pair<int, std::string>>>> matches;
-    int total_matches = 0;
+    using FileMatches = std::vector<std::pair<int, std::string>>;
+    std::vector<std::pair<std::string, FileMatches>> matches;
+    std::mutex matches_mutex;
+    std::atomic<int> total_matches{0};
     const int max_matches = 100;
-    const int max_files = 50;
+    const size_t max_files = 50;
 
-    auto process_file = [&](const fs::path& file_path) {
-        if (total_matches >= max_matches || matches.size() >= max_files) {
-            return;
-        }
+    auto limits_reached = [&] {
+        return total_matches.load() >= max_matches || matches.size() >= max_files;
+    };
 
+    // Search one file; returns false once the limits are reached
+    auto process_file = [&](const fs::path& file_path, std::string_view rel_path, Searcher& searcher) {
         // Apply glob filter
-        if (has_glob) {
-            std::string filename = file_path.filename().string();
-            if (!std::regex_match(filename, glob_regex)) {
-                return;
+        if (glob) {
+            std::string_view subject = rel_path;
+            if (!glob->has_separator()) {
+                size_t slash = subject.rfind('/');
+                if (slash != std::string_view::npos) subject.remove_prefix(slash + 1);
+            }
+            if (!glob->matches(subject)) {
+                return true;
             }
         }
 
-        std::ifstream file(file_path);
-        if (!file) return;
+        MappedFile file;
+        if (!file.open(file_path)) return true;
 
-        std::vector<std::pair<int, std::string>> file_matches;
-        std::string line;
-        int line_num = 0;
+        // Skip binary files
+        if (is_binary_content(file.data())) return true;
 
-        while (std::getline(file, line) && total_matches < max_matches) {
-            line_num++;
-            if (std::regex_search(line, pattern)) {
-                file_matches.emplace_back(line_num, line);
-                total_matches++;
-            }
-        }
+        FileMatches file_matches;
 
-        if (!file_matches.empty()) {
+        searcher.search(file.data(), [&](size_t line_num, std::string_view line) {
+            if (total_matches.fetch_add(1) >= max_matches) return false;
+            file_matches.emplace_back(static_cast<int>(line_num), std::string(line));
+            return true;
+        });
+
+        std::lock_guard lock(matches_mutex);
+        if (!file_matches.empty() && matches.size() < max_files) {
             matches.emplace_back(file_path.string(), std::move(file_matches));
         }
+        return !limits_reached();
     };
 
     try {
         if (fs::is_regular_file(search_path)) {
-            process_file(search_path);
+            Searcher searcher(pattern);
+            process_file(search_path, search_path.filename().string(), searcher);
         } else if (fs::is_directory(search_path)) {
-            for (const auto& entry : fs::recursive_directory_iterator(search_path,
-                    fs::directory_options::skip_permission_denied)) {
-                if (!entry.is_regular_file()) continue;
+            auto candidates = include_hidden ? std::nullopt :
+                indexed_candidates(pattern, search_path, ctx);
 
-                // Skip binary files and large files
-                auto size = entry.file_size();
-                if (size > 10 * 1024 * 1024) continue;  // Skip files > 10MB
+            WalkOptions walk_options;
+            walk_options.include_hidden = include_hidden;
+            walk_options.max_file_size = 10 * 1024 * 1024;  // Skip files > 10MB
+            if (glob && glob->has_separator()) {
+                walk_options.dir_filter = [&](std::string_view dir) {
+                    return glob->could_match_within(dir);
+                };
+            }
 
-                process_file(entry.path());
+            // One searcher per worker (the DFA cache is not thread-safe)
+            FileWalker walker(walk_options);
+            std::vector<Searcher> searchers;
+            searchers.reserve(walker.num_threads());
+            for (size_t i = 0; i < walker.num_threads(); ++i) {
+                searchers.emplace_back(pattern);
+            }
 
-                if (total_matches >= max_matches || matches.size() >= max_files) {
-                    break;
+            if (candidates) {
+                // Verify only the files the index selected
+                std::atomic<size_t> next{0};
+                auto verify = [&](Searcher& searcher) {
+                    for (size_t i; (i = next.fetch_add(1)) < candidates->size();) {
+                        const std::string& rel = (*candidates)[i];
+                        if (!process_file(search_path / rel, rel, searcher)) break;
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                size_t num_threads = std::min(searchers.size(), candidates->size() / 16 + 1);
+                for (size_t t = 1; t < num_threads; ++t) {
+                    threads.emplace_back(verify, std::ref(searchers[t]));
                 }
+                verify(searchers[0]);
+                for (auto& t : threads) t.join();
+            } else {
+                walker.walk(search_path, [&](const WalkEntry& entry) {
+                    return process_file(entry.path, entry.rel_path, searchers[entry.worker]);
+                });
             }
         }
     } catch (const std::exception& e) {
@@ -109,6 +195,11 @@ ToolResult grep_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    // Workers finish in any order; keep output stable
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
     // Format output based on mode
     std::ostringstream result;
 
@@ -133,7 +224,7 @@ ToolResult grep_handler(const Json& args, const ToolContext& ctx) {
     std::string output = result.str();
     if (output.empty()) {
         output = "No matches found";
-    } else if (total_matches >= max_matches) {
+    } else if (total_matches.load() >= max_matches) {
         output += "\n... [results limited to " + std::to_string(max_matches) + " matches]";
     }
 
@@ -147,13 +238,14 @@ void register_search_tools(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "grep",
-            .description = "Search for a regex pattern in files. Returns matching lines with file paths and line numbers.",
+            .description = "Search for a regex pattern in files. Returns matching lines with file paths and line numbers. Skips files ignored by .gitignore.",
             .parameters = {
                 {"pattern", "The regex pattern to search for", ParamType::String, true},
                 {"path", "File or directory to search in (default: working directory)", ParamType::String, false},
-                {"glob", "Glob pattern to filter files (e.g., *.cpp, *.py)", ParamType::String, false},
+                {"glob", "Glob pattern to filter files (e.g., *.cpp, *.{h,hpp}, src/**/*.py)", ParamType::String, false},
                 {"output_mode", "Output mode: content (default), files_with_matches, or count", ParamType::String, false,
-                    std::nullopt, std::vector<std::string>{"content", "files_with_matches", "count"}}
+                    std::nullopt, std::vector<std::string>{"content", "files_with_matches", "count"}},
+                {"include_hidden", "Include hidden files and directories (default: false)", ParamType::Boolean, false}
             },
             .keywords = {"search", "grep", "find", "pattern", "regex", "match"}
         },
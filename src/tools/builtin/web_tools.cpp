@@ -1,101 +1,60 @@
 #include "gpagent/tools/tool_registry.hpp"
+#include "gpagent/tools/html_text.hpp"
+#include "gpagent/tools/http_cache.hpp"
 #include "gpagent/core/config.hpp"
 
 #define CPPHTTPLIB_OPENSSL_SUPPORT
 #include <httplib.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <iomanip>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 namespace gpagent::tools::builtin {
 
-// Simple HTML to text converter using string operations (avoid regex for stability)
-std::string html_to_text(const std::string& html) {
-    std::string text;
-    text.reserve(html.size());
-
-    bool in_tag = false;
-    bool in_script = false;
-    bool in_style = false;
-
-    for (size_t i = 0; i < html.size(); ++i) {
-        char c = html[i];
-
-        if (c == '<') {
-            in_tag = true;
-            // Check for script/style tags
-            if (i + 7 < html.size()) {
-                std::string tag = html.substr(i, 7);
-                if (tag == "<script" || tag == "<SCRIPT") in_script = true;
-                if (i + 6 < html.size() && (html.substr(i, 6) == "<style" || html.substr(i, 6) == "<STYLE")) in_style = true;
-            }
-            // Check for closing script/style
-            if (i + 9 < html.size() && (html.substr(i, 9) == "</script>" || html.substr(i, 9) == "</SCRIPT>")) in_script = false;
-            if (i + 8 < html.size() && (html.substr(i, 8) == "</style>" || html.substr(i, 8) == "</STYLE>")) in_style = false;
-
-            // Add newlines for block elements
-            if (i + 3 < html.size()) {
-                std::string tag3 = html.substr(i, 3);
-                if (tag3 == "<br" || tag3 == "<BR" || tag3 == "<p>" || tag3 == "<P>" ||
-                    tag3 == "<di" || tag3 == "<DI" || tag3 == "<li" || tag3 == "<LI") {
-                    text += '\n';
-                }
-            }
-            continue;
-        }
+// Bytes of an HTML page fed to the extractor; the rest is not downloaded
+constexpr size_t kMaxHtmlBytes = 10 * 1024 * 1024;
 
-        if (c == '>') {
-            in_tag = false;
-            continue;
-        }
+// web_fetch_batch: URLs per call, downloads in flight overall and per host
+constexpr size_t kMaxBatchUrls = 20;
+constexpr size_t kMaxConcurrentFetches = 8;
+constexpr size_t kMaxFetchesPerHost = 2;
 
-        // Skip content inside tags, scripts, and styles
-        if (in_tag || in_script || in_style) continue;
-
-        // Handle HTML entities
-        if (c == '&' && i + 1 < html.size()) {
-            if (html.substr(i, 6) == "&nbsp;") { text += ' '; i += 5; continue; }
-            if (html.substr(i, 5) == "&amp;") { text += '&'; i += 4; continue; }
-            if (html.substr(i, 4) == "&lt;") { text += '<'; i += 3; continue; }
-            if (html.substr(i, 4) == "&gt;") { text += '>'; i += 3; continue; }
-            if (html.substr(i, 6) == "&quot;") { text += '"'; i += 5; continue; }
-            if (html.substr(i, 5) == "&#39;") { text += '\''; i += 4; continue; }
-        }
+// Redirect hops followed by web_fetch before giving up
+constexpr int kMaxRedirects = 10;
 
-        text += c;
-    }
+// HTML by Content-Type, or by sniffing the start of the body
+bool is_html(const std::string& content_type, std::string_view head) {
+    auto lower = [](std::string_view s) {
+        std::string out(s);
+        std::transform(out.begin(), out.end(), out.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return out;
+    };
+    if (lower(content_type).find("html") != std::string::npos) return true;
+    std::string start = lower(head.substr(0, 1024));
+    return start.find("<html") != std::string::npos || start.find("<!doctype html") != std::string::npos;
+}
 
-    // Collapse whitespace
-    std::string result;
-    result.reserve(text.size());
-    bool last_was_space = false;
-    bool last_was_newline = false;
+// Response headers that decide whether and how long a page is cached
+constexpr const char* kCacheHeaders[] = {
+    "Cache-Control", "Pragma", "Expires", "Date", "Age", "Last-Modified", "ETag", "Vary"
+};
 
-    for (char c : text) {
-        if (c == '\n' || c == '\r') {
-            if (!last_was_newline) {
-                result += '\n';
-                last_was_newline = true;
-            }
-            last_was_space = false;
-        } else if (c == ' ' || c == '\t') {
-            if (!last_was_space && !last_was_newline) {
-                result += ' ';
-                last_was_space = true;
-            }
-        } else {
-            result += c;
-            last_was_space = false;
-            last_was_newline = false;
-        }
-    }
+// Shared response cache, or null when disabled
+std::shared_ptr<HttpCache> response_cache(const ToolContext& ctx) {
+    if (!ctx.config || !ctx.config->tools.http_cache) return nullptr;
+    return HttpCache::open(ctx.config->memory.storage_path / "http_cache",
+                           static_cast<uint64_t>(std::max(ctx.config->tools.http_cache_max_mb, 1)) * 1024 * 1024);
+}
 
-    // Trim
-    size_t start = result.find_first_not_of(" \t\n\r");
-    if (start == std::string::npos) return "";
-    size_t end = result.find_last_not_of(" \t\n\r");
-    return result.substr(start, end - start + 1);
+bool offline_mode(const ToolContext& ctx) {
+    return ctx.config && ctx.config->tools.http_cache_offline;
 }
 
 // URL encode a string
@@ -389,87 +348,388 @@ std::vector<SearchResult> search_perplexity(const std::string& query, int num_re
 }
 
 // =============================================================================
-// Web Fetch Handler
+// Page fetching (shared by web_fetch and web_fetch_batch)
 // =============================================================================
-ToolResult web_fetch_handler(const Json& args, const ToolContext& ctx) {
-    (void)ctx;
 
-    std::string url = args.at("url").get<std::string>();
-    bool raw_html = args.value("raw", false);
-    int max_length = args.value("max_length", 50000);
+// Clients by scheme://host:port, so that pages from one host fetched in a
+// row reuse the connection
+using ClientCache = std::map<std::string, std::unique_ptr<httplib::Client>>;
+
+std::string origin_of(const ParsedUrl& parsed) {
+    return parsed.scheme + "://" + parsed.host + ":" + std::to_string(parsed.port);
+}
+
+// Redirects are followed by fetch_page rather than by httplib: with
+// follow_location, httplib takes every 3xx for a redirect, so a 304 to a
+// conditional request fails for lack of a Location header
+httplib::Client& client_for(ClientCache& clients, const ParsedUrl& parsed) {
+    std::string origin = origin_of(parsed);
+    auto& client = clients[origin];
+    if (!client) {
+        client = std::make_unique<httplib::Client>(origin);
+        client->set_follow_location(false);
+        client->set_keep_alive(true);
+        client->set_read_timeout(30);
+        client->set_connection_timeout(10);
+    }
+    return *client;
+}
+
+bool is_redirect(int status) {
+    return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+}
+
+// Target of a Location header, which may be relative to the requested URL
+std::string resolve_location(const ParsedUrl& from, const std::string& location) {
+    std::string lower = location.substr(0, 8);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower.rfind("http://", 0) == 0 || lower.rfind("https://", 0) == 0) {
+        return location;
+    }
+    if (location.rfind("//", 0) == 0) {
+        return from.scheme + ":" + location;
+    }
+    if (!location.empty() && location[0] == '/') {
+        return origin_of(from) + location;
+    }
+    std::string dir = from.path.substr(0, from.path.find_first_of("?#"));
+    dir = dir.substr(0, dir.rfind('/') + 1);
+    return origin_of(from) + (dir.empty() ? "/" : dir) + location;
+}
+
+struct FetchOptions {
+    bool raw_html = false;
+    bool main_content = true;
+    int max_length = 50000;  // longer text is cut with a marker
+};
+
+struct FetchedPage {
+    bool ok = false;
+    std::string content;  // extracted text, or the body for non-HTML and raw
+    std::string error;
+};
 
+FetchedPage fetch_page(const std::string& url, const FetchOptions& options,
+                       ClientCache& clients, const ToolContext& ctx) {
     auto parsed = parse_url(url);
     if (!parsed.valid) {
-        return ToolResult{
-            .success = false,
-            .content = "",
-            .error_message = "Invalid URL: " + url
-        };
+        return FetchedPage{.ok = false, .content = "", .error = "Invalid URL: " + url};
     }
 
-    try {
-        std::unique_ptr<httplib::Client> client;
+    auto truncated = [&](std::string content) {
+        if (static_cast<int>(content.length()) > options.max_length) {
+            content = content.substr(0, options.max_length) + "\n\n... [truncated]";
+        }
+        return FetchedPage{.ok = true, .content = std::move(content)};
+    };
 
-        if (parsed.scheme == "https") {
-            client = std::make_unique<httplib::Client>(
-                "https://" + parsed.host + ":" + std::to_string(parsed.port));
-        } else {
-            client = std::make_unique<httplib::Client>(
-                "http://" + parsed.host + ":" + std::to_string(parsed.port));
+    // The cache keeps the page as downloaded and converts it per call, so
+    // raw and extracted reads share an entry
+    auto from_cache = [&](const HttpCache::Entry& entry) {
+        if (!options.raw_html && is_html(entry.content_type, entry.body)) {
+            return truncated(html_to_text(entry.body, options.main_content));
         }
+        return truncated(entry.body);
+    };
 
-        client->set_follow_location(true);
-        client->set_read_timeout(30);
-        client->set_connection_timeout(10);
+    auto cache = response_cache(ctx);
+    std::string cache_key = "GET " + url;
+    std::optional<HttpCache::Entry> cached = cache ? cache->get(cache_key) : std::nullopt;
+    if (cached && (cached->fresh(HttpCache::now()) || offline_mode(ctx))) {
+        spdlog::debug("web_fetch served from cache: {}", url);
+        return from_cache(*cached);
+    }
+    if (offline_mode(ctx)) {
+        return FetchedPage{.ok = false, .content = "", .error = "Offline mode: " + url + " is not in the HTTP cache"};
+    }
 
+    try {
         // Set a browser-like user agent
         httplib::Headers headers = {
             {"User-Agent", "Mozilla/5.0 (compatible; GPAgent/1.0)"},
             {"Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8"}
         };
 
-        auto res = client->Get(parsed.path, headers);
+        // A stale entry is revalidated rather than downloaded again
+        if (cached && !cached->etag.empty()) {
+            headers.emplace("If-None-Match", cached->etag);
+        }
+        if (cached && !cached->last_modified.empty()) {
+            headers.emplace("If-Modified-Since", cached->last_modified);
+        }
 
-        if (!res) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "Failed to fetch URL: connection error"
-            };
+        // HTML is converted as it arrives; other content is kept only up to
+        // max_length. Either way the download stops once enough is read.
+        int status = 0;
+        std::string content_type;
+        std::string location;
+        std::map<std::string, std::string> response_headers;
+        std::optional<bool> html;
+        HtmlTextExtractor extractor(options.main_content);
+        size_t html_bytes = 0;
+        std::string body;
+        std::string html_body;  // the page as downloaded, for the cache
+        bool stopped = false;
+        bool received = false;
+
+        ParsedUrl target = parsed;
+        for (int redirects = 0;; ++redirects) {
+            location.clear();
+            auto res = client_for(clients, target).Get(target.path, headers,
+                [&](const httplib::Response& response) {
+                    status = response.status;
+                    location = response.get_header_value("Location");
+                    content_type = response.get_header_value("Content-Type");
+                    for (const char* name : kCacheHeaders) {
+                        response_headers[name] = response.get_header_value(name);
+                    }
+                    return response.status < 400;
+                },
+                [&](const char* data, size_t length) {
+                    // The body of a redirect is not the page
+                    if (is_redirect(status) && !location.empty()) return true;
+
+                    std::string_view chunk(data, length);
+                    if (!html) html = !options.raw_html && is_html(content_type, chunk);
+
+                    if (*html) {
+                        extractor.feed(chunk);
+                        if (cache) html_body.append(chunk);
+                        html_bytes += length;
+                        stopped = html_bytes >= kMaxHtmlBytes;
+                    } else {
+                        size_t limit = static_cast<size_t>(std::max(options.max_length, 0)) + 1;
+                        body.append(chunk.substr(0, limit - std::min(limit, body.size())));
+                        stopped = body.size() >= limit;
+                    }
+                    return !stopped;
+                });
+            received = static_cast<bool>(res);
+
+            // An interrupted download leaves the connection unusable
+            if (stopped || !res) clients.erase(origin_of(target));
+
+            if (!res || !is_redirect(status) || location.empty()) break;
+            if (redirects == kMaxRedirects) {
+                return FetchedPage{.ok = false, .content = "", .error = "Too many redirects: " + url};
+            }
+            target = parse_url(resolve_location(target, location));
+            if (!target.valid) {
+                return FetchedPage{.ok = false, .content = "", .error = "Invalid redirect target: " + location};
+            }
         }
 
-        if (res->status >= 400) {
-            return ToolResult{
-                .success = false,
-                .content = "",
-                .error_message = "HTTP error: " + std::to_string(res->status)
-            };
+        HttpCache::HeaderLookup header = [&](const std::string& name) {
+            if (name == "Content-Type") return content_type;
+            auto it = response_headers.find(name);
+            return it == response_headers.end() ? std::string() : it->second;
+        };
+
+        if (status == 304 && cached) {
+            HttpCache::refresh(*cached, header, HttpCache::now());
+            cache->put(cache_key, *cached);
+            return from_cache(*cached);
         }
 
-        std::string content = res->body;
+        if (status >= 400) {
+            return FetchedPage{.ok = false, .content = "", .error = "HTTP error: " + std::to_string(status)};
+        }
 
-        // Convert HTML to text unless raw requested
-        if (!raw_html && content.find("<html") != std::string::npos) {
-            content = html_to_text(content);
+        if (!received && !stopped) {
+            return FetchedPage{.ok = false, .content = "", .error = "Failed to fetch URL: connection error"};
         }
 
-        // Truncate if too long
-        if (static_cast<int>(content.length()) > max_length) {
-            content = content.substr(0, max_length) + "\n\n... [truncated]";
+        // Only complete downloads are stored
+        if (cache && !stopped) {
+            std::string downloaded = html.value_or(false) ? std::move(html_body) : body;
+            if (auto entry = HttpCache::from_response(status, header, std::move(downloaded), HttpCache::now())) {
+                cache->put(cache_key, *entry);
+            } else if (cached) {
+                cache->remove(cache_key);
+            }
         }
 
+        return truncated(html.value_or(false) ? extractor.finish() : std::move(body));
+
+    } catch (const std::exception& e) {
+        return FetchedPage{.ok = false, .content = "", .error = std::string("Error fetching URL: ") + e.what()};
+    }
+}
+
+// =============================================================================
+// Web Fetch Handler
+// =============================================================================
+ToolResult web_fetch_handler(const Json& args, const ToolContext& ctx) {
+    std::string url = args.at("url").get<std::string>();
+
+    FetchOptions options{
+        .raw_html = args.value("raw", false),
+        .main_content = args.value("main_content", true),
+        .max_length = args.value("max_length", 50000)
+    };
+
+    ClientCache clients;
+    FetchedPage page = fetch_page(url, options, clients, ctx);
+    if (!page.ok) {
         return ToolResult{
-            .success = true,
-            .content = content
+            .success = false,
+            .content = "",
+            .error_message = page.error
         };
+    }
 
-    } catch (const std::exception& e) {
+    return ToolResult{
+        .success = true,
+        .content = std::move(page.content)
+    };
+}
+
+// =============================================================================
+// Batch Fetch Handler
+// =============================================================================
+
+// Lengths that fit a total budget: pages shorter than an equal share keep
+// all of their text and the rest is split evenly among the longer ones
+std::vector<size_t> share_budget(const std::vector<size_t>& lengths, size_t budget) {
+    std::vector<size_t> order(lengths.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return lengths[a] < lengths[b]; });
+
+    std::vector<size_t> shares(lengths.size(), 0);
+    size_t left = budget;
+    for (size_t k = 0; k < order.size(); ++k) {
+        size_t fair = left / (order.size() - k);
+        shares[order[k]] = std::min(lengths[order[k]], fair);
+        left -= shares[order[k]];
+    }
+    return shares;
+}
+
+ToolResult web_fetch_batch_handler(const Json& args, const ToolContext& ctx) {
+    const Json& url_list = args.at("urls");
+    if (!url_list.is_array() || url_list.empty()) {
         return ToolResult{
             .success = false,
             .content = "",
-            .error_message = std::string("Error fetching URL: ") + e.what()
+            .error_message = "urls must be a non-empty list of URLs"
         };
     }
+
+    // Unique URLs in the given order; any entry that is not an http(s) URL
+    // fails the call, naming the entries to fix
+    std::vector<std::string> urls;
+    std::vector<std::string> invalid;
+    for (size_t i = 0; i < url_list.size(); ++i) {
+        const Json& item = url_list[i];
+        if (!item.is_string() || !parse_url(item.get<std::string>()).valid) {
+            invalid.push_back("urls[" + std::to_string(i) + "] = " + item.dump());
+            continue;
+        }
+        std::string url = item.get<std::string>();
+        if (std::find(urls.begin(), urls.end(), url) == urls.end()) urls.push_back(std::move(url));
+    }
+    if (!invalid.empty()) {
+        std::string list;
+        for (const auto& entry : invalid) list += (list.empty() ? "" : ", ") + entry;
+        return ToolResult{
+            .success = false,
+            .content = "",
+            .error_message = "Not an http:// or https:// URL: " + list
+        };
+    }
+    if (urls.size() > kMaxBatchUrls) {
+        return ToolResult{
+            .success = false,
+            .content = "",
+            .error_message = "At most " + std::to_string(kMaxBatchUrls) + " URLs per call, got " +
+                             std::to_string(urls.size())
+        };
+    }
+
+    int max_length = std::max(args.value("max_length", 100000), 1000);
+    FetchOptions options{
+        .raw_html = false,
+        .main_content = args.value("main_content", true),
+        // No single page can use more than the whole budget
+        .max_length = max_length
+    };
+
+    // Workers take the next URL whose host is below its connection limit;
+    // pages are extracted on the worker that downloads them
+    std::vector<FetchedPage> pages(urls.size());
+    std::vector<std::string> hosts(urls.size());
+    for (size_t i = 0; i < urls.size(); ++i) hosts[i] = parse_url(urls[i]).host;
+
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+    std::vector<bool> taken(urls.size(), false);
+    std::map<std::string, size_t> in_flight;
+    size_t remaining = urls.size();
+
+    auto worker = [&] {
+        ClientCache clients;
+        std::unique_lock lock(mutex);
+        while (remaining > 0) {
+            size_t next = urls.size();
+            for (size_t i = 0; i < urls.size(); ++i) {
+                if (!taken[i] && in_flight[hosts[i]] < kMaxFetchesPerHost) {
+                    next = i;
+                    break;
+                }
+            }
+            if (next == urls.size()) {
+                // Everything left waits on a busy host
+                slot_freed.wait(lock);
+                continue;
+            }
+
+            taken[next] = true;
+            --remaining;
+            ++in_flight[hosts[next]];
+            lock.unlock();
+            FetchedPage page = fetch_page(urls[next], options, clients, ctx);
+            lock.lock();
+            pages[next] = std::move(page);
+            --in_flight[hosts[next]];
+            slot_freed.notify_all();
+        }
+    };
+
+    size_t worker_count = std::min(urls.size(), kMaxConcurrentFetches);
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) workers.emplace_back(worker);
+    for (auto& thread : workers) thread.join();
+
+    // One document, each page trimmed to its share of max_length
+    std::vector<size_t> lengths;
+    size_t fetched = 0;
+    for (const auto& page : pages) {
+        lengths.push_back(page.ok ? page.content.size() : page.error.size());
+        if (page.ok) ++fetched;
+    }
+    std::vector<size_t> shares = share_budget(lengths, static_cast<size_t>(max_length));
+
+    std::ostringstream output;
+    output << "Fetched " << fetched << " of " << urls.size() << " pages.\n";
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const FetchedPage& page = pages[i];
+        output << "\n## [" << (i + 1) << "] " << urls[i] << "\n\n";
+        if (!page.ok) {
+            output << "Error: " << page.error << "\n";
+            continue;
+        }
+        output << page.content.substr(0, shares[i]);
+        if (shares[i] < page.content.size()) output << "\n\n... [truncated]";
+        output << "\n";
+    }
+
+    return ToolResult{
+        .success = fetched > 0,
+        .content = output.str(),
+        .error_message = fetched > 0 ? "" : "None of the URLs could be fetched"
+    };
 }
 
 // =============================================================================
@@ -495,6 +755,28 @@ ToolResult web_search_handler(const Json& args, const ToolContext& ctx) {
         }
     }
 
+    // Results for a query are reused for search.cache_ttl_hours
+    auto cache = response_cache(ctx);
+    int ttl_hours = ctx.config ? ctx.config->search.cache_ttl_hours : 0;
+    std::string cache_key = "SEARCH " + provider + " " + std::to_string(num_results) + "\n" + query;
+    if (cache) {
+        auto cached = cache->get(cache_key);
+        if (cached && (cached->fresh(HttpCache::now()) || offline_mode(ctx))) {
+            spdlog::info("Web search served from cache for query: {}", query);
+            return ToolResult{
+                .success = true,
+                .content = cached->body
+            };
+        }
+    }
+    if (offline_mode(ctx)) {
+        return ToolResult{
+            .success = false,
+            .content = "",
+            .error_message = "Offline mode: no cached search results for: " + query
+        };
+    }
+
     spdlog::info("Web search using provider: {} for query: {}", provider, query);
 
     std::vector<SearchResult> results;
@@ -540,9 +822,19 @@ ToolResult web_search_handler(const Json& args, const ToolContext& ctx) {
         };
     }
 
+    std::string content = format_results(results);
+    if (cache && ttl_hours > 0) {
+        HttpCache::Entry entry;
+        entry.content_type = "text/markdown";
+        entry.stored_at = HttpCache::now();
+        entry.fresh_until = entry.stored_at + static_cast<int64_t>(ttl_hours) * 3600;
+        entry.body = content;
+        cache->put(cache_key, entry);
+    }
+
     return ToolResult{
         .success = true,
-        .content = format_results(results)
+        .content = std::move(content)
     };
 }
 
@@ -551,10 +843,11 @@ void register_web_tools(ToolRegistry& registry) {
     registry.register_tool(
         ToolSpec{
             .name = "web_fetch",
-            .description = "Fetch and read a web page. Returns text content extracted from HTML.",
+            .description = "Fetch and read a web page. Returns the page's main text as markdown-style headings, lists and code blocks.",
             .parameters = {
                 {"url", "The URL to fetch (must start with http:// or https://)", ParamType::String, true},
                 {"raw", "Return raw HTML instead of extracted text (default: false)", ParamType::Boolean, false},
+                {"main_content", "Keep only the main article text, dropping navigation, sidebars and footers (default: true)", ParamType::Boolean, false},
                 {"max_length", "Maximum content length to return (default: 50000)", ParamType::Integer, false}
             },
             .keywords = {"web", "fetch", "url", "http", "page", "download", "read"}
@@ -563,6 +856,22 @@ void register_web_tools(ToolRegistry& registry) {
         "builtin"
     );
 
+    registry.register_tool(
+        ToolSpec{
+            .name = "web_fetch_batch",
+            .description = "Fetch several web pages at once and return their main text as one document. "
+                           "Faster than calling web_fetch for each URL; the length budget is shared between pages.",
+            .parameters = {
+                {"urls", "The URLs to fetch (up to 20, each starting with http:// or https://)", ParamType::Array, true},
+                {"main_content", "Keep only the main article text of each page (default: true)", ParamType::Boolean, false},
+                {"max_length", "Maximum total length of the combined document (default: 100000)", ParamType::Integer, false}
+            },
+            .keywords = {"web", "fetch", "url", "http", "pages", "batch", "parallel", "research", "read"}
+        },
+        web_fetch_batch_handler,
+        "builtin"
+    );
+
     registry.register_tool(
         ToolSpec{
             .name = "web_search",
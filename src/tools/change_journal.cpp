@@ -0,0 +1,147 @@
+#include "gpagent/tools/change_journal.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace gpagent::tools {
+
+std::shared_ptr<ChangeJournal> ChangeJournal::for_project(const fs::path& root) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::weak_ptr<ChangeJournal>> registry;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(root, ec);
+    if (ec) canonical = root;
+
+    std::lock_guard lock(registry_mutex);
+    if (auto existing = registry[canonical.string()].lock()) {
+        return existing;
+    }
+
+    // Journals close their thread and watches with their last user
+    std::erase_if(registry, [](const auto& entry) { return entry.second.expired(); });
+    std::shared_ptr<ChangeJournal> journal = create(canonical);
+    if (journal) {
+        journal->watch("");
+        registry[canonical.string()] = journal;
+    }
+    return journal;
+}
+
+std::unique_ptr<ChangeJournal> ChangeJournal::create(const fs::path& root, size_t max_records) {
+    auto watcher = DirWatcher::create(root);
+    if (!watcher) return nullptr;
+    return std::unique_ptr<ChangeJournal>(new ChangeJournal(std::move(watcher), max_records));
+}
+
+ChangeJournal::ChangeJournal(std::unique_ptr<DirWatcher> watcher, size_t max_records)
+    : watcher_(std::move(watcher)), max_records_(std::max<size_t>(max_records, 1)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+ChangeJournal::~ChangeJournal() {
+    stopping_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+void ChangeJournal::run() {
+    // Draining as events arrive keeps the kernel queue from overflowing
+    // between queries
+    while (!stopping_.load()) {
+        if (!watcher_->wait(kPollIntervalMs)) continue;
+        Changes batch;
+        {
+            std::lock_guard lock(mutex_);
+            batch = drain_locked();
+        }
+        notify(batch);
+    }
+}
+
+ChangeJournal::Changes ChangeJournal::drain_locked() {
+    Changes batch;
+    auto pending = watcher_->poll();
+    if (pending.overflow) {
+        lost_through_ = ++last_sequence_;
+        batch.overflow = true;
+    }
+    for (auto& file : pending.files) {
+        records_.push_back(Record{++last_sequence_, file, false});
+    }
+    for (auto& dir : pending.dirs) {
+        records_.push_back(Record{++last_sequence_, dir, true});
+    }
+    while (records_.size() > max_records_) {
+        lost_through_ = std::max(lost_through_, records_.front().sequence);
+        records_.pop_front();
+    }
+
+    batch.files = std::move(pending.files);
+    batch.dirs = std::move(pending.dirs);
+    batch.sequence = last_sequence_;
+    return batch;
+}
+
+void ChangeJournal::notify(const Changes& batch) {
+    if (!batch.overflow && batch.files.empty() && batch.dirs.empty()) return;
+
+    // Called unlocked so that listeners may query the journal
+    std::vector<Listener> listeners;
+    {
+        std::lock_guard lock(listeners_mutex_);
+        for (const auto& [id, listener] : listeners_) listeners.push_back(listener);
+    }
+    for (const auto& listener : listeners) listener(batch);
+}
+
+uint64_t ChangeJournal::sequence() {
+    Changes batch;
+    uint64_t sequence;
+    {
+        std::lock_guard lock(mutex_);
+        batch = drain_locked();
+        sequence = last_sequence_;
+    }
+    notify(batch);
+    return sequence;
+}
+
+ChangeJournal::Changes ChangeJournal::since(uint64_t sequence) {
+    Changes batch;
+    Changes changes;
+    {
+        std::lock_guard lock(mutex_);
+        batch = drain_locked();
+
+        changes.sequence = last_sequence_;
+        changes.overflow = lost_through_ > sequence;
+        if (!changes.overflow) {
+            // Records are in sequence order: find the first one after the position
+            auto first = std::upper_bound(records_.begin(), records_.end(), sequence,
+                [](uint64_t seq, const Record& record) { return seq < record.sequence; });
+            std::set<std::string> files, dirs;
+            for (auto it = first; it != records_.end(); ++it) {
+                (it->dir ? dirs : files).insert(it->path);
+            }
+            changes.files.assign(files.begin(), files.end());
+            changes.dirs.assign(dirs.begin(), dirs.end());
+        }
+    }
+    notify(batch);
+    return changes;
+}
+
+size_t ChangeJournal::subscribe(Listener listener) {
+    std::lock_guard lock(listeners_mutex_);
+    size_t id = next_listener_++;
+    listeners_[id] = std::move(listener);
+    return id;
+}
+
+void ChangeJournal::unsubscribe(size_t id) {
+    std::lock_guard lock(listeners_mutex_);
+    listeners_.erase(id);
+}
+
+}  // namespace gpagent::tools
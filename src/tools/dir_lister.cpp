@@ -0,0 +1,199 @@
+#include "gpagent/tools/dir_lister.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr size_t kMaxListerThreads = 8;
+// Files per stat thread below which more threads do not pay off
+constexpr size_t kStatsPerThread = 128;
+
+using Type = DirListEntry::Type;
+
+struct Child {
+    std::string name;
+    Type type;
+};
+
+bool is_dot_or_dotdot(const char* name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+#ifdef __linux__
+
+// Kernel record returned by getdents64 (glibc only exposes it since 2.30).
+// The name runs past the declared array up to d_reclen; it is read through
+// offsetof so the record never needs a flexible array member.
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+constexpr size_t kDirentBuffer = 64 * 1024;
+
+// Up to limit visible children of a directory, in directory order. The type
+// comes from d_type; only filesystems that leave it unknown cost a stat.
+std::vector<Child> read_children(const std::string& dir, bool include_hidden, size_t limit) {
+    std::vector<Child> children;
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return children;
+
+    std::vector<char> buffer(kDirentBuffer);
+    while (children.size() < limit) {
+        long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (n <= 0) break;
+
+        for (long offset = 0; offset < n && children.size() < limit;) {
+            const char* record = buffer.data() + offset;
+            const auto* ent = reinterpret_cast<const LinuxDirent64*>(record);
+            offset += ent->d_reclen;
+
+            const char* name = record + offsetof(LinuxDirent64, d_name);
+            if (is_dot_or_dotdot(name)) continue;
+            if (!include_hidden && name[0] == '.') continue;
+
+            unsigned char d_type = ent->d_type;
+            if (d_type == DT_UNKNOWN) {
+                struct stat st;
+                if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                d_type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR :
+                         S_ISLNK(st.st_mode) ? DT_LNK : DT_UNKNOWN;
+            }
+            switch (d_type) {
+                case DT_REG: children.push_back(Child{name, Type::File}); break;
+                case DT_DIR: children.push_back(Child{name, Type::Directory}); break;
+                case DT_LNK: children.push_back(Child{name, Type::Symlink}); break;
+                default: break;
+            }
+        }
+    }
+    ::close(fd);
+    return children;
+}
+
+uint64_t file_size(const std::string& path) {
+#ifdef STATX_SIZE
+    // Don't force a round trip to the server on network filesystems
+    struct statx stx;
+    if (::statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_SIZE, &stx) == 0) {
+        return stx.stx_size;
+    }
+    if (errno != ENOSYS) return 0;
+#endif
+    struct stat st;
+    return ::lstat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+#else
+
+std::vector<Child> read_children(const std::string& dir, bool include_hidden, size_t limit) {
+    std::vector<Child> children;
+    std::error_code ec;
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::directory_iterator() && children.size() < limit; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (!include_hidden && name[0] == '.') continue;
+        std::error_code type_ec;
+        if (it->is_symlink(type_ec)) {
+            children.push_back(Child{name, Type::Symlink});
+        } else if (it->is_directory(type_ec)) {
+            children.push_back(Child{name, Type::Directory});
+        } else if (it->is_regular_file(type_ec)) {
+            children.push_back(Child{name, Type::File});
+        }
+    }
+    return children;
+}
+
+uint64_t file_size(const std::string& path) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+#endif
+
+struct Walk {
+    const DirListOptions& options;
+    std::string root;  // with trailing '/'
+    DirListing listing;
+
+    bool full() const { return listing.entries.size() >= options.max_entries; }
+
+    void visit(const std::string& rel_dir, int depth) {
+        // One more than fits tells whether the listing is truncated
+        size_t budget = options.max_entries - listing.entries.size() + 1;
+        auto children = read_children(root + rel_dir, options.include_hidden, budget);
+
+        for (auto& child : children) {
+            if (full()) {
+                listing.truncated = true;
+                return;
+            }
+            std::string rel = rel_dir + child.name;
+            listing.entries.push_back(DirListEntry{rel, child.type, 0, depth});
+            if (child.type == Type::Directory && options.recursive && depth < options.max_depth) {
+                visit(rel + "/", depth + 1);
+                if (listing.truncated) return;
+            }
+        }
+    }
+
+    // Sizes of the listed files, fanned out across threads for big listings
+    void stat_files() {
+        std::vector<DirListEntry*> files;
+        for (auto& entry : listing.entries) {
+            if (entry.type == Type::File) files.push_back(&entry);
+        }
+
+        size_t threads = options.num_threads;
+        if (threads == 0) {
+            threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, kMaxListerThreads);
+        }
+        threads = std::clamp<size_t>(files.size() / kStatsPerThread, 1, threads);
+
+        std::atomic<size_t> next{0};
+        auto work = [&] {
+            for (size_t i = next++; i < files.size(); i = next++) {
+                files[i]->size = file_size(root + files[i]->rel_path);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+    }
+};
+
+}  // namespace
+
+DirListing list_directory_tree(const fs::path& root, const DirListOptions& options) {
+    Walk walk{options, root.string(), {}};
+    if (walk.root.empty()) walk.root = ".";
+    if (walk.root.back() != '/') walk.root.push_back('/');
+
+    if (options.max_entries > 0) {
+        walk.visit("", 0);
+        walk.stat_files();
+    }
+    return std::move(walk.listing);
+}
+
+}  // namespace gpagent::tools
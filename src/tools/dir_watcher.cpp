@@ -0,0 +1,159 @@
+#include "gpagent/tools/dir_watcher.hpp"
+
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace gpagent::tools {
+
+#ifdef __linux__
+
+namespace {
+
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM |
+                                IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR |
+                                IN_EXCL_UNLINK;
+
+}  // namespace
+
+std::unique_ptr<DirWatcher> DirWatcher::create(const fs::path& root, size_t max_watches) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return nullptr;
+    return std::unique_ptr<DirWatcher>(new DirWatcher(root, fd, max_watches));
+}
+
+DirWatcher::DirWatcher(fs::path root, int fd, size_t max_watches)
+    : root_(std::move(root)), fd_(fd), max_watches_(max_watches) {}
+
+DirWatcher::~DirWatcher() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool DirWatcher::watch(std::string_view rel_dir) {
+    std::lock_guard lock(mutex_);
+    std::string rel(rel_dir);
+    if (wds_.count(rel)) return true;
+    if (wds_.size() >= max_watches_) return false;
+
+    fs::path path = rel.empty() ? root_ : root_ / rel;
+    int wd = inotify_add_watch(fd_, path.c_str(), kWatchMask);
+    if (wd < 0) {
+        // Out of kernel watches; a vanished directory is reported by its parent
+        return errno != ENOSPC && errno != ENOMEM;
+    }
+
+    // The same inode under a new name (moved before its events were read)
+    auto it = paths_.find(wd);
+    if (it != paths_.end()) wds_.erase(it->second);
+
+    paths_[wd] = rel;
+    wds_[rel] = wd;
+    return true;
+}
+
+bool DirWatcher::watching(std::string_view rel_dir) const {
+    std::lock_guard lock(mutex_);
+    return wds_.count(std::string(rel_dir)) > 0;
+}
+
+size_t DirWatcher::watch_count() const {
+    std::lock_guard lock(mutex_);
+    return wds_.size();
+}
+
+void DirWatcher::forget(const std::string& rel_dir) {
+    std::string prefix = rel_dir + "/";
+    for (auto it = wds_.begin(); it != wds_.end();) {
+        if (it->first == rel_dir || it->first.rfind(prefix, 0) == 0) {
+            inotify_rm_watch(fd_, it->second);
+            paths_.erase(it->second);
+            it = wds_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+DirWatcher::Changes DirWatcher::poll() {
+    std::lock_guard lock(mutex_);
+    Changes changes;
+    std::set<std::string> files, dirs;
+
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+        if (n <= 0) break;
+
+        for (char* p = buffer; p < buffer + n;) {
+            auto* event = reinterpret_cast<struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                changes.overflow = true;
+                continue;
+            }
+            auto it = paths_.find(event->wd);
+            if (it == paths_.end()) continue;
+            std::string dir = it->second;
+
+            if (event->mask & IN_IGNORED) {
+                wds_.erase(dir);
+                paths_.erase(it);
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // Reported through the parent; only the root has none
+                if (dir.empty()) changes.overflow = true;
+                continue;
+            }
+            if (event->len == 0) continue;
+
+            std::string rel = dir.empty() ? std::string(event->name) : dir + "/" + event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) {
+                    dirs.insert(rel);
+                }
+                // The moved inode keeps its watches, now under a stale path
+                if (event->mask & IN_MOVED_FROM) forget(rel);
+            } else {
+                files.insert(rel);
+            }
+        }
+    }
+
+    changes.files.assign(files.begin(), files.end());
+    changes.dirs.assign(dirs.begin(), dirs.end());
+    return changes;
+}
+
+bool DirWatcher::wait(int timeout_ms) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    return ::poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN);
+}
+
+#else
+
+std::unique_ptr<DirWatcher> DirWatcher::create(const fs::path&, size_t) {
+    return nullptr;
+}
+
+DirWatcher::DirWatcher(fs::path root, int fd, size_t max_watches)
+    : root_(std::move(root)), fd_(fd), max_watches_(max_watches) {}
+
+DirWatcher::~DirWatcher() = default;
+
+bool DirWatcher::watch(std::string_view) { return false; }
+bool DirWatcher::watching(std::string_view) const { return false; }
+size_t DirWatcher::watch_count() const { return 0; }
+void DirWatcher::forget(const std::string&) {}
+DirWatcher::Changes DirWatcher::poll() { return Changes{{}, {}, true}; }
+bool DirWatcher::wait(int) { return false; }
+
+#endif
+
+}  // namespace gpagent::tools
@@ -0,0 +1,79 @@
+#include "gpagent/tools/disk_lru.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace gpagent::tools {
+
+DiskLru::DiskLru(fs::path dir, uint64_t max_bytes)
+    : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+
+void DiskLru::set(const std::string& name, uint64_t bytes, int64_t last_used) {
+    auto& entry = entries_[name];
+    total_bytes_ = total_bytes_ - entry.bytes + bytes;
+    entry = Entry{bytes, last_used};
+}
+
+void DiskLru::grow(const std::string& name, uint64_t bytes) {
+    auto& entry = entries_[name];
+    entry.bytes += bytes;
+    entry.last_used = now_ns();
+    total_bytes_ += bytes;
+}
+
+void DiskLru::used(const std::string& name) {
+    if (auto it = entries_.find(name); it != entries_.end()) {
+        it->second.last_used = now_ns();
+    }
+}
+
+void DiskLru::erase(const std::string& name) {
+    std::error_code ec;
+    fs::remove_all(dir_ / name, ec);
+    if (auto it = entries_.find(name); it != entries_.end()) {
+        total_bytes_ -= it->second.bytes;
+        entries_.erase(it);
+    }
+}
+
+void DiskLru::evict(const std::string& keep) {
+    if (total_bytes_ <= max_bytes_) return;
+
+    std::vector<std::pair<int64_t, std::string>> by_age;
+    by_age.reserve(entries_.size());
+    for (const auto& [name, entry] : entries_) {
+        if (name != keep) by_age.emplace_back(entry.last_used, name);
+    }
+    std::sort(by_age.begin(), by_age.end());
+
+    uint64_t target = max_bytes_ / 10 * 9;
+    for (const auto& [last_used, name] : by_age) {
+        if (total_bytes_ <= target) break;
+        erase(name);
+    }
+}
+
+bool DiskLru::discard_temp(const fs::path& path) {
+    if (!path.filename().string().ends_with(".tmp")) return false;
+    std::error_code ec;
+    fs::remove(path, ec);
+    return true;
+}
+
+void DiskLru::stamp(const fs::path& path) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+int64_t DiskLru::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t DiskLru::to_unix_ns(fs::file_time_type time) {
+    auto sys = std::chrono::file_clock::to_sys(time);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sys.time_since_epoch()).count();
+}
+
+}  // namespace gpagent::tools
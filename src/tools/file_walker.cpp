@@ -0,0 +1,468 @@
+#include "gpagent/tools/file_walker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr size_t kMaxWalkerThreads = 8;
+
+// Braces are literal in gitignore patterns; GlobMatcher would expand them
+std::string escape_braces(std::string_view pattern) {
+    std::string out;
+    out.reserve(pattern.size());
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+            out += pattern[i];
+            out += pattern[++i];
+            continue;
+        }
+        if (pattern[i] == '{' || pattern[i] == '}') out += '\\';
+        out += pattern[i];
+    }
+    return out;
+}
+
+// One ignore file placed in the walk tree. Paths are given relative to the
+// walk root and translated to the ignore file's directory.
+struct IgnoreLayer {
+    IgnoreRules rules;
+    std::string prefix;   // prepended for ignore files above the walk root
+    size_t strip = 0;     // removed for ignore files below the walk root
+    std::shared_ptr<const IgnoreLayer> parent;
+};
+
+using IgnoreChain = std::shared_ptr<const IgnoreLayer>;
+
+// Deeper ignore files take precedence over their parents
+bool is_ignored(const IgnoreChain& chain, std::string_view rel_path, bool is_dir) {
+    std::string buffer;
+    for (const IgnoreLayer* layer = chain.get(); layer; layer = layer->parent.get()) {
+        std::string_view local = rel_path.substr(layer->strip);
+        if (!layer->prefix.empty()) {
+            buffer = layer->prefix;
+            buffer.append(local);
+            local = buffer;
+        }
+        switch (layer->rules.match(local, is_dir)) {
+            case IgnoreRules::Verdict::Ignore: return true;
+            case IgnoreRules::Verdict::Include: return false;
+            case IgnoreRules::Verdict::None: break;
+        }
+    }
+    return false;
+}
+
+IgnoreChain push_layer(IgnoreChain parent, const fs::path& file,
+                       std::string prefix, size_t strip) {
+    auto rules = IgnoreRules::load(file);
+    if (!rules || rules->empty()) return parent;
+    auto layer = std::make_shared<IgnoreLayer>();
+    layer->rules = std::move(*rules);
+    layer->prefix = std::move(prefix);
+    layer->strip = strip;
+    layer->parent = std::move(parent);
+    return layer;
+}
+
+enum class EntryType { File, Directory, Other };
+
+struct DirEntry {
+    std::string name;
+    EntryType type = EntryType::Other;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    bool has_stat = false;
+};
+
+#ifdef __linux__
+
+bool fill_stat(int dir_fd, DirEntry& entry) {
+    struct stat st;
+    if (fstatat(dir_fd, entry.name.c_str(), &st, 0) != 0) return false;
+    entry.type = S_ISREG(st.st_mode) ? EntryType::File :
+                 S_ISDIR(st.st_mode) ? EntryType::Directory : EntryType::Other;
+    entry.size = static_cast<uint64_t>(st.st_size);
+    entry.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    entry.has_stat = true;
+    return true;
+}
+
+// List a directory using d_type, stat'ing only when the type is unknown,
+// a symlink needs resolving, or the caller asked for metadata.
+template <typename Fn>
+void list_directory(const std::string& dir, bool need_stat, Fn&& fn) {
+    DIR* d = opendir(dir.empty() ? "." : dir.c_str());
+    if (!d) return;
+    int fd = dirfd(d);
+
+    while (struct dirent* ent = readdir(d)) {
+        const char* name = ent->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        DirEntry entry;
+        entry.name = name;
+        bool is_link = false;
+        switch (ent->d_type) {
+            case DT_REG: entry.type = EntryType::File; break;
+            case DT_DIR: entry.type = EntryType::Directory; break;
+            case DT_LNK: is_link = true; [[fallthrough]];
+            case DT_UNKNOWN:
+                if (!fill_stat(fd, entry)) continue;
+                break;
+            default: continue;
+        }
+
+        // Never follow directory symlinks (avoids cycles)
+        if (is_link && entry.type == EntryType::Directory) continue;
+
+        if (need_stat && entry.type == EntryType::File && !entry.has_stat) {
+            if (!fill_stat(fd, entry)) continue;
+        }
+
+        if (!fn(entry)) break;
+    }
+    closedir(d);
+}
+
+#else
+
+template <typename Fn>
+void list_directory(const std::string& dir, bool need_stat, Fn&& fn) {
+    std::error_code ec;
+    fs::directory_iterator it(dir.empty() ? fs::path(".") : fs::path(dir),
+                              fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        DirEntry entry;
+        entry.name = it->path().filename().string();
+        if (it->is_symlink(ec) && it->is_directory(ec)) continue;
+        if (it->is_regular_file(ec)) {
+            entry.type = EntryType::File;
+        } else if (it->is_directory(ec)) {
+            entry.type = EntryType::Directory;
+        } else {
+            continue;
+        }
+        if (need_stat && entry.type == EntryType::File) {
+            entry.size = it->file_size(ec);
+            auto mtime = it->last_write_time(ec);
+            entry.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                mtime.time_since_epoch()).count();
+            entry.has_stat = true;
+        }
+        if (!fn(entry)) break;
+    }
+}
+
+#endif
+
+}  // namespace
+
+// ============================================================================
+// IgnoreRules
+// ============================================================================
+
+IgnoreRules IgnoreRules::parse(std::string_view content) {
+    IgnoreRules result;
+
+    size_t pos = 0;
+    while (pos <= content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string_view::npos) end = content.size();
+        std::string_view line = content.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') continue;
+
+        // Trailing spaces are ignored unless escaped
+        while (!line.empty() && line.back() == ' ' &&
+               !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) continue;
+
+        Rule rule;
+        if (line[0] == '!') {
+            rule.negated = true;
+            line.remove_prefix(1);
+        } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '!' || line[1] == '#')) {
+            line.remove_prefix(1);
+        }
+
+        if (!line.empty() && line.back() == '/') {
+            rule.dir_only = true;
+            line.remove_suffix(1);
+        }
+
+        // A slash anywhere but the end anchors the pattern to this directory
+        rule.anchored = line.find('/') != std::string_view::npos;
+        if (!line.empty() && line[0] == '/') line.remove_prefix(1);
+        if (line.empty()) continue;
+
+        // "dir/**" matches what is inside dir, not dir itself
+        std::string pattern = escape_braces(line);
+        if (pattern.ends_with("/**")) pattern.insert(pattern.size() - 2, "*/");
+        auto glob = GlobMatcher::compile(pattern);
+        if (glob.is_err()) continue;
+        rule.glob = std::move(glob).value();
+
+        result.rules_.push_back(std::move(rule));
+    }
+
+    return result;
+}
+
+std::optional<IgnoreRules> IgnoreRules::load(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return parse(ss.str());
+}
+
+bool IgnoreRules::rule_matches(const Rule& rule, std::string_view rel_path,
+                               std::string_view basename, bool is_dir) {
+    if (rule.dir_only && !is_dir) return false;
+
+    return rule.glob.matches(rule.anchored ? rel_path : basename);
+}
+
+IgnoreRules::Verdict IgnoreRules::match(std::string_view rel_path, bool is_dir) const {
+    size_t slash = rel_path.rfind('/');
+    std::string_view basename = slash == std::string_view::npos ?
+        rel_path : rel_path.substr(slash + 1);
+
+    // Last matching rule wins, so scan from the end and stop at the first hit
+    for (auto it = rules_.rbegin(); it != rules_.rend(); ++it) {
+        if (rule_matches(*it, rel_path, basename, is_dir)) {
+            return it->negated ? Verdict::Include : Verdict::Ignore;
+        }
+    }
+    return Verdict::None;
+}
+
+// ============================================================================
+// FileWalker
+// ============================================================================
+
+struct FileWalker::Impl {
+    struct DirJob {
+        std::string rel;   // relative to root, with trailing '/' ("" for root)
+        IgnoreChain ignores;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<DirJob> jobs;
+    };
+
+    FileWalker& walker;
+    const WalkOptions& options;
+    const Visitor& visit;
+    std::string root;      // with trailing '/' unless empty
+    fs::path root_path;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<size_t> pending{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+
+    Impl(FileWalker& w, const fs::path& r, const Visitor& v)
+        : walker(w), options(w.options_), visit(v), root_path(r) {
+        root = r.string();
+        if (!root.empty() && root.back() != '/') root.push_back('/');
+        for (size_t i = 0; i < w.num_threads_; ++i) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+    }
+
+    void push(size_t worker, DirJob job) {
+        pending.fetch_add(1);
+        {
+            std::lock_guard lock(queues[worker]->mutex);
+            queues[worker]->jobs.push_back(std::move(job));
+        }
+        idle_cv.notify_one();
+    }
+
+    // Own queue is LIFO (depth-first, cache friendly); steal FIFO from others
+    bool pop(size_t worker, DirJob& job) {
+        {
+            auto& own = *queues[worker];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i) {
+            auto& victim = *queues[(worker + i) % queues.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void finish_job() {
+        if (pending.fetch_sub(1) == 1) {
+            std::lock_guard lock(idle_mutex);
+            idle_cv.notify_all();
+        }
+    }
+
+    void run_worker(size_t worker) {
+        DirJob job;
+        while (!walker.stopped()) {
+            if (pop(worker, job)) {
+                process(worker, job);
+                finish_job();
+                continue;
+            }
+            if (pending.load() == 0) break;
+
+            std::unique_lock lock(idle_mutex);
+            idle_cv.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return pending.load() == 0 || walker.stopped();
+            });
+        }
+        // Wake any waiters so they observe stop/completion promptly
+        idle_cv.notify_all();
+    }
+
+    bool skip_dir(const std::string& name) const {
+        return std::find(options.skip_dirs.begin(), options.skip_dirs.end(), name) !=
+               options.skip_dirs.end();
+    }
+
+    void process(size_t worker, const DirJob& job) {
+        std::string dir = root + job.rel;
+
+        IgnoreChain ignores = job.ignores;
+        if (options.respect_ignore_files) {
+            ignores = push_layer(ignores, dir + ".gitignore", "", job.rel.size());
+            ignores = push_layer(ignores, dir + ".ignore", "", job.rel.size());
+        }
+
+        bool need_stat = options.stat_files || options.max_file_size > 0;
+        std::string rel;
+
+        list_directory(dir, need_stat, [&](const DirEntry& entry) {
+            if (walker.stopped()) return false;
+            if (!options.include_hidden && entry.name[0] == '.') return true;
+
+            rel.assign(job.rel);
+            rel.append(entry.name);
+
+            if (entry.type == EntryType::Directory) {
+                if (!options.recursive || skip_dir(entry.name)) return true;
+                if (ignores && is_ignored(ignores, rel, true)) return true;
+                if (options.dir_filter && !options.dir_filter(rel)) return true;
+                push(worker, DirJob{rel + "/", ignores});
+                return true;
+            }
+
+            if (entry.type != EntryType::File) return true;
+            if (ignores && is_ignored(ignores, rel, false)) return true;
+            if (options.max_file_size > 0 && entry.size > options.max_file_size) return true;
+
+            WalkEntry out;
+            out.path = root_path / rel;
+            out.rel_path = rel;
+            out.size = entry.size;
+            out.mtime_ns = entry.mtime_ns;
+            out.worker = worker;
+            if (!visit(out)) {
+                walker.stop();
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // Ignore files from the enclosing repository, above the walk root
+    IgnoreChain ancestor_ignores() const {
+        std::error_code ec;
+        fs::path abs = fs::absolute(root_path, ec).lexically_normal();
+        if (ec) return nullptr;
+        if (!abs.empty() && !abs.has_filename()) abs = abs.parent_path();
+
+        if (fs::exists(abs / ".git", ec)) {
+            return push_layer(nullptr, abs / ".git" / "info" / "exclude", "", 0);
+        }
+
+        // Find the repository root; outside a repo only the root's own files apply
+        std::vector<fs::path> ancestors;
+        fs::path repo_root;
+        for (fs::path p = abs.parent_path(); ; p = p.parent_path()) {
+            ancestors.push_back(p);
+            if (fs::exists(p / ".git", ec)) {
+                repo_root = p;
+                break;
+            }
+            if (p == p.parent_path()) break;
+        }
+        if (repo_root.empty()) return nullptr;
+
+        IgnoreChain chain = push_layer(nullptr, repo_root / ".git" / "info" / "exclude",
+                                       abs.lexically_relative(repo_root).generic_string() + "/", 0);
+        for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+            std::string prefix = abs.lexically_relative(*it).generic_string() + "/";
+            chain = push_layer(chain, *it / ".gitignore", prefix, 0);
+            chain = push_layer(chain, *it / ".ignore", prefix, 0);
+        }
+        return chain;
+    }
+};
+
+FileWalker::FileWalker(WalkOptions options)
+    : options_(std::move(options)) {
+    num_threads_ = options_.num_threads;
+    if (num_threads_ == 0) {
+        num_threads_ = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, kMaxWalkerThreads);
+    }
+}
+
+void FileWalker::walk(const fs::path& root, const Visitor& visit) {
+    stopped_.store(false);
+
+    Impl impl(*this, root, visit);
+    IgnoreChain ignores = options_.respect_ignore_files ? impl.ancestor_ignores() : nullptr;
+    impl.push(0, Impl::DirJob{"", ignores});
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads_ - 1);
+    for (size_t i = 1; i < num_threads_; ++i) {
+        threads.emplace_back([&impl, i] { impl.run_worker(i); });
+    }
+    impl.run_worker(0);
+
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+}  // namespace gpagent::tools
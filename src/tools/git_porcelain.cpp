@@ -0,0 +1,808 @@
+#include "gpagent/tools/git_porcelain.hpp"
+#include "gpagent/tools/file_walker.hpp"
+#include "gpagent/tools/line_diff.hpp"
+#include "gpagent/tools/search_engine.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools::git {
+
+namespace {
+
+// Commits visited by ahead_behind before giving up on very old forks
+constexpr size_t kMaxAheadBehindWalk = 200000;
+
+constexpr uint32_t kModeTypeMask = 0170000;
+
+std::string abbrev(const ObjectId& id) {
+    return to_hex(id).substr(0, 7);
+}
+
+std::string mode_string(uint32_t mode) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%06o", mode);
+    return buf;
+}
+
+bool is_gitlink(uint32_t mode) {
+    return (mode & kModeTypeMask) == kModeGitlink;
+}
+
+// Submodule HEAD and whether it has local changes
+void check_submodule(const fs::path& path, FileChange& change) {
+    auto sub = Repository::open(path);
+    if (sub.is_err()) return;
+    auto head = sub.value()->resolve_ref("HEAD");
+    if (head.is_ok() && head.value()) {
+        change.new_id = *head.value();
+    }
+    auto status = read_status(*sub.value(), true);
+    if (status.is_ok()) {
+        change.submodule_dirty = !status.value().staged.empty() || !status.value().unstaged.empty();
+        change.submodule_untracked = !status.value().untracked.empty();
+    }
+}
+
+bool path_matches(std::string_view path, std::string_view filter) {
+    if (filter.empty()) return true;
+    if (path.size() < filter.size() || path.compare(0, filter.size(), filter) != 0) return false;
+    return path.size() == filter.size() || path[filter.size()] == '/';
+}
+
+std::string_view change_label(ChangeKind kind) {
+    switch (kind) {
+        case ChangeKind::Added: return "new file:";
+        case ChangeKind::Modified: return "modified:";
+        case ChangeKind::Deleted: return "deleted:";
+        case ChangeKind::Renamed: return "renamed:";
+        case ChangeKind::TypeChanged: return "typechange:";
+    }
+    return "unknown:";
+}
+
+std::string_view conflict_label(uint8_t stages) {
+    switch (stages) {
+        case 1: return "both deleted:";
+        case 2: return "added by us:";
+        case 3: return "deleted by them:";
+        case 4: return "added by them:";
+        case 5: return "deleted by us:";
+        case 6: return "both added:";
+        case 7: return "both modified:";
+    }
+    return "unmerged:";
+}
+
+// Labels padded to the widest in their section plus one space, as git does
+void append_entry(std::string& out, std::string_view label, size_t width, const std::string& text) {
+    out += '\t';
+    out.append(label);
+    out.append(width - label.size(), ' ');
+    out += text;
+    out += '\n';
+}
+
+std::string plural(size_t n, const char* word) {
+    return std::to_string(n) + " " + word + (n == 1 ? "" : "s");
+}
+
+}  // namespace
+
+// ============================================================================
+// Worktree
+// ============================================================================
+
+std::optional<FileStat> stat_worktree(const fs::path& path) {
+#ifdef __linux__
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) return std::nullopt;
+
+    FileStat out;
+    if (S_ISLNK(st.st_mode)) {
+        out.mode = kModeSymlink;
+    } else if (S_ISDIR(st.st_mode)) {
+        out.mode = kModeTree;
+    } else if (S_ISREG(st.st_mode)) {
+        out.mode = (st.st_mode & S_IXUSR) ? kModeExecutable : kModeFile;
+    }
+    out.size = static_cast<uint64_t>(st.st_size);
+    out.mtime_s = st.st_mtim.tv_sec;
+    out.mtime_ns = st.st_mtim.tv_nsec;
+    out.ctime_s = st.st_ctim.tv_sec;
+    out.ctime_ns = st.st_ctim.tv_nsec;
+    out.ino = static_cast<uint64_t>(st.st_ino);
+    out.uid = st.st_uid;
+    out.gid = st.st_gid;
+    return out;
+#else
+    (void)path;
+    return std::nullopt;
+#endif
+}
+
+bool stat_matches(const IndexEntry& entry, const FileStat& st, const Index& index) {
+    // The index keeps the low 32 bits of each field
+    if (entry.size != static_cast<uint32_t>(st.size)) return false;
+    if (entry.mtime_s != static_cast<uint32_t>(st.mtime_s) ||
+        entry.mtime_ns != static_cast<uint32_t>(st.mtime_ns)) return false;
+    if (entry.ctime_s != static_cast<uint32_t>(st.ctime_s) ||
+        entry.ctime_ns != static_cast<uint32_t>(st.ctime_ns)) return false;
+    if (entry.ino != static_cast<uint32_t>(st.ino) || entry.uid != st.uid || entry.gid != st.gid) {
+        return false;
+    }
+    if (entry.mode != st.mode) return false;
+
+    // Racily clean: modified in the same instant the index was written
+    bool racy = index.mtime_s == 0 ||
+                int64_t(entry.mtime_s) > index.mtime_s ||
+                (int64_t(entry.mtime_s) == index.mtime_s && int64_t(entry.mtime_ns) >= index.mtime_ns);
+    return !racy;
+}
+
+Result<WorktreeContent, Error> read_worktree(const Repository& repo, const std::string& rel) {
+    using R = Result<WorktreeContent, Error>;
+    WorktreeContent content;
+    fs::path path = repo.work_tree() / rel;
+
+    auto st = stat_worktree(path);
+    if (!st) return R::ok(std::move(content));
+    content.mode = st->mode;
+
+    if (content.mode == kModeSymlink) {
+#ifdef __linux__
+        std::string target(static_cast<size_t>(st->size) + 1, '\0');
+        ssize_t n = ::readlink(path.c_str(), target.data(), target.size());
+        if (n < 0) return R::err(ErrorCode::FileReadFailed, "Cannot read symlink", path.string());
+        target.resize(static_cast<size_t>(n));
+        content.data = std::move(target);
+        content.exists = true;
+#endif
+    } else if (content.mode == kModeFile || content.mode == kModeExecutable) {
+        MappedFile file;
+        if (!file.open(path)) return R::err(ErrorCode::FileReadFailed, "Cannot read file", path.string());
+        if (repo.content_ambiguous(file.data())) {
+            return R::err(ErrorCode::NotImplemented, "Content filters or EOL conversion apply", rel);
+        }
+        content.data.assign(file.data());
+        content.exists = true;
+    }
+    return R::ok(std::move(content));
+}
+
+Result<std::optional<FileChange>, Error> compare_worktree_entry(Repository& repo, const Index& index,
+                                                                const IndexEntry& entry,
+                                                                const ContentHasher& hash) {
+    using R = Result<std::optional<FileChange>, Error>;
+
+    FileChange change;
+    change.path = entry.path;
+    change.old_mode = entry.mode;
+    change.new_mode = entry.mode;
+    change.old_id = entry.id;
+
+    fs::path path = repo.work_tree() / entry.path;
+    auto st = stat_worktree(path);
+
+    if (is_gitlink(entry.mode)) {
+        if (!st || st->mode != kModeTree) {
+            change.kind = ChangeKind::Deleted;
+            change.new_mode = 0;
+            return R::ok(std::move(change));
+        }
+        change.new_id = entry.id;
+        check_submodule(path, change);
+        if (change.new_id == entry.id && !change.submodule_dirty && !change.submodule_untracked) {
+            return R::ok(std::nullopt);
+        }
+        return R::ok(std::move(change));
+    }
+
+    if (!st || st->mode == 0 || st->mode == kModeTree) {
+        change.kind = ChangeKind::Deleted;
+        change.new_mode = 0;
+        return R::ok(std::move(change));
+    }
+    if (!entry.intent_to_add && stat_matches(entry, *st, index)) return R::ok(std::nullopt);
+
+    Result<ObjectId, Error> id = Result<ObjectId, Error>::ok(ObjectId{});
+    if (hash) {
+        id = hash(entry, *st);
+    } else {
+        auto content = read_worktree(repo, entry.path);
+        if (content.is_err()) return R::err(content.error());
+        id = Result<ObjectId, Error>::ok(hash_object(ObjectType::Blob, content.value().data));
+    }
+    if (id.is_err()) return R::err(id.error());
+
+    change.new_mode = st->mode;
+    change.new_id = id.value();
+    if (entry.intent_to_add) {
+        change.kind = ChangeKind::Added;
+        change.old_mode = 0;
+        change.old_id = {};
+    } else if ((st->mode & kModeTypeMask) != (entry.mode & kModeTypeMask)) {
+        change.kind = ChangeKind::TypeChanged;
+    } else if (change.new_id != entry.id || st->mode != entry.mode) {
+        change.kind = ChangeKind::Modified;
+    } else {
+        return R::ok(std::nullopt);
+    }
+    return R::ok(std::move(change));
+}
+
+TrackedPaths::TrackedPaths(const Index& index) {
+    for (const auto& entry : index.entries) {
+        std::string_view path = entry.path;
+        files.insert(path);
+        if (is_gitlink(entry.mode)) gitlinks.insert(path);
+        for (size_t slash = path.find('/'); slash != std::string_view::npos;
+             slash = path.find('/', slash + 1)) {
+            dirs.insert(path.substr(0, slash));
+        }
+    }
+}
+
+std::string collapse_untracked(std::string_view path, const TrackedPaths& tracked) {
+    // Report the outermost directory that holds no tracked files
+    for (size_t slash = path.find('/'); slash != std::string_view::npos;
+         slash = path.find('/', slash + 1)) {
+        if (!tracked.dirs.count(path.substr(0, slash))) {
+            return std::string(path.substr(0, slash + 1));
+        }
+    }
+    return std::string(path);
+}
+
+// ============================================================================
+// Status
+// ============================================================================
+
+Result<std::vector<FileChange>, Error> staged_changes(Repository& repo, const Index& index) {
+    using R = Result<std::vector<FileChange>, Error>;
+
+    auto head = repo.resolve_ref("HEAD");
+    if (head.is_err()) return R::err(head.error());
+
+    static const FlatTree kEmptyTree;
+    std::shared_ptr<const FlatTree> tree;
+    if (head.value()) {
+        auto flat = repo.commit_tree(*head.value());
+        if (flat.is_err()) return R::err(flat.error());
+        tree = flat.value();
+    }
+    const FlatTree& head_tree = tree ? *tree : kEmptyTree;
+
+    std::vector<FileChange> added, deleted, changes;
+    std::unordered_set<std::string_view> in_index;
+
+    for (const auto& entry : index.entries) {
+        in_index.insert(entry.path);
+        if (entry.stage != 0 || entry.intent_to_add) continue;
+
+        FileChange change;
+        change.path = entry.path;
+        change.new_mode = entry.mode;
+        change.new_id = entry.id;
+
+        const FlatEntry* old = find_entry(head_tree, entry.path);
+        if (!old) {
+            change.kind = ChangeKind::Added;
+            added.push_back(std::move(change));
+        } else if (old->id != entry.id || old->mode != entry.mode) {
+            bool type_changed = (old->mode & kModeTypeMask) != (entry.mode & kModeTypeMask);
+            change.kind = type_changed ? ChangeKind::TypeChanged : ChangeKind::Modified;
+            change.old_mode = old->mode;
+            change.old_id = old->id;
+            changes.push_back(std::move(change));
+        }
+    }
+    for (const auto& old : head_tree) {
+        if (in_index.count(old.path)) continue;
+        FileChange change;
+        change.kind = ChangeKind::Deleted;
+        change.path = old.path;
+        change.old_mode = old.mode;
+        change.old_id = old.id;
+        deleted.push_back(std::move(change));
+    }
+
+    // Exact renames: a deleted and an added path with the same blob
+    std::unordered_map<ObjectId, std::vector<size_t>, ObjectIdHash> deleted_by_id;
+    for (size_t i = 0; i < deleted.size(); ++i) {
+        if (!is_gitlink(deleted[i].old_mode)) deleted_by_id[deleted[i].old_id].push_back(i);
+    }
+    std::vector<bool> renamed(deleted.size(), false);
+    for (auto& change : added) {
+        auto it = deleted_by_id.find(change.new_id);
+        if (is_gitlink(change.new_mode) || it == deleted_by_id.end() || it->second.empty()) {
+            changes.push_back(std::move(change));
+            continue;
+        }
+        const FileChange& source = deleted[it->second.front()];
+        renamed[it->second.front()] = true;
+        it->second.erase(it->second.begin());
+        change.kind = ChangeKind::Renamed;
+        change.old_path = source.path;
+        change.old_mode = source.old_mode;
+        change.old_id = source.old_id;
+        changes.push_back(std::move(change));
+    }
+    for (size_t i = 0; i < deleted.size(); ++i) {
+        if (!renamed[i]) changes.push_back(std::move(deleted[i]));
+    }
+
+    std::sort(changes.begin(), changes.end(),
+              [](const FileChange& a, const FileChange& b) { return a.path < b.path; });
+    return R::ok(std::move(changes));
+}
+
+Result<std::vector<FileChange>, Error> unstaged_changes(Repository& repo, const Index& index) {
+    using R = Result<std::vector<FileChange>, Error>;
+    std::vector<FileChange> changes;
+    for (const auto& entry : index.entries) {
+        if (entry.stage != 0 || entry.skip_worktree || entry.assume_valid) continue;
+        auto change = compare_worktree_entry(repo, index, entry);
+        if (change.is_err()) return R::err(change.error());
+        if (change.value()) changes.push_back(std::move(*change.value()));
+    }
+    return R::ok(std::move(changes));
+}
+
+std::vector<std::string> untracked_files(Repository& repo, const Index& index) {
+    TrackedPaths tracked(index);
+
+    WalkOptions options;
+    options.include_hidden = true;
+    options.skip_dirs = {".git"};
+    options.dir_filter = [&tracked](std::string_view rel) { return !tracked.gitlinks.count(rel); };
+
+    std::mutex mutex;
+    std::set<std::string> found;
+    FileWalker walker(std::move(options));
+    walker.walk(repo.work_tree(), [&](const WalkEntry& entry) {
+        if (tracked.files.count(entry.rel_path) || entry.rel_path == ".git") return true;
+        std::string item = collapse_untracked(entry.rel_path, tracked);
+        std::lock_guard lock(mutex);
+        found.insert(std::move(item));
+        return true;
+    });
+    return {found.begin(), found.end()};
+}
+
+Result<void, Error> read_head_state(Repository& repo, Status& status) {
+    status.branch = repo.head_branch();
+    auto head = repo.resolve_ref("HEAD");
+    if (head.is_err()) return Result<void, Error>::err(head.error());
+    status.head = head.value();
+    std::error_code ec;
+    status.merging = fs::exists(repo.git_dir() / "MERGE_HEAD", ec);
+
+    if (!status.branch.empty() && status.head) {
+        if (auto upstream = repo.upstream_ref(status.branch)) {
+            std::string_view name = *upstream;
+            for (std::string_view prefix : {"refs/remotes/", "refs/heads/"}) {
+                if (name.rfind(prefix, 0) == 0) name.remove_prefix(prefix.size());
+            }
+            auto target = repo.resolve_ref(*upstream);
+            if (target.is_ok() && !target.value()) {
+                status.upstream = name;
+                status.upstream_gone = true;
+            } else if (target.is_ok()) {
+                auto counts = ahead_behind(repo, *status.head, *target.value());
+                if (counts.is_ok()) {
+                    status.upstream = name;
+                    std::tie(status.ahead, status.behind) = counts.value();
+                }
+            }
+        }
+    }
+    return Result<void, Error>::ok();
+}
+
+std::vector<Conflict> unmerged_paths(const Index& index) {
+    std::vector<Conflict> conflicts;
+    for (const auto& entry : index.entries) {
+        if (entry.stage == 0) continue;
+        if (conflicts.empty() || conflicts.back().path != entry.path) {
+            conflicts.push_back({entry.path, 0});
+        }
+        conflicts.back().stages |= static_cast<uint8_t>(1u << (entry.stage - 1));
+    }
+    return conflicts;
+}
+
+Result<Status, Error> read_status(Repository& repo, bool include_untracked) {
+    using R = Result<Status, Error>;
+
+    auto index = repo.read_index();
+    if (index.is_err()) return R::err(index.error());
+
+    Status status;
+    if (auto head = read_head_state(repo, status); head.is_err()) return R::err(head.error());
+
+    auto staged = staged_changes(repo, index.value());
+    if (staged.is_err()) return R::err(staged.error());
+    status.staged = std::move(staged.value());
+
+    auto unstaged = unstaged_changes(repo, index.value());
+    if (unstaged.is_err()) return R::err(unstaged.error());
+    status.unstaged = std::move(unstaged.value());
+
+    status.unmerged = unmerged_paths(index.value());
+
+    if (include_untracked) {
+        status.untracked = untracked_files(repo, index.value());
+    }
+    return R::ok(std::move(status));
+}
+
+std::string format_status(const Status& status) {
+    std::string out;
+    if (!status.branch.empty()) {
+        out += "On branch " + status.branch + "\n";
+    } else if (status.head) {
+        out += "HEAD detached at " + abbrev(*status.head) + "\n";
+    }
+
+    if (!status.upstream.empty()) {
+        const std::string up = "'" + status.upstream + "'";
+        if (status.upstream_gone) {
+            out += "Your branch is based on " + up + ", but the upstream is gone.\n";
+        } else if (status.ahead == 0 && status.behind == 0) {
+            out += "Your branch is up to date with " + up + ".\n";
+        } else if (status.behind == 0) {
+            out += "Your branch is ahead of " + up + " by " + plural(status.ahead, "commit") + ".\n";
+        } else if (status.ahead == 0) {
+            out += "Your branch is behind " + up + " by " + plural(status.behind, "commit") +
+                   ", and can be fast-forwarded.\n";
+        } else {
+            out += "Your branch and " + up + " have diverged,\nand have " +
+                   std::to_string(status.ahead) + " and " + std::to_string(status.behind) +
+                   " different commits each, respectively.\n";
+        }
+        out += "\n";
+    }
+
+    if (!status.unmerged.empty()) {
+        out += "You have unmerged paths.\n\n";
+    } else if (status.merging) {
+        out += "All conflicts fixed but you are still merging.\n\n";
+    }
+
+    if (!status.head) {
+        out += "\nNo commits yet\n\n";
+    }
+
+    constexpr size_t kChangeWidth = 12;  // "typechange: "
+    if (!status.staged.empty()) {
+        out += "Changes to be committed:\n";
+        for (const auto& change : status.staged) {
+            std::string text = change.kind == ChangeKind::Renamed
+                ? change.old_path + " -> " + change.path : change.path;
+            append_entry(out, change_label(change.kind), kChangeWidth, text);
+        }
+        out += "\n";
+    }
+
+    if (!status.unmerged.empty()) {
+        out += "Unmerged paths:\n";
+        for (const auto& conflict : status.unmerged) {
+            append_entry(out, conflict_label(conflict.stages), 17, conflict.path);
+        }
+        out += "\n";
+    }
+
+    if (!status.unstaged.empty()) {
+        out += "Changes not staged for commit:\n";
+        for (const auto& change : status.unstaged) {
+            std::string text = change.path;
+            if (is_gitlink(change.old_mode) && change.kind == ChangeKind::Modified) {
+                std::vector<std::string> notes;
+                if (change.new_id != change.old_id) notes.push_back("new commits");
+                if (change.submodule_dirty) notes.push_back("modified content");
+                if (change.submodule_untracked) notes.push_back("untracked content");
+                text += " (";
+                for (size_t i = 0; i < notes.size(); ++i) text += (i ? ", " : "") + notes[i];
+                text += ")";
+            }
+            append_entry(out, change_label(change.kind), kChangeWidth, text);
+        }
+        out += "\n";
+    }
+
+    if (!status.untracked.empty()) {
+        out += "Untracked files:\n";
+        for (const auto& path : status.untracked) {
+            out += "\t" + path + "\n";
+        }
+        out += "\n";
+    }
+
+    if (status.staged.empty()) {
+        if (!status.unstaged.empty() || !status.unmerged.empty()) {
+            out += "no changes added to commit\n";
+        } else if (!status.untracked.empty()) {
+            out += "nothing added to commit but untracked files present\n";
+        } else if (!status.head) {
+            out += "nothing to commit\n";
+        } else {
+            out += "nothing to commit, working tree clean\n";
+        }
+    }
+    return out;
+}
+
+Result<std::pair<size_t, size_t>, Error> ahead_behind(Repository& repo, const ObjectId& a,
+                                                      const ObjectId& b) {
+    using R = Result<std::pair<size_t, size_t>, Error>;
+    if (a == b) return R::ok({0, 0});
+
+    // Paint commits reachable from a and b in commit-date order until
+    // everything still queued is reachable from both. Commit dates can tie
+    // or be skewed, so a commit that gains a flag after it was counted is
+    // uncounted and walked again.
+    constexpr uint8_t kFromA = 1, kFromB = 2, kBoth = kFromA | kFromB;
+    struct Node {
+        uint8_t flags = 0;
+        bool queued = false;
+        bool done = false;
+        int64_t time = 0;
+        std::vector<ObjectId> parents;
+    };
+    std::unordered_map<ObjectId, Node, ObjectIdHash> nodes;
+    std::priority_queue<std::pair<int64_t, ObjectId>> queue;
+    size_t single = 0;  // queued commits not yet known to be common
+    size_t ahead = 0, behind = 0, visited = 0;
+
+    auto mark = [&](const ObjectId& id, uint8_t flags) -> Result<void, Error> {
+        Node& node = nodes[id];
+        uint8_t old = node.flags;
+        node.flags |= flags;
+        if (node.flags == old && (node.done || node.queued)) return Result<void, Error>::ok();
+        if (node.done) {
+            if (old == kFromA) --ahead;
+            if (old == kFromB) --behind;
+            node.done = false;
+            node.queued = true;
+            queue.push({node.time, id});
+            if (node.flags != kBoth) ++single;
+        } else if (!node.queued) {
+            auto commit = repo.read_commit(id);
+            if (commit.is_err()) return Result<void, Error>::err(commit.error());
+            node.time = commit.value().committer.time;
+            node.parents = std::move(commit.value().parents);
+            node.queued = true;
+            queue.push({node.time, id});
+            if (node.flags != kBoth) ++single;
+        } else if (old != kBoth && node.flags == kBoth) {
+            --single;
+        }
+        return Result<void, Error>::ok();
+    };
+
+    if (auto r = mark(a, kFromA); r.is_err()) return R::err(r.error());
+    if (auto r = mark(b, kFromB); r.is_err()) return R::err(r.error());
+
+    while (single > 0 && !queue.empty()) {
+        if (++visited > kMaxAheadBehindWalk) {
+            return R::err(ErrorCode::InvalidState, "History too long to compare", "");
+        }
+        ObjectId id = queue.top().second;
+        queue.pop();
+        Node& node = nodes[id];
+        node.queued = false;
+        node.done = true;
+        if (node.flags != kBoth) --single;
+        if (node.flags == kFromA) ++ahead;
+        if (node.flags == kFromB) ++behind;
+
+        uint8_t flags = node.flags;
+        std::vector<ObjectId> parents = node.parents;
+        for (const auto& parent : parents) {
+            if (auto r = mark(parent, flags); r.is_err()) return R::err(r.error());
+        }
+    }
+    return R::ok({ahead, behind});
+}
+
+// ============================================================================
+// Diff
+// ============================================================================
+
+namespace {
+
+struct DiffSide {
+    bool exists = false;
+    std::string path;
+    uint32_t mode = 0;
+    ObjectId id{};
+    std::string content;
+};
+
+void append_file_diff(std::string& out, const DiffSide& a, const DiffSide& b,
+                      bool renamed) {
+    const std::string a_name = "a/" + (a.exists ? a.path : b.path);
+    const std::string b_name = "b/" + (b.exists ? b.path : a.path);
+    out += "diff --git " + a_name + " " + b_name + "\n";
+
+    if (!a.exists) {
+        out += "new file mode " + mode_string(b.mode) + "\n";
+    } else if (!b.exists) {
+        out += "deleted file mode " + mode_string(a.mode) + "\n";
+    } else if (a.mode != b.mode) {
+        out += "old mode " + mode_string(a.mode) + "\nnew mode " + mode_string(b.mode) + "\n";
+    }
+    if (renamed) {
+        out += "similarity index 100%\nrename from " + a.path + "\nrename to " + b.path + "\n";
+        if (a.content == b.content) return;
+    }
+
+    if (!(a.exists && b.exists && a.id == b.id)) {
+        out += "index " + (a.exists ? abbrev(a.id) : std::string(7, '0')) + ".." +
+               (b.exists ? abbrev(b.id) : std::string(7, '0'));
+        if (a.exists && b.exists && a.mode == b.mode) out += " " + mode_string(a.mode);
+        out += "\n";
+    }
+
+    const std::string from = a.exists ? a_name : "/dev/null";
+    const std::string to = b.exists ? b_name : "/dev/null";
+    if (is_binary_content(a.content) || is_binary_content(b.content)) {
+        out += "Binary files " + from + " and " + to + " differ\n";
+        return;
+    }
+    std::string hunks = unified_diff(a.content, b.content);
+    if (hunks.empty()) return;
+    out += "--- " + from + "\n+++ " + to + "\n" + hunks;
+}
+
+std::string subproject_line(const ObjectId& id, bool dirty) {
+    return "Subproject commit " + to_hex(id) + (dirty ? "-dirty" : "") + "\n";
+}
+
+Result<void, Error> load_blob(Repository& repo, DiffSide& side) {
+    if (!side.exists) return Result<void, Error>::ok();
+    if (is_gitlink(side.mode)) {
+        side.content = subproject_line(side.id, false);
+        return Result<void, Error>::ok();
+    }
+    auto object = repo.read_object(side.id);
+    if (object.is_err()) return Result<void, Error>::err(object.error());
+    side.content = std::move(object.value().data);
+    return Result<void, Error>::ok();
+}
+
+}  // namespace
+
+Result<std::string, Error> format_diff(Repository& repo, DiffTarget target, std::string_view path) {
+    using R = Result<std::string, Error>;
+
+    std::string filter(path);
+    while (filter.rfind("./", 0) == 0) filter.erase(0, 2);
+    while (!filter.empty() && filter.back() == '/') filter.pop_back();
+    if (filter == ".") filter.clear();
+    if (filter.find_first_of("*?[:") != std::string::npos) {
+        return R::err(ErrorCode::NotImplemented, "Pathspec magic is not supported", filter);
+    }
+
+    auto index = repo.read_index();
+    if (index.is_err()) return R::err(index.error());
+    auto changes = target == DiffTarget::Staged ? staged_changes(repo, index.value())
+                                                : unstaged_changes(repo, index.value());
+    if (changes.is_err()) return R::err(changes.error());
+
+    std::string out;
+    for (const auto& change : changes.value()) {
+        if (!path_matches(change.path, filter) &&
+            !(change.kind == ChangeKind::Renamed && path_matches(change.old_path, filter))) {
+            continue;
+        }
+
+        DiffSide a{change.kind != ChangeKind::Added,
+                   change.kind == ChangeKind::Renamed ? change.old_path : change.path,
+                   change.old_mode, change.old_id, {}};
+        DiffSide b{change.kind != ChangeKind::Deleted, change.path,
+                   change.new_mode, change.new_id, {}};
+
+        if (auto r = load_blob(repo, a); r.is_err()) return R::err(r.error());
+        if (target == DiffTarget::Staged) {
+            if (auto r = load_blob(repo, b); r.is_err()) return R::err(r.error());
+        } else if (b.exists && is_gitlink(b.mode)) {
+            // Untracked files inside a submodule show in status, not diff
+            if (b.id == a.id && !change.submodule_dirty) continue;
+            b.content = subproject_line(b.id, change.submodule_dirty);
+        } else if (b.exists) {
+            auto content = read_worktree(repo, change.path);
+            if (content.is_err()) return R::err(content.error());
+            b.content = std::move(content.value().data);
+        }
+
+        if (change.kind == ChangeKind::TypeChanged) {
+            // Shown by git as a deletion followed by an addition
+            DiffSide none;
+            append_file_diff(out, a, none, false);
+            append_file_diff(out, none, b, false);
+        } else {
+            append_file_diff(out, a, b, change.kind == ChangeKind::Renamed);
+        }
+    }
+    return R::ok(std::move(out));
+}
+
+// ============================================================================
+// Log
+// ============================================================================
+
+Result<std::string, Error> format_log(Repository& repo, size_t max_count, bool oneline) {
+    using R = Result<std::string, Error>;
+
+    auto head = repo.resolve_ref("HEAD");
+    if (head.is_err()) return R::err(head.error());
+    if (!head.value()) {
+        std::string branch = repo.head_branch();
+        return R::err(ErrorCode::NotFound,
+                      "your current branch '" + branch + "' does not have any commits yet", branch);
+    }
+
+    // Newest commit date first; ties in the order commits were found
+    struct Pending {
+        int64_t time;
+        uint64_t seq;
+        ObjectId id;
+        Commit commit;
+        bool operator<(const Pending& other) const {
+            return time != other.time ? time < other.time : seq > other.seq;
+        }
+    };
+    std::priority_queue<Pending> queue;
+    std::unordered_set<ObjectId, ObjectIdHash> seen;
+    uint64_t seq = 0;
+
+    auto push = [&](const ObjectId& id) -> Result<void, Error> {
+        if (!seen.insert(id).second) return Result<void, Error>::ok();
+        auto commit = repo.read_commit(id);
+        if (commit.is_err()) return Result<void, Error>::err(commit.error());
+        int64_t time = commit.value().committer.time;
+        queue.push({time, seq++, id, std::move(commit.value())});
+        return Result<void, Error>::ok();
+    };
+    if (auto r = push(*head.value()); r.is_err()) return R::err(r.error());
+
+    std::string out;
+    for (size_t shown = 0; shown < max_count && !queue.empty(); ++shown) {
+        Pending next = queue.top();
+        queue.pop();
+
+        out += abbrev(next.id) + " ";
+        if (!oneline) {
+            const Signature& author = next.commit.author;
+            std::time_t local = static_cast<std::time_t>(author.time + int64_t(author.tz_minutes) * 60);
+            std::tm tm{};
+            gmtime_r(&local, &tm);
+            char date[16];
+            std::strftime(date, sizeof(date), "%Y-%m-%d", &tm);
+            out += std::string(date) + " | ";
+        }
+        out += next.commit.subject();
+        if (!oneline) out += " [" + next.commit.author.name + "]";
+        out += "\n";
+
+        for (const auto& parent : next.commit.parents) {
+            if (auto r = push(parent); r.is_err()) return R::err(r.error());
+        }
+    }
+    return R::ok(std::move(out));
+}
+
+}  // namespace gpagent::tools::git
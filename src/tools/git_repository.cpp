@@ -0,0 +1,960 @@
+#include "gpagent/tools/git_repository.hpp"
+
+#include <openssl/evp.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+namespace gpagent::tools::git {
+
+namespace {
+
+// Longest delta chain followed before giving up (git writes at most 4095)
+constexpr size_t kMaxDeltaDepth = 10000;
+
+uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+uint16_t read_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::optional<std::string> read_text_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+std::string trim(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return std::string(s);
+}
+
+const char* type_name(ObjectType type) {
+    switch (type) {
+        case ObjectType::Commit: return "commit";
+        case ObjectType::Tree: return "tree";
+        case ObjectType::Blob: return "blob";
+        case ObjectType::Tag: return "tag";
+        default: return "";
+    }
+}
+
+ObjectType type_from_name(std::string_view name) {
+    if (name == "commit") return ObjectType::Commit;
+    if (name == "tree") return ObjectType::Tree;
+    if (name == "blob") return ObjectType::Blob;
+    if (name == "tag") return ObjectType::Tag;
+    return ObjectType::None;
+}
+
+// Inflate a zlib stream whose inflated size is known (pack entries)
+bool inflate_exact(std::string_view in, size_t size, std::string& out) {
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) return false;
+
+    out.resize(size + 1);  // room to detect oversized streams
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(std::min<size_t>(in.size(), UINT_MAX));
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+
+    int ret = inflate(&zs, Z_FINISH);
+    bool ok = ret == Z_STREAM_END && zs.total_out == size;
+    inflateEnd(&zs);
+    out.resize(size);
+    return ok;
+}
+
+// Inflate a whole zlib stream of unknown size (loose objects)
+bool inflate_all(std::string_view in, std::string& out) {
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) return false;
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(std::min<size_t>(in.size(), UINT_MAX));
+    out.clear();
+
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        size_t used = out.size();
+        out.resize(std::max<size_t>(used * 2, 4096));
+        zs.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+        zs.avail_out = static_cast<uInt>(out.size() - used);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.resize(zs.total_out);
+        if (ret == Z_BUF_ERROR && zs.avail_in > 0) ret = Z_OK;  // needs more output room
+    }
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+// Little-endian base-128 size used in delta headers
+bool read_delta_size(std::string_view data, size_t& pos, uint64_t& value) {
+    value = 0;
+    int shift = 0;
+    while (pos < data.size() && shift < 64) {
+        uint8_t c = static_cast<uint8_t>(data[pos++]);
+        value |= uint64_t(c & 0x7F) << shift;
+        shift += 7;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+bool apply_delta(std::string_view base, std::string_view delta, std::string& out) {
+    size_t pos = 0;
+    uint64_t base_size = 0, result_size = 0;
+    if (!read_delta_size(delta, pos, base_size) || !read_delta_size(delta, pos, result_size) ||
+        base_size != base.size()) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(result_size);
+    while (pos < delta.size()) {
+        uint8_t cmd = static_cast<uint8_t>(delta[pos++]);
+        if (cmd & 0x80) {
+            // Copy from base: offset and size bytes present per flag bit
+            uint64_t offset = 0, size = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (cmd & (1 << i)) {
+                    if (pos >= delta.size()) return false;
+                    offset |= uint64_t(static_cast<uint8_t>(delta[pos++])) << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (cmd & (0x10 << i)) {
+                    if (pos >= delta.size()) return false;
+                    size |= uint64_t(static_cast<uint8_t>(delta[pos++])) << (8 * i);
+                }
+            }
+            if (size == 0) size = 0x10000;
+            if (offset + size > base.size()) return false;
+            out.append(base.substr(offset, size));
+        } else if (cmd != 0) {
+            // Insert literal bytes
+            if (pos + cmd > delta.size()) return false;
+            out.append(delta.substr(pos, cmd));
+            pos += cmd;
+        } else {
+            return false;
+        }
+    }
+    return out.size() == result_size;
+}
+
+// git's offset varint (OFS_DELTA base offsets, index v4 path prefixes)
+bool read_offset_varint(std::string_view data, size_t& pos, uint64_t& value) {
+    if (pos >= data.size()) return false;
+    uint8_t c = static_cast<uint8_t>(data[pos++]);
+    value = c & 0x7F;
+    while (c & 0x80) {
+        if (pos >= data.size()) return false;
+        c = static_cast<uint8_t>(data[pos++]);
+        value = ((value + 1) << 7) | (c & 0x7F);
+    }
+    return true;
+}
+
+Result<Commit, Error> parse_commit(const Object& object, const ObjectId& id) {
+    if (object.type != ObjectType::Commit) {
+        return Result<Commit, Error>::err(ErrorCode::InvalidArgument, "Not a commit", to_hex(id));
+    }
+
+    auto parse_signature = [](std::string_view value) {
+        Signature sig;
+        size_t lt = value.find('<');
+        size_t gt = value.rfind('>');
+        if (lt == std::string_view::npos || gt == std::string_view::npos || gt < lt) {
+            sig.name = trim(value);
+            return sig;
+        }
+        sig.name = trim(value.substr(0, lt));
+        sig.email = std::string(value.substr(lt + 1, gt - lt - 1));
+
+        std::istringstream rest{std::string(value.substr(gt + 1))};
+        std::string tz;
+        rest >> sig.time >> tz;
+        if (tz.size() == 5 && (tz[0] == '+' || tz[0] == '-')) {
+            int hhmm = std::atoi(tz.c_str() + 1);
+            sig.tz_minutes = (hhmm / 100) * 60 + hhmm % 100;
+            if (tz[0] == '-') sig.tz_minutes = -sig.tz_minutes;
+        }
+        return sig;
+    };
+
+    Commit commit;
+    std::string_view data = object.data;
+    while (!data.empty()) {
+        size_t eol = data.find('\n');
+        std::string_view line = data.substr(0, eol);
+        data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
+        if (line.empty()) {
+            commit.message = std::string(data);
+            break;
+        }
+
+        size_t space = line.find(' ');
+        std::string_view key = line.substr(0, space);
+        std::string_view value = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+        if (key == "tree") {
+            if (auto tree = from_hex(value)) commit.tree = *tree;
+        } else if (key == "parent") {
+            if (auto parent = from_hex(value)) commit.parents.push_back(*parent);
+        } else if (key == "author") {
+            commit.author = parse_signature(value);
+        } else if (key == "committer") {
+            commit.committer = parse_signature(value);
+        }
+        // Other headers (gpgsig, encoding, continuation lines) are skipped
+    }
+    return Result<Commit, Error>::ok(std::move(commit));
+}
+
+Result<std::vector<TreeEntry>, Error> parse_tree(const Object& object, const ObjectId& id) {
+    if (object.type != ObjectType::Tree) {
+        return Result<std::vector<TreeEntry>, Error>::err(ErrorCode::InvalidArgument, "Not a tree", to_hex(id));
+    }
+
+    std::vector<TreeEntry> entries;
+    std::string_view data = object.data;
+    while (!data.empty()) {
+        size_t space = data.find(' ');
+        size_t nul = data.find('\0', space);
+        if (space == std::string_view::npos || nul == std::string_view::npos || nul + 21 > data.size()) {
+            return Result<std::vector<TreeEntry>, Error>::err(ErrorCode::InvalidState, "Corrupt tree", to_hex(id));
+        }
+        TreeEntry entry;
+        for (char c : data.substr(0, space)) {
+            entry.mode = entry.mode * 8 + static_cast<uint32_t>(c - '0');
+        }
+        entry.name = std::string(data.substr(space + 1, nul - space - 1));
+        std::memcpy(entry.id.data(), data.data() + nul + 1, 20);
+        entries.push_back(std::move(entry));
+        data.remove_prefix(nul + 21);
+    }
+    return Result<std::vector<TreeEntry>, Error>::ok(std::move(entries));
+}
+
+}  // namespace
+
+// ============================================================================
+// Object ids
+// ============================================================================
+
+size_t ObjectIdHash::operator()(const ObjectId& id) const {
+    size_t h;
+    std::memcpy(&h, id.data(), sizeof(h));  // ids are uniformly distributed
+    return h;
+}
+
+std::string to_hex(const ObjectId& id) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(40, '0');
+    for (size_t i = 0; i < id.size(); ++i) {
+        out[2 * i] = digits[id[i] >> 4];
+        out[2 * i + 1] = digits[id[i] & 0xF];
+    }
+    return out;
+}
+
+std::optional<ObjectId> from_hex(std::string_view hex) {
+    if (hex.size() < 40) return std::nullopt;
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    ObjectId id;
+    for (size_t i = 0; i < id.size(); ++i) {
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return std::nullopt;
+        id[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return id;
+}
+
+bool is_null(const ObjectId& id) {
+    return std::all_of(id.begin(), id.end(), [](uint8_t b) { return b == 0; });
+}
+
+ObjectId hash_object(ObjectType type, std::string_view data) {
+    std::string header = std::string(type_name(type)) + " " + std::to_string(data.size());
+    header.push_back('\0');
+
+    ObjectId id{};
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha1(), nullptr);
+    EVP_DigestUpdate(ctx, header.data(), header.size());
+    EVP_DigestUpdate(ctx, data.data(), data.size());
+    unsigned int len = 0;
+    EVP_DigestFinal_ex(ctx, id.data(), &len);
+    EVP_MD_CTX_free(ctx);
+    return id;
+}
+
+std::string Commit::subject() const {
+    std::string out;
+    std::string_view rest = message;
+    while (!rest.empty()) {
+        size_t eol = rest.find('\n');
+        std::string line = trim(rest.substr(0, eol));
+        rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+        if (line.empty()) {
+            if (out.empty()) continue;
+            break;
+        }
+        if (!out.empty()) out += ' ';
+        out += line;
+    }
+    return out;
+}
+
+const FlatEntry* find_entry(const FlatTree& tree, std::string_view path) {
+    auto it = std::lower_bound(tree.begin(), tree.end(), path,
+        [](const FlatEntry& e, std::string_view p) { return e.path < p; });
+    return it != tree.end() && it->path == path ? &*it : nullptr;
+}
+
+// ============================================================================
+// PackFile
+// ============================================================================
+
+bool PackFile::open(const fs::path& idx_path) {
+    if (!idx_.open(idx_path, false)) return false;
+
+    const auto* p = reinterpret_cast<const uint8_t*>(idx_.data().data());
+    size_t size = idx_.size();
+    constexpr size_t kHeader = 8 + 256 * 4;
+    if (size < kHeader + 40 || std::memcmp(p, "\377tOc", 4) != 0 || read_be32(p + 4) != 2) {
+        return false;  // v1 indexes predate git 1.5.2
+    }
+
+    fanout_ = p + 8;
+    count_ = read_be32(fanout_ + 255 * 4);
+    size_t ids_size = size_t(count_) * 20;
+    size_t table_end = kHeader + ids_size + size_t(count_) * 8;  // ids, crcs, offsets
+    if (table_end + 40 > size) return false;
+
+    ids_ = p + kHeader;
+    offsets32_ = ids_ + ids_size + size_t(count_) * 4;
+    offsets64_ = p + table_end;
+    offsets64_count_ = (size - table_end - 40) / 8;
+
+    pack_path_ = idx_path;
+    pack_path_.replace_extension(".pack");
+    if (!pack_.open(pack_path_, false)) return false;
+    return pack_.size() >= 12 && std::memcmp(pack_.data().data(), "PACK", 4) == 0;
+}
+
+std::optional<uint64_t> PackFile::find(const ObjectId& id) const {
+    uint32_t lo = id[0] == 0 ? 0 : read_be32(fanout_ + (id[0] - 1) * 4);
+    uint32_t hi = read_be32(fanout_ + id[0] * 4);
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = std::memcmp(ids_ + size_t(mid) * 20, id.data(), 20);
+        if (cmp == 0) {
+            uint32_t offset = read_be32(offsets32_ + size_t(mid) * 4);
+            if (!(offset & 0x80000000u)) return offset;
+
+            // Large packs keep offsets >= 2GB in a second table
+            size_t index = offset & 0x7FFFFFFFu;
+            if (index >= offsets64_count_) return std::nullopt;
+            const uint8_t* q = offsets64_ + index * 8;
+            return (uint64_t(read_be32(q)) << 32) | read_be32(q + 4);
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+// ============================================================================
+// Repository
+// ============================================================================
+
+size_t Repository::DeltaKeyHash::operator()(const DeltaKey& key) const {
+    return std::hash<const void*>()(key.pack) ^ std::hash<uint64_t>()(key.offset);
+}
+
+Result<std::shared_ptr<Repository>, Error> Repository::open(const fs::path& work_tree) {
+    using R = Result<std::shared_ptr<Repository>, Error>;
+
+    auto repo = std::make_shared<Repository>();
+    repo->work_tree_ = work_tree;
+
+    std::error_code ec;
+    fs::path dot_git = work_tree / ".git";
+    if (fs::is_directory(dot_git, ec)) {
+        repo->git_dir_ = dot_git;
+    } else if (fs::is_regular_file(dot_git, ec)) {
+        // Linked worktree or submodule: "gitdir: <path>"
+        auto content = read_text_file(dot_git);
+        if (!content || content->rfind("gitdir:", 0) != 0) {
+            return R::err(ErrorCode::InvalidState, "Unrecognized .git file", dot_git.string());
+        }
+        fs::path dir = trim(std::string_view(*content).substr(7));
+        repo->git_dir_ = dir.is_absolute() ? dir : work_tree / dir;
+    } else {
+        return R::err(ErrorCode::NotFound, "Not a git repository", work_tree.string());
+    }
+
+    repo->common_dir_ = repo->git_dir_;
+    if (auto common = read_text_file(repo->git_dir_ / "commondir")) {
+        fs::path dir = trim(*common);
+        repo->common_dir_ = dir.is_absolute() ? dir : repo->git_dir_ / dir;
+    }
+
+    fs::path objects = repo->common_dir_ / "objects";
+    repo->object_dirs_.push_back(objects);
+    if (auto alternates = read_text_file(objects / "info" / "alternates")) {
+        std::istringstream lines(*alternates);
+        std::string line;
+        while (std::getline(lines, line)) {
+            line = trim(line);
+            if (line.empty() || line[0] == '#') continue;
+            fs::path dir = line;
+            repo->object_dirs_.push_back(dir.is_absolute() ? dir : objects / dir);
+        }
+    }
+
+    if (auto check = repo->check_format(); check.is_err()) {
+        return R::err(check.error());
+    }
+    repo->scan_packs();
+    return R::ok(std::move(repo));
+}
+
+Result<std::shared_ptr<Repository>, Error> Repository::for_work_tree(const fs::path& work_tree) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::shared_ptr<Repository>> registry;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(work_tree, ec);
+    if (ec) canonical = work_tree;
+
+    std::lock_guard lock(registry_mutex);
+    auto it = registry.find(canonical.string());
+    if (it != registry.end()) {
+        return Result<std::shared_ptr<Repository>, Error>::ok(it->second);
+    }
+
+    auto repo = open(canonical);
+    if (repo.is_ok()) {
+        registry[canonical.string()] = repo.value();
+    }
+    return repo;
+}
+
+Result<void, Error> Repository::check_format() {
+    // Only SHA-1 object ids and loose/packed refs are understood
+    if (auto config = read_text_file(common_dir_ / "config")) {
+        std::istringstream lines(*config);
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::string key;
+            for (char c : line) {
+                if (!std::isspace(static_cast<unsigned char>(c))) {
+                    key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                }
+            }
+            if (key.rfind("objectformat=", 0) == 0 && key != "objectformat=sha1") {
+                return Result<void, Error>::err(ErrorCode::NotImplemented, "Unsupported object format", line);
+            }
+            if (key.rfind("refstorage=", 0) == 0 && key != "refstorage=files") {
+                return Result<void, Error>::err(ErrorCode::NotImplemented, "Unsupported ref storage", line);
+            }
+            if (key == "autocrlf=true" || key == "autocrlf=input") {
+                eol_conversion_ = true;
+            }
+        }
+    }
+
+    // Attributes at the root that may rewrite content on checkin
+    for (const fs::path& path : {work_tree_ / ".gitattributes", git_dir_ / "info" / "attributes"}) {
+        if (auto attributes = read_text_file(path)) {
+            if (attributes->find("filter") != std::string::npos) {
+                clean_filters_ = true;
+            }
+            if (attributes->find("eol") != std::string::npos ||
+                attributes->find("text") != std::string::npos ||
+                attributes->find("crlf") != std::string::npos) {
+                eol_conversion_ = true;
+            }
+        }
+    }
+    return Result<void, Error>::ok();
+}
+
+void Repository::scan_packs() {
+    for (const auto& dir : object_dirs_) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(dir / "pack", ec)) {
+            const fs::path& path = entry.path();
+            if (path.extension() != ".idx") continue;
+            if (std::find(known_packs_.begin(), known_packs_.end(), path) != known_packs_.end()) continue;
+
+            known_packs_.push_back(path);
+            auto pack = std::make_unique<PackFile>();
+            if (pack->open(path)) {
+                packs_.push_back(std::move(pack));
+            }
+        }
+    }
+}
+
+Result<Object, Error> Repository::read_loose(const ObjectId& id, bool& found) {
+    using R = Result<Object, Error>;
+    std::string hex = to_hex(id);
+
+    for (const auto& dir : object_dirs_) {
+        MappedFile file;
+        if (!file.open(dir / hex.substr(0, 2) / hex.substr(2))) continue;
+        found = true;
+
+        std::string raw;
+        if (!inflate_all(file.data(), raw)) {
+            return R::err(ErrorCode::InvalidState, "Corrupt loose object", hex);
+        }
+        size_t space = raw.find(' ');
+        size_t nul = raw.find('\0');
+        if (space == std::string::npos || nul == std::string::npos || space > nul) {
+            return R::err(ErrorCode::InvalidState, "Corrupt loose object header", hex);
+        }
+
+        Object object;
+        object.type = type_from_name(std::string_view(raw).substr(0, space));
+        object.data = raw.substr(nul + 1);
+        return R::ok(std::move(object));
+    }
+    found = false;
+    return R::err(ErrorCode::NotFound, "Object not found", hex);
+}
+
+Result<Object, Error> Repository::read_packed(PackFile& pack, uint64_t offset) {
+    using R = Result<Object, Error>;
+
+    // A delta and where its result lives, so it can serve as a cached base
+    struct Link {
+        PackFile* pack;
+        uint64_t offset;
+        std::string_view delta;  // deflated
+        uint64_t size;           // inflated
+    };
+
+    // Walk down the chain to a whole object, then apply the deltas back up.
+    // Chains are followed in a loop rather than by recursion: git writes
+    // them up to 4095 deep, and a corrupt pack could make them longer.
+    std::vector<Link> chain;
+    std::shared_ptr<const Object> base;
+    PackFile* current = &pack;
+    uint64_t at = offset;
+    auto corrupt = [&current](const char* what) {
+        return R::err(ErrorCode::InvalidState, what, current->path().string());
+    };
+    while (!base) {
+        if (chain.size() > kMaxDeltaDepth) return corrupt("Delta chain too deep");
+        std::string_view data = current->pack_data();
+        size_t pos = at;
+        if (pos >= data.size()) return corrupt("Pack offset out of range");
+
+        // Type and inflated size
+        uint8_t c = static_cast<uint8_t>(data[pos++]);
+        int type = (c >> 4) & 7;
+        uint64_t size = c & 0x0F;
+        int shift = 4;
+        while (c & 0x80) {
+            if (pos >= data.size() || shift > 57) return corrupt("Corrupt pack entry");
+            c = static_cast<uint8_t>(data[pos++]);
+            size |= uint64_t(c & 0x7F) << shift;
+            shift += 7;
+        }
+
+        if (type >= 1 && type <= 4) {
+            Object object;
+            object.type = static_cast<ObjectType>(type);
+            if (!inflate_exact(data.substr(pos), size, object.data)) {
+                return corrupt("Corrupt pack object");
+            }
+            if (chain.empty()) return R::ok(std::move(object));
+            base = std::make_shared<const Object>(std::move(object));
+            cache_delta_base(DeltaKey{current, at}, base);
+            break;
+        }
+
+        // Deltified: locate the base in this or another pack
+        PackFile* base_pack = nullptr;
+        uint64_t base_offset = 0;
+        if (type == 6) {
+            uint64_t distance = 0;
+            if (!read_offset_varint(data, pos, distance) || distance > at) {
+                return corrupt("Corrupt delta offset");
+            }
+            base_pack = current;
+            base_offset = at - distance;
+        } else if (type == 7) {
+            if (pos + 20 > data.size()) return corrupt("Corrupt delta base");
+            ObjectId base_id;
+            std::memcpy(base_id.data(), data.data() + pos, 20);
+            pos += 20;
+            for (auto& candidate : packs_) {
+                if (auto found = candidate->find(base_id)) {
+                    base_pack = candidate.get();
+                    base_offset = *found;
+                    break;
+                }
+            }
+            if (!base_pack) {
+                // Loose, or in a pack written since the last scan
+                auto result = read_object_locked(base_id);
+                if (result.is_err()) return result;
+                base = std::make_shared<const Object>(std::move(result).value());
+            }
+        } else {
+            return corrupt("Unknown pack object type");
+        }
+        chain.push_back(Link{current, at, data.substr(pos), size});
+
+        if (base_pack) {
+            if (auto it = delta_cache_.find(DeltaKey{base_pack, base_offset}); it != delta_cache_.end()) {
+                base = it->second;
+            }
+            current = base_pack;
+            at = base_offset;
+        }
+    }
+
+    Object object;
+    for (size_t i = chain.size(); i-- > 0;) {
+        const Link& link = chain[i];
+        std::string delta;
+        if (!inflate_exact(link.delta, link.size, delta)) {
+            return R::err(ErrorCode::InvalidState, "Corrupt delta", link.pack->path().string());
+        }
+        object.type = base->type;
+        if (!apply_delta(base->data, delta, object.data)) {
+            return R::err(ErrorCode::InvalidState, "Invalid delta", link.pack->path().string());
+        }
+        if (i > 0) {
+            base = std::make_shared<const Object>(std::move(object));
+            cache_delta_base(DeltaKey{link.pack, link.offset}, base);
+            object = Object{};
+        }
+    }
+    return R::ok(std::move(object));
+}
+
+void Repository::cache_delta_base(const DeltaKey& key, std::shared_ptr<const Object> base) {
+    if (delta_cache_bytes_ + base->data.size() > kDeltaCacheBytes) {
+        delta_cache_.clear();
+        delta_cache_bytes_ = 0;
+    }
+    if (delta_cache_.emplace(key, base).second) {
+        delta_cache_bytes_ += base->data.size();
+    }
+}
+
+Result<Object, Error> Repository::read_object_locked(const ObjectId& id) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (auto& pack : packs_) {
+            if (auto offset = pack->find(id)) {
+                return read_packed(*pack, *offset);
+            }
+        }
+
+        bool found = false;
+        auto loose = read_loose(id, found);
+        if (found) return loose;
+
+        // A gc or fetch may have written new packs since we looked
+        scan_packs();
+    }
+    return Result<Object, Error>::err(ErrorCode::NotFound, "Object not found", to_hex(id));
+}
+
+Result<Object, Error> Repository::read_object(const ObjectId& id) {
+    std::lock_guard lock(mutex_);
+    return read_object_locked(id);
+}
+
+Result<Commit, Error> Repository::read_commit(const ObjectId& id) {
+    auto object = read_object(id);
+    if (object.is_err()) return Result<Commit, Error>::err(object.error());
+    return parse_commit(object.value(), id);
+}
+
+Result<std::vector<TreeEntry>, Error> Repository::read_tree(const ObjectId& id) {
+    auto object = read_object(id);
+    if (object.is_err()) return Result<std::vector<TreeEntry>, Error>::err(object.error());
+    return parse_tree(object.value(), id);
+}
+
+Result<void, Error> Repository::flatten(const ObjectId& tree, const std::string& prefix, FlatTree& out) {
+    auto object = read_object_locked(tree);
+    if (object.is_err()) return Result<void, Error>::err(object.error());
+    auto entries = parse_tree(object.value(), tree);
+    if (entries.is_err()) return Result<void, Error>::err(entries.error());
+
+    for (auto& entry : entries.value()) {
+        std::string path = prefix + entry.name;
+        if (entry.mode == kModeTree) {
+            auto sub = flatten(entry.id, path + "/", out);
+            if (sub.is_err()) return sub;
+        } else {
+            out.push_back(FlatEntry{std::move(path), entry.mode, entry.id});
+        }
+    }
+    return Result<void, Error>::ok();
+}
+
+Result<std::shared_ptr<const FlatTree>, Error> Repository::commit_tree(const ObjectId& commit) {
+    using R = Result<std::shared_ptr<const FlatTree>, Error>;
+    std::lock_guard lock(mutex_);
+
+    for (auto it = tree_cache_.begin(); it != tree_cache_.end(); ++it) {
+        if (it->first == commit) {
+            tree_cache_.splice(tree_cache_.begin(), tree_cache_, it);
+            return R::ok(tree_cache_.front().second);
+        }
+    }
+
+    auto object = read_object_locked(commit);
+    if (object.is_err()) return R::err(object.error());
+    auto parsed = parse_commit(object.value(), commit);
+    if (parsed.is_err()) return R::err(parsed.error());
+
+    auto flat = std::make_shared<FlatTree>();
+    auto result = flatten(parsed.value().tree, "", *flat);
+    if (result.is_err()) return R::err(result.error());
+
+    // Tree order sorts directories as "name/"; re-sort into index order
+    std::sort(flat->begin(), flat->end(),
+              [](const FlatEntry& a, const FlatEntry& b) { return a.path < b.path; });
+
+    tree_cache_.emplace_front(commit, flat);
+    if (tree_cache_.size() > kTreeCacheSize) {
+        tree_cache_.pop_back();
+    }
+    return R::ok(std::move(flat));
+}
+
+std::optional<std::string> Repository::read_ref_file(const std::string& name) const {
+    if (auto content = read_text_file(git_dir_ / name)) return trim(*content);
+    if (name != "HEAD" && common_dir_ != git_dir_) {
+        if (auto content = read_text_file(common_dir_ / name)) return trim(*content);
+    }
+    return std::nullopt;
+}
+
+Result<std::optional<ObjectId>, Error> Repository::resolve_ref(const std::string& name) {
+    using R = Result<std::optional<ObjectId>, Error>;
+
+    std::string current = name;
+    for (int depth = 0; depth < 10; ++depth) {
+        if (auto content = read_ref_file(current)) {
+            if (content->rfind("ref:", 0) == 0) {
+                current = trim(std::string_view(*content).substr(4));
+                continue;
+            }
+            if (auto id = from_hex(*content)) return R::ok(*id);
+            return R::err(ErrorCode::InvalidState, "Corrupt ref", current);
+        }
+
+        if (auto packed = read_text_file(common_dir_ / "packed-refs")) {
+            std::istringstream lines(*packed);
+            std::string line;
+            while (std::getline(lines, line)) {
+                if (line.empty() || line[0] == '#' || line[0] == '^') continue;
+                if (line.size() > 41 && line.compare(41, std::string::npos, current) == 0) {
+                    if (auto id = from_hex(line)) return R::ok(*id);
+                }
+            }
+        }
+
+        if (current == "HEAD") {
+            return R::err(ErrorCode::NotFound, "HEAD not found", git_dir_.string());
+        }
+        return R::ok(std::nullopt);  // unborn branch
+    }
+    return R::err(ErrorCode::InvalidState, "Symbolic ref loop", name);
+}
+
+std::string Repository::head_branch() {
+    auto head = read_ref_file("HEAD");
+    if (head && head->rfind("ref: refs/heads/", 0) == 0) {
+        return head->substr(16);
+    }
+    return "";
+}
+
+std::optional<std::string> Repository::upstream_ref(const std::string& branch) const {
+    auto config = read_text_file(common_dir_ / "config");
+    if (!config) return std::nullopt;
+
+    // Minimal parse of [branch "<name>"] remote/merge
+    const std::string section = "[branch \"" + branch + "\"]";
+    bool in_section = false;
+    std::string remote, merge;
+    std::istringstream lines(*config);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string text = trim(line);
+        if (text.empty() || text[0] == '#' || text[0] == ';') continue;
+        if (text[0] == '[') {
+            in_section = text == section;
+            continue;
+        }
+        if (!in_section) continue;
+        size_t eq = text.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = trim(std::string_view(text).substr(0, eq));
+        std::string value = trim(std::string_view(text).substr(eq + 1));
+        if (key == "remote") remote = value;
+        if (key == "merge") merge = value;
+    }
+
+    if (remote.empty() || merge.rfind("refs/heads/", 0) != 0) return std::nullopt;
+    if (remote == ".") return merge;
+    return "refs/remotes/" + remote + "/" + merge.substr(11);
+}
+
+Result<Index, Error> Repository::read_index() {
+    using R = Result<Index, Error>;
+    fs::path path = git_dir_ / "index";
+
+    Index index;
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        return R::ok(std::move(index));  // fresh repository
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        return R::err(ErrorCode::FileReadFailed, "Cannot read index", path.string());
+    }
+
+#ifdef __linux__
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+        index.mtime_s = st.st_mtim.tv_sec;
+        index.mtime_ns = st.st_mtim.tv_nsec;
+    }
+#endif
+
+    std::string_view data = file.data();
+    const auto* p = reinterpret_cast<const uint8_t*>(data.data());
+    if (data.size() < 32 || std::memcmp(p, "DIRC", 4) != 0) {
+        return R::err(ErrorCode::InvalidState, "Corrupt index", path.string());
+    }
+    uint32_t version = read_be32(p + 4);
+    uint32_t count = read_be32(p + 8);
+    if (version < 2 || version > 4) {
+        return R::err(ErrorCode::NotImplemented, "Unsupported index version " + std::to_string(version), path.string());
+    }
+
+    const size_t end = data.size() - 20;  // trailing checksum
+    size_t pos = 12;
+    std::string previous;
+    index.entries.reserve(count);
+
+    for (uint32_t n = 0; n < count; ++n) {
+        if (pos + 62 > end) {
+            return R::err(ErrorCode::InvalidState, "Truncated index", path.string());
+        }
+        const uint8_t* e = p + pos;
+        IndexEntry entry;
+        entry.ctime_s = read_be32(e);
+        entry.ctime_ns = read_be32(e + 4);
+        entry.mtime_s = read_be32(e + 8);
+        entry.mtime_ns = read_be32(e + 12);
+        entry.dev = read_be32(e + 16);
+        entry.ino = read_be32(e + 20);
+        entry.mode = read_be32(e + 24);
+        entry.uid = read_be32(e + 28);
+        entry.gid = read_be32(e + 32);
+        entry.size = read_be32(e + 36);
+        std::memcpy(entry.id.data(), e + 40, 20);
+        uint16_t flags = read_be16(e + 60);
+        entry.assume_valid = flags & 0x8000;
+        entry.stage = static_cast<uint8_t>((flags >> 12) & 3);
+
+        size_t header = 62;
+        if (version >= 3 && (flags & 0x4000)) {
+            if (pos + 64 > end) {
+                return R::err(ErrorCode::InvalidState, "Truncated index", path.string());
+            }
+            uint16_t extended = read_be16(e + 62);
+            entry.skip_worktree = extended & 0x4000;
+            entry.intent_to_add = extended & 0x2000;
+            header = 64;
+        }
+
+        size_t name_start = pos + header;
+        if (version == 4) {
+            // Path is the previous path minus N bytes, plus a NUL-terminated suffix
+            uint64_t strip = 0;
+            if (!read_offset_varint(data.substr(0, end), name_start, strip) || strip > previous.size()) {
+                return R::err(ErrorCode::InvalidState, "Corrupt index path", path.string());
+            }
+            size_t nul = data.find('\0', name_start);
+            if (nul == std::string_view::npos || nul >= end) {
+                return R::err(ErrorCode::InvalidState, "Corrupt index path", path.string());
+            }
+            entry.path = previous.substr(0, previous.size() - strip);
+            entry.path.append(data.substr(name_start, nul - name_start));
+            pos = nul + 1;
+        } else {
+            size_t nul = data.find('\0', name_start);
+            if (nul == std::string_view::npos || nul >= end) {
+                return R::err(ErrorCode::InvalidState, "Corrupt index path", path.string());
+            }
+            entry.path = std::string(data.substr(name_start, nul - name_start));
+            // Entries are NUL-padded to a multiple of 8 bytes
+            pos += (header + entry.path.size() + 8) & ~size_t(7);
+        }
+
+        if (entry.mode == kModeTree) {
+            return R::err(ErrorCode::NotImplemented, "Sparse index is not supported", path.string());
+        }
+        previous = entry.path;
+        index.entries.push_back(std::move(entry));
+    }
+
+    // Extensions: uppercase signatures are optional caches, anything else
+    // (split index "link", sparse "sdir") changes the meaning of the entries
+    while (pos + 8 <= end) {
+        const uint8_t* ext = p + pos;
+        uint32_t size = read_be32(ext + 4);
+        if (!(ext[0] >= 'A' && ext[0] <= 'Z')) {
+            return R::err(ErrorCode::NotImplemented,
+                          "Unsupported index extension " + std::string(reinterpret_cast<const char*>(ext), 4),
+                          path.string());
+        }
+        pos += 8 + size;
+    }
+
+    return R::ok(std::move(index));
+}
+
+}  // namespace gpagent::tools::git
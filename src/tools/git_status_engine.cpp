@@ -0,0 +1,468 @@
+#include "gpagent/tools/git_status_engine.hpp"
+#include "gpagent/tools/file_walker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <thread>
+
+namespace gpagent::tools::git {
+
+namespace {
+
+// Entries each checking thread should have before another one is started
+constexpr size_t kEntriesPerThread = 512;
+constexpr size_t kMaxCheckThreads = 8;
+constexpr size_t kCheckBatch = 64;
+
+bool is_gitlink(const IndexEntry& entry) {
+    return (entry.mode & 0170000) == kModeGitlink;
+}
+
+bool is_checked(const IndexEntry& entry) {
+    return entry.stage == 0 && !entry.skip_worktree && !entry.assume_valid;
+}
+
+std::string parent_dir(std::string_view path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string_view::npos ? std::string() : std::string(path.substr(0, slash));
+}
+
+std::string base_name(std::string_view path) {
+    size_t slash = path.rfind('/');
+    return std::string(slash == std::string_view::npos ? path : path.substr(slash + 1));
+}
+
+// File timestamps come from the kernel's coarse clock, so a write that
+// follows a read always gets an mtime at or after this
+void coarse_now(int64_t& s, int64_t& ns) {
+#ifdef __linux__
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    s = ts.tv_sec;
+    ns = ts.tv_nsec;
+#else
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    s = std::chrono::duration_cast<std::chrono::seconds>(now).count();
+    ns = 0;
+#endif
+}
+
+void parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+    size_t threads = std::min({kMaxCheckThreads,
+                               std::max<size_t>(1, std::thread::hardware_concurrency()),
+                               (n + kEntriesPerThread - 1) / kEntriesPerThread});
+    if (threads <= 1) {
+        for (size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t start; (start = next.fetch_add(kCheckBatch)) < n;) {
+            for (size_t i = start; i < std::min(n, start + kCheckBatch); ++i) fn(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+}
+
+}  // namespace
+
+StatusEngine::StatusEngine(std::shared_ptr<Repository> repo)
+    : repo_(std::move(repo)) {}
+
+Result<std::shared_ptr<StatusEngine>, Error> StatusEngine::for_work_tree(const fs::path& work_tree) {
+    using R = Result<std::shared_ptr<StatusEngine>, Error>;
+    struct Entry {
+        std::shared_ptr<StatusEngine> engine;
+        std::chrono::steady_clock::time_point last_used;
+    };
+    static std::mutex registry_mutex;
+    static std::map<std::string, Entry> registry;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(work_tree, ec);
+    if (ec) canonical = work_tree;
+
+    std::lock_guard lock(registry_mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = registry.find(canonical.string());
+    if (it != registry.end()) {
+        it->second.last_used = now;
+        return R::ok(it->second.engine);
+    }
+
+    auto repo = Repository::for_work_tree(canonical);
+    if (repo.is_err()) return R::err(repo.error());
+
+    auto engine = std::make_shared<StatusEngine>(repo.value());
+    registry[canonical.string()] = Entry{engine, now};
+
+    // Dropping an engine releases its change journal, whose inotify watches
+    // close once no engine or index uses the project any more
+    while (registry.size() > kMaxEngines) {
+        auto oldest = std::min_element(registry.begin(), registry.end(),
+            [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        registry.erase(oldest);
+    }
+    return R::ok(std::move(engine));
+}
+
+Result<Status, Error> StatusEngine::status() {
+    using R = Result<Status, Error>;
+    std::lock_guard lock(mutex_);
+
+    if (auto r = refresh(); r.is_err()) {
+        invalidate();
+        return R::err(r.error());
+    }
+
+    Status status;
+    if (auto head = read_head_state(*repo_, status); head.is_err()) return R::err(head.error());
+
+    if (!staged_valid_ || staged_head_ != status.head) {
+        auto staged = staged_changes(*repo_, *index_);
+        if (staged.is_err()) return R::err(staged.error());
+        staged_ = std::move(staged.value());
+        staged_head_ = status.head;
+        staged_valid_ = true;
+    }
+    status.staged = staged_;
+
+    status.unstaged.reserve(unstaged_.size());
+    for (const auto& [path, change] : unstaged_) {
+        status.unstaged.push_back(change);
+    }
+    status.unmerged = unmerged_paths(*index_);
+
+    std::set<std::string> untracked;
+    for (const auto& file : files_) {
+        if (!tracked_->files.count(file)) untracked.insert(collapse_untracked(file, *tracked_));
+    }
+    status.untracked.assign(untracked.begin(), untracked.end());
+    return R::ok(std::move(status));
+}
+
+Result<void, Error> StatusEngine::refresh() {
+    auto index_stat = stat_worktree(repo_->git_dir() / "index");
+    auto exclude_stat = stat_worktree(repo_->git_dir() / "info" / "exclude");
+
+    bool first_load = !index_;
+    bool index_changed = first_load || index_stat != index_stat_;
+    std::vector<size_t> reindexed;
+    if (index_changed) {
+        index_stat_ = index_stat;
+        if (auto r = load_index(reindexed); r.is_err()) return r;
+    }
+
+    if (!journal_ && !journal_failed_) {
+        journal_ = ChangeJournal::for_project(repo_->work_tree());
+        journal_failed_ = !journal_;
+        if (journal_) journal_sequence_ = journal_->sequence();
+        files_valid_ = false;
+    }
+
+    ChangeJournal::Changes changes;
+    if (journal_) {
+        changes = journal_->since(journal_sequence_);
+        journal_sequence_ = changes.sequence;
+    }
+    bool full = !journal_ || changes.overflow;
+
+    bool watched = true;
+    if (full || !files_valid_ || exclude_stat != exclude_stat_) {
+        exclude_stat_ = exclude_stat;
+        files_.clear();
+        watched = scan_files("", {}, true);
+        files_valid_ = true;
+        find_unwatched();
+    } else {
+        watched = refresh_files(changes);
+        if (index_changed) find_unwatched();
+    }
+    if (!watched && journal_) {
+        // Out of inotify watches: fall back to checking every entry
+        journal_.reset();
+        journal_failed_ = true;
+    }
+
+    std::vector<size_t> positions;
+    if (full || first_load) {
+        unstaged_.clear();
+        for (size_t i = 0; i < index_->entries.size(); ++i) {
+            if (is_checked(index_->entries[i])) positions.push_back(i);
+        }
+    } else {
+        std::set<size_t> picked(unwatched_.begin(), unwatched_.end());
+        picked.insert(reindexed.begin(), reindexed.end());
+        for (const auto& file : changes.files) {
+            auto it = entry_pos_.find(file);
+            if (it != entry_pos_.end()) picked.insert(it->second);
+        }
+        for (const auto& dir : changes.dirs) {
+            std::string prefix = dir + "/";
+            auto it = std::lower_bound(index_->entries.begin(), index_->entries.end(), prefix,
+                [](const IndexEntry& entry, const std::string& key) { return entry.path < key; });
+            for (; it != index_->entries.end() && it->path.rfind(prefix, 0) == 0; ++it) {
+                picked.insert(static_cast<size_t>(it - index_->entries.begin()));
+            }
+            if (auto exact = entry_pos_.find(dir); exact != entry_pos_.end()) picked.insert(exact->second);
+        }
+        for (std::string_view gitlink : tracked_->gitlinks) {
+            if (auto it = entry_pos_.find(gitlink); it != entry_pos_.end()) picked.insert(it->second);
+        }
+        for (size_t pos : picked) {
+            if (is_checked(index_->entries[pos])) positions.push_back(pos);
+        }
+    }
+    return check_entries(positions);
+}
+
+Result<void, Error> StatusEngine::load_index(std::vector<size_t>& changed) {
+    auto index = repo_->read_index();
+    if (index.is_err()) return Result<void, Error>::err(index.error());
+
+    auto fresh = std::make_unique<Index>(std::move(index.value()));
+    std::unordered_map<std::string_view, size_t> positions;
+    for (size_t i = 0; i < fresh->entries.size(); ++i) {
+        if (fresh->entries[i].stage == 0) positions[fresh->entries[i].path] = i;
+    }
+
+    // A rewrite that only refreshed stat data leaves earlier results valid;
+    // recheck entries that are new or whose blob, mode or flags changed
+    for (const auto& [path, pos] : positions) {
+        const IndexEntry& entry = fresh->entries[pos];
+        auto old = entry_pos_.find(path);
+        if (old == entry_pos_.end()) {
+            changed.push_back(pos);
+            continue;
+        }
+        const IndexEntry& before = index_->entries[old->second];
+        if (before.id != entry.id || before.mode != entry.mode ||
+            before.intent_to_add != entry.intent_to_add ||
+            before.skip_worktree != entry.skip_worktree || before.assume_valid != entry.assume_valid) {
+            changed.push_back(pos);
+        }
+    }
+    for (auto it = unstaged_.begin(); it != unstaged_.end();) {
+        auto pos = positions.find(it->first);
+        it = (pos == positions.end() || !is_checked(fresh->entries[pos->second]))
+            ? unstaged_.erase(it) : std::next(it);
+    }
+
+    // Staged changes only depend on HEAD and the entries' blobs and modes
+    uint64_t fingerprint = 1469598103934665603ull;
+    auto mix = [&fingerprint](const void* data, size_t size) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) fingerprint = (fingerprint ^ bytes[i]) * 1099511628211ull;
+    };
+    for (const auto& entry : fresh->entries) {
+        mix(entry.path.data(), entry.path.size() + 1);
+        mix(entry.id.data(), entry.id.size());
+        mix(&entry.mode, sizeof(entry.mode));
+        uint8_t flags = static_cast<uint8_t>(entry.stage << 1 | entry.intent_to_add);
+        mix(&flags, 1);
+    }
+    if (fingerprint != index_fingerprint_) staged_valid_ = false;
+    index_fingerprint_ = fingerprint;
+
+    tracked_.reset();
+    entry_pos_ = std::move(positions);
+    index_ = std::move(fresh);
+    tracked_ = std::make_unique<TrackedPaths>(*index_);
+
+    for (auto it = verified_.begin(); it != verified_.end();) {
+        it = entry_pos_.count(it->first) ? std::next(it) : verified_.erase(it);
+    }
+    return Result<void, Error>::ok();
+}
+
+bool StatusEngine::scan_files(const std::string& dir, const std::set<std::string>& subdirs,
+                              bool recursive) {
+    const std::string prefix = dir.empty() ? "" : dir + "/";
+    std::atomic<bool> watched{true};
+    if (journal_ && !journal_->watch(dir)) watched = false;
+
+    WalkOptions options;
+    options.include_hidden = true;
+    options.skip_dirs = {".git"};
+    options.recursive = recursive;
+    options.dir_filter = [&](std::string_view rel) {
+        if (!subdirs.empty() && !subdirs.count(std::string(rel.substr(0, rel.find('/'))))) {
+            return false;
+        }
+        std::string full = prefix + std::string(rel);
+        if (tracked_->gitlinks.count(full)) return false;
+        if (journal_ && !journal_->watch(full)) watched = false;
+        return true;
+    };
+
+    std::mutex mutex;
+    std::vector<std::string> found;
+    FileWalker walker(std::move(options));
+    walker.walk(dir.empty() ? repo_->work_tree() : repo_->work_tree() / dir, [&](const WalkEntry& entry) {
+        std::string full = prefix + std::string(entry.rel_path);
+        if (full == ".git") return true;
+        std::lock_guard lock(mutex);
+        found.push_back(std::move(full));
+        return true;
+    });
+    files_.insert(std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    return watched;
+}
+
+bool StatusEngine::refresh_files(const DirWatcher::Changes& changes) {
+    // Changed directory -> its changed subdirectories to rescan recursively
+    std::map<std::string, std::set<std::string>> dirty;
+    for (const auto& file : changes.files) {
+        std::string name = base_name(file);
+        if (name == ".gitignore" || name == ".ignore") {
+            files_.clear();
+            return scan_files("", {}, true);
+        }
+        dirty[parent_dir(file)];
+    }
+    for (const auto& dir : changes.dirs) {
+        dirty[parent_dir(dir)].insert(base_name(dir));
+    }
+
+    bool watched = true;
+    for (const auto& [dir, subdirs] : dirty) {
+        const std::string prefix = dir.empty() ? "" : dir + "/";
+        for (auto it = files_.lower_bound(prefix);
+             it != files_.end() && it->compare(0, prefix.size(), prefix) == 0;) {
+            std::string_view rest = std::string_view(*it).substr(prefix.size());
+            size_t slash = rest.find('/');
+            bool stale = slash == std::string_view::npos ||
+                         subdirs.count(std::string(rest.substr(0, slash)));
+            it = stale ? files_.erase(it) : std::next(it);
+        }
+
+        std::error_code ec;
+        if (fs::is_directory(repo_->work_tree() / dir, ec)) {
+            watched = scan_files(dir, subdirs, !subdirs.empty()) && watched;
+        }
+    }
+    return watched;
+}
+
+Result<void, Error> StatusEngine::check_entries(const std::vector<size_t>& positions) {
+    const size_t n = positions.size();
+    std::vector<std::optional<FileChange>> changes(n);
+    std::vector<std::optional<Verified>> fresh(n);
+    std::vector<std::optional<Error>> errors(n);
+
+    // Submodules go through their own engines, one at a time
+    for (size_t i = 0; i < n; ++i) {
+        const IndexEntry& entry = index_->entries[positions[i]];
+        if (!is_gitlink(entry)) continue;
+
+        FileChange change;
+        change.path = entry.path;
+        change.old_mode = entry.mode;
+        change.new_mode = entry.mode;
+        change.old_id = entry.id;
+        change.new_id = entry.id;
+
+        fs::path path = repo_->work_tree() / entry.path;
+        auto st = stat_worktree(path);
+        if (!st || st->mode != kModeTree) {
+            change.kind = ChangeKind::Deleted;
+            change.new_mode = 0;
+            changes[i] = std::move(change);
+            continue;
+        }
+        auto sub = StatusEngine::for_work_tree(path);
+        if (sub.is_err()) continue;  // not checked out
+        auto sub_status = sub.value()->status();
+        if (sub_status.is_err()) continue;
+        const Status& s = sub_status.value();
+        if (s.head) change.new_id = *s.head;
+        change.submodule_dirty = !s.staged.empty() || !s.unstaged.empty();
+        change.submodule_untracked = !s.untracked.empty();
+        if (change.new_id != entry.id || change.submodule_dirty || change.submodule_untracked) {
+            changes[i] = std::move(change);
+        }
+    }
+
+    parallel_for(n, [&](size_t i) {
+        const IndexEntry& entry = index_->entries[positions[i]];
+        if (is_gitlink(entry)) return;
+
+        // Reuse a hash taken under identical stat data, unless the file
+        // could have been written again in the same clock tick
+        auto hasher = [&, i](const IndexEntry& e, const FileStat& st) -> Result<ObjectId, Error> {
+            auto it = verified_.find(e.path);
+            if (it != verified_.end() && it->second.stat == st &&
+                (st.mtime_s < it->second.hashed_s ||
+                 (st.mtime_s == it->second.hashed_s && st.mtime_ns < it->second.hashed_ns))) {
+                return Result<ObjectId, Error>::ok(it->second.id);
+            }
+            Verified verified;
+            verified.stat = st;
+            coarse_now(verified.hashed_s, verified.hashed_ns);
+            auto content = read_worktree(*repo_, e.path);
+            if (content.is_err()) return Result<ObjectId, Error>::err(content.error());
+            verified.id = hash_object(ObjectType::Blob, content.value().data);
+            hashed_files_++;
+            fresh[i] = verified;
+            return Result<ObjectId, Error>::ok(verified.id);
+        };
+
+        auto change = compare_worktree_entry(*repo_, *index_, entry, hasher);
+        if (change.is_err()) {
+            errors[i] = change.error();
+        } else {
+            changes[i] = std::move(change.value());
+        }
+    });
+
+    for (const auto& error : errors) {
+        if (error) return Result<void, Error>::err(*error);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const std::string& path = index_->entries[positions[i]].path;
+        if (fresh[i]) verified_[path] = *fresh[i];
+        if (changes[i]) {
+            unstaged_[path] = std::move(*changes[i]);
+        } else {
+            unstaged_.erase(path);
+        }
+    }
+    return Result<void, Error>::ok();
+}
+
+void StatusEngine::find_unwatched() {
+    unwatched_.clear();
+    if (!journal_) return;
+
+    std::unordered_map<std::string, bool> watched_dirs;
+    for (size_t i = 0; i < index_->entries.size(); ++i) {
+        const IndexEntry& entry = index_->entries[i];
+        if (!is_checked(entry) || is_gitlink(entry)) continue;
+        std::string dir = parent_dir(entry.path);
+        auto it = watched_dirs.find(dir);
+        if (it == watched_dirs.end()) {
+            it = watched_dirs.emplace(dir, journal_->watching(dir)).first;
+        }
+        if (!it->second) unwatched_.push_back(i);
+    }
+}
+
+void StatusEngine::invalidate() {
+    tracked_.reset();
+    entry_pos_.clear();
+    index_.reset();
+    unwatched_.clear();
+    unstaged_.clear();
+    files_.clear();
+    files_valid_ = false;
+    staged_valid_ = false;
+}
+
+}  // namespace gpagent::tools::git
@@ -0,0 +1,341 @@
+#include "gpagent/tools/glob_matcher.hpp"
+
+#include <algorithm>
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr uint32_t encode(uint32_t alt, uint32_t index) {
+    return (alt << 16) | index;
+}
+
+// Match one pattern character (literal, '?', class or escape) at p.
+// Returns false on mismatch; on success advances p past the pattern element.
+bool match_char(std::string_view pattern, size_t& p, char c) {
+    char pc = pattern[p];
+
+    if (pc == '?') {
+        ++p;
+        return true;
+    }
+
+    if (pc == '[') {
+        size_t q = p + 1;
+        bool negate = q < pattern.size() && (pattern[q] == '!' || pattern[q] == '^');
+        if (negate) ++q;
+
+        bool matched = false;
+        bool first = true;
+        while (q < pattern.size() && (first || pattern[q] != ']')) {
+            first = false;
+            char lo = pattern[q];
+            if (lo == '\\' && q + 1 < pattern.size()) lo = pattern[++q];
+            char hi = lo;
+            if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']') {
+                hi = pattern[q + 2];
+                q += 2;
+            }
+            if (c >= lo && c <= hi) matched = true;
+            ++q;
+        }
+
+        if (q >= pattern.size()) {
+            // Unterminated class: '[' is literal
+            ++p;
+            return c == '[';
+        }
+        p = q + 1;
+        return matched != negate;
+    }
+
+    if (pc == '\\' && p + 1 < pattern.size()) {
+        p += 2;
+        return pattern[p - 1] == c;
+    }
+
+    ++p;
+    return pc == c;
+}
+
+bool has_wildcards(std::string_view s) {
+    return s.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+// Expand '{a,b}' alternatives (nested braces allowed). Braces without a
+// top-level comma are kept literally.
+bool expand_braces(const std::string& pattern, std::vector<std::string>& out) {
+    int depth = 0;
+    size_t open = std::string::npos;
+    std::vector<size_t> commas;
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '\\') {
+            ++i;
+            continue;
+        }
+        if (c == '{') {
+            if (depth++ == 0) {
+                open = i;
+                commas.clear();
+            }
+        } else if (c == ',' && depth == 1) {
+            commas.push_back(i);
+        } else if (c == '}' && depth > 0 && --depth == 0) {
+            if (commas.empty()) continue;
+
+            std::string prefix = pattern.substr(0, open);
+            std::string suffix = pattern.substr(i + 1);
+            size_t start = open + 1;
+            commas.push_back(i);
+            for (size_t end : commas) {
+                if (!expand_braces(prefix + pattern.substr(start, end - start) + suffix, out)) {
+                    return false;
+                }
+                start = end + 1;
+            }
+            return true;
+        }
+    }
+
+    if (out.size() >= GlobMatcher::kMaxAlternatives) return false;
+    out.push_back(pattern);
+    return true;
+}
+
+}  // namespace
+
+bool wildcard_match(std::string_view pattern, std::string_view text) {
+    size_t p = 0;
+    size_t s = 0;
+    size_t star_p = std::string_view::npos;
+    size_t star_s = 0;
+
+    // Single-star backtracking: linear in practice, no recursion
+    while (s < text.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star_p = p++;
+            star_s = s;
+            continue;
+        }
+        if (p < pattern.size()) {
+            size_t next = p;
+            if (match_char(pattern, next, text[s])) {
+                p = next;
+                ++s;
+                continue;
+            }
+        }
+        if (star_p == std::string_view::npos) return false;
+        p = star_p + 1;
+        s = ++star_s;
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// ============================================================================
+// GlobMatcher
+// ============================================================================
+
+Result<GlobMatcher, Error> GlobMatcher::compile(std::string_view pattern) {
+    std::string source(pattern);
+    while (source.starts_with("./")) source.erase(0, 2);
+
+    if (source.empty()) {
+        return Result<GlobMatcher, Error>::err(ErrorCode::InvalidArgument, "Empty glob pattern");
+    }
+
+    std::vector<std::string> alternatives;
+    if (!expand_braces(source, alternatives)) {
+        return Result<GlobMatcher, Error>::err(
+            ErrorCode::InvalidArgument,
+            "Too many brace alternatives in glob pattern",
+            std::string(pattern)
+        );
+    }
+
+    GlobMatcher matcher;
+    matcher.source_ = std::string(pattern);
+
+    std::vector<std::vector<std::string>> split_alts;
+    for (const auto& alt : alternatives) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= alt.size()) {
+            size_t end = alt.find('/', start);
+            if (end == std::string::npos) end = alt.size();
+            std::string part = alt.substr(start, end - start);
+            // Collapse empty segments and consecutive '**'
+            if (!part.empty() && !(part == "**" && !parts.empty() && parts.back() == "**")) {
+                parts.push_back(std::move(part));
+            }
+            start = end + 1;
+        }
+        matcher.has_separator_ |= parts.size() > 1;
+        split_alts.push_back(std::move(parts));
+    }
+
+    // Literal leading directories shared by all alternatives
+    for (size_t i = 0;; ++i) {
+        const auto& first = split_alts[0];
+        if (i + 1 >= first.size() || has_wildcards(first[i])) break;
+        bool shared = std::all_of(split_alts.begin(), split_alts.end(), [&](const auto& parts) {
+            return i + 1 < parts.size() && parts[i] == first[i];
+        });
+        if (!shared) break;
+        matcher.literal_prefix_ += first[i] + "/";
+    }
+
+    for (const auto& parts : split_alts) {
+        matcher.offsets_.push_back(static_cast<uint32_t>(matcher.segments_.size()));
+        for (const auto& part : parts) {
+            Segment seg;
+            std::string_view rest;
+            if (part == "**") {
+                seg.kind = Segment::Kind::DoubleStar;
+            } else if (part == "*") {
+                seg.kind = Segment::Kind::Star;
+            } else if (!has_wildcards(part)) {
+                seg.kind = Segment::Kind::Literal;
+                seg.text = part;
+            } else if (part[0] == '*' && !has_wildcards(std::string_view(part).substr(1))) {
+                seg.kind = Segment::Kind::Suffix;
+                seg.text = part.substr(1);
+            } else if (part.back() == '*' &&
+                       !has_wildcards(std::string_view(part).substr(0, part.size() - 1))) {
+                seg.kind = Segment::Kind::Prefix;
+                seg.text = part.substr(0, part.size() - 1);
+            } else {
+                seg.kind = Segment::Kind::Wild;
+                seg.text = part;
+            }
+            matcher.segments_.push_back(std::move(seg));
+        }
+    }
+    matcher.offsets_.push_back(static_cast<uint32_t>(matcher.segments_.size()));
+    matcher.linear_ = split_alts.size() == 1 &&
+        std::none_of(matcher.segments_.begin(), matcher.segments_.end(),
+                     [](const Segment& seg) { return seg.kind == Segment::Kind::DoubleStar; });
+
+    return Result<GlobMatcher, Error>::ok(std::move(matcher));
+}
+
+bool GlobMatcher::match_segment(const Segment& segment, std::string_view component) {
+    switch (segment.kind) {
+        case Segment::Kind::Literal:
+            return component == segment.text;
+        case Segment::Kind::Suffix:
+            return component.ends_with(segment.text);
+        case Segment::Kind::Prefix:
+            return component.starts_with(segment.text);
+        case Segment::Kind::Star:
+        case Segment::Kind::DoubleStar:
+            return true;
+        case Segment::Kind::Wild:
+            return wildcard_match(segment.text, component);
+    }
+    return false;
+}
+
+bool GlobMatcher::is_accepting(uint32_t alt, uint32_t state) const {
+    return offsets_[alt] + state == offsets_[alt + 1];
+}
+
+// Add a state and its epsilon closure ('**' may match zero segments)
+void GlobMatcher::add_state(StateSet& states, uint32_t alt, uint32_t state) const {
+    while (true) {
+        uint32_t code = encode(alt, state);
+        if (std::find(states.begin(), states.end(), code) != states.end()) return;
+        states.push_back(code);
+
+        if (is_accepting(alt, state) ||
+            segments_[offsets_[alt] + state].kind != Segment::Kind::DoubleStar) {
+            return;
+        }
+        ++state;
+    }
+}
+
+GlobMatcher::StateSet GlobMatcher::initial_states() const {
+    StateSet states;
+    for (uint32_t alt = 0; alt + 1 < offsets_.size(); ++alt) {
+        add_state(states, alt, 0);
+    }
+    return states;
+}
+
+GlobMatcher::StateSet GlobMatcher::step(const StateSet& states, std::string_view component) const {
+    StateSet next;
+    for (uint32_t code : states) {
+        uint32_t alt = code >> 16;
+        uint32_t state = code & 0xFFFF;
+        if (is_accepting(alt, state)) continue;
+
+        const Segment& seg = segments_[offsets_[alt] + state];
+        if (seg.kind == Segment::Kind::DoubleStar) {
+            add_state(next, alt, state);
+        } else if (match_segment(seg, component)) {
+            add_state(next, alt, state + 1);
+        }
+    }
+    return next;
+}
+
+bool GlobMatcher::matches(std::string_view rel_path) const {
+    if (linear_) {
+        // One segment per path component: no state set needed (the common
+        // case for ignore rules, matched against every walked path)
+        size_t next = 0;
+        size_t start = 0;
+        while (start < rel_path.size()) {
+            size_t end = rel_path.find('/', start);
+            if (end == std::string_view::npos) end = rel_path.size();
+            if (end > start) {
+                if (next == segments_.size()) return false;
+                if (!match_segment(segments_[next++], rel_path.substr(start, end - start))) return false;
+            }
+            start = end + 1;
+        }
+        return next == segments_.size();
+    }
+
+    StateSet states = initial_states();
+
+    size_t start = 0;
+    while (start < rel_path.size() && !states.empty()) {
+        size_t end = rel_path.find('/', start);
+        if (end == std::string_view::npos) end = rel_path.size();
+        if (end > start) {
+            states = step(states, rel_path.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    return std::any_of(states.begin(), states.end(), [&](uint32_t code) {
+        return is_accepting(code >> 16, code & 0xFFFF);
+    });
+}
+
+bool GlobMatcher::could_match_within(std::string_view rel_dir) const {
+    StateSet states = initial_states();
+
+    size_t start = 0;
+    while (start < rel_dir.size() && !states.empty()) {
+        size_t end = rel_dir.find('/', start);
+        if (end == std::string_view::npos) end = rel_dir.size();
+        if (end > start) {
+            states = step(states, rel_dir.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    // Only non-accepting states can still consume the files inside
+    return std::any_of(states.begin(), states.end(), [&](uint32_t code) {
+        return !is_accepting(code >> 16, code & 0xFFFF);
+    });
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,1013 @@
+#include "gpagent/tools/html_text.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace gpagent::tools {
+
+namespace {
+
+// Below this a text block doesn't count towards its ancestors' scores
+constexpr uint32_t kMinScoredChars = 25;
+
+// A chosen subtree with less text than this is only trusted if no other
+// prose was left out
+constexpr uint32_t kMinContentChars = 500;
+
+constexpr size_t kMaxAttrValue = 512;
+
+char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool is_alnum(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+bool contains_any(std::string_view haystack, std::initializer_list<std::string_view> needles) {
+    for (auto needle : needles) {
+        if (haystack.find(needle) != std::string_view::npos) return true;
+    }
+    return false;
+}
+
+// Case-insensitive search that skips whitespace in the haystack
+// ("display: none" matches "display:none")
+bool contains_ignoring_space(std::string_view haystack, std::string_view needle) {
+    for (size_t start = 0; start < haystack.size(); ++start) {
+        size_t i = start, j = 0;
+        while (i < haystack.size() && j < needle.size()) {
+            if (is_space(haystack[i]) && j > 0) {
+                ++i;
+            } else if (to_lower(haystack[i]) == needle[j]) {
+                ++i;
+                ++j;
+            } else {
+                break;
+            }
+        }
+        if (j == needle.size()) return true;
+    }
+    return false;
+}
+
+// Class/id/role hints, after readability
+bool negative_hint(std::string_view hints) {
+    return contains_any(hints, {"-ad-", "banner", "combx", "comment", "com-", "contact", "foot",
+                                "masthead", "media", "meta", "outbrain", "promo", "related",
+                                "scroll", "share", "shoutbox", "sidebar", "skyscraper", "sponsor",
+                                "shopping", "tags", "tool", "widget", "nav", "menu", "breadcrumb",
+                                "cookie", "popup", "subscribe", "newsletter", "social"});
+}
+
+bool positive_hint(std::string_view hints) {
+    return contains_any(hints, {"article", "body", "content", "entry", "hentry", "h-entry", "main",
+                                "page", "post", "text", "blog", "story"});
+}
+
+bool unlikely_hint(std::string_view hints) {
+    return contains_any(hints, {"-ad-", "banner", "breadcrumb", "combx", "comment", "community",
+                                "disqus", "extra", "footer", "gdpr", "header", "menu", "related",
+                                "remark", "replies", "rss", "shoutbox", "sidebar", "skyscraper",
+                                "social", "sponsor", "supplemental", "pager", "popup", "cookie",
+                                "navigation", "complementary", "contentinfo"}) &&
+           !contains_any(hints, {"and", "article", "body", "column", "content", "main", "shadow"});
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Code point of a character reference name ("amp", "#39", "#x27"), or 0.
+// Without the closing ';' only numeric and a few legacy names are accepted.
+uint32_t decode_entity(std::string_view name, bool terminated) {
+    static const std::unordered_map<std::string_view, uint32_t> named = {
+        {"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''}, {"nbsp", 0xA0},
+        {"iexcl", 0xA1}, {"cent", 0xA2}, {"pound", 0xA3}, {"curren", 0xA4}, {"yen", 0xA5},
+        {"brvbar", 0xA6}, {"sect", 0xA7}, {"uml", 0xA8}, {"copy", 0xA9}, {"ordf", 0xAA},
+        {"laquo", 0xAB}, {"not", 0xAC}, {"shy", 0xAD}, {"reg", 0xAE}, {"macr", 0xAF},
+        {"deg", 0xB0}, {"plusmn", 0xB1}, {"sup2", 0xB2}, {"sup3", 0xB3}, {"acute", 0xB4},
+        {"micro", 0xB5}, {"para", 0xB6}, {"middot", 0xB7}, {"cedil", 0xB8}, {"sup1", 0xB9},
+        {"ordm", 0xBA}, {"raquo", 0xBB}, {"frac14", 0xBC}, {"frac12", 0xBD}, {"frac34", 0xBE},
+        {"iquest", 0xBF}, {"Agrave", 0xC0}, {"Aacute", 0xC1}, {"Acirc", 0xC2}, {"Atilde", 0xC3},
+        {"Auml", 0xC4}, {"Aring", 0xC5}, {"AElig", 0xC6}, {"Ccedil", 0xC7}, {"Egrave", 0xC8},
+        {"Eacute", 0xC9}, {"Ecirc", 0xCA}, {"Euml", 0xCB}, {"Igrave", 0xCC}, {"Iacute", 0xCD},
+        {"Icirc", 0xCE}, {"Iuml", 0xCF}, {"ETH", 0xD0}, {"Ntilde", 0xD1}, {"Ograve", 0xD2},
+        {"Oacute", 0xD3}, {"Ocirc", 0xD4}, {"Otilde", 0xD5}, {"Ouml", 0xD6}, {"times", 0xD7},
+        {"Oslash", 0xD8}, {"Ugrave", 0xD9}, {"Uacute", 0xDA}, {"Ucirc", 0xDB}, {"Uuml", 0xDC},
+        {"Yacute", 0xDD}, {"THORN", 0xDE}, {"szlig", 0xDF}, {"agrave", 0xE0}, {"aacute", 0xE1},
+        {"acirc", 0xE2}, {"atilde", 0xE3}, {"auml", 0xE4}, {"aring", 0xE5}, {"aelig", 0xE6},
+        {"ccedil", 0xE7}, {"egrave", 0xE8}, {"eacute", 0xE9}, {"ecirc", 0xEA}, {"euml", 0xEB},
+        {"igrave", 0xEC}, {"iacute", 0xED}, {"icirc", 0xEE}, {"iuml", 0xEF}, {"eth", 0xF0},
+        {"ntilde", 0xF1}, {"ograve", 0xF2}, {"oacute", 0xF3}, {"ocirc", 0xF4}, {"otilde", 0xF5},
+        {"ouml", 0xF6}, {"divide", 0xF7}, {"oslash", 0xF8}, {"ugrave", 0xF9}, {"uacute", 0xFA},
+        {"ucirc", 0xFB}, {"uuml", 0xFC}, {"yacute", 0xFD}, {"thorn", 0xFE}, {"yuml", 0xFF},
+        {"OElig", 0x152}, {"oelig", 0x153}, {"Scaron", 0x160}, {"scaron", 0x161}, {"fnof", 0x192},
+        {"circ", 0x2C6}, {"tilde", 0x2DC}, {"Alpha", 0x391}, {"Beta", 0x392}, {"Gamma", 0x393},
+        {"Delta", 0x394}, {"Theta", 0x398}, {"Lambda", 0x39B}, {"Pi", 0x3A0}, {"Sigma", 0x3A3},
+        {"Phi", 0x3A6}, {"Psi", 0x3A8}, {"Omega", 0x3A9}, {"alpha", 0x3B1}, {"beta", 0x3B2},
+        {"gamma", 0x3B3}, {"delta", 0x3B4}, {"epsilon", 0x3B5}, {"zeta", 0x3B6}, {"eta", 0x3B7},
+        {"theta", 0x3B8}, {"iota", 0x3B9}, {"kappa", 0x3BA}, {"lambda", 0x3BB}, {"mu", 0x3BC},
+        {"nu", 0x3BD}, {"xi", 0x3BE}, {"pi", 0x3C0}, {"rho", 0x3C1}, {"sigma", 0x3C3},
+        {"tau", 0x3C4}, {"phi", 0x3C6}, {"chi", 0x3C7}, {"psi", 0x3C8}, {"omega", 0x3C9},
+        {"ensp", 0x2002}, {"emsp", 0x2003}, {"thinsp", 0x2009}, {"zwnj", 0x200C}, {"zwj", 0x200D},
+        {"lrm", 0x200E}, {"rlm", 0x200F}, {"ndash", 0x2013}, {"mdash", 0x2014}, {"lsquo", 0x2018},
+        {"rsquo", 0x2019}, {"sbquo", 0x201A}, {"ldquo", 0x201C}, {"rdquo", 0x201D},
+        {"bdquo", 0x201E}, {"dagger", 0x2020}, {"Dagger", 0x2021}, {"bull", 0x2022},
+        {"hellip", 0x2026}, {"permil", 0x2030}, {"prime", 0x2032}, {"Prime", 0x2033},
+        {"lsaquo", 0x2039}, {"rsaquo", 0x203A}, {"euro", 0x20AC}, {"trade", 0x2122},
+        {"larr", 0x2190}, {"uarr", 0x2191}, {"rarr", 0x2192}, {"darr", 0x2193}, {"harr", 0x2194},
+        {"rArr", 0x21D2}, {"hArr", 0x21D4}, {"forall", 0x2200}, {"part", 0x2202},
+        {"exist", 0x2203}, {"empty", 0x2205}, {"nabla", 0x2207}, {"isin", 0x2208},
+        {"notin", 0x2209}, {"sum", 0x2211}, {"minus", 0x2212}, {"radic", 0x221A},
+        {"infin", 0x221E}, {"and", 0x2227}, {"or", 0x2228}, {"cap", 0x2229}, {"cup", 0x222A},
+        {"int", 0x222B}, {"asymp", 0x2248}, {"ne", 0x2260}, {"equiv", 0x2261}, {"le", 0x2264},
+        {"ge", 0x2265}, {"sub", 0x2282}, {"sup", 0x2283}, {"sube", 0x2286}, {"supe", 0x2287},
+        {"sdot", 0x22C5}, {"loz", 0x25CA}, {"spades", 0x2660}, {"clubs", 0x2663},
+        {"hearts", 0x2665}, {"diams", 0x2666}, {"check", 0x2713}, {"star", 0x2606},
+    };
+
+    if (name.size() > 1 && name[0] == '#') {
+        uint32_t cp = 0;
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        size_t digits = 0;
+        for (char c : name.substr(hex ? 2 : 1)) {
+            int v;
+            if (c >= '0' && c <= '9') {
+                v = c - '0';
+            } else if (hex && to_lower(c) >= 'a' && to_lower(c) <= 'f') {
+                v = to_lower(c) - 'a' + 10;
+            } else {
+                return 0;
+            }
+            cp = std::min<uint32_t>(cp * (hex ? 16 : 10) + static_cast<uint32_t>(v), 0x110000);
+            ++digits;
+        }
+        if (digits == 0) return 0;
+        if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0xFFFD;
+        return cp;
+    }
+
+    auto it = named.find(name);
+    if (it == named.end()) return 0;
+    if (!terminated) {
+        static constexpr std::string_view legacy[] = {"amp", "lt", "gt", "quot", "nbsp", "copy", "reg"};
+        if (std::find(std::begin(legacy), std::end(legacy), name) == std::end(legacy)) return 0;
+    }
+    return it->second;
+}
+
+// Decode character references and collapse whitespace (for the title)
+std::string decode_text(std::string_view raw) {
+    std::string out;
+    bool space = false;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        uint32_t cp = static_cast<unsigned char>(raw[i]);
+        size_t consumed = 1;
+        if (raw[i] == '&') {
+            size_t end = raw.find(';', i + 1);
+            if (end != std::string_view::npos && end - i <= 32) {
+                if (uint32_t decoded = decode_entity(raw.substr(i + 1, end - i - 1), true)) {
+                    cp = decoded;
+                    consumed = end - i + 1;
+                }
+            }
+        }
+        if (cp == 0xA0 || (cp < 0x80 && is_space(static_cast<char>(cp)))) {
+            space = !out.empty();
+        } else {
+            if (space) out += ' ';
+            space = false;
+            if (consumed == 1) out += raw[i]; else append_utf8(out, cp);
+        }
+        i += consumed - 1;
+    }
+    return out;
+}
+
+}  // namespace
+
+HtmlTextExtractor::HtmlTextExtractor(bool main_content) : main_content_(main_content) {
+    // Node 0 is the document; text outside any block element lands there
+    nodes_.push_back(Node{0, Kind::Container, false, 0});
+    attr_value_.reserve(kMaxAttrValue);
+}
+
+HtmlTextExtractor::Kind HtmlTextExtractor::classify(std::string_view name) {
+    static const std::unordered_map<std::string_view, Kind> kinds = {
+        {"a", Kind::Anchor}, {"address", Kind::Paragraph}, {"area", Kind::Void},
+        {"article", Kind::Container}, {"aside", Kind::Container}, {"audio", Kind::Skip},
+        {"base", Kind::Void}, {"blockquote", Kind::Quote}, {"body", Kind::Container},
+        {"br", Kind::Break}, {"button", Kind::Skip}, {"canvas", Kind::Skip},
+        {"caption", Kind::Paragraph}, {"center", Kind::Container}, {"code", Kind::Code},
+        {"col", Kind::Void}, {"dd", Kind::Paragraph}, {"details", Kind::Container},
+        {"dialog", Kind::Skip}, {"div", Kind::Container}, {"dl", Kind::Container},
+        {"dt", Kind::Paragraph}, {"embed", Kind::Void}, {"fieldset", Kind::Container},
+        {"figcaption", Kind::Paragraph}, {"figure", Kind::Container}, {"footer", Kind::Container},
+        {"form", Kind::Container}, {"h1", Kind::Heading}, {"h2", Kind::Heading},
+        {"h3", Kind::Heading}, {"h4", Kind::Heading}, {"h5", Kind::Heading}, {"h6", Kind::Heading},
+        {"head", Kind::Skip}, {"header", Kind::Container}, {"hr", Kind::Rule},
+        {"html", Kind::Container}, {"iframe", Kind::Raw}, {"img", Kind::Void},
+        {"input", Kind::Void}, {"li", Kind::ListItem}, {"link", Kind::Void},
+        {"main", Kind::Container}, {"map", Kind::Skip}, {"math", Kind::Skip}, {"menu", Kind::List},
+        {"meta", Kind::Void}, {"nav", Kind::Container}, {"noembed", Kind::Raw},
+        {"noframes", Kind::Raw}, {"noscript", Kind::Raw}, {"object", Kind::Skip},
+        {"ol", Kind::List}, {"p", Kind::Paragraph}, {"param", Kind::Void},
+        {"picture", Kind::Skip}, {"pre", Kind::Pre}, {"script", Kind::Raw},
+        {"section", Kind::Container}, {"select", Kind::Skip}, {"source", Kind::Void},
+        {"style", Kind::Raw}, {"summary", Kind::Paragraph}, {"svg", Kind::Skip},
+        {"table", Kind::Container}, {"tbody", Kind::Container}, {"td", Kind::Cell},
+        {"template", Kind::Skip}, {"textarea", Kind::Raw}, {"tfoot", Kind::Container},
+        {"th", Kind::Cell}, {"thead", Kind::Container}, {"title", Kind::Raw}, {"tr", Kind::Row},
+        {"track", Kind::Void}, {"ul", Kind::List}, {"video", Kind::Skip}, {"wbr", Kind::Void},
+        {"xmp", Kind::Raw},
+    };
+    auto it = kinds.find(name);
+    return it == kinds.end() ? Kind::Inline : it->second;
+}
+
+void HtmlTextExtractor::feed(std::string_view chunk) {
+    for (char c : chunk) step(c);
+}
+
+bool HtmlTextExtractor::skipping() const {
+    return !stack_.empty() && stack_.back().skip;
+}
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+void HtmlTextExtractor::step(char c) {
+    switch (state_) {
+    case State::Text:
+        if (c == '<') {
+            state_ = State::TagOpen;
+        } else if (c == '&') {
+            entity_len_ = 0;
+            state_ = State::Entity;
+        } else {
+            put_text(c);
+        }
+        return;
+
+    case State::Entity:
+        if (c == ';') {
+            state_ = State::Text;
+            end_entity(true);
+        } else if ((is_alnum(c) || (c == '#' && entity_len_ == 0)) && entity_len_ < sizeof(entity_)) {
+            entity_[entity_len_++] = c;
+        } else {
+            state_ = State::Text;
+            end_entity(false);
+            step(c);
+        }
+        return;
+
+    case State::TagOpen:
+        tag_len_ = 0;
+        self_closing_ = false;
+        hidden_ = false;
+        hints_.clear();
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            tag_[tag_len_++] = to_lower(c);
+            state_ = State::TagName;
+        } else if (c == '/') {
+            state_ = State::EndTagName;
+        } else if (c == '!') {
+            dashes_ = 0;
+            state_ = State::MarkupDecl;
+        } else if (c == '?') {
+            state_ = State::Bogus;
+        } else {
+            // A bare '<' in text
+            state_ = State::Text;
+            put_text('<');
+            step(c);
+        }
+        return;
+
+    case State::TagName:
+        if (is_space(c)) {
+            state_ = State::BeforeAttr;
+        } else if (c == '/') {
+            self_closing_ = true;
+            state_ = State::BeforeAttr;
+        } else if (c == '>') {
+            state_ = State::Text;
+            emit_start_tag();
+        } else if (tag_len_ < kMaxName) {
+            tag_[tag_len_++] = to_lower(c);
+        }
+        return;
+
+    case State::EndTagName:
+        if (c == '>') {
+            state_ = State::Text;
+            emit_end_tag(std::string_view(tag_, tag_len_));
+        } else if (is_space(c) || c == '/') {
+            state_ = State::EndTagRest;
+        } else if (tag_len_ < kMaxName) {
+            tag_[tag_len_++] = to_lower(c);
+        }
+        return;
+
+    case State::EndTagRest:
+        if (c == '>') {
+            state_ = State::Text;
+            emit_end_tag(std::string_view(tag_, tag_len_));
+        }
+        return;
+
+    case State::BeforeAttr:
+        if (is_space(c)) return;
+        if (c == '/') {
+            self_closing_ = true;
+        } else if (c == '>') {
+            state_ = State::Text;
+            emit_start_tag();
+        } else {
+            self_closing_ = false;
+            attr_len_ = 0;
+            attr_value_.clear();
+            attr_[attr_len_++] = to_lower(c);
+            state_ = State::AttrName;
+        }
+        return;
+
+    case State::AttrName:
+        if (c == '=') {
+            state_ = State::BeforeValue;
+        } else if (is_space(c)) {
+            state_ = State::AfterAttrName;
+        } else if (c == '/' || c == '>') {
+            end_attr_value();
+            state_ = State::BeforeAttr;
+            step(c);
+        } else if (attr_len_ < kMaxName) {
+            attr_[attr_len_++] = to_lower(c);
+        }
+        return;
+
+    case State::AfterAttrName:
+        if (is_space(c)) return;
+        if (c == '=') {
+            state_ = State::BeforeValue;
+        } else {
+            end_attr_value();
+            state_ = State::BeforeAttr;
+            step(c);
+        }
+        return;
+
+    case State::BeforeValue:
+        if (is_space(c)) return;
+        if (c == '"' || c == '\'') {
+            quote_ = c;
+            state_ = State::ValueQuoted;
+        } else if (c == '>') {
+            end_attr_value();
+            state_ = State::Text;
+            emit_start_tag();
+        } else {
+            attr_value_ += c;
+            state_ = State::ValueUnquoted;
+        }
+        return;
+
+    case State::ValueQuoted:
+        if (c == quote_) {
+            end_attr_value();
+            state_ = State::BeforeAttr;
+        } else if (attr_value_.size() < kMaxAttrValue) {
+            attr_value_ += c;
+        }
+        return;
+
+    case State::ValueUnquoted:
+        if (is_space(c) || c == '>') {
+            end_attr_value();
+            state_ = State::BeforeAttr;
+            step(c);
+        } else if (attr_value_.size() < kMaxAttrValue) {
+            attr_value_ += c;
+        }
+        return;
+
+    case State::MarkupDecl:
+        if (c == '-' && ++dashes_ == 2) {
+            dashes_ = 0;
+            state_ = State::Comment;
+        } else if (c == '>') {
+            state_ = State::Text;
+        } else if (c != '-') {
+            state_ = State::Bogus;
+        }
+        return;
+
+    case State::Comment:
+        if (c == '>' && dashes_ >= 2) {
+            state_ = State::Text;
+        } else {
+            dashes_ = c == '-' ? dashes_ + 1 : 0;
+        }
+        return;
+
+    case State::Bogus:
+        if (c == '>') state_ = State::Text;
+        return;
+
+    case State::RawText: {
+        // Look for "</name" followed by a delimiter
+        size_t want_len = raw_len_ + 2;
+        if (raw_match_ == want_len) {
+            if (c == '>' || is_space(c) || c == '/') {
+                raw_match_ = 0;
+                std::copy(raw_name_, raw_name_ + raw_len_, tag_);
+                tag_len_ = raw_len_;
+                state_ = State::EndTagRest;
+                step(c);
+                return;
+            }
+        } else {
+            char want = raw_match_ == 0 ? '<' : raw_match_ == 1 ? '/' : raw_name_[raw_match_ - 2];
+            if (to_lower(c) == want) {
+                ++raw_match_;
+                return;
+            }
+        }
+        if (raw_title_) {
+            if (raw_match_ > 0) title_ += '<';
+            if (raw_match_ > 1) title_ += '/';
+            if (raw_match_ > 2) title_.append(raw_name_, raw_match_ - 2);
+        }
+        raw_match_ = 0;
+        if (c == '<') {
+            raw_match_ = 1;
+        } else if (raw_title_ && title_.size() < 1024) {
+            title_ += c;
+        }
+        return;
+    }
+    }
+}
+
+void HtmlTextExtractor::end_entity(bool terminated) {
+    std::string_view name(entity_, entity_len_);
+    uint32_t cp = decode_entity(name, terminated);
+    if (cp == 0) {
+        put_text('&');
+        for (char c : name) put_text(c);
+        if (terminated) put_text(';');
+    } else if (cp == 0xA0) {
+        put_text(' ');
+    } else if (cp == 0xAD || (cp >= 0x200B && cp <= 0x200F) || cp == 0xFEFF) {
+        // Soft hyphens, zero-width and direction marks
+    } else if (cp < 0x80) {
+        put_text(static_cast<char>(cp));
+    } else {
+        std::string encoded;  // at most 4 bytes, no heap
+        append_utf8(encoded, cp);
+        put_str(encoded);
+    }
+}
+
+void HtmlTextExtractor::end_attr_value() {
+    std::string_view name(attr_, attr_len_);
+    if (name == "class" || name == "id" || name == "role") {
+        for (char c : attr_value_) hints_ += to_lower(c);
+        hints_ += ' ';
+    } else if (name == "hidden") {
+        hidden_ = true;
+    } else if (name == "aria-hidden") {
+        hidden_ = hidden_ || attr_value_ == "true";
+    } else if (name == "style") {
+        hidden_ = hidden_ || contains_ignoring_space(attr_value_, "display:none") ||
+                  contains_ignoring_space(attr_value_, "visibility:hidden");
+    }
+    attr_len_ = 0;
+    attr_value_.clear();
+}
+
+// ============================================================================
+// Tree building
+// ============================================================================
+
+void HtmlTextExtractor::emit_start_tag() {
+    std::string_view name(tag_, tag_len_);
+    Kind kind = classify(name);
+
+    if (kind == Kind::Raw) {
+        std::copy(tag_, tag_ + tag_len_, raw_name_);
+        raw_len_ = tag_len_;
+        raw_match_ = 0;
+        raw_title_ = name == "title" && title_.empty();
+        state_ = State::RawText;
+        return;
+    }
+
+    if ((kind == Kind::Pre || kind == Kind::Code) && hints_.size() > 0) {
+        for (std::string_view prefix : {"language-", "lang-"}) {
+            size_t pos = hints_.find(prefix);
+            if (pos != std::string::npos) {
+                size_t start = pos + prefix.size();
+                code_lang_ = hints_.substr(start, hints_.find(' ', start) - start);
+                break;
+            }
+        }
+    }
+
+    open_element(name, kind);
+
+    // <br/>, <div/>: nothing to close later
+    if (self_closing_ && !stack_.empty() && std::string_view(stack_.back().name, stack_.back().name_len) == name) {
+        close_element(stack_.size() - 1);
+    }
+}
+
+void HtmlTextExtractor::emit_end_tag(std::string_view name) {
+    if (name == "br") {
+        open_element(name, Kind::Break);
+        return;
+    }
+    for (size_t i = stack_.size(); i-- > 0;) {
+        if (std::string_view(stack_[i].name, stack_[i].name_len) == name) {
+            close_element(i);
+            return;
+        }
+    }
+}
+
+void HtmlTextExtractor::open_element(std::string_view name, Kind kind) {
+    bool block = kind != Kind::Inline && kind != Kind::Anchor && kind != Kind::Code &&
+                 kind != Kind::Void && kind != Kind::Break && kind != Kind::Cell && kind != Kind::Skip;
+
+    // Implied end tags: a block closes an open <p>, an item closes the
+    // previous item, a row or cell the previous one
+    auto close_open = [this](std::initializer_list<std::string_view> names,
+                             std::initializer_list<std::string_view> scope) {
+        for (size_t i = stack_.size(); i-- > 0;) {
+            std::string_view open(stack_[i].name, stack_[i].name_len);
+            if (std::find(names.begin(), names.end(), open) != names.end()) {
+                close_element(i);
+                return;
+            }
+            if (std::find(scope.begin(), scope.end(), open) != scope.end()) return;
+        }
+    };
+    if (pre_depth_ == 0) {
+        if (block) close_open({"p"}, {"div", "section", "article", "main", "body", "li", "td", "th",
+                                      "blockquote", "table", "ul", "ol"});
+        if (kind == Kind::ListItem) close_open({"li"}, {"ul", "ol", "menu"});
+        if (name == "dt" || name == "dd") close_open({"dt", "dd"}, {"dl"});
+        if (kind == Kind::Row) close_open({"tr"}, {"table"});
+        if (kind == Kind::Cell) close_open({"td", "th"}, {"tr", "table"});
+    }
+
+    if (block && pre_depth_ == 0) end_block();
+
+    switch (kind) {
+    case Kind::Break:
+        if (pre_depth_ > 0) {
+            put_text('\n');
+        } else if (!skipping() && text_.size() > block_start_ && text_.back() != '\n') {
+            text_ += '\n';
+            pending_space_ = false;
+        }
+        return;
+    case Kind::Rule:
+        if (!skipping() && pre_depth_ == 0) {
+            Block rule{};
+            rule.kind = BlockKind::Rule;
+            rule.node = stack_.empty() ? 0 : stack_.back().node;
+            rule.start = rule.size = 0;
+            blocks_.push_back(std::move(rule));
+        }
+        return;
+    case Kind::Void:
+        return;
+    case Kind::Cell:
+        if (cells_in_row_++ > 0 && text_.size() > block_start_) {
+            pending_space_ = false;
+            put_str(" | ");
+        }
+        break;
+    default:
+        break;
+    }
+
+    Element element{};
+    size_t len = std::min(name.size(), kMaxName);
+    std::copy(name.begin(), name.begin() + static_cast<std::ptrdiff_t>(len), element.name);
+    element.name_len = static_cast<uint8_t>(len);
+    element.kind = kind;
+    element.skip = skipping() || kind == Kind::Skip || hidden_;
+    element.node = stack_.empty() ? 0 : stack_.back().node;
+
+    if (block || kind == Kind::Cell) {
+        // Readability's tag bias, plus class/id/role hints
+        int weight = 0;
+        if (name == "div") {
+            weight = 5;
+        } else if (kind == Kind::Pre || kind == Kind::Cell || kind == Kind::Quote) {
+            weight = name == "th" ? -5 : 3;
+        } else if (kind == Kind::List || kind == Kind::ListItem || name == "dd" || name == "dt" ||
+                   name == "form" || name == "address") {
+            weight = -3;
+        } else if (kind == Kind::Heading) {
+            weight = -5;
+        }
+        if (negative_hint(hints_)) weight -= 25;
+        if (positive_hint(hints_)) weight += 25;
+
+        bool structural = name == "body" || name == "html" || name == "main" || name == "article";
+        bool unlikely = nodes_[element.node].unlikely ||
+                        (!structural && (name == "nav" || name == "aside" || name == "footer" ||
+                                         unlikely_hint(hints_)));
+
+        element.node = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{stack_.empty() ? 0 : stack_.back().node, kind, unlikely, weight});
+    }
+
+    if (kind == Kind::List) {
+        element.ordered = name == "ol";
+    } else if (kind == Kind::ListItem) {
+        for (size_t i = stack_.size(); i-- > 0;) {
+            if (stack_[i].kind == Kind::List) {
+                element.counter = ++stack_[i].counter;
+                break;
+            }
+        }
+    } else if (kind == Kind::Pre) {
+        if (pre_depth_++ == 0) {
+            pre_start_ = true;
+            if (hints_.find("lang") == std::string::npos) code_lang_.clear();
+        }
+    } else if (kind == Kind::Code && pre_depth_ == 0 && !element.skip) {
+        put_text('`');
+    } else if (kind == Kind::Anchor) {
+        ++link_depth_;
+    } else if (kind == Kind::Row) {
+        cells_in_row_ = 0;
+    }
+
+    stack_.push_back(element);
+}
+
+void HtmlTextExtractor::close_element(size_t index) {
+    while (stack_.size() > index) {
+        const Element& element = stack_.back();
+        Kind kind = element.kind;
+        bool block = kind != Kind::Inline && kind != Kind::Anchor && kind != Kind::Code &&
+                     kind != Kind::Cell && kind != Kind::Skip;
+
+        if (kind == Kind::Pre || (block && pre_depth_ == 0)) end_block();
+
+        if (kind == Kind::Pre) {
+            --pre_depth_;
+        } else if (kind == Kind::Anchor) {
+            link_depth_ = std::max(0, link_depth_ - 1);
+        } else if (kind == Kind::Code && pre_depth_ == 0 && !element.skip) {
+            if (text_.size() > block_start_ && text_.back() == '`') {
+                text_.pop_back();  // empty <code></code>
+            } else {
+                pending_space_ = false;
+                put_text('`');
+            }
+        }
+        stack_.pop_back();
+    }
+}
+
+// ============================================================================
+// Text blocks
+// ============================================================================
+
+void HtmlTextExtractor::put_text(char c) {
+    if (skipping()) return;
+
+    if (pre_depth_ > 0) {
+        if (c == '\r') return;
+        if (pre_start_) {
+            pre_start_ = false;
+            if (c == '\n') return;
+        }
+        text_ += c;
+        if (!is_space(c) && (c & 0xC0) != 0x80) ++block_chars_;
+        return;
+    }
+
+    if (is_space(c)) {
+        pending_space_ = true;
+        return;
+    }
+    if (pending_space_) {
+        if (text_.size() > block_start_ && text_.back() != '\n') text_ += ' ';
+        pending_space_ = false;
+    }
+    text_ += c;
+    if ((c & 0xC0) != 0x80) {
+        ++block_chars_;
+        if (link_depth_ > 0) ++block_link_chars_;
+        if (c == ',') ++block_commas_;
+    }
+}
+
+void HtmlTextExtractor::put_str(std::string_view s) {
+    for (char c : s) put_text(c);
+}
+
+void HtmlTextExtractor::end_block() {
+    size_t end = text_.size();
+    while (end > block_start_ && (text_[end - 1] == ' ' || text_[end - 1] == '\n')) --end;
+    bool empty = block_chars_ == 0 || end == block_start_;
+
+    if (!empty) {
+        Block block{};
+        block.kind = BlockKind::Paragraph;
+        bool found = false;
+        int lists = 0;
+        for (size_t i = stack_.size(); i-- > 0;) {
+            const Element& e = stack_[i];
+            if (!found) {
+                found = true;
+                if (e.kind == Kind::Pre) {
+                    block.kind = BlockKind::Pre;
+                    block.lang = code_lang_;
+                } else if (e.kind == Kind::Heading) {
+                    block.kind = BlockKind::Heading;
+                    block.level = static_cast<uint8_t>(e.name[1] - '0');
+                } else if (e.kind == Kind::ListItem) {
+                    block.kind = BlockKind::Item;
+                    block.ordinal = e.counter;
+                } else if (e.kind == Kind::Row) {
+                    block.kind = BlockKind::Row;
+                } else {
+                    found = false;
+                }
+                if (block.kind == BlockKind::Item && block.ordinal > 0) {
+                    // Bullets unless the enclosing list is ordered
+                    for (size_t j = i; j-- > 0;) {
+                        if (stack_[j].kind == Kind::List) {
+                            if (!stack_[j].ordered) block.ordinal = 0;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (e.kind == Kind::Quote) ++block.quote_depth;
+            if (e.kind == Kind::List) ++lists;
+        }
+        if (block.kind == BlockKind::Item) block.level = static_cast<uint8_t>(std::clamp(lists, 1, 8));
+
+        block.node = stack_.empty() ? 0 : stack_.back().node;
+        block.start = static_cast<uint32_t>(block_start_);
+        block.size = static_cast<uint32_t>(end - block_start_);
+        block.chars = block_chars_;
+        block.link_chars = block_link_chars_;
+        block.commas = block_commas_;
+
+        for (uint32_t n = block.node;; n = nodes_[n].parent) {
+            nodes_[n].chars += block.chars;
+            nodes_[n].link_chars += block.link_chars;
+            if (n == 0) break;
+        }
+        blocks_.push_back(std::move(block));
+        text_.resize(end);
+    } else {
+        text_.resize(block_start_);
+    }
+
+    block_start_ = text_.size();
+    block_chars_ = block_link_chars_ = block_commas_ = 0;
+    pending_space_ = false;
+    cells_in_row_ = 0;
+}
+
+// ============================================================================
+// Main content selection and rendering
+// ============================================================================
+
+std::vector<bool> HtmlTextExtractor::select_blocks() {
+    std::vector<bool> keep(blocks_.size(), !main_content_);
+    if (!main_content_) return keep;
+
+    // Score each block's ancestors: the parent fully, the grandparent half,
+    // then a third per further level
+    for (const Block& block : blocks_) {
+        if (block.chars < kMinScoredChars || nodes_[block.node].unlikely) continue;
+        double score = 1.0 + block.commas + std::min(block.chars / 100.0, 3.0);
+        uint32_t n = block.node == 0 ? 0 : nodes_[block.node].parent;
+        for (int level = 0; level < 5; ++level) {
+            Node& node = nodes_[n];
+            if (!node.scored) {
+                node.scored = true;
+                node.score = node.weight;
+            }
+            node.score += score / (level == 0 ? 1.0 : level == 1 ? 2.0 : level * 3.0);
+            if (n == 0) break;
+            n = node.parent;
+        }
+    }
+
+    auto final_score = [this](const Node& node) {
+        double density = node.chars ? static_cast<double>(node.link_chars) / node.chars : 0.0;
+        return node.score * (1.0 - density);
+    };
+
+    size_t top = nodes_.size();
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (!nodes_[i].scored || nodes_[i].unlikely) continue;
+        if (top == nodes_.size() || final_score(nodes_[i]) > final_score(nodes_[top])) top = i;
+    }
+
+    auto contains = [this](uint32_t ancestor, uint32_t n) {
+        for (;; n = nodes_[n].parent) {
+            if (n == ancestor) return true;
+            if (n == 0) return false;
+        }
+    };
+
+    if (top < nodes_.size() && top != 0) {
+        // Content split into several similar blocks (e.g. one per section):
+        // move up to an ancestor holding at least three of the close calls
+        std::vector<uint32_t> alternatives;
+        for (size_t i = 1; i < nodes_.size(); ++i) {
+            if (i != top && nodes_[i].scored && !nodes_[i].unlikely &&
+                final_score(nodes_[i]) >= 0.75 * final_score(nodes_[top])) {
+                alternatives.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        if (alternatives.size() >= 3) {
+            for (uint32_t n = nodes_[top].parent; n != 0; n = nodes_[n].parent) {
+                size_t inside = std::count_if(alternatives.begin(), alternatives.end(),
+                                              [&](uint32_t a) { return contains(n, a); });
+                if (inside >= 3) {
+                    top = n;
+                    break;
+                }
+            }
+        }
+
+        // Climb while an ancestor scores higher; stop once scores drop off
+        double last = nodes_[top].score;
+        for (uint32_t n = nodes_[top].parent; n != 0; n = nodes_[n].parent) {
+            if (!nodes_[n].scored) continue;
+            if (nodes_[n].score < last / 3) break;
+            if (nodes_[n].score > last) {
+                top = n;
+                break;
+            }
+            last = nodes_[n].score;
+        }
+    }
+
+    std::vector<bool> selected(nodes_.size(), false);
+    if (top < nodes_.size()) {
+        selected[top] = true;
+        double threshold = std::max(10.0, final_score(nodes_[top]) * 0.2);
+        for (size_t i = 1; i < nodes_.size(); ++i) {
+            const Node& node = nodes_[i];
+            if (i == top || node.parent != nodes_[top].parent || node.unlikely || top == 0) continue;
+            double density = node.chars ? static_cast<double>(node.link_chars) / node.chars : 0.0;
+            if ((node.scored && final_score(node) >= threshold) ||
+                (node.kind == Kind::Paragraph && node.chars > 80 && density < 0.25)) {
+                selected[i] = true;
+            }
+        }
+    }
+
+    // Prose left outside the selection means the page has no single main
+    // content (reference docs split into many sections, a short page)
+    uint32_t kept_chars = 0, left_prose_chars = 0;
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        const Block& block = blocks_[b];
+        if (nodes_[block.node].unlikely) continue;
+        for (uint32_t n = block.node;; n = nodes_[n].parent) {
+            if (selected[n]) {
+                keep[b] = true;
+                kept_chars += block.chars;
+                break;
+            }
+            if (n == 0) break;
+        }
+        if (!keep[b] && block.chars >= kMinScoredChars && block.link_chars * 4 < block.chars) {
+            left_prose_chars += block.chars;
+        }
+    }
+
+    if (kept_chars == 0 || left_prose_chars * 2 > kept_chars ||
+        (kept_chars < kMinContentChars && left_prose_chars > 0)) {
+        for (size_t b = 0; b < blocks_.size(); ++b) keep[b] = !nodes_[blocks_[b].node].unlikely;
+    }
+    return keep;
+}
+
+std::string HtmlTextExtractor::finish() {
+    if (state_ == State::Entity) {
+        state_ = State::Text;
+        end_entity(false);
+    }
+    close_element(0);
+    end_block();
+    title_ = decode_text(title_);
+
+    std::vector<bool> keep = select_blocks();
+
+    std::string out;
+    out.reserve(text_.size() + text_.size() / 8 + title_.size());
+
+    // The title, unless the content opens with the same heading
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        if (!keep[b]) continue;
+        std::string_view first(text_.data() + blocks_[b].start, blocks_[b].size);
+        if (!title_.empty() && !(blocks_[b].kind == BlockKind::Heading && title_.rfind(first, 0) == 0)) {
+            out += "# " + title_;
+        }
+        break;
+    }
+
+    BlockKind prev = BlockKind::Rule;
+    std::string rendered;
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        if (!keep[b]) continue;
+        const Block& block = blocks_[b];
+        std::string_view text(text_.data() + block.start, block.size);
+        if (block.kind == BlockKind::Rule && (out.empty() || prev == BlockKind::Rule)) continue;
+
+        rendered.clear();
+        std::string indent;
+        switch (block.kind) {
+        case BlockKind::Heading:
+            rendered.append(block.level, '#');
+            rendered += ' ';
+            break;
+        case BlockKind::Item:
+            indent.assign(2u * (block.level - 1u), ' ');
+            rendered += indent;
+            rendered += block.ordinal ? std::to_string(block.ordinal) + ". " : "- ";
+            indent += "  ";
+            break;
+        case BlockKind::Pre:
+            rendered += "```" + block.lang + "\n";
+            break;
+        case BlockKind::Rule:
+            rendered += "---";
+            break;
+        default:
+            break;
+        }
+        for (char c : text) {
+            rendered += c;
+            if (c == '\n' && !indent.empty() && block.kind == BlockKind::Item) rendered += indent;
+        }
+        if (block.kind == BlockKind::Pre) rendered += "\n```";
+
+        if (!out.empty()) {
+            bool tight = (prev == BlockKind::Item && block.kind == BlockKind::Item) ||
+                         (prev == BlockKind::Row && block.kind == BlockKind::Row);
+            out += tight ? "\n" : "\n\n";
+        }
+        if (block.quote_depth > 0) {
+            std::string prefix;
+            for (int i = 0; i < block.quote_depth; ++i) prefix += "> ";
+            out += prefix;
+            for (char c : rendered) {
+                out += c;
+                if (c == '\n') out += prefix;
+            }
+        } else {
+            out += rendered;
+        }
+        prev = block.kind;
+    }
+
+    while (!out.empty() && out.back() == '\n') out.pop_back();
+    return out;
+}
+
+std::string html_to_text(std::string_view html, bool main_content) {
+    HtmlTextExtractor extractor(main_content);
+    extractor.feed(html);
+    return extractor.finish();
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,347 @@
+#include "gpagent/tools/http_cache.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+#include "gpagent/core/types.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr const char* kDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// Entries above this share of the budget are not stored, so one large
+// download cannot flush the cache
+constexpr uint64_t kMaxEntryShare = 8;
+
+uint64_t fnv1a(std::string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return lower(x) == lower(y); });
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+std::optional<int64_t> parse_seconds(std::string_view s) {
+    s = trim(s);
+    if (s.size() >= 2 && s.front() == '"' && s.back() == '"') s = s.substr(1, s.size() - 2);
+    int64_t value = 0;
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc() || end != s.data() + s.size() || value < 0) return std::nullopt;
+    return value;
+}
+
+struct CacheControl {
+    bool no_store = false;
+    bool no_cache = false;
+    std::optional<int64_t> max_age;
+};
+
+CacheControl parse_cache_control(std::string_view value) {
+    CacheControl cc;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view directive = trim(value.substr(0, comma));
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+
+        size_t eq = directive.find('=');
+        std::string_view name = trim(directive.substr(0, eq));
+        std::string_view arg = eq == std::string_view::npos ? std::string_view() : directive.substr(eq + 1);
+
+        if (iequals(name, "no-store")) {
+            cc.no_store = true;
+        } else if (iequals(name, "no-cache")) {
+            cc.no_cache = true;
+        } else if (iequals(name, "max-age")) {
+            // A malformed max-age makes the response stale
+            cc.max_age = parse_seconds(arg).value_or(0);
+        }
+    }
+    return cc;
+}
+
+// Seconds the response stays fresh from when it was generated (RFC 9111 4.2.1)
+int64_t freshness_lifetime(const HttpCache::HeaderLookup& header, int64_t now) {
+    std::string cache_control = header("Cache-Control");
+    CacheControl cc = parse_cache_control(cache_control);
+    if (cache_control.empty() && header("Pragma").find("no-cache") != std::string::npos) {
+        cc.no_cache = true;
+    }
+
+    if (cc.no_cache) return 0;
+    if (cc.max_age) return *cc.max_age;
+
+    int64_t date = parse_http_date(header("Date")).value_or(now);
+    std::string expires = header("Expires");
+    if (!expires.empty()) {
+        // Invalid dates such as "0" mean already expired
+        auto at = parse_http_date(expires);
+        return at ? std::max<int64_t>(0, *at - date) : 0;
+    }
+
+    if (auto modified = parse_http_date(header("Last-Modified"))) {
+        return std::clamp<int64_t>((date - *modified) / 10, 0, HttpCache::kMaxHeuristicSeconds);
+    }
+    return 0;
+}
+
+int64_t current_age(const HttpCache::HeaderLookup& header) {
+    return parse_seconds(header("Age")).value_or(0);
+}
+
+}  // namespace
+
+// =============================================================================
+// HTTP dates
+// =============================================================================
+
+std::optional<int64_t> parse_http_date(std::string_view value) {
+    // All three formats are day, month, year and time in some order, with
+    // the day before the year; weekday names and the zone are ignored
+    int day = -1, month = -1, year = -1, hour = -1, minute = -1, second = -1;
+    size_t i = 0;
+    while (i < value.size()) {
+        char c = value[i];
+        if (c == ' ' || c == ',' || c == '-' || c == '\t') {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < value.size() && value[i] != ' ' && value[i] != ',' && value[i] != '-' && value[i] != '\t') ++i;
+        std::string_view token = value.substr(start, i - start);
+
+        if (token.find(':') != std::string_view::npos) {
+            if (std::sscanf(std::string(token).c_str(), "%2d:%2d:%2d", &hour, &minute, &second) != 3) {
+                return std::nullopt;
+            }
+        } else if (token[0] >= '0' && token[0] <= '9') {
+            int number = 0;
+            auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), number);
+            if (ec != std::errc() || end != token.data() + token.size()) return std::nullopt;
+            if (day < 0) {
+                day = number;
+            } else if (year < 0) {
+                // Two-digit years (RFC 850)
+                year = token.size() <= 2 ? (number < 70 ? 2000 + number : 1900 + number) : number;
+            } else {
+                return std::nullopt;
+            }
+        } else if (token.size() == 3) {
+            for (int m = 0; m < 12; ++m) {
+                if (iequals(token, kMonths[m])) month = m;
+            }
+        }
+    }
+
+    if (day < 1 || day > 31 || month < 0 || year < 1970 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return std::nullopt;
+    }
+
+    std::tm tm{};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    return static_cast<int64_t>(timegm(&tm));
+}
+
+std::string format_http_date(int64_t time) {
+    std::time_t t = static_cast<std::time_t>(time);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                  kDays[tm.tm_wday], tm.tm_mday, kMonths[tm.tm_mon], tm.tm_year + 1900,
+                  tm.tm_hour, tm.tm_min, tm.tm_sec);
+    return buf;
+}
+
+// =============================================================================
+// Freshness
+// =============================================================================
+
+std::optional<HttpCache::Entry> HttpCache::from_response(int status, const HeaderLookup& header,
+                                                         std::string body, int64_t now) {
+    if (status != 200) return std::nullopt;
+    if (parse_cache_control(header("Cache-Control")).no_store) return std::nullopt;
+    if (trim(header("Vary")) == "*") return std::nullopt;
+
+    Entry entry;
+    entry.status = status;
+    entry.content_type = header("Content-Type");
+    entry.etag = header("ETag");
+    entry.last_modified = header("Last-Modified");
+    entry.stored_at = now;
+    entry.fresh_until = now + freshness_lifetime(header, now) - current_age(header);
+    entry.body = std::move(body);
+    return entry;
+}
+
+void HttpCache::refresh(Entry& entry, const HeaderLookup& header, int64_t now) {
+    // Validators and freshness from the 304, falling back to the stored ones
+    HeaderLookup merged = [&](const std::string& name) {
+        std::string value = header(name);
+        if (!value.empty()) return value;
+        if (iequals(name, "ETag")) return entry.etag;
+        if (iequals(name, "Last-Modified")) return entry.last_modified;
+        return std::string();
+    };
+
+    entry.etag = merged("ETag");
+    entry.last_modified = merged("Last-Modified");
+    entry.stored_at = now;
+    entry.fresh_until = now + freshness_lifetime(merged, now) - current_age(header);
+}
+
+int64_t HttpCache::now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// =============================================================================
+// Storage
+// =============================================================================
+
+HttpCache::HttpCache(fs::path dir, uint64_t max_bytes)
+    : lru_(std::move(dir), max_bytes) {}
+
+std::shared_ptr<HttpCache> HttpCache::open(const fs::path& dir, uint64_t max_bytes) {
+    return shared_disk_cache<HttpCache>(dir, max_bytes);
+}
+
+std::string HttpCache::file_name(const std::string& key) const {
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.entry", static_cast<unsigned long long>(fnv1a(key)));
+    return name;
+}
+
+void HttpCache::load() {
+    if (loaded_) return;
+    loaded_ = true;
+
+    std::error_code ec;
+    fs::create_directories(lru_.dir(), ec);
+    for (const auto& item : fs::directory_iterator(lru_.dir(), ec)) {
+        std::error_code item_ec;
+        if (!item.is_regular_file(item_ec) || DiskLru::discard_temp(item.path())) continue;
+        std::string name = item.path().filename().string();
+        if (!name.ends_with(".entry")) continue;
+
+        uint64_t size = item.file_size(item_ec);
+        auto mtime = item.last_write_time(item_ec);
+        if (item_ec) continue;
+        lru_.set(name, size, DiskLru::to_unix_ns(mtime));
+    }
+    lru_.evict();
+}
+
+std::optional<HttpCache::Entry> HttpCache::get(const std::string& key) {
+    std::string name = file_name(key);
+    {
+        std::lock_guard lock(mutex_);
+        load();
+        if (!lru_.contains(name)) return std::nullopt;
+    }
+
+    // Entries are replaced by rename, so reading needs no lock
+    fs::path path = lru_.dir() / name;
+    std::ifstream in(path, std::ios::binary);
+    std::string meta_line;
+    if (!in || !std::getline(in, meta_line)) return std::nullopt;
+
+    Entry entry;
+    try {
+        core::Json meta = core::Json::parse(meta_line);
+        if (meta.value("key", "") != key) return std::nullopt;  // hash collision
+        entry.status = meta.value("status", 200);
+        entry.content_type = meta.value("content_type", "");
+        entry.etag = meta.value("etag", "");
+        entry.last_modified = meta.value("last_modified", "");
+        entry.stored_at = meta.value("stored_at", int64_t{0});
+        entry.fresh_until = meta.value("fresh_until", int64_t{0});
+    } catch (const std::exception& e) {
+        spdlog::debug("Dropping unreadable HTTP cache entry {}: {}", path.string(), e.what());
+        remove(key);
+        return std::nullopt;
+    }
+    entry.body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    DiskLru::stamp(path);
+    std::lock_guard lock(mutex_);
+    lru_.used(name);
+    return entry;
+}
+
+void HttpCache::put(const std::string& key, const Entry& entry) {
+    core::Json meta = {
+        {"key", key},
+        {"status", entry.status},
+        {"content_type", entry.content_type},
+        {"etag", entry.etag},
+        {"last_modified", entry.last_modified},
+        {"stored_at", entry.stored_at},
+        {"fresh_until", entry.fresh_until}
+    };
+    std::string meta_line = meta.dump() + "\n";
+    uint64_t size = meta_line.size() + entry.body.size();
+    if (size > lru_.max_bytes() / kMaxEntryShare) return;
+
+    std::string name = file_name(key);
+    {
+        std::lock_guard lock(mutex_);
+        load();
+    }
+
+    auto written = write_file_atomic(lru_.dir() / name, {meta_line, entry.body});
+    if (written.is_err()) {
+        spdlog::warn("Failed to write HTTP cache entry: {}", written.error().message);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    lru_.set(name, size);
+    lru_.evict();
+}
+
+void HttpCache::remove(const std::string& key) {
+    std::string name = file_name(key);
+    std::lock_guard lock(mutex_);
+    load();
+    lru_.erase(name);
+}
+
+uint64_t HttpCache::size_bytes() {
+    std::lock_guard lock(mutex_);
+    load();
+    return lru_.total_bytes();
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,130 @@
+#include "gpagent/tools/image_cache.hpp"
+#include "gpagent/tools/base64.hpp"
+#include "gpagent/core/sha256.hpp"
+
+#include <fstream>
+#include <iterator>
+
+namespace gpagent::tools {
+
+namespace {
+
+// Identity of a file as last seen on disk
+std::optional<std::string> stat_key(const fs::path& path, int max_dimension) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec) return std::nullopt;
+    auto mtime = fs::last_write_time(path, ec);
+    if (ec) return std::nullopt;
+    return fs::absolute(path, ec).string() + '\n' + std::to_string(size) + '\n' +
+           std::to_string(mtime.time_since_epoch().count()) + '\n' + std::to_string(max_dimension);
+}
+
+}  // namespace
+
+ImageCache::ImageCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+ImageCache& ImageCache::shared() {
+    static ImageCache cache;
+    return cache;
+}
+
+std::string ImageCache::content_id(const std::string& content, int max_dimension) {
+    return sha256_hex({std::to_string(max_dimension), "\n", content});
+}
+
+Result<std::shared_ptr<const ImageCache::Image>, Error> ImageCache::load(
+    const fs::path& path, int max_dimension, const Encoder& encode) {
+    using R = Result<std::shared_ptr<const Image>, Error>;
+
+    auto key = stat_key(path, max_dimension);
+    if (key) {
+        std::lock_guard lock(mutex_);
+        if (auto it = by_stat_.find(*key); it != by_stat_.end()) {
+            if (auto image = lookup_locked(it->second)) return R::ok(std::move(image));
+            by_stat_.erase(it);
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return R::err(ErrorCode::FileReadFailed, "Cannot open image", path.string());
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        return R::err(ErrorCode::FileReadFailed, "Cannot read image", path.string());
+    }
+
+    std::string id = content_id(content, max_dimension);
+    {
+        std::lock_guard lock(mutex_);
+        if (auto image = lookup_locked(id)) {
+            if (key) by_stat_[*key] = id;
+            return R::ok(std::move(image));
+        }
+    }
+
+    // Encode outside the lock: it is the slow part, and a concurrent miss on
+    // the same content only costs a duplicate encode
+    auto encoded = encode(content, max_dimension);
+    if (!encoded || encoded->bytes.empty()) {
+        return R::err(ErrorCode::ToolExecutionFailed, "Failed to decode image", path.string());
+    }
+
+    auto image = std::make_shared<Image>();
+    image->id = id;
+    image->base64 = std::make_shared<const std::string>(base64_encode(encoded->bytes));
+    image->media_type = std::move(encoded->media_type);
+    image->width = encoded->width;
+    image->height = encoded->height;
+    image->was_resized = encoded->was_resized;
+    image->encoded_size = encoded->bytes.size();
+
+    std::lock_guard lock(mutex_);
+    if (key) by_stat_[*key] = id;
+    insert_locked(image);
+    return R::ok(std::move(image));
+}
+
+std::shared_ptr<const ImageCache::Image> ImageCache::find(const std::string& id) {
+    std::lock_guard lock(mutex_);
+    return lookup_locked(id);
+}
+
+size_t ImageCache::size_bytes() {
+    std::lock_guard lock(mutex_);
+    return total_bytes_;
+}
+
+std::shared_ptr<const ImageCache::Image> ImageCache::lookup_locked(const std::string& id) {
+    auto it = images_.find(id);
+    if (it == images_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.image;
+}
+
+void ImageCache::insert_locked(std::shared_ptr<const Image> image) {
+    if (auto it = images_.find(image->id); it != images_.end()) {
+        total_bytes_ -= it->second.image->base64->size();
+        lru_.erase(it->second.lru);
+        images_.erase(it);
+    }
+
+    total_bytes_ += image->base64->size();
+    lru_.push_front(image->id);
+    images_.emplace(image->id, Slot{image, lru_.begin()});
+
+    // Keep the newest image even when it alone exceeds the budget; messages
+    // holding an evicted payload keep their own reference to it
+    while (total_bytes_ > max_bytes_ && lru_.size() > 1) {
+        auto victim = images_.find(lru_.back());
+        total_bytes_ -= victim->second.image->base64->size();
+        images_.erase(victim);
+        lru_.pop_back();
+    }
+    if (by_stat_.size() > 4 * images_.size() + 64) {
+        std::erase_if(by_stat_, [this](const auto& entry) { return !images_.contains(entry.second); });
+    }
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,621 @@
+#include "gpagent/tools/interpreter_pool.hpp"
+
+#include "gpagent/core/types.hpp"
+#include "gpagent/tools/output_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+// Same overall budget as the one-shot path, keeping the tail for tracebacks
+constexpr size_t kOutputHeadBytes = 60000;
+constexpr size_t kOutputTailBytes = 40000;
+
+// The driver's globals live in the interpreter's own __main__; each snippet
+// gets a new module registered as __main__ while it runs. Afterwards the
+// working directory, environment, builtins, sys.path and argv are put back,
+// and modules imported from outside the interpreter's prefixes (the project's
+// own code) are dropped so edits to them are seen. Frames are
+// "<length>\n<json>" on the control socket (fd 3): first {"ready"} from the
+// worker, then one {"exit_code", "clean"} per request, where clean is false
+// if the snippet left threads running.
+constexpr const char* kPythonDriver = R"PY(
+import builtins, json, linecache, os, site, socket, sys, threading, traceback, types
+
+KEEP = tuple(os.path.join(os.path.realpath(p), "") for p in
+             {sys.prefix, sys.base_prefix, sys.exec_prefix, site.getusersitepackages()})
+
+def run(request):
+    source = request["code"]
+    linecache.cache["<code>"] = (len(source), None, source.splitlines(True), "<code>")
+    module = types.ModuleType("__main__")
+    module.__file__ = "<code>"
+    module.__builtins__ = builtins
+    sys.modules["__main__"] = module
+    sys.argv[:] = ["<code>"]
+    os.environ.update(request["env"])
+    try:
+        os.chdir(request["cwd"])
+        exec(compile(source, "<code>", "exec"), module.__dict__)
+        for thread in threading.enumerate():
+            if thread is not threading.main_thread() and not thread.daemon:
+                thread.join()
+    except SystemExit as e:
+        if e.code is None:
+            return 0
+        if isinstance(e.code, int):
+            return e.code & 0xFF
+        print(e.code, file=sys.stderr)
+        return 1
+    except BaseException as e:
+        traceback.print_exception(type(e), e, e.__traceback__.tb_next)
+        return 1
+    return 0
+
+def main():
+    control = socket.socket(fileno=3)
+    reader = control.makefile("rb")
+    def send(message):
+        body = json.dumps(message).encode()
+        control.sendall(b"%d\n%s" % (len(body), body))
+
+    saved_path, saved_argv, saved_env = list(sys.path), list(sys.argv), dict(os.environ)
+    saved_main, saved_streams = sys.modules["__main__"], (sys.stdin, sys.stdout, sys.stderr)
+    saved_cwd, saved_builtins = os.getcwd(), dict(builtins.__dict__)
+    send({"ready": True})
+    while True:
+        header = reader.readline()
+        if not header:
+            return
+        modules, threads = set(sys.modules), threading.active_count()
+        code = run(json.loads(reader.read(int(header))))
+        for stream in (sys.stdout, sys.stderr):
+            try:
+                stream.flush()
+            except Exception:
+                pass
+        clean = threading.active_count() <= threads
+        sys.stdin, sys.stdout, sys.stderr = saved_streams
+        sys.modules["__main__"] = saved_main
+        sys.path[:], sys.argv[:] = saved_path, saved_argv
+        os.environ.clear()
+        os.environ.update(saved_env)
+        try:
+            os.chdir(saved_cwd)
+        except OSError:
+            pass
+        builtins.__dict__.clear()
+        builtins.__dict__.update(saved_builtins)
+        for name in set(sys.modules) - modules:
+            path = getattr(sys.modules[name], "__file__", None)
+            if path and not os.path.realpath(path).startswith(KEEP):
+                del sys.modules[name]
+        linecache.cache.pop("<code>", None)
+        send({"exit_code": code, "clean": clean})
+
+main()
+)PY";
+
+// Snippets run as the body of an async CommonJS-style wrapper, so require,
+// module and top-level await work. A run ends once the promise settles and
+// no timers, handles or requests beyond those present before it are left.
+// Modules it loaded from outside node_modules are evicted from the require
+// cache, like the Python driver's project modules.
+constexpr const char* kNodeDriver = R"JS(
+'use strict';
+const net = require('net'), path = require('path'), vm = require('vm'), Module = require('module');
+const control = new net.Socket({ fd: 3, readable: true, writable: true });
+const savedEnv = { ...process.env };
+const savedCwd = process.cwd();
+process.stdout; process.stderr;  // open the stdio handles before any baseline
+let current = null;
+
+function report(err) {
+  let text = err && err.stack ? err.stack : 'Uncaught ' + String(err);
+  const driver = text.indexOf('\n    at run ([eval]');  // frames below the snippet are ours
+  if (driver >= 0) text = text.slice(0, driver);
+  process.stderr.write(text + '\n');
+  if (current) current.failed = true;
+}
+process.on('uncaughtException', report);
+process.on('unhandledRejection', report);
+
+function resources() {
+  const counts = new Map();
+  for (const r of process.getActiveResourcesInfo()) counts.set(r, (counts.get(r) || 0) + 1);
+  return counts;
+}
+function settle(base) {
+  return new Promise((resolve) => {
+    const check = () => {
+      for (const [r, n] of resources()) {
+        if (n > (base.get(r) || 0)) return setTimeout(() => setImmediate(check), 2);
+      }
+      resolve();
+    };
+    setImmediate(check);
+  });
+}
+function send(message) {
+  const body = Buffer.from(JSON.stringify(message));
+  control.write(body.length + '\n');
+  control.write(body);
+}
+
+async function run(request) {
+  const base = resources();
+  const cached = new Set(Object.keys(Module._cache));
+  current = { failed: false };
+  process.exitCode = undefined;
+  Object.assign(process.env, request.env);
+  try {
+    process.chdir(request.cwd);
+    const cwd = process.cwd();
+    const filename = path.join(cwd, '<code>');
+    const module = new Module(filename, null);
+    module.filename = filename;
+    module.paths = Module._nodeModulePaths(cwd);
+    const fn = vm.runInThisContext(
+      '(async function (exports, require, module, __filename, __dirname) {' + request.code + '\n})',
+      { filename: '<code>' });
+    await fn.call(module.exports, module.exports, Module.createRequire(filename), module,
+                  filename, cwd);
+  } catch (err) {
+    report(err);
+  }
+  await settle(base);
+  const code = current.failed ? 1 : (process.exitCode || 0);
+  current = null;
+  process.exitCode = undefined;
+  for (const key of Object.keys(process.env)) if (!(key in savedEnv)) delete process.env[key];
+  Object.assign(process.env, savedEnv);
+  process.chdir(savedCwd);
+  const packages = path.sep + 'node_modules' + path.sep;
+  for (const key of Object.keys(Module._cache)) {
+    if (!cached.has(key) && !key.includes(packages)) delete Module._cache[key];
+  }
+  return code;
+}
+
+let pending = Buffer.alloc(0), busy = false;
+function pump() {
+  if (busy) return;
+  const newline = pending.indexOf(10);
+  if (newline < 0) return;
+  const length = Number(pending.subarray(0, newline).toString());
+  if (pending.length < newline + 1 + length) return;
+  const request = JSON.parse(pending.subarray(newline + 1, newline + 1 + length).toString());
+  pending = pending.subarray(newline + 1 + length);
+  busy = true;
+  control.pause();
+  setImmediate(async () => {
+    send({ exit_code: await run(request), clean: true });
+    busy = false;
+    control.resume();
+    pump();
+  });
+}
+control.on('data', (chunk) => { pending = Buffer.concat([pending, chunk]); pump(); });
+control.on('end', () => process.exit(0));
+control.on('error', () => process.exit(0));
+send({ ready: true });
+)JS";
+
+}  // namespace
+
+#ifdef __linux__
+
+struct InterpreterPool::Worker {
+    pid_t pid = -1;
+    int control_fd = -1;  // request/response socket, the worker's fd 3
+    int output_fd = -1;   // the worker's stdout and stderr
+    bool ready = false;   // the driver has announced itself
+    int runs = 0;
+    std::string inbox;    // partial frames from the control socket
+
+    ~Worker() {
+        if (pid > 0) {
+            kill(-pid, SIGKILL);
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        if (control_fd >= 0) close(control_fd);
+        if (output_fd >= 0) close(output_fd);
+    }
+
+    bool alive() {
+        int status = 0;
+        if (pid > 0 && waitpid(pid, &status, WNOHANG) == 0) return true;
+        pid = -1;
+        return false;
+    }
+
+    // A process the snippet left behind: another member of the worker's
+    // process group, or a child that moved to its own session. Either could
+    // write into later runs' output.
+    bool has_strays() const {
+        DIR* proc = opendir("/proc");
+        if (!proc) return true;
+        bool found = false;
+        while (dirent* entry = readdir(proc)) {
+            if (entry->d_name[0] < '1' || entry->d_name[0] > '9') continue;
+            if (std::atoi(entry->d_name) == pid) continue;
+
+            char path[64];
+            std::snprintf(path, sizeof(path), "/proc/%s/stat", entry->d_name);
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            char stat[512];
+            ssize_t n = read(fd, stat, sizeof(stat) - 1);
+            close(fd);
+            if (n <= 0) continue;
+            stat[n] = '\0';
+
+            // "pid (comm) state ppid pgrp ..."; comm may contain spaces
+            const char* fields = std::strrchr(stat, ')');
+            char state = 0;
+            int ppid = 0, pgrp = 0;
+            if (!fields || std::sscanf(fields + 1, " %c %d %d", &state, &ppid, &pgrp) != 3) continue;
+            if (state != 'Z' && (pgrp == pid || ppid == pid)) {
+                found = true;
+                break;
+            }
+        }
+        closedir(proc);
+        return found;
+    }
+
+    int64_t rss_bytes() const {
+        std::ifstream statm("/proc/" + std::to_string(pid) + "/statm");
+        int64_t size = 0, resident = 0;
+        if (!(statm >> size >> resident)) return 0;
+        return resident * sysconf(_SC_PAGESIZE);
+    }
+};
+
+namespace {
+
+using Worker = InterpreterPool::Worker;
+
+enum class WaitStatus { Done, TimedOut, Lost };
+
+std::unique_ptr<Worker> spawn_worker(InterpreterPool::Language language) {
+    int control[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, control) != 0) return nullptr;
+    int output[2];
+    if (pipe2(output, O_CLOEXEC) != 0) {
+        close(control[0]);
+        close(control[1]);
+        return nullptr;
+    }
+
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid < 0) {
+        for (int fd : {control[0], control[1], output[0], output[1]}) close(fd);
+        return nullptr;
+    }
+
+    if (pid == 0) {
+        // Child: own process group (a timeout kills everything the snippet
+        // started), dies with the agent, can't gain privileges or dump core
+        setpgid(0, 0);
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) _exit(127);
+        prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+        rlimit no_core{0, 0};
+        setrlimit(RLIMIT_CORE, &no_core);
+
+        // Move the control socket out of the way before filling fds 0-3
+        int control_fd = fcntl(control[1], F_DUPFD, 10);
+        int null_fd = open("/dev/null", O_RDONLY);
+        if (control_fd < 0 || null_fd < 0) _exit(127);
+        dup2(null_fd, STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        dup2(output[1], STDERR_FILENO);
+        dup2(control_fd, 3);
+#ifdef SYS_close_range
+        syscall(SYS_close_range, 4u, ~0u, 0u);
+#endif
+
+        if (language == InterpreterPool::Language::Python) {
+            execlp("python3", "python3", "-u", "-c", kPythonDriver, nullptr);
+        } else {
+            execlp("node", "node", "-e", kNodeDriver, nullptr);
+        }
+        _exit(127);
+    }
+
+    setpgid(pid, pid);
+    close(control[1]);
+    close(output[1]);
+    fcntl(control[0], F_SETFL, fcntl(control[0], F_GETFL) | O_NONBLOCK);
+    fcntl(output[0], F_SETFL, fcntl(output[0], F_GETFL) | O_NONBLOCK);
+
+    auto worker = std::make_unique<Worker>();
+    worker->pid = pid;
+    worker->control_fd = control[0];
+    worker->output_fd = output[0];
+    return worker;
+}
+
+// Pop one complete "<length>\n<json>" frame; false if none is buffered yet
+bool take_frame(std::string& inbox, core::Json& frame) {
+    size_t newline = inbox.find('\n');
+    if (newline == std::string::npos) return false;
+    size_t length = std::strtoull(inbox.c_str(), nullptr, 10);
+    if (inbox.size() < newline + 1 + length) return false;
+    frame = core::Json::parse(inbox.substr(newline + 1, length), nullptr, false);
+    inbox.erase(0, newline + 1 + length);
+    return true;
+}
+
+// Read whatever output is buffered without waiting for more
+void drain_output(Worker& worker, OutputBuffer& output, OutputBatcher& stream) {
+    char buffer[65536];
+    for (;;) {
+        ssize_t n = read(worker.output_fd, buffer, sizeof(buffer));
+        if (n <= 0 && !(n < 0 && errno == EINTR)) break;
+        if (n > 0) {
+            output.append(std::string_view(buffer, static_cast<size_t>(n)));
+            stream.append(std::string_view(buffer, static_cast<size_t>(n)));
+        }
+    }
+}
+
+// Send the request and relay output until the response frame arrives
+WaitStatus exchange(Worker& worker, std::string request, int timeout_ms, core::Json& response,
+                    OutputBuffer& output, OutputBatcher& stream) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::vector<char> buffer(65536);
+
+    while (true) {
+        core::Json frame;
+        while (take_frame(worker.inbox, frame)) {
+            if (frame.is_discarded()) return WaitStatus::Lost;
+            if (!worker.ready) {
+                worker.ready = true;
+                continue;
+            }
+            response = std::move(frame);
+            drain_output(worker, output, stream);
+            return WaitStatus::Done;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return WaitStatus::TimedOut;
+        int wait_ms = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        if (int due = stream.due_in_ms(); due >= 0) {
+            wait_ms = std::min(wait_ms, due);
+        }
+
+        pollfd fds[2] = {
+            {worker.control_fd, static_cast<short>(POLLIN | (request.empty() ? 0 : POLLOUT)), 0},
+            {worker.output_fd, POLLIN, 0},
+        };
+        int ret = poll(fds, worker.output_fd >= 0 ? 2 : 1, std::max(wait_ms, 1));
+        if (ret < 0 && errno != EINTR) return WaitStatus::Lost;
+
+        if (ret > 0 && (fds[1].revents & (POLLIN | POLLHUP))) {
+            ssize_t n = read(worker.output_fd, buffer.data(), buffer.size());
+            if (n > 0) {
+                output.append(std::string_view(buffer.data(), static_cast<size_t>(n)));
+                stream.append(std::string_view(buffer.data(), static_cast<size_t>(n)));
+            } else if (n == 0) {
+                // Closed by the snippet or a dying worker; the socket decides
+                close(worker.output_fd);
+                worker.output_fd = -1;
+            }
+        }
+        if (ret > 0 && (fds[0].revents & POLLOUT) && !request.empty()) {
+            ssize_t n = send(worker.control_fd, request.data(), request.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                request.erase(0, static_cast<size_t>(n));
+            } else if (n < 0 && errno != EINTR && errno != EAGAIN) {
+                return WaitStatus::Lost;
+            }
+        }
+        if (ret > 0 && (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            ssize_t n = recv(worker.control_fd, buffer.data(), buffer.size(), 0);
+            if (n > 0) {
+                worker.inbox.append(buffer.data(), static_cast<size_t>(n));
+            } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+                return WaitStatus::Lost;
+            }
+        }
+        stream.flush_if_due();
+    }
+}
+
+// Kill the worker's process group and return its exit status
+int reap(Worker& worker) {
+    kill(-worker.pid, SIGKILL);
+    int status = 0;
+    int exit_code = -1;
+    if (waitpid(worker.pid, &status, 0) == worker.pid) {
+        if (WIFEXITED(status)) {
+            exit_code = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            exit_code = 128 + WTERMSIG(status);
+        }
+    }
+    worker.pid = -1;
+    return exit_code;
+}
+
+}  // namespace
+
+void InterpreterPool::spawner_loop() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        spawn_cv_.wait(lock, [this] { return stopping_ || !spawn_queue_.empty(); });
+        if (stopping_) return;
+        SpawnRequest request = std::move(spawn_queue_.front());
+        spawn_queue_.pop_front();
+
+        lock.unlock();
+        auto worker = spawn_worker(request.language);
+        lock.lock();
+
+        if (request.caller) {
+            request.caller->set_value(std::move(worker));
+        } else {
+            --spares_pending_[request.language];
+            if (worker && !unavailable_[request.language]) {
+                idle_[request.language].push_back(std::move(worker));
+            }
+        }
+    }
+}
+
+std::unique_ptr<Worker> InterpreterPool::acquire(Language language) {
+    std::unique_lock lock(mutex_);
+    if (unavailable_[language]) return nullptr;
+    if (!spawner_.joinable()) spawner_ = std::thread(&InterpreterPool::spawner_loop, this);
+
+    auto& idle = idle_[language];
+    std::unique_ptr<Worker> worker;
+    while (!idle.empty() && !worker) {
+        worker = std::move(idle.back());
+        idle.pop_back();
+        if (!worker->alive()) worker.reset();
+    }
+
+    std::future<std::unique_ptr<Worker>> spawned;
+    if (!worker) {
+        std::promise<std::unique_ptr<Worker>> promise;
+        spawned = promise.get_future();
+        spawn_queue_.push_back({language, std::move(promise)});
+    }
+    // Start the next call's worker now; it boots while this one runs
+    if (idle.empty() && spares_pending_[language] == 0) {
+        ++spares_pending_[language];
+        spawn_queue_.push_back({language, std::nullopt});
+    }
+    spawn_cv_.notify_one();
+
+    if (!worker) {
+        lock.unlock();
+        worker = spawned.get();
+    }
+    return worker;
+}
+
+void InterpreterPool::release(Language language, std::unique_ptr<Worker> worker) {
+    if (worker->runs >= kMaxRunsPerWorker || worker->rss_bytes() > kMaxWorkerRssBytes) return;
+
+    std::lock_guard lock(mutex_);
+    auto& idle = idle_[language];
+    if (idle.size() < kIdleWorkers) idle.push_back(std::move(worker));
+}
+
+std::optional<InterpreterPool::RunResult> InterpreterPool::run(
+    Language language, const std::string& code, const std::string& working_dir,
+    const std::map<std::string, std::string>& env, int timeout_ms, const OutputCallback& on_output) {
+    auto worker = acquire(language);
+    if (!worker) return std::nullopt;
+
+    core::Json request = {{"code", code}, {"cwd", working_dir.empty() ? "." : working_dir}, {"env", env}};
+    std::string body = request.dump(-1, ' ', false, core::Json::error_handler_t::replace);
+
+    OutputBuffer output(kOutputHeadBytes, kOutputTailBytes);
+    OutputBatcher stream(on_output);
+    core::Json response;
+    WaitStatus status = exchange(*worker, std::to_string(body.size()) + "\n" + body, timeout_ms,
+                                 response, output, stream);
+
+    RunResult result;
+    if (status == WaitStatus::Done && response.contains("exit_code")) {
+        const core::Json& exit_code = response["exit_code"];
+        result.exit_code = exit_code.is_number_integer() ? exit_code.get<int>() : 1;
+        ++worker->runs;
+        stream.flush();
+        result.output = output.str();
+
+        // Threads or processes still running could print into the next
+        // run's output; the worker is closed with them instead
+        const core::Json& clean = response["clean"];
+        if (clean.is_boolean() && clean.get<bool>() && !worker->has_strays()) {
+            release(language, std::move(worker));
+        }
+        return result;
+    }
+
+    if (status == WaitStatus::Lost && !worker->ready) {
+        // The interpreter is missing or its driver failed to start
+        reap(*worker);
+        std::lock_guard lock(mutex_);
+        unavailable_[language] = true;
+        idle_[language].clear();
+        return std::nullopt;
+    }
+
+    // Timed out, or the snippet ended the interpreter (exit(), a crash)
+    result.timed_out = status == WaitStatus::TimedOut;
+    result.exit_code = reap(*worker);
+    if (worker->output_fd >= 0) drain_output(*worker, output, stream);
+    stream.flush();
+    result.output = output.str();
+    return result;
+}
+
+#else
+
+struct InterpreterPool::Worker {};
+
+std::unique_ptr<InterpreterPool::Worker> InterpreterPool::acquire(Language) {
+    return nullptr;
+}
+
+void InterpreterPool::release(Language, std::unique_ptr<Worker>) {}
+
+std::optional<InterpreterPool::RunResult> InterpreterPool::run(
+    Language, const std::string&, const std::string&, const std::map<std::string, std::string>&,
+    int, const OutputCallback&) {
+    return std::nullopt;
+}
+
+void InterpreterPool::spawner_loop() {}
+
+#endif
+
+InterpreterPool::InterpreterPool() = default;
+
+InterpreterPool::~InterpreterPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    spawn_cv_.notify_all();
+    if (spawner_.joinable()) spawner_.join();
+}
+
+InterpreterPool& InterpreterPool::instance() {
+    static InterpreterPool pool;
+    return pool;
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,297 @@
+#include "gpagent/tools/line_diff.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+namespace gpagent::tools {
+
+namespace {
+
+// Beyond this many edit steps in one range, split at the furthest forward
+// point instead of searching for the optimal middle (bounded time on huge,
+// mostly rewritten files at the cost of a slightly larger diff)
+constexpr int kMaxCost = 1024;
+
+class Differ {
+public:
+    Differ(const std::vector<int>& a, const std::vector<int>& b,
+           std::vector<bool>& deleted, std::vector<bool>& inserted)
+        : a_(a), b_(b), deleted_(deleted), inserted_(inserted) {}
+
+    void compare(int a0, int a1, int b0, int b1) {
+        while (a0 < a1 && b0 < b1 && a_[a0] == b_[b0]) {
+            ++a0;
+            ++b0;
+        }
+        while (a0 < a1 && b0 < b1 && a_[a1 - 1] == b_[b1 - 1]) {
+            --a1;
+            --b1;
+        }
+        if (a0 == a1) {
+            for (int j = b0; j < b1; ++j) inserted_[j] = true;
+            return;
+        }
+        if (b0 == b1) {
+            for (int i = a0; i < a1; ++i) deleted_[i] = true;
+            return;
+        }
+
+        auto [x, y] = split(a0, a1, b0, b1);
+        compare(a0, a0 + x, b0, b0 + y);
+        compare(a0 + x, a1, b0 + y, b1);
+    }
+
+private:
+    const std::vector<int>& a_;
+    const std::vector<int>& b_;
+    std::vector<bool>& deleted_;
+    std::vector<bool>& inserted_;
+
+    // Find a point (x, y), relative to (a0, b0), on an optimal edit path by
+    // running the forward and reverse searches until they overlap
+    std::pair<int, int> split(int a0, int a1, int b0, int b1) {
+        const int n = a1 - a0;
+        const int m = b1 - b0;
+        const int max_d = (n + m + 1) / 2;
+        const int offset = max_d + 1;
+        const int length = 2 * offset + 1;
+        std::vector<int> vf(length, -1);
+        std::vector<int> vb(length, -1);
+        vf[offset + 1] = 0;
+        vb[offset + 1] = 0;
+
+        const int delta = n - m;
+        const bool front = (delta & 1) != 0;
+        int kf_start = 0, kf_end = 0, kb_start = 0, kb_end = 0;
+
+        for (int d = 0; d < max_d; ++d) {
+            for (int k = -d + kf_start; k <= d - kf_end; k += 2) {
+                int i = offset + k;
+                int x = (k == -d || (k != d && vf[i - 1] < vf[i + 1])) ? vf[i + 1] : vf[i - 1] + 1;
+                int y = x - k;
+                while (x < n && y < m && a_[a0 + x] == b_[b0 + y]) {
+                    ++x;
+                    ++y;
+                }
+                vf[i] = x;
+                if (x > n) {
+                    kf_end += 2;
+                } else if (y > m) {
+                    kf_start += 2;
+                } else if (front) {
+                    int j = offset + delta - k;
+                    if (j >= 0 && j < length && vb[j] != -1 && x >= n - vb[j]) {
+                        return {x, y};
+                    }
+                }
+            }
+
+            for (int k = -d + kb_start; k <= d - kb_end; k += 2) {
+                int i = offset + k;
+                int x = (k == -d || (k != d && vb[i - 1] < vb[i + 1])) ? vb[i + 1] : vb[i - 1] + 1;
+                int y = x - k;
+                while (x < n && y < m && a_[a1 - 1 - x] == b_[b1 - 1 - y]) {
+                    ++x;
+                    ++y;
+                }
+                vb[i] = x;
+                if (x > n) {
+                    kb_end += 2;
+                } else if (y > m) {
+                    kb_start += 2;
+                } else if (!front) {
+                    int j = offset + delta - k;
+                    if (j >= 0 && j < length && vf[j] != -1) {
+                        int fx = vf[j];
+                        int fy = fx - (j - offset);
+                        if (fx >= n - x) {
+                            return {fx, fy};
+                        }
+                    }
+                }
+            }
+
+            if (d >= kMaxCost) {
+                return furthest_forward(vf, offset, d, n, m);
+            }
+        }
+
+        // No common subsequence: everything in a replaced by everything in b
+        return {n, 0};
+    }
+
+    static std::pair<int, int> furthest_forward(const std::vector<int>& vf, int offset, int d,
+                                                int n, int m) {
+        std::pair<int, int> best{0, 0};
+        for (int k = -d; k <= d; k += 2) {
+            int x = vf[offset + k];
+            int y = x - k;
+            if (x < 0 || x > n || y < 0 || y > m) continue;
+            if ((x < n || y < m) && x + y > best.first + best.second) {
+                best = {x, y};
+            }
+        }
+        if (best.first + best.second == 0) {
+            best = {n, 0};
+        }
+        return best;
+    }
+};
+
+// Slide each group of changed lines down while the line after it equals its
+// first line, as git does, so ambiguous diffs come out the same way
+void compact(const std::vector<int>& ids, std::vector<bool>& changed) {
+    const size_t n = ids.size();
+    size_t start = 0;
+    while (start < n) {
+        if (!changed[start]) {
+            ++start;
+            continue;
+        }
+        size_t end = start;
+        while (end < n && changed[end]) ++end;
+        while (end < n && ids[start] == ids[end]) {
+            changed[start++] = false;
+            changed[end++] = true;
+            while (end < n && changed[end]) ++end;
+        }
+        start = end;
+    }
+}
+
+bool is_funcname_line(std::string_view line) {
+    if (line.empty()) return false;
+    unsigned char c = static_cast<unsigned char>(line.front());
+    return std::isalpha(c) || c == '_' || c == '$';
+}
+
+std::string hunk_range(size_t start, size_t count) {
+    if (count == 1) return std::to_string(start + 1);
+    if (count == 0) return std::to_string(start) + ",0";
+    return std::to_string(start + 1) + "," + std::to_string(count);
+}
+
+void append_line(std::string& out, char prefix, std::string_view line) {
+    out += prefix;
+    out.append(line);
+    if (line.empty() || line.back() != '\n') {
+        out += "\n\\ No newline at end of file\n";
+    }
+}
+
+}  // namespace
+
+bool LineDiff::empty() const {
+    return std::find(deleted.begin(), deleted.end(), true) == deleted.end() &&
+           std::find(inserted.begin(), inserted.end(), true) == inserted.end();
+}
+
+std::vector<std::string_view> split_lines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    while (!text.empty()) {
+        size_t nl = text.find('\n');
+        size_t len = nl == std::string_view::npos ? text.size() : nl + 1;
+        lines.push_back(text.substr(0, len));
+        text.remove_prefix(len);
+    }
+    return lines;
+}
+
+LineDiff diff_lines(std::string_view a, std::string_view b) {
+    LineDiff diff;
+    diff.a = split_lines(a);
+    diff.b = split_lines(b);
+    diff.deleted.assign(diff.a.size(), false);
+    diff.inserted.assign(diff.b.size(), false);
+
+    // Compare lines by interned id
+    std::unordered_map<std::string_view, int> ids;
+    auto intern = [&ids](const std::vector<std::string_view>& lines) {
+        std::vector<int> out;
+        out.reserve(lines.size());
+        for (std::string_view line : lines) {
+            out.push_back(ids.emplace(line, static_cast<int>(ids.size())).first->second);
+        }
+        return out;
+    };
+    std::vector<int> a_ids = intern(diff.a);
+    std::vector<int> b_ids = intern(diff.b);
+
+    Differ(a_ids, b_ids, diff.deleted, diff.inserted)
+        .compare(0, static_cast<int>(a_ids.size()), 0, static_cast<int>(b_ids.size()));
+    compact(a_ids, diff.deleted);
+    compact(b_ids, diff.inserted);
+    return diff;
+}
+
+std::string unified_diff(std::string_view a, std::string_view b, int context) {
+    LineDiff diff = diff_lines(a, b);
+    const size_t n = diff.a.size();
+    const size_t m = diff.b.size();
+    const size_t ctx = static_cast<size_t>(std::max(context, 0));
+
+    // Collect change blocks as [i0, i1) x [j0, j1)
+    struct Change { size_t i0, i1, j0, j1; };
+    std::vector<Change> changes;
+    size_t i = 0, j = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && !diff.deleted[i] && !diff.inserted[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        Change change{i, i, j, j};
+        while (i < n && diff.deleted[i]) ++i;
+        while (j < m && diff.inserted[j]) ++j;
+        change.i1 = i;
+        change.j1 = j;
+        if (change.i0 == change.i1 && change.j0 == change.j1) break;  // inconsistent flags
+        changes.push_back(change);
+    }
+
+    std::string out;
+    for (size_t first = 0; first < changes.size();) {
+        // Merge changes whose context would touch or overlap
+        size_t last = first;
+        while (last + 1 < changes.size() && changes[last + 1].i0 - changes[last].i1 <= 2 * ctx) {
+            ++last;
+        }
+
+        const Change& head = changes[first];
+        const Change& tail = changes[last];
+        size_t a_start = head.i0 > ctx ? head.i0 - ctx : 0;
+        size_t a_end = std::min(n, tail.i1 + ctx);
+        size_t b_start = head.j0 - (head.i0 - a_start);
+        size_t b_end = tail.j1 + (a_end - tail.i1);
+
+        out += "@@ -" + hunk_range(a_start, a_end - a_start) +
+               " +" + hunk_range(b_start, b_end - b_start) + " @@";
+        for (size_t k = a_start; k-- > 0;) {
+            if (is_funcname_line(diff.a[k])) {
+                std::string_view func = diff.a[k].substr(0, 80);
+                while (!func.empty() && std::isspace(static_cast<unsigned char>(func.back()))) {
+                    func.remove_suffix(1);
+                }
+                out += ' ';
+                out.append(func);
+                break;
+            }
+        }
+        out += '\n';
+
+        size_t ai = a_start;
+        size_t bj = b_start;
+        for (size_t c = first; c <= last; ++c) {
+            for (; ai < changes[c].i0; ++ai, ++bj) append_line(out, ' ', diff.a[ai]);
+            for (; ai < changes[c].i1; ++ai) append_line(out, '-', diff.a[ai]);
+            for (; bj < changes[c].j1; ++bj) append_line(out, '+', diff.b[bj]);
+        }
+        for (; ai < a_end; ++ai) append_line(out, ' ', diff.a[ai]);
+
+        first = last + 1;
+    }
+    return out;
+}
+
+}  // namespace gpagent::tools
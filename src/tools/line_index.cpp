@@ -0,0 +1,171 @@
+#include "gpagent/tools/line_index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <list>
+
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr size_t kCacheEntries = 16;
+constexpr size_t kScanBlock = 1 << 20;
+
+// Record the offset after every kStride-th newline in [begin, end).
+// Newlines are located 64 bytes at a time with SSE2 compare masks; blocks
+// that cannot cross a stride boundary are counted with popcount alone.
+void scan_newlines(const char* data, uint64_t begin, uint64_t end,
+                   uint64_t& newlines, std::vector<uint64_t>& checkpoints) {
+    uint64_t pos = begin;
+
+    auto record = [&](uint64_t newline_pos) {
+        if (++newlines % LineIndex::kStride == 0) {
+            checkpoints.push_back(newline_pos + 1);
+        }
+    };
+
+#if defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    while (pos + 64 <= end) {
+        const char* p = data + pos;
+        uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), nl)));
+        uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), nl)));
+        uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32)), nl)));
+        uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)), nl)));
+        uint64_t mask = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+
+        auto count = static_cast<uint64_t>(__builtin_popcountll(mask));
+        uint64_t to_boundary = LineIndex::kStride - newlines % LineIndex::kStride;
+        if (count < to_boundary) {
+            newlines += count;
+        } else {
+            while (mask) {
+                record(pos + static_cast<uint64_t>(__builtin_ctzll(mask)));
+                mask &= mask - 1;
+            }
+        }
+        pos += 64;
+    }
+#endif
+
+    while (pos < end) {
+        const void* hit = std::memchr(data + pos, '\n', end - pos);
+        if (!hit) break;
+        uint64_t at = static_cast<uint64_t>(static_cast<const char*>(hit) - data);
+        record(at);
+        pos = at + 1;
+    }
+}
+
+LineIndex::Stamp stamp_of(const struct stat& st) {
+    return {static_cast<uint64_t>(st.st_size),
+            static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec,
+            static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino)};
+}
+
+}  // namespace
+
+LineIndex::LineIndex(MappedFile file, const Stamp& stamp)
+    : file_(std::move(file))
+    , stamp_(stamp) {}
+
+void LineIndex::extend_to(size_t line) {
+    size_t needed = line / kStride;
+    while (checkpoints_.size() <= needed && scanned_ < file_.size()) {
+        uint64_t end = std::min<uint64_t>(scanned_ + kScanBlock, file_.size());
+        scan_newlines(file_.data().data(), scanned_, end, newlines_, checkpoints_);
+        scanned_ = end;
+    }
+}
+
+size_t LineIndex::read_lines(size_t first, size_t count, const LineCallback& on_line) {
+    uint64_t pos;
+    size_t line;
+    {
+        std::lock_guard lock(mutex_);
+        extend_to(first);
+        size_t checkpoint = std::min(first / kStride, checkpoints_.size() - 1);
+        pos = checkpoints_[checkpoint];
+        line = checkpoint * kStride;
+    }
+
+    std::string_view data = file_.data();
+    const char* base = data.data();
+    const uint64_t size = data.size();
+
+    // Skip from the checkpoint to the first requested line (< kStride lines)
+    while (line < first && pos < size) {
+        const void* hit = std::memchr(base + pos, '\n', size - pos);
+        if (!hit) return 0;
+        pos = static_cast<uint64_t>(static_cast<const char*>(hit) - base) + 1;
+        line++;
+    }
+    if (line < first) return 0;
+
+    size_t visited = 0;
+    while (visited < count && pos < size) {
+        const void* hit = std::memchr(base + pos, '\n', size - pos);
+        uint64_t end = hit ? static_cast<uint64_t>(static_cast<const char*>(hit) - base) : size;
+        visited++;
+        if (!on_line(line++, data.substr(pos, end - pos))) break;
+        pos = end + 1;
+    }
+    return visited;
+}
+
+Result<std::shared_ptr<LineIndex>, Error> LineIndex::open(const fs::path& path) {
+    static std::mutex cache_mutex;
+    static std::list<std::pair<std::string, std::shared_ptr<LineIndex>>> cache;  // MRU first
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return Result<std::shared_ptr<LineIndex>, Error>::err(
+            ErrorCode::FileReadFailed, std::strerror(errno), path.string());
+    }
+    Stamp stamp = stamp_of(st);
+
+    std::error_code ec;
+    std::string key = fs::absolute(path, ec).lexically_normal().string();
+
+    {
+        std::lock_guard lock(cache_mutex);
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->first != key) continue;
+            if (it->second->stamp() == stamp) {
+                cache.splice(cache.begin(), cache, it);
+                return Result<std::shared_ptr<LineIndex>, Error>::ok(cache.front().second);
+            }
+            cache.erase(it);
+            break;
+        }
+    }
+
+    // Stamp the index with the descriptor that was read, so a file replaced
+    // between the stat above and the open is not cached under the old stamp
+    MappedFile file;
+    if (!file.open(path, true, &st)) {
+        return Result<std::shared_ptr<LineIndex>, Error>::err(
+            ErrorCode::FileReadFailed, "Failed to open file", path.string());
+    }
+    auto index = std::make_shared<LineIndex>(std::move(file), stamp_of(st));
+
+    std::lock_guard lock(cache_mutex);
+    cache.emplace_front(key, index);
+    if (cache.size() > kCacheEntries) {
+        cache.pop_back();
+    }
+    return Result<std::shared_ptr<LineIndex>, Error>::ok(std::move(index));
+}
+
+}  // namespace gpagent::tools
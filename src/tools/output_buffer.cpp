@@ -0,0 +1,133 @@
+#include "gpagent/tools/output_buffer.hpp"
+
+#include <algorithm>
+
+namespace gpagent::tools {
+
+namespace {
+
+bool is_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Bytes in the UTF-8 sequence a lead byte starts
+size_t sequence_length(char lead) {
+    auto byte = static_cast<unsigned char>(lead);
+    return byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+}
+
+}  // namespace
+
+OutputBuffer::OutputBuffer(size_t head_limit, size_t tail_limit)
+    : head_limit_(head_limit)
+    , tail_limit_(tail_limit) {}
+
+void OutputBuffer::append(std::string_view data) {
+    total_ += data.size();
+
+    if (head_.size() < head_limit_) {
+        size_t n = std::min(data.size(), head_limit_ - head_.size());
+        head_.append(data.substr(0, n));
+        data.remove_prefix(n);
+    }
+    if (data.empty() || tail_limit_ == 0) return;
+
+    // Only the last tail_limit bytes of a large write can survive
+    if (data.size() >= tail_limit_) {
+        tail_.assign(data.substr(data.size() - tail_limit_));
+        tail_pos_ = 0;
+        return;
+    }
+
+    if (tail_.size() < tail_limit_) {
+        size_t n = std::min(data.size(), tail_limit_ - tail_.size());
+        tail_.append(data.substr(0, n));
+        data.remove_prefix(n);
+    }
+
+    // Overwrite the oldest bytes of the ring
+    while (!data.empty()) {
+        size_t n = std::min(data.size(), tail_limit_ - tail_pos_);
+        tail_.replace(tail_pos_, n, data.substr(0, n));
+        tail_pos_ = (tail_pos_ + n) % tail_limit_;
+        data.remove_prefix(n);
+    }
+}
+
+size_t OutputBuffer::omitted() const {
+    return total_ - head_.size() - tail_.size();
+}
+
+std::string OutputBuffer::str() const {
+    std::string tail = tail_.substr(tail_pos_) + tail_.substr(0, tail_pos_);
+    size_t dropped = omitted();
+    if (dropped == 0) {
+        return head_ + tail;
+    }
+
+    // Don't split multi-byte characters at the cut points. The head keeps a
+    // final character only if all of its bytes made it in.
+    std::string_view head = head_;
+    size_t trailing = 0;
+    while (trailing < head.size() && is_continuation(head[head.size() - 1 - trailing])) ++trailing;
+    if (trailing < head.size()) {
+        size_t length = sequence_length(head[head.size() - 1 - trailing]);
+        if (length == 1) {
+            head.remove_suffix(trailing);
+        } else if (trailing + 1 < length) {
+            head.remove_suffix(trailing + 1);
+        }
+    }
+    size_t skip = 0;
+    while (skip < tail.size() && is_continuation(tail[skip])) ++skip;
+
+    std::string out(head);
+    out += "\n... [" + std::to_string(dropped) + " bytes omitted] ...\n";
+    out.append(tail, skip);
+    return out;
+}
+
+// ============================================================================
+// OutputBatcher
+// ============================================================================
+
+OutputBatcher::OutputBatcher(Callback callback, std::chrono::milliseconds interval,
+                             size_t max_pending)
+    : callback_(std::move(callback))
+    , interval_(interval)
+    , max_pending_(max_pending)
+    , last_flush_(std::chrono::steady_clock::now()) {}
+
+void OutputBatcher::append(std::string_view data) {
+    if (!callback_) return;
+    pending_.append(data);
+    if (pending_.size() > max_pending_) {
+        // Start the kept bytes at a character boundary
+        size_t cut = pending_.size() - max_pending_;
+        while (cut < pending_.size() && is_continuation(pending_[cut])) ++cut;
+        pending_.erase(0, cut);
+    }
+}
+
+int OutputBatcher::due_in_ms() const {
+    if (pending_.empty()) return -1;
+    auto elapsed = std::chrono::steady_clock::now() - last_flush_;
+    auto due = std::chrono::duration_cast<std::chrono::milliseconds>(interval_ - elapsed).count();
+    return due > 0 ? static_cast<int>(due) : 0;
+}
+
+void OutputBatcher::flush_if_due() {
+    if (std::chrono::steady_clock::now() - last_flush_ >= interval_) {
+        flush();
+    }
+}
+
+void OutputBatcher::flush() {
+    if (callback_ && !pending_.empty()) {
+        callback_(pending_);
+        pending_.clear();
+    }
+    last_flush_ = std::chrono::steady_clock::now();
+}
+
+}  // namespace gpagent::tools
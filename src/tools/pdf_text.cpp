@@ -0,0 +1,269 @@
+#include "gpagent/tools/pdf_text.hpp"
+#include "gpagent/tools/atomic_write.hpp"
+#include "gpagent/core/sha256.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#ifdef HAVE_POPPLER
+#include <poppler/cpp/poppler-document.h>
+#include <poppler/cpp/poppler-page.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+// Page count of a cached document; its mtime is the document's access time
+constexpr const char* kCountFile = "pages";
+
+std::string page_file(int page) {
+    return std::to_string(page) + ".txt";
+}
+
+std::optional<std::string> read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) return std::nullopt;
+    return content;
+}
+
+std::optional<std::string> stat_key(const fs::path& path) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec) return std::nullopt;
+    auto mtime = fs::last_write_time(path, ec);
+    if (ec) return std::nullopt;
+    return fs::absolute(path, ec).string() + '\n' + std::to_string(size) + '\n' +
+           std::to_string(mtime.time_since_epoch().count());
+}
+
+#ifdef HAVE_POPPLER
+
+class PopplerSource : public PdfSource {
+public:
+    explicit PopplerSource(std::unique_ptr<poppler::document> doc) : doc_(std::move(doc)) {}
+
+    int page_count() const override { return doc_->pages(); }
+
+    std::string page_text(int page) override {
+        std::unique_ptr<poppler::page> p(doc_->create_page(page));
+        if (!p) return "";
+        auto utf8 = p->text().to_utf8();
+        return std::string(utf8.data(), utf8.size());
+    }
+
+private:
+    std::unique_ptr<poppler::document> doc_;
+};
+
+#endif
+
+}  // namespace
+
+#ifdef HAVE_POPPLER
+std::unique_ptr<PdfSource> open_poppler_pdf(const std::string& content) {
+    std::unique_ptr<poppler::document> doc(
+        poppler::document::load_from_raw_data(content.data(), static_cast<int>(content.size())));
+    if (!doc || doc->is_locked()) return nullptr;
+    return std::make_unique<PopplerSource>(std::move(doc));
+}
+#endif
+
+PdfTextCache::PdfTextCache(fs::path dir, uint64_t max_bytes)
+    : lru_(std::move(dir), max_bytes) {}
+
+std::shared_ptr<PdfTextCache> PdfTextCache::open(const fs::path& dir, uint64_t max_bytes) {
+    return shared_disk_cache<PdfTextCache>(dir, max_bytes);
+}
+
+Result<PdfTextCache::Range, Error> PdfTextCache::read(const fs::path& pdf, int first, int count,
+                                                      const PdfOpener& opener) {
+    using R = Result<Range, Error>;
+
+    std::optional<std::string> content;
+    std::string hash;
+    auto key = stat_key(pdf);
+    {
+        std::lock_guard lock(mutex_);
+        load();
+        if (key) {
+            if (auto it = by_stat_.find(*key); it != by_stat_.end()) hash = it->second;
+        }
+    }
+    if (hash.empty()) {
+        content = read_file(pdf);
+        if (!content) {
+            return R::err(ErrorCode::FileReadFailed, "Cannot read PDF", pdf.string());
+        }
+        hash = sha256_hex({*content});
+        std::lock_guard lock(mutex_);
+        if (key) by_stat_[*key] = hash;
+    }
+
+    // Parsed lazily: a fully cached range never touches the PDF
+    std::unique_ptr<PdfSource> source;
+    auto open_source = [&]() -> bool {
+        if (source) return true;
+        if (!content) content = read_file(pdf);
+        if (content) source = opener(*content);
+        return source != nullptr;
+    };
+
+    Range range;
+    if (auto cached = cached_page_count(hash)) {
+        range.total_pages = *cached;
+    } else {
+        if (!open_source()) {
+            return R::err(ErrorCode::FileReadFailed, "Failed to parse PDF", pdf.string());
+        }
+        range.total_pages = source->page_count();
+        store(hash, kCountFile, std::to_string(range.total_pages));
+    }
+
+    first = std::clamp(first, 0, range.total_pages);
+    int last = first + std::clamp(count, 0, range.total_pages - first);
+
+    std::vector<int> missing;
+    for (int page = first; page < last; ++page) {
+        auto text = cached_page(hash, page);
+        if (!text) missing.push_back(page);
+        range.pages.push_back(Page{page, text.value_or("")});
+    }
+    range.extracted = static_cast<int>(missing.size());
+
+    if (!missing.empty()) {
+        if (!open_source()) {
+            return R::err(ErrorCode::FileReadFailed, "Failed to parse PDF", pdf.string());
+        }
+
+        // Contiguous runs per thread; each thread parses its own copy since
+        // a document is not safe to share
+        size_t threads = std::min<size_t>({std::max(1u, std::thread::hardware_concurrency()),
+                                           static_cast<size_t>(kMaxThreads), (missing.size() + 3) / 4});
+        size_t per_thread = (missing.size() + threads - 1) / threads;
+        std::vector<std::string> texts(missing.size());
+
+        auto extract = [&](PdfSource& doc, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                texts[i] = doc.page_text(missing[i]);
+                store(hash, page_file(missing[i]), texts[i]);
+            }
+        };
+
+        std::atomic<bool> worker_failed{false};
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; ++t) {
+            size_t begin = t * per_thread;
+            size_t end = std::min(missing.size(), begin + per_thread);
+            if (begin >= end) break;
+            workers.emplace_back([&, begin, end]() {
+                if (auto doc = opener(*content)) {
+                    extract(*doc, begin, end);
+                } else {
+                    worker_failed = true;
+                }
+            });
+        }
+        extract(*source, 0, std::min(missing.size(), per_thread));
+        for (auto& worker : workers) worker.join();
+
+        // Pages the other workers did extract stay cached for a retry
+        if (worker_failed) {
+            return R::err(ErrorCode::FileReadFailed, "Failed to parse PDF", pdf.string());
+        }
+
+        for (auto& page : range.pages) {
+            auto it = std::lower_bound(missing.begin(), missing.end(), page.number);
+            if (it != missing.end() && *it == page.number) {
+                page.text = std::move(texts[static_cast<size_t>(it - missing.begin())]);
+            }
+        }
+    }
+
+    touch(hash);
+    return R::ok(std::move(range));
+}
+
+uint64_t PdfTextCache::size_bytes() {
+    std::lock_guard lock(mutex_);
+    load();
+    return lru_.total_bytes();
+}
+
+std::optional<std::string> PdfTextCache::cached_page(const std::string& hash, int page) const {
+    if (lru_.dir().empty()) return std::nullopt;
+    return read_file(doc_dir(hash) / page_file(page));
+}
+
+std::optional<int> PdfTextCache::cached_page_count(const std::string& hash) const {
+    if (lru_.dir().empty()) return std::nullopt;
+    auto text = read_file(doc_dir(hash) / kCountFile);
+    if (!text) return std::nullopt;
+    try {
+        return std::stoi(*text);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+void PdfTextCache::store(const std::string& hash, const std::string& name, const std::string& content) {
+    if (lru_.dir().empty()) return;
+
+    std::error_code ec;
+    fs::create_directories(doc_dir(hash), ec);
+    auto written = write_file_atomic(doc_dir(hash) / name, {content});
+    if (written.is_err()) {
+        spdlog::warn("Failed to cache PDF text: {}", written.error().message);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    lru_.grow(hash, content.size());
+}
+
+void PdfTextCache::touch(const std::string& hash) {
+    if (lru_.dir().empty()) return;
+
+    DiskLru::stamp(doc_dir(hash) / kCountFile);
+
+    std::lock_guard lock(mutex_);
+    lru_.used(hash);
+    lru_.evict(hash);
+}
+
+void PdfTextCache::load() {
+    if (loaded_ || lru_.dir().empty()) return;
+    loaded_ = true;
+
+    std::error_code ec;
+    fs::create_directories(lru_.dir(), ec);
+    for (const auto& item : fs::directory_iterator(lru_.dir(), ec)) {
+        std::error_code item_ec;
+        if (!item.is_directory(item_ec)) continue;
+
+        auto mtime = fs::last_write_time(item.path() / kCountFile, item_ec);
+        if (item_ec) {
+            // Never got as far as its page count
+            fs::remove_all(item.path(), item_ec);
+            continue;
+        }
+        uint64_t bytes = 0;
+        for (const auto& file : fs::directory_iterator(item.path(), item_ec)) {
+            std::error_code file_ec;
+            if (DiskLru::discard_temp(file.path())) continue;
+            uint64_t size = file.file_size(file_ec);
+            if (!file_ec) bytes += size;
+        }
+        lru_.set(item.path().filename().string(), bytes, DiskLru::to_unix_ns(mtime));
+    }
+    lru_.evict();
+}
+
+}  // namespace gpagent::tools
@@ -0,0 +1,163 @@
+#include "gpagent/tools/piece_table.hpp"
+
+#include <algorithm>
+
+namespace gpagent::tools {
+
+PieceTable::PieceTable(std::string_view original)
+    : original_(original)
+    , size_(original.size()) {
+    if (!original.empty()) {
+        pieces_.push_back(Piece{false, 0, original.size()});
+    }
+}
+
+std::string_view PieceTable::view(const Piece& piece) const {
+    std::string_view source = piece.added ? std::string_view(added_) : original_;
+    return source.substr(piece.start, piece.length);
+}
+
+std::string PieceTable::collect(size_t index, size_t offset, size_t n) const {
+    std::string out;
+    for (; index < pieces_.size() && out.size() < n; ++index, offset = 0) {
+        std::string_view v = view(pieces_[index]).substr(offset);
+        out.append(v.substr(0, n - out.size()));
+    }
+    return out;
+}
+
+size_t PieceTable::find(std::string_view needle, size_t from) const {
+    if (needle.empty() || needle.size() > size_) return std::string::npos;
+
+    const size_t span = needle.size() - 1;
+    size_t piece_start = 0;
+
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        std::string_view v = view(pieces_[i]);
+        size_t piece_end = piece_start + v.size();
+        if (piece_end <= from) {
+            piece_start = piece_end;
+            continue;
+        }
+
+        size_t local_from = from > piece_start ? from - piece_start : 0;
+        size_t best = std::string::npos;
+
+        // Match entirely inside this piece
+        size_t pos = v.find(needle, local_from);
+        if (pos != std::string_view::npos) {
+            best = piece_start + pos;
+        }
+
+        // Match starting in the last span bytes and continuing into later pieces
+        if (span > 0 && i + 1 < pieces_.size()) {
+            size_t tail = std::max(local_from, v.size() > span ? v.size() - span : 0);
+            if (tail < v.size()) {
+                std::string window = collect(i, tail, (v.size() - tail) + span);
+                size_t hit = window.find(needle);
+                if (hit != std::string::npos && tail + hit < v.size()) {
+                    best = std::min(best, piece_start + tail + hit);
+                }
+            }
+        }
+
+        if (best != std::string::npos) return best;
+        piece_start = piece_end;
+    }
+    return std::string::npos;
+}
+
+void PieceTable::replace(size_t pos, size_t len, std::string_view text) {
+    replace_ranges({pos}, len, text);
+}
+
+size_t PieceTable::replace_all(std::string_view needle, std::string_view text) {
+    std::vector<size_t> starts;
+    for (size_t pos = find(needle); pos != std::string::npos; pos = find(needle, pos + needle.size())) {
+        starts.push_back(pos);
+    }
+    if (!starts.empty()) {
+        replace_ranges(starts, needle.size(), text);
+    }
+    return starts.size();
+}
+
+void PieceTable::replace_ranges(const std::vector<size_t>& starts, size_t len, std::string_view text) {
+    Piece inserted{true, added_.size(), text.size()};
+    added_.append(text);
+
+    std::vector<Piece> result;
+    result.reserve(pieces_.size() + starts.size() * 2);
+
+    auto emit = [&](const Piece& piece) {
+        if (piece.length == 0) return;
+        // Merge with the previous piece when contiguous in the same buffer
+        if (!result.empty()) {
+            Piece& last = result.back();
+            if (last.added == piece.added && last.start + last.length == piece.start) {
+                last.length += piece.length;
+                return;
+            }
+        }
+        result.push_back(piece);
+    };
+
+    size_t next = 0;          // next range to apply
+    size_t piece_start = 0;   // document offset of the current piece
+    for (const Piece& piece : pieces_) {
+        size_t piece_end = piece_start + piece.length;
+        size_t cursor = piece_start;  // document offset not yet emitted
+
+        while (cursor < piece_end) {
+            if (next < starts.size() && starts[next] < piece_end) {
+                size_t range_start = starts[next];
+                size_t range_end = range_start + len;
+
+                if (cursor < range_start) {
+                    emit(Piece{piece.added, piece.start + (cursor - piece_start), range_start - cursor});
+                    cursor = range_start;
+                }
+                if (cursor == range_start) {
+                    emit(inserted);
+                }
+                // Skip the replaced bytes that fall in this piece
+                cursor = std::min(range_end, piece_end);
+                if (range_end <= piece_end) {
+                    next++;
+                }
+            } else {
+                emit(Piece{piece.added, piece.start + (cursor - piece_start), piece_end - cursor});
+                cursor = piece_end;
+            }
+        }
+        piece_start = piece_end;
+    }
+
+    // Insertions at the very end (pos == size, len == 0)
+    for (; next < starts.size(); ++next) {
+        emit(inserted);
+    }
+
+    pieces_ = std::move(result);
+    size_ = size_ - starts.size() * len + starts.size() * text.size();
+}
+
+std::vector<std::string_view> PieceTable::chunks() const {
+    std::vector<std::string_view> out;
+    out.reserve(pieces_.size());
+    for (const auto& piece : pieces_) {
+        out.push_back(view(piece));
+    }
+    return out;
+}
+
+std::string PieceTable::to_string() const {
+    std::string out;
+    out.reserve(size_);
+    for (const auto& piece : pieces_) {
+        out.append(view(piece));
+    }
+    return out;
+}
+
+}  // namespace gpagent::tools
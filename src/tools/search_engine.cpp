@@ -0,0 +1,1036 @@
+#include "gpagent/tools/search_engine.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+// ============================================================================
+// Regex parser (ECMAScript subset) -> AST
+// ============================================================================
+
+struct ParseError {
+    bool unsupported;  // valid regex, but not expressible by the DFA
+    std::string message;
+};
+
+struct Node;
+using NodePtr = std::unique_ptr<Node>;
+
+struct Node {
+    enum class Kind { Empty, Class, Assert, Concat, Alt, Repeat };
+
+    Kind kind = Kind::Empty;
+    std::bitset<256> cls;
+    int assert_kind = 0;
+    int min = 0;
+    int max = -1;  // -1 = unbounded
+    std::vector<NodePtr> children;
+};
+
+NodePtr make_node(Node::Kind kind) {
+    auto node = std::make_unique<Node>();
+    node->kind = kind;
+    return node;
+}
+
+bool is_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+std::bitset<256> digit_class() {
+    std::bitset<256> cls;
+    for (int c = '0'; c <= '9'; ++c) cls.set(c);
+    return cls;
+}
+
+std::bitset<256> word_class() {
+    std::bitset<256> cls;
+    for (int c = 0; c < 256; ++c) {
+        if (is_word_byte(static_cast<unsigned char>(c))) cls.set(c);
+    }
+    return cls;
+}
+
+std::bitset<256> space_class() {
+    std::bitset<256> cls;
+    for (char c : std::string_view(" \t\n\v\f\r")) cls.set(static_cast<unsigned char>(c));
+    return cls;
+}
+
+class Parser {
+public:
+    explicit Parser(std::string_view pattern) : p_(pattern) {}
+
+    NodePtr parse() {
+        auto root = parse_alt();
+        if (pos_ < p_.size()) {
+            fail("Unmatched ')'");
+        }
+        return root;
+    }
+
+private:
+    std::string_view p_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+
+    [[noreturn]] void fail(const std::string& msg) { throw ParseError{false, msg}; }
+    [[noreturn]] void unsupported(const std::string& msg) { throw ParseError{true, msg}; }
+
+    bool at_end() const { return pos_ >= p_.size(); }
+    char peek() const { return at_end() ? '\0' : p_[pos_]; }
+
+    bool consume(char c) {
+        if (!at_end() && p_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    NodePtr parse_alt() {
+        if (++depth_ > 200) unsupported("Pattern nesting too deep");
+
+        auto first = parse_concat();
+        if (peek() != '|') {
+            --depth_;
+            return first;
+        }
+
+        auto alt = make_node(Node::Kind::Alt);
+        alt->children.push_back(std::move(first));
+        while (consume('|')) {
+            alt->children.push_back(parse_concat());
+        }
+        --depth_;
+        return alt;
+    }
+
+    NodePtr parse_concat() {
+        auto cat = make_node(Node::Kind::Concat);
+        while (!at_end() && peek() != '|' && peek() != ')') {
+            cat->children.push_back(parse_repeat());
+        }
+        return cat;
+    }
+
+    NodePtr parse_repeat() {
+        auto atom = parse_atom();
+
+        while (!at_end()) {
+            int min = 0;
+            int max = -1;
+            char c = peek();
+
+            if (c == '*') {
+                ++pos_;
+            } else if (c == '+') {
+                ++pos_;
+                min = 1;
+            } else if (c == '?') {
+                ++pos_;
+                max = 1;
+            } else if (c == '{') {
+                if (!parse_braces(min, max)) fail("Invalid repetition braces");
+            } else {
+                break;
+            }
+
+            if (atom->kind == Node::Kind::Assert) {
+                fail("Nothing to repeat");
+            }
+            consume('?');  // Lazy quantifier: same line-match result
+
+            auto rep = make_node(Node::Kind::Repeat);
+            rep->min = min;
+            rep->max = max;
+            rep->children.push_back(std::move(atom));
+            atom = std::move(rep);
+        }
+
+        return atom;
+    }
+
+    bool parse_braces(int& min, int& max) {
+        size_t save = pos_;
+        ++pos_;  // '{'
+
+        auto read_int = [&](int& out) {
+            size_t start = pos_;
+            long value = 0;
+            while (!at_end() && std::isdigit(static_cast<unsigned char>(peek()))) {
+                value = value * 10 + (peek() - '0');
+                if (value > 1000) unsupported("Repetition count too large");
+                ++pos_;
+            }
+            out = static_cast<int>(value);
+            return pos_ > start;
+        };
+
+        if (!read_int(min)) {
+            pos_ = save;
+            return false;
+        }
+        if (consume('}')) {
+            max = min;
+            return true;
+        }
+        if (!consume(',')) {
+            pos_ = save;
+            return false;
+        }
+        if (consume('}')) {
+            max = -1;
+            return true;
+        }
+        if (!read_int(max) || !consume('}') || max < min) {
+            pos_ = save;
+            return false;
+        }
+        return true;
+    }
+
+    NodePtr class_node(const std::bitset<256>& cls) {
+        auto node = make_node(Node::Kind::Class);
+        node->cls = cls;
+        return node;
+    }
+
+    NodePtr byte_node(unsigned char c) {
+        std::bitset<256> cls;
+        cls.set(c);
+        return class_node(cls);
+    }
+
+    NodePtr assert_node(int kind) {
+        auto node = make_node(Node::Kind::Assert);
+        node->assert_kind = kind;
+        return node;
+    }
+
+    NodePtr parse_atom() {
+        char c = p_[pos_++];
+
+        switch (c) {
+            case '(': {
+                if (consume('?')) {
+                    if (!consume(':')) unsupported("Lookaround is not supported by the DFA");
+                }
+                auto inner = parse_alt();
+                if (!consume(')')) fail("Missing ')'");
+                return inner;
+            }
+            case '[':
+                return class_node(parse_class());
+            case '.': {
+                std::bitset<256> cls;
+                cls.set();
+                cls.reset('\n');
+                cls.reset('\r');
+                return class_node(cls);
+            }
+            case '^':
+                return assert_node(RegexProgram::LineStart);
+            case '$':
+                return assert_node(RegexProgram::LineEnd);
+            case '\\':
+                return parse_escape();
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                fail("Nothing to repeat");
+            case ')':
+                fail("Unmatched ')'");
+            default:
+                return byte_node(static_cast<unsigned char>(c));
+        }
+    }
+
+    // Parse the escape after '\'. Returns a byte, or sets `cls` for class escapes.
+    int parse_escape_char(bool in_class, std::bitset<256>& cls, bool& is_class, int& assert_kind) {
+        if (at_end()) fail("Trailing backslash");
+
+        is_class = false;
+        assert_kind = -1;
+        char c = p_[pos_++];
+
+        switch (c) {
+            case 'd': is_class = true; cls = digit_class(); return -1;
+            case 'D': is_class = true; cls = ~digit_class(); return -1;
+            case 'w': is_class = true; cls = word_class(); return -1;
+            case 'W': is_class = true; cls = ~word_class(); return -1;
+            case 's': is_class = true; cls = space_class(); return -1;
+            case 'S': is_class = true; cls = ~space_class(); return -1;
+            case 'b':
+                if (in_class) return '\b';
+                assert_kind = RegexProgram::WordBoundary;
+                return -1;
+            case 'B':
+                if (in_class) fail("Invalid escape in class");
+                assert_kind = RegexProgram::NotWordBoundary;
+                return -1;
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            case '0': return '\0';
+            case 'c': {
+                if (at_end() || !std::isalpha(static_cast<unsigned char>(peek()))) {
+                    fail("Invalid control escape");
+                }
+                return p_[pos_++] % 32;
+            }
+            case 'x':
+                return parse_hex(2);
+            case 'u': {
+                int value = parse_hex(4);
+                if (value > 0x7f) unsupported("Non-ASCII \\u escapes are not supported by the DFA");
+                return value;
+            }
+            default:
+                if (c >= '1' && c <= '9') {
+                    unsupported("Backreferences are not supported by the DFA");
+                }
+                return static_cast<unsigned char>(c);
+        }
+    }
+
+    int parse_hex(int digits) {
+        int value = 0;
+        for (int i = 0; i < digits; ++i) {
+            if (at_end() || !std::isxdigit(static_cast<unsigned char>(peek()))) {
+                fail("Invalid hex escape");
+            }
+            char h = p_[pos_++];
+            value = value * 16 + (std::isdigit(static_cast<unsigned char>(h)) ? h - '0'
+                                  : (std::tolower(static_cast<unsigned char>(h)) - 'a' + 10));
+        }
+        return value;
+    }
+
+    NodePtr parse_escape() {
+        std::bitset<256> cls;
+        bool is_class = false;
+        int assert_kind = -1;
+        int value = parse_escape_char(false, cls, is_class, assert_kind);
+
+        if (is_class) return class_node(cls);
+        if (assert_kind >= 0) return assert_node(assert_kind);
+        return byte_node(static_cast<unsigned char>(value));
+    }
+
+    std::bitset<256> parse_class() {
+        std::bitset<256> cls;
+        bool negate = consume('^');
+
+        while (true) {
+            if (at_end()) fail("Missing ']'");
+            if (consume(']')) break;
+
+            int lo = parse_class_atom(cls);
+            if (lo < 0) continue;  // class escape already merged
+
+            if (peek() == '-' && pos_ + 1 < p_.size() && p_[pos_ + 1] != ']') {
+                ++pos_;  // '-'
+                std::bitset<256> ignored;
+                int hi = parse_class_atom(ignored);
+                if (hi < 0) fail("Invalid class range");
+                if (hi < lo) fail("Invalid class range");
+                for (int b = lo; b <= hi; ++b) cls.set(b);
+            } else {
+                cls.set(lo);
+            }
+        }
+
+        if (negate) cls.flip();
+        return cls;
+    }
+
+    // Returns a byte, or -1 if a class escape was merged into `cls`
+    int parse_class_atom(std::bitset<256>& cls) {
+        char c = p_[pos_++];
+        if (c != '\\') return static_cast<unsigned char>(c);
+
+        std::bitset<256> esc;
+        bool is_class = false;
+        int assert_kind = -1;
+        int value = parse_escape_char(true, esc, is_class, assert_kind);
+        if (is_class) {
+            cls |= esc;
+            return -1;
+        }
+        return value;
+    }
+};
+
+// ============================================================================
+// AST -> NFA program (built back to front: each node is compiled with its
+// continuation, which makes repetition expansion straightforward)
+// ============================================================================
+
+constexpr size_t kMaxProgramSize = 20000;
+
+class Compiler {
+public:
+    RegexProgram compile(const Node& root) {
+        int match = emit({RegexProgram::Op::Match});
+        prog_.start = compile(root, match);
+        return std::move(prog_);
+    }
+
+private:
+    RegexProgram prog_;
+
+    int emit(RegexProgram::Inst inst) {
+        if (prog_.insts.size() >= kMaxProgramSize) {
+            throw ParseError{true, "Pattern too large for the DFA"};
+        }
+        prog_.insts.push_back(inst);
+        return static_cast<int>(prog_.insts.size() - 1);
+    }
+
+    int compile(const Node& node, int next) {
+        using Op = RegexProgram::Op;
+
+        switch (node.kind) {
+            case Node::Kind::Empty:
+                return next;
+
+            case Node::Kind::Class: {
+                prog_.classes.push_back(node.cls);
+                return emit({Op::Class, next, -1, static_cast<int>(prog_.classes.size() - 1)});
+            }
+
+            case Node::Kind::Assert:
+                return emit({Op::Assert, next, -1, node.assert_kind});
+
+            case Node::Kind::Concat:
+                for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+                    next = compile(**it, next);
+                }
+                return next;
+
+            case Node::Kind::Alt: {
+                std::vector<int> entries;
+                for (const auto& child : node.children) {
+                    entries.push_back(compile(*child, next));
+                }
+                int entry = entries.back();
+                for (int i = static_cast<int>(entries.size()) - 2; i >= 0; --i) {
+                    entry = emit({Op::Split, entries[i], entry});
+                }
+                return entry;
+            }
+
+            case Node::Kind::Repeat: {
+                const Node& body = *node.children.front();
+                int entry = next;
+
+                if (node.max < 0) {
+                    int loop = emit({Op::Split, -1, next});
+                    prog_.insts[loop].x = compile(body, loop);
+                    entry = loop;
+                } else {
+                    for (int i = 0; i < node.max - node.min; ++i) {
+                        int body_entry = compile(body, entry);
+                        entry = emit({Op::Split, body_entry, next});
+                    }
+                }
+
+                for (int i = 0; i < node.min; ++i) {
+                    entry = compile(body, entry);
+                }
+                return entry;
+            }
+        }
+        return next;
+    }
+};
+
+// ============================================================================
+// Literal extraction for the prefilter
+// ============================================================================
+
+bool single_byte(const Node& node, unsigned char& out) {
+    if (node.kind != Node::Kind::Class || node.cls.count() != 1) return false;
+    for (int c = 0; c < 256; ++c) {
+        if (node.cls.test(c)) {
+            out = static_cast<unsigned char>(c);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Flatten a concatenation (including nested groups) into a sequence of leaves
+void flatten_concat(const Node& node, std::vector<const Node*>& out) {
+    if (node.kind == Node::Kind::Concat) {
+        for (const auto& child : node.children) {
+            flatten_concat(*child, out);
+        }
+    } else {
+        out.push_back(&node);
+    }
+}
+
+// Longest literal run that every match must contain
+std::string extract_required_literal(const Node& root, bool& whole_literal, bool& anchored_start) {
+    std::vector<const Node*> leaves;
+    flatten_concat(root, leaves);
+
+    anchored_start = !leaves.empty() && leaves.front()->kind == Node::Kind::Assert &&
+                     leaves.front()->assert_kind == RegexProgram::LineStart;
+
+    std::string best;
+    std::string run;
+    whole_literal = !leaves.empty();
+
+    auto finish_run = [&]() {
+        if (run.size() > best.size()) best = run;
+        run.clear();
+    };
+
+    for (const Node* leaf : leaves) {
+        unsigned char c;
+        if (single_byte(*leaf, c)) {
+            run.push_back(static_cast<char>(c));
+            continue;
+        }
+
+        whole_literal = false;
+
+        if (leaf->kind == Node::Kind::Assert) {
+            continue;  // zero-width: the run stays contiguous
+        }
+        if (leaf->kind == Node::Kind::Repeat && leaf->min >= 1 &&
+            single_byte(*leaf->children.front(), c)) {
+            run.push_back(static_cast<char>(c));
+            finish_run();
+            run.push_back(static_cast<char>(c));
+            continue;
+        }
+        finish_run();
+    }
+    finish_run();
+
+    return best;
+}
+
+// Approximate byte frequency in source code and prose, most common first.
+// The prefilter runs memchr on the rarest byte of the literal.
+constexpr std::string_view kCommonBytes =
+    " etaoinsrlcdhupmfgy\n._(),;=/-\"bwvk*:'\tx0>1<{}[]ETSAI2jqzCRNO";
+
+int byte_frequency_rank(unsigned char c) {
+    size_t idx = kCommonBytes.find(static_cast<char>(c));
+    return idx == std::string_view::npos ? 0 : static_cast<int>(kCommonBytes.size() - idx);
+}
+
+}  // namespace
+
+// ============================================================================
+// SearchPattern
+// ============================================================================
+
+Result<SearchPattern, Error> SearchPattern::compile(const std::string& pattern) {
+    SearchPattern sp;
+    sp.source_ = pattern;
+
+    auto use_fallback = [&]() -> Result<SearchPattern, Error> {
+        try {
+            sp.fallback_ = std::make_shared<const std::regex>(pattern, std::regex::ECMAScript);
+        } catch (const std::regex_error& e) {
+            return Result<SearchPattern, Error>::err(ErrorCode::InvalidArgument, e.what(), pattern);
+        }
+        return Result<SearchPattern, Error>::ok(std::move(sp));
+    };
+
+    try {
+        Parser parser(pattern);
+        NodePtr root = parser.parse();
+
+        Compiler compiler;
+        sp.program_ = std::make_shared<const RegexProgram>(compiler.compile(*root));
+        sp.required_literal_ = extract_required_literal(*root, sp.is_literal_, sp.anchored_start_);
+        if (sp.required_literal_.empty()) {
+            sp.is_literal_ = false;
+        }
+    } catch (const ParseError& e) {
+        if (e.unsupported) {
+            return use_fallback();
+        }
+        // Our parser is stricter in a few corners; let std::regex decide
+        auto fallback = use_fallback();
+        if (fallback.is_err()) {
+            return Result<SearchPattern, Error>::err(ErrorCode::InvalidArgument, e.message, pattern);
+        }
+        return fallback;
+    }
+
+    return Result<SearchPattern, Error>::ok(std::move(sp));
+}
+
+// ============================================================================
+// Lazy DFA
+// ============================================================================
+
+struct Searcher::Dfa {
+    static constexpr int kMatch = -2;
+    static constexpr int kUnknown = -1;
+    static constexpr size_t kMaxStates = 4096;
+
+    enum Flags : uint8_t {
+        AtLineStart = 1,
+        PrevWord = 2
+    };
+
+    struct State {
+        std::vector<int> pcs;  // NFA pcs before epsilon closure
+        uint8_t flags = 0;
+    };
+
+    const RegexProgram& prog;
+    bool anchored;
+
+    std::vector<State> states;
+    std::unordered_map<std::string, int> index;
+    std::vector<int32_t> trans;   // states * 256
+    std::vector<int8_t> eol;      // -1 unknown, 0 / 1
+
+    // Scratch space for closure computation
+    std::vector<uint32_t> visited;
+    uint32_t generation = 0;
+    std::vector<int> stack;
+    std::vector<int> consuming;
+
+    int start = 0;
+
+    Dfa(const RegexProgram& p, bool anchored_start)
+        : prog(p)
+        , anchored(anchored_start)
+        , visited(p.insts.size(), 0)
+    {
+        reset();
+    }
+
+    void reset() {
+        states.clear();
+        index.clear();
+        trans.clear();
+        eol.clear();
+        start = intern({prog.start}, AtLineStart);
+    }
+
+    bool is_dead(int s) const { return s >= 0 && states[s].pcs.empty(); }
+
+    int intern(std::vector<int> pcs, uint8_t flags) {
+        std::string key;
+        key.reserve(1 + pcs.size() * sizeof(int));
+        key.push_back(static_cast<char>(flags));
+        key.append(reinterpret_cast<const char*>(pcs.data()), pcs.size() * sizeof(int));
+
+        auto it = index.find(key);
+        if (it != index.end()) return it->second;
+
+        int id = static_cast<int>(states.size());
+        states.push_back(State{std::move(pcs), flags});
+        index.emplace(std::move(key), id);
+        trans.resize(states.size() * 256, kUnknown);
+        eol.push_back(-1);
+        return id;
+    }
+
+    bool assertion_holds(int kind, uint8_t flags, int next) const {
+        bool prev_word = flags & PrevWord;
+        bool next_word = next >= 0 && is_word_byte(static_cast<unsigned char>(next));
+        switch (kind) {
+            case RegexProgram::LineStart: return flags & AtLineStart;
+            case RegexProgram::LineEnd: return next < 0;
+            case RegexProgram::WordBoundary: return prev_word != next_word;
+            case RegexProgram::NotWordBoundary: return prev_word == next_word;
+        }
+        return false;
+    }
+
+    // Follow epsilon edges given the surrounding bytes. Fills `consuming`
+    // with Class instructions; returns true if Match is reachable.
+    bool closure(const State& state, int next) {
+        using Op = RegexProgram::Op;
+
+        if (++generation == 0) {
+            std::fill(visited.begin(), visited.end(), 0);
+            generation = 1;
+        }
+
+        consuming.clear();
+        stack.assign(state.pcs.begin(), state.pcs.end());
+        bool matched = false;
+
+        while (!stack.empty()) {
+            int pc = stack.back();
+            stack.pop_back();
+            if (pc < 0 || visited[pc] == generation) continue;
+            visited[pc] = generation;
+
+            const auto& inst = prog.insts[pc];
+            switch (inst.op) {
+                case Op::Class:
+                    consuming.push_back(pc);
+                    break;
+                case Op::Split:
+                    stack.push_back(inst.y);
+                    stack.push_back(inst.x);
+                    break;
+                case Op::Jump:
+                    stack.push_back(inst.x);
+                    break;
+                case Op::Assert:
+                    if (assertion_holds(inst.arg, state.flags, next)) {
+                        stack.push_back(inst.x);
+                    }
+                    break;
+                case Op::Match:
+                    matched = true;
+                    break;
+            }
+        }
+
+        return matched;
+    }
+
+    int step(int s, unsigned char c) {
+        int cached = trans[static_cast<size_t>(s) * 256 + c];
+        if (cached != kUnknown) return cached;
+
+        if (closure(states[s], c)) {
+            trans[static_cast<size_t>(s) * 256 + c] = kMatch;
+            return kMatch;
+        }
+
+        std::vector<int> pcs;
+        pcs.reserve(consuming.size() + 1);
+        for (int pc : consuming) {
+            const auto& inst = prog.insts[pc];
+            if (prog.classes[inst.arg].test(c)) {
+                pcs.push_back(inst.x);
+            }
+        }
+        if (!anchored) {
+            pcs.push_back(prog.start);
+        }
+        std::sort(pcs.begin(), pcs.end());
+        pcs.erase(std::unique(pcs.begin(), pcs.end()), pcs.end());
+
+        uint8_t flags = is_word_byte(c) ? PrevWord : 0;
+
+        if (states.size() >= kMaxStates) {
+            // Cache blew up (pathological pattern): start over, like RE2
+            reset();
+            return intern(std::move(pcs), flags);
+        }
+
+        int target = intern(std::move(pcs), flags);
+        trans[static_cast<size_t>(s) * 256 + c] = target;
+        return target;
+    }
+
+    bool matches_at_eol(int s) {
+        if (eol[s] < 0) {
+            eol[s] = closure(states[s], -1) ? 1 : 0;
+        }
+        return eol[s] == 1;
+    }
+};
+
+// ============================================================================
+// Searcher
+// ============================================================================
+
+Searcher::Searcher(const SearchPattern& pattern)
+    : pattern_(&pattern)
+{
+    if (pattern.program_ && !pattern.is_literal_) {
+        dfa_ = std::make_unique<Dfa>(*pattern.program_, pattern.anchored_start_);
+    }
+}
+
+Searcher::~Searcher() = default;
+Searcher::Searcher(Searcher&&) noexcept = default;
+Searcher& Searcher::operator=(Searcher&&) noexcept = default;
+
+bool Searcher::line_matches(std::string_view line) {
+    if (pattern_->fallback_) {
+        return std::regex_search(line.begin(), line.end(), *pattern_->fallback_);
+    }
+    if (pattern_->is_literal_) {
+        return find_literal(line, pattern_->required_literal_) != std::string_view::npos;
+    }
+
+    Dfa& dfa = *dfa_;
+    int s = dfa.start;
+    for (char ch : line) {
+        s = dfa.step(s, static_cast<unsigned char>(ch));
+        if (s == Dfa::kMatch) return true;
+        if (dfa.is_dead(s)) return false;
+    }
+    return dfa.matches_at_eol(s);
+}
+
+bool Searcher::matches(std::string_view line) {
+    return line_matches(line);
+}
+
+size_t Searcher::search(std::string_view data, const LineCallback& on_match) {
+    const char* base = data.data();
+    const size_t size = data.size();
+    size_t reported = 0;
+
+    auto line_end = [&](size_t from) {
+        const void* nl = from < size ? std::memchr(base + from, '\n', size - from) : nullptr;
+        return nl ? static_cast<size_t>(static_cast<const char*>(nl) - base) : size;
+    };
+
+    // Fallback and literal-prefiltered paths work on candidate lines
+    if (pattern_->fallback_ || !pattern_->required_literal_.empty()) {
+        const std::string& literal = pattern_->required_literal_;
+        size_t pos = 0;
+        size_t line_no = 1;
+        size_t counted = 0;
+
+        while (pos < size) {
+            size_t ls = pos;
+            size_t le;
+
+            if (!literal.empty()) {
+                size_t hit = find_literal(data, literal, pos);
+                if (hit == std::string_view::npos) break;
+
+                // Back up to the start of the line containing the hit
+                ls = hit;
+                while (ls > pos && base[ls - 1] != '\n') --ls;
+                le = line_end(hit);
+            } else {
+                le = line_end(pos);
+            }
+
+            line_no += std::count(base + counted, base + ls, '\n');
+            counted = ls;
+
+            std::string_view line(base + ls, le - ls);
+            if (line_matches(line)) {
+                ++reported;
+                if (!on_match(line_no, line)) return reported;
+            }
+
+            pos = le + 1;
+        }
+        return reported;
+    }
+
+    // Full DFA scan across the buffer, resetting at each newline
+    Dfa& dfa = *dfa_;
+    int s = dfa.start;
+    size_t ls = 0;
+    size_t line_no = 1;
+
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(base[i]);
+
+        if (c == '\n') {
+            if (dfa.matches_at_eol(s)) {
+                ++reported;
+                if (!on_match(line_no, std::string_view(base + ls, i - ls))) return reported;
+            }
+            ls = i + 1;
+            ++line_no;
+            s = dfa.start;
+            continue;
+        }
+
+        s = dfa.step(s, c);
+
+        if (s == Dfa::kMatch || dfa.is_dead(s)) {
+            size_t le = line_end(i);
+            if (s == Dfa::kMatch) {
+                ++reported;
+                if (!on_match(line_no, std::string_view(base + ls, le - ls))) return reported;
+            }
+            if (le >= size) return reported;
+            i = le;
+            ls = le + 1;
+            ++line_no;
+            s = dfa.start;
+        }
+    }
+
+    if (ls < size && dfa.matches_at_eol(s)) {
+        ++reported;
+        on_match(line_no, std::string_view(base + ls, size - ls));
+    }
+
+    return reported;
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+size_t find_literal(std::string_view haystack, std::string_view needle, size_t from) {
+    if (needle.empty()) {
+        return from <= haystack.size() ? from : std::string_view::npos;
+    }
+    if (from >= haystack.size() || haystack.size() - from < needle.size()) {
+        return std::string_view::npos;
+    }
+
+    // Pick the rarest byte of the needle as the memchr anchor
+    size_t rare = 0;
+    int best_rank = byte_frequency_rank(static_cast<unsigned char>(needle[0]));
+    for (size_t i = 1; i < needle.size(); ++i) {
+        int rank = byte_frequency_rank(static_cast<unsigned char>(needle[i]));
+        if (rank < best_rank) {
+            best_rank = rank;
+            rare = i;
+        }
+    }
+
+    const char* base = haystack.data();
+    const char* p = base + from + rare;
+    const char* last = base + haystack.size() - (needle.size() - rare);  // inclusive
+
+    while (p <= last) {
+        const void* found = std::memchr(p, needle[rare], static_cast<size_t>(last - p) + 1);
+        if (!found) break;
+
+        const char* candidate = static_cast<const char*>(found) - rare;
+        if (std::memcmp(candidate, needle.data(), needle.size()) == 0) {
+            return static_cast<size_t>(candidate - base);
+        }
+        p = static_cast<const char*>(found) + 1;
+    }
+
+    return std::string_view::npos;
+}
+
+bool is_binary_content(std::string_view data) {
+    size_t probe = std::min<size_t>(data.size(), 8192);
+    return std::memchr(data.data(), '\0', probe) != nullptr;
+}
+
+// ============================================================================
+// MappedFile
+// ============================================================================
+
+namespace {
+constexpr size_t kMmapThreshold = 64 * 1024;
+}
+
+MappedFile::~MappedFile() {
+    reset();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        reset();
+        mapped_ = other.mapped_;
+        size_ = other.size_;
+        buffer_ = std::move(other.buffer_);
+        data_ = mapped_ ? other.data_ : buffer_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::reset() {
+#ifdef __linux__
+    if (mapped_ && data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+bool MappedFile::open(const fs::path& path, bool sequential, struct stat* info) {
+    reset();
+
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    if (info) *info = st;
+
+    size_t file_size = static_cast<size_t>(st.st_size);
+
+    if (file_size >= kMmapThreshold) {
+        void* addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            if (sequential) {
+                madvise(addr, file_size, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+            data_ = static_cast<const char*>(addr);
+            size_ = file_size;
+            mapped_ = true;
+            return true;
+        }
+    }
+
+    buffer_.resize(file_size);
+    size_t total = 0;
+    while (total < file_size) {
+        ssize_t n = ::read(fd, buffer_.data() + total, file_size - total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            buffer_.clear();
+            return false;
+        }
+        if (n == 0) break;  // File shrank while reading
+        total += static_cast<size_t>(n);
+    }
+    ::close(fd);
+
+    buffer_.resize(total);
+#else
+    (void)sequential;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    if (info) ::stat(path.c_str(), info);
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+#endif
+
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+}  // namespace gpagent::tools
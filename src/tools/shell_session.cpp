@@ -0,0 +1,476 @@
+#include "gpagent/tools/shell_session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace gpagent::tools {
+
+namespace {
+
+// Same budget as a one-shot command, for the single interleaved stream
+constexpr size_t kOutputHeadBytes = 20000;
+constexpr size_t kOutputTailBytes = 10000;
+
+constexpr int kStartupTimeoutMs = 5000;
+
+// After ^C, how long the job gets to wind down before the shell is killed
+constexpr int kInterruptGraceMs = 2000;
+
+std::string random_hex(size_t bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::random_device rd;
+    std::string out;
+    for (size_t i = 0; i < bytes; ++i) {
+        unsigned v = rd() & 0xFF;
+        out += digits[v >> 4];
+        out += digits[v & 0xF];
+    }
+    return out;
+}
+
+std::string shell_quote(const std::string& s) {
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'') {
+            out += "'\\''";
+        } else {
+            out += c;
+        }
+    }
+    return out + "'";
+}
+
+#ifdef __linux__
+
+// Write the command script readable by the owner only. The temp directory
+// is shared, so the file is recreated exclusively rather than truncated:
+// that also refuses a symlink or file planted under the name.
+bool write_script(const fs::path& path, const std::string& text) {
+    unlink(path.c_str());
+    int fd = open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    std::string_view rest = text;
+    while (!rest.empty()) {
+        ssize_t n = write(fd, rest.data(), rest.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return false;
+        }
+        rest.remove_prefix(static_cast<size_t>(n));
+    }
+    return close(fd) == 0;
+}
+
+#endif
+
+// Parse "<seq>_<code>__" following the marker prefix
+bool parse_marker(std::string_view rest, uint64_t& seq, int& code) {
+    auto read_number = [&rest](uint64_t& value) {
+        size_t n = 0;
+        value = 0;
+        while (n < rest.size() && rest[n] >= '0' && rest[n] <= '9') {
+            value = value * 10 + static_cast<uint64_t>(rest[n] - '0');
+            ++n;
+        }
+        rest.remove_prefix(n);
+        return n > 0;
+    };
+
+    uint64_t code_value = 0;
+    if (!read_number(seq) || rest.empty() || rest.front() != '_') return false;
+    rest.remove_prefix(1);
+    if (!read_number(code_value) || rest != "__") return false;
+    code = static_cast<int>(code_value);
+    return true;
+}
+
+}  // namespace
+
+ShellSession::ShellSession(std::string working_dir, std::map<std::string, std::string> env)
+    : working_dir_(std::move(working_dir))
+    , env_(std::move(env)) {}
+
+ShellSession::~ShellSession() {
+    std::lock_guard lock(mutex_);
+    stop_locked();
+}
+
+bool ShellSession::start() {
+    std::lock_guard lock(mutex_);
+    return start_locked();
+}
+
+bool ShellSession::alive() const {
+    std::lock_guard lock(mutex_);
+    return master_fd_ >= 0;
+}
+
+#ifdef __linux__
+
+bool ShellSession::start_locked() {
+    if (master_fd_ >= 0) return true;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0) return false;
+
+    char slave_name[128];
+    if (grantpt(master) != 0 || unlockpt(master) != 0 ||
+        ptsname_r(master, slave_name, sizeof(slave_name)) != 0) {
+        close(master);
+        return false;
+    }
+    int slave = open(slave_name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave < 0) {
+        close(master);
+        return false;
+    }
+
+    // Raw input (no echo, no line length limit) but keep ISIG so ^C still
+    // interrupts the foreground job; no \n -> \r\n on output
+    termios tio;
+    if (tcgetattr(slave, &tio) == 0) {
+        tio.c_lflag &= ~static_cast<tcflag_t>(ECHO | ECHOE | ECHOK | ECHONL | ICANON);
+        tio.c_oflag &= ~static_cast<tcflag_t>(ONLCR);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+    winsize ws{};
+    ws.ws_row = 50;
+    ws.ws_col = 250;
+    ioctl(slave, TIOCSWINSZ, &ws);
+
+    std::string nonce = random_hex(8);
+    std::error_code ec;
+    fs::path tmp_dir = fs::temp_directory_path(ec);
+    if (ec) tmp_dir = "/tmp";
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(master);
+        close(slave);
+        return false;
+    }
+
+    if (pid == 0) {
+        // Child: new session with the PTY as controlling terminal
+        setsid();
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+
+        if (!working_dir_.empty()) {
+            if (chdir(working_dir_.c_str()) != 0) {
+                _exit(127);
+            }
+        }
+
+        for (const auto& [key, value] : env_) {
+            setenv(key.c_str(), value.c_str(), 1);
+        }
+
+        // Output goes to a terminal, so tools would page, color and prompt
+        // as if a person were watching: no prompts, no pagers waiting on the
+        // terminal, no color codes, and no credential prompts on /dev/tty
+        setenv("PS1", "", 1);
+        setenv("PS2", "", 1);
+        unsetenv("PROMPT_COMMAND");
+        setenv("TERM", "dumb", 1);
+        setenv("PAGER", "cat", 1);
+        setenv("GIT_PAGER", "cat", 1);
+        setenv("MANPAGER", "cat", 1);
+        setenv("SYSTEMD_PAGER", "cat", 1);
+        setenv("NO_COLOR", "1", 1);
+        setenv("CLICOLOR", "0", 1);
+        unsetenv("CLICOLOR_FORCE");
+        setenv("GIT_TERMINAL_PROMPT", "0", 1);
+
+        execl("/bin/bash", "bash", "--noprofile", "--norc", "--noediting", "-i", nullptr);
+        _exit(127);
+    }
+
+    close(slave);
+    master_fd_ = master;
+    pid_ = pid;
+    seq_ = 0;
+    marker_ = "__GPAGENT_" + nonce + "_";
+    script_path_ = tmp_dir / ("gpagent-shell-" + nonce + ".sh");
+
+    // Wait for the shell to come up, discarding its startup chatter
+    int exit_code = 0;
+    if (!send_marker(0, "0", "set +o history; ") ||
+        wait_for_marker(0, kStartupTimeoutMs, exit_code, nullptr, nullptr) != WaitStatus::Done) {
+        stop_locked();
+        return false;
+    }
+    return true;
+}
+
+int ShellSession::stop_locked() {
+    if (master_fd_ < 0) return -1;
+
+    // Kill the foreground job and the shell; closing the master hangs up
+    // anything left in the session
+    pid_t foreground = tcgetpgrp(master_fd_);
+    if (foreground > 0) {
+        kill(-foreground, SIGKILL);
+    }
+    kill(-pid_, SIGKILL);
+    close(master_fd_);
+    master_fd_ = -1;
+
+    int status = 0;
+    int exit_code = -1;
+    if (waitpid(pid_, &status, 0) == pid_) {
+        if (WIFEXITED(status)) {
+            exit_code = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            exit_code = 128 + WTERMSIG(status);
+        }
+    }
+    pid_ = -1;
+
+    std::error_code ec;
+    fs::remove(script_path_, ec);
+    return exit_code;
+}
+
+bool ShellSession::send(std::string_view text) {
+    while (!text.empty()) {
+        ssize_t n = write(master_fd_, text.data(), text.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        text.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool ShellSession::send_marker(uint64_t seq, std::string_view status, std::string_view prefix) {
+    std::string line(prefix);
+    line += "printf '\\n" + marker_ + std::to_string(seq) + "_%d__\\n' ";
+    line += status;
+    line += '\n';
+    return send(line);
+}
+
+ShellSession::WaitStatus ShellSession::wait_for_marker(uint64_t seq, int timeout_ms, int& exit_code,
+                                                       OutputBuffer* output, OutputBatcher* stream) {
+    auto emit = [&](std::string_view data) {
+        if (data.empty()) return;
+        if (output) output->append(data);
+        if (stream) stream->append(data);
+    };
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::string window;
+    std::vector<char> buffer(65536);
+
+    while (true) {
+        // Consume complete marker lines; everything before them is output
+        size_t pos;
+        while ((pos = window.find(marker_)) != std::string::npos) {
+            size_t eol = window.find('\n', pos);
+            if (eol == std::string::npos) break;
+
+            std::string_view rest(window.data() + pos + marker_.size(), eol - pos - marker_.size());
+            uint64_t marker_seq = 0;
+            int code = 0;
+            if (!parse_marker(rest, marker_seq, code)) {
+                emit(std::string_view(window).substr(0, eol + 1));
+                window.erase(0, eol + 1);
+                continue;
+            }
+
+            // The marker is preceded by a newline we printed ourselves
+            size_t start = (pos > 0 && window[pos - 1] == '\n') ? pos - 1 : pos;
+            emit(std::string_view(window).substr(0, start));
+            window.erase(0, eol + 1);
+
+            if (marker_seq == seq) {
+                exit_code = code;
+                if (stream) stream->flush();
+                return WaitStatus::Done;
+            }
+            // Otherwise a late marker from an interrupted command: drop it
+        }
+
+        // Hold back an incomplete marker line, or a tail that could start one
+        size_t safe = window.find(marker_);
+        if (safe == std::string::npos) {
+            size_t k = std::min(window.size(), marker_.size() - 1);
+            while (k > 0 && window.compare(window.size() - k, k, marker_, 0, k) != 0) --k;
+            safe = window.size() - k;
+        }
+        if (safe > 0 && window[safe - 1] == '\n') --safe;
+        if (safe > 0) {
+            emit(std::string_view(window).substr(0, safe));
+            window.erase(0, safe);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            emit(window);
+            return WaitStatus::TimedOut;
+        }
+        int wait_ms = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+        if (stream) {
+            if (int due = stream->due_in_ms(); due >= 0) {
+                wait_ms = std::min(wait_ms, due);
+            }
+        }
+
+        pollfd pfd{master_fd_, POLLIN, 0};
+        int ret = poll(&pfd, 1, std::max(wait_ms, 1));
+        if (ret < 0 && errno != EINTR) {
+            emit(window);
+            return WaitStatus::Lost;
+        }
+        if (ret > 0) {
+            ssize_t n = read(master_fd_, buffer.data(), buffer.size());
+            if (n > 0) {
+                window.append(buffer.data(), static_cast<size_t>(n));
+            } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+                // EIO: the shell exited and the terminal was hung up
+                emit(window);
+                return WaitStatus::Lost;
+            }
+        }
+        if (stream) stream->flush_if_due();
+    }
+}
+
+ShellSession::RunResult ShellSession::run(const std::string& command, int timeout_ms,
+                                          const OutputCallback& on_output) {
+    std::lock_guard lock(mutex_);
+    RunResult result;
+
+    if (master_fd_ < 0 && !start_locked()) {
+        result.session_lost = true;
+        result.output = "Failed to start shell";
+        return result;
+    }
+
+    // Sourcing a script keeps cd/export effects and avoids terminal line
+    // limits and quoting issues for multi-line commands
+    if (!write_script(script_path_, command + '\n')) {
+        result.output = "Failed to write command script: " + script_path_.string();
+        return result;
+    }
+
+    uint64_t seq = ++seq_;
+    OutputBuffer output(kOutputHeadBytes, kOutputTailBytes);
+    OutputBatcher stream(on_output);
+
+    WaitStatus status = WaitStatus::Lost;
+    if (send_marker(seq, "\"$?\"", ". " + shell_quote(script_path_.string()) + " < /dev/null; ")) {
+        status = wait_for_marker(seq, timeout_ms, result.exit_code, &output, &stream);
+    }
+
+    if (status == WaitStatus::TimedOut) {
+        result.timed_out = true;
+
+        // Interrupt the foreground job. The interrupted line never reaches
+        // its own marker, so ask the shell for a fresh one.
+        send("\x03");
+        if (!send_marker(seq, "130") ||
+            wait_for_marker(seq, kInterruptGraceMs, result.exit_code, &output, &stream) != WaitStatus::Done) {
+            result.exit_code = stop_locked();
+            result.session_lost = true;
+        }
+    } else if (status == WaitStatus::Lost) {
+        // e.g. the command ran `exit`; the next call starts a new shell
+        result.exit_code = stop_locked();
+        result.session_lost = true;
+    }
+
+    stream.flush();
+    result.output = output.str();
+    return result;
+}
+
+#else
+
+bool ShellSession::start_locked() {
+    return false;
+}
+
+int ShellSession::stop_locked() {
+    return -1;
+}
+
+bool ShellSession::send(std::string_view) {
+    return false;
+}
+
+bool ShellSession::send_marker(uint64_t, std::string_view, std::string_view) {
+    return false;
+}
+
+ShellSession::WaitStatus ShellSession::wait_for_marker(uint64_t, int, int&, OutputBuffer*, OutputBatcher*) {
+    return WaitStatus::Lost;
+}
+
+ShellSession::RunResult ShellSession::run(const std::string&, int, const OutputCallback&) {
+    RunResult result;
+    result.session_lost = true;
+    result.output = "Persistent shell sessions are not supported on this platform";
+    return result;
+}
+
+#endif
+
+std::shared_ptr<ShellSession> ShellSession::for_session(const std::string& session_id,
+                                                        const std::string& working_dir,
+                                                        const std::map<std::string, std::string>& env) {
+    struct Entry {
+        std::shared_ptr<ShellSession> shell;
+        std::chrono::steady_clock::time_point last_used;
+    };
+    static std::mutex registry_mutex;
+    static std::map<std::string, Entry> registry;
+
+    std::lock_guard lock(registry_mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto& entry = registry[session_id];
+    entry.last_used = now;
+    if (!entry.shell) {
+        auto shell = std::make_shared<ShellSession>(working_dir, env);
+        if (!shell->start()) {
+            registry.erase(session_id);
+            return nullptr;
+        }
+        entry.shell = shell;
+
+        // Close the least recently used shells; a running command keeps
+        // its shell alive through the shared_ptr until it finishes
+        while (registry.size() > kMaxSessions) {
+            auto oldest = std::min_element(registry.begin(), registry.end(),
+                [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+            registry.erase(oldest);
+        }
+        return shell;
+    }
+    return entry.shell;
+}
+
+}  // namespace gpagent::tools
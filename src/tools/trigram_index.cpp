@@ -0,0 +1,568 @@
+#include "gpagent/tools/trigram_index.hpp"
+#include "gpagent/tools/change_journal.hpp"
+#include "gpagent/tools/file_walker.hpp"
+#include "gpagent/tools/search_engine.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+
+namespace gpagent::tools {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'P', 'T', 'R', 'I', 'X', '0', '1'};
+constexpr size_t kBatchSize = 512;
+constexpr int64_t kRacyWindowNs = 2'000'000'000;
+constexpr auto kSaveInterval = std::chrono::seconds(60);
+
+// Distinct trigrams of a buffer, skipping those that span a newline
+// (grep matches never cross lines). Uses a 2^24-bit set that is cleared
+// incrementally, so extraction is one pass with no sorting.
+class TrigramExtractor {
+public:
+    TrigramExtractor() : seen_(1u << 18, 0) {}
+
+    const std::vector<uint32_t>& extract(std::string_view data) {
+        for (uint32_t key : keys_) {
+            seen_[key >> 6] = 0;
+        }
+        keys_.clear();
+
+        uint32_t key = 0;
+        int run = 0;  // bytes since the last newline
+        for (unsigned char c : data) {
+            if (c == '\n') {
+                run = 0;
+                continue;
+            }
+            key = ((key << 8) | c) & 0xFFFFFF;
+            if (++run < 3) continue;
+
+            uint64_t bit = uint64_t{1} << (key & 63);
+            uint64_t& word = seen_[key >> 6];
+            if (!(word & bit)) {
+                word |= bit;
+                keys_.push_back(key);
+            }
+        }
+        return keys_;
+    }
+
+private:
+    std::vector<uint64_t> seen_;
+    std::vector<uint32_t> keys_;
+};
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t fnv1a(std::string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void write_string(std::ostream& out, std::string_view s) {
+    write_pod(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+bool read_string(std::istream& in, std::string& s) {
+    uint32_t len = 0;
+    if (!read_pod(in, len)) return false;
+    s.resize(len);
+    return static_cast<bool>(in.read(s.data(), len));
+}
+
+}  // namespace
+
+TrigramIndex::TrigramIndex(fs::path root, fs::path index_path)
+    : root_(std::move(root))
+    , index_path_(std::move(index_path)) {
+    load();
+}
+
+TrigramIndex::~TrigramIndex() {
+    std::lock_guard lock(mutex_);
+    if (unsaved_changes_ > 0) {
+        save_locked();
+    }
+}
+
+size_t TrigramIndex::file_count() const {
+    std::lock_guard lock(mutex_);
+    return files_.size() - dead_count_;
+}
+
+// ============================================================================
+// Postings
+// ============================================================================
+
+void TrigramIndex::append(Posting& posting, uint32_t id) {
+    uint32_t delta = posting.count == 0 ? id : id - posting.last;
+    while (delta >= 0x80) {
+        posting.bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    posting.bytes.push_back(static_cast<uint8_t>(delta));
+    posting.last = id;
+    posting.count++;
+}
+
+std::vector<uint32_t> TrigramIndex::decode(const Posting& posting) {
+    std::vector<uint32_t> ids;
+    ids.reserve(posting.count);
+
+    uint32_t id = 0;
+    uint32_t value = 0;
+    int shift = 0;
+    for (uint8_t b : posting.bytes) {
+        value |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (b & 0x80) {
+            shift += 7;
+            continue;
+        }
+        id = ids.empty() ? value : id + value;
+        ids.push_back(id);
+        value = 0;
+        shift = 0;
+    }
+    return ids;
+}
+
+// Drop dead files and renumber ids (postings stay sorted)
+void TrigramIndex::compact() {
+    std::vector<uint32_t> remap(files_.size(), UINT32_MAX);
+    std::vector<FileInfo> live;
+    live.reserve(files_.size() - dead_count_);
+    by_path_.clear();
+
+    for (uint32_t id = 0; id < files_.size(); ++id) {
+        if (files_[id].flags & Dead) continue;
+        remap[id] = static_cast<uint32_t>(live.size());
+        by_path_.emplace(files_[id].path, remap[id]);
+        live.push_back(std::move(files_[id]));
+    }
+
+    for (auto it = postings_.begin(); it != postings_.end();) {
+        Posting rebuilt;
+        for (uint32_t id : decode(it->second)) {
+            if (remap[id] != UINT32_MAX) append(rebuilt, remap[id]);
+        }
+        if (rebuilt.count == 0) {
+            it = postings_.erase(it);
+        } else {
+            it->second = std::move(rebuilt);
+            ++it;
+        }
+    }
+
+    files_ = std::move(live);
+    dead_count_ = 0;
+}
+
+// ============================================================================
+// Refresh
+// ============================================================================
+
+bool TrigramIndex::refresh() {
+    std::lock_guard lock(mutex_);
+
+    // Oversized trees are not re-walked on every grep
+    if (too_large_) return false;
+
+    struct Changed {
+        std::string path;
+        uint64_t size;
+        int64_t mtime_ns;
+    };
+
+    std::vector<Changed> changed;
+    std::vector<uint32_t> retired;
+
+    if (auto journaled = journaled_changes()) {
+        // Only known files changed: re-stat just those
+        for (const auto& path : *journaled) {
+            uint32_t id = by_path_.at(path);
+            retired.push_back(id);
+
+            std::error_code ec;
+            auto status = fs::symlink_status(root_ / path, ec);
+            if (ec || !fs::is_regular_file(status)) continue;
+            uint64_t size = fs::file_size(root_ / path, ec);
+            auto mtime = fs::last_write_time(root_ / path, ec);
+            if (ec || size > kMaxFileSize) continue;
+            int64_t mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::file_clock::to_sys(mtime).time_since_epoch()).count();
+            changed.push_back(Changed{path, size, mtime_ns});
+        }
+    } else {
+        // Stat walk: find new and modified files without reading contents,
+        // watching each directory entered so the next refresh can use the journal
+        if (!journal_) journal_ = ChangeJournal::for_project(root_);
+        std::atomic<bool> watched{journal_ && journal_->watch("")};
+        if (journal_) journal_sequence_ = journal_->sequence();
+
+        WalkOptions options;
+        options.stat_files = true;
+        options.max_file_size = kMaxFileSize;
+        options.dir_filter = [&](std::string_view rel) {
+            if (watched.load() && !journal_->watch(rel)) watched.store(false);
+            return true;
+        };
+
+        std::vector<uint8_t> seen(files_.size(), 0);
+        std::mutex changed_mutex;
+        std::atomic<size_t> total{0};
+
+        FileWalker walker(options);
+        walker.walk(root_, [&](const WalkEntry& entry) {
+            if (total.fetch_add(1) >= kMaxFiles) return false;
+
+            auto it = by_path_.find(std::string(entry.rel_path));
+            if (it != by_path_.end()) {
+                const FileInfo& info = files_[it->second];
+                if (info.size == entry.size && info.mtime_ns == entry.mtime_ns && !(info.flags & Racy)) {
+                    seen[it->second] = 1;
+                    return true;
+                }
+            }
+            std::lock_guard changed_lock(changed_mutex);
+            changed.push_back(Changed{std::string(entry.rel_path), entry.size, entry.mtime_ns});
+            return true;
+        });
+        journal_complete_ = watched.load();
+
+        too_large_ = total.load() > kMaxFiles;
+        if (too_large_) {
+            ready_.store(true);
+            spdlog::debug("Trigram index disabled for {}: more than {} files", root_.string(), kMaxFiles);
+            return false;
+        }
+
+        for (uint32_t id = 0; id < seen.size(); ++id) {
+            if (!seen[id] && !(files_[id].flags & Dead)) retired.push_back(id);
+        }
+    }
+
+    // Retire files that disappeared or changed
+    for (uint32_t id : retired) {
+        files_[id].flags |= Dead;
+        by_path_.erase(files_[id].path);
+        dead_count_++;
+        unsaved_changes_++;
+    }
+
+    // Index changed files in batches: extract in parallel, merge serially
+    size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8);
+    std::vector<TrigramExtractor> extractors(std::min(num_threads, changed.size()));
+    int64_t indexed_at = now_ns();
+
+    for (size_t start = 0; start < changed.size(); start += kBatchSize) {
+        size_t count = std::min(kBatchSize, changed.size() - start);
+        std::vector<std::vector<uint32_t>> keys(count);
+        std::vector<uint8_t> flags(count, 0);
+        std::atomic<size_t> next{0};
+
+        auto work = [&](TrigramExtractor& extractor) {
+            for (size_t i; (i = next.fetch_add(1)) < count;) {
+                MappedFile file;
+                if (!file.open(root_ / changed[start + i].path)) {
+                    flags[i] = Binary;
+                    continue;
+                }
+                if (is_binary_content(file.data())) {
+                    flags[i] = Binary;
+                    continue;
+                }
+                keys[i] = extractor.extract(file.data());
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < extractors.size(); ++t) {
+            threads.emplace_back(work, std::ref(extractors[t]));
+        }
+        work(extractors[0]);
+        for (auto& t : threads) t.join();
+
+        // Group the batch by trigram so each posting is looked up once
+        std::vector<uint64_t> pairs;
+        for (size_t i = 0; i < count; ++i) {
+            Changed& c = changed[start + i];
+            auto id = static_cast<uint32_t>(files_.size());
+            if (c.mtime_ns > indexed_at - kRacyWindowNs) {
+                flags[i] |= Racy;
+            }
+            for (uint32_t key : keys[i]) {
+                pairs.push_back((uint64_t{key} << 32) | id);
+            }
+            by_path_[c.path] = id;
+            files_.push_back(FileInfo{std::move(c.path), c.size, c.mtime_ns, flags[i]});
+            unsaved_changes_++;
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        Posting* posting = nullptr;
+        uint32_t current = UINT32_MAX;
+        for (uint64_t pair : pairs) {
+            auto key = static_cast<uint32_t>(pair >> 32);
+            if (key != current) {
+                posting = &postings_[key];
+                current = key;
+            }
+            append(*posting, static_cast<uint32_t>(pair));
+        }
+    }
+
+    if (dead_count_ > 1024 && dead_count_ * 4 > files_.size()) {
+        compact();
+    }
+
+    if (unsaved_changes_ > 0 && std::chrono::steady_clock::now() - last_save_ > kSaveInterval) {
+        save_locked();
+    }
+    ready_.store(true);
+    return true;
+}
+
+std::optional<std::vector<std::string>> TrigramIndex::journaled_changes() {
+    if (!journal_ || !journal_complete_) return std::nullopt;
+
+    auto changes = journal_->since(journal_sequence_);
+    if (changes.overflow || !changes.dirs.empty()) return std::nullopt;
+
+    // New files (and ignore-file edits) need the walk's filtering rules
+    for (const auto& path : changes.files) {
+        std::string_view name = std::string_view(path).substr(path.rfind('/') + 1);
+        if (!by_path_.contains(path) || name == ".gitignore" || name == ".ignore") return std::nullopt;
+    }
+    journal_sequence_ = changes.sequence;
+    return std::move(changes.files);
+}
+
+void TrigramIndex::build_async() {
+    if (building_.exchange(true)) return;
+
+    std::thread([self = shared_from_this()] {
+        self->refresh();
+        self->building_.store(false);
+    }).detach();
+}
+
+// ============================================================================
+// Query
+// ============================================================================
+
+std::optional<std::vector<std::string>> TrigramIndex::candidates(std::string_view literal,
+                                                                 std::string_view rel_prefix) const {
+    if (literal.size() < 3 || literal.find('\n') != std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (too_large_) return std::nullopt;
+
+    // A prefix the walk skipped (ignored, hidden) is not covered by the index
+    if (!rel_prefix.empty()) {
+        bool covered = std::any_of(files_.begin(), files_.end(), [&](const FileInfo& info) {
+            return !(info.flags & Dead) && info.path.compare(0, rel_prefix.size(), rel_prefix) == 0;
+        });
+        if (!covered) return std::nullopt;
+    }
+
+    std::vector<const Posting*> lists;
+    for (size_t i = 0; i + 3 <= literal.size(); ++i) {
+        uint32_t key = (static_cast<uint8_t>(literal[i]) << 16) |
+                       (static_cast<uint8_t>(literal[i + 1]) << 8) |
+                       static_cast<uint8_t>(literal[i + 2]);
+        auto it = postings_.find(key);
+        if (it == postings_.end()) {
+            return std::vector<std::string>{};
+        }
+        lists.push_back(&it->second);
+    }
+
+    // Intersect starting from the rarest trigram
+    std::sort(lists.begin(), lists.end(), [](const Posting* a, const Posting* b) {
+        return a->count < b->count;
+    });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    std::vector<uint32_t> ids = decode(*lists[0]);
+    std::vector<uint32_t> scratch;
+    for (size_t i = 1; i < lists.size() && !ids.empty(); ++i) {
+        std::vector<uint32_t> other = decode(*lists[i]);
+        scratch.clear();
+        std::set_intersection(ids.begin(), ids.end(), other.begin(), other.end(),
+                              std::back_inserter(scratch));
+        ids.swap(scratch);
+    }
+
+    std::vector<std::string> result;
+    for (uint32_t id : ids) {
+        const FileInfo& info = files_[id];
+        if (info.flags & (Dead | Binary)) continue;
+        if (!rel_prefix.empty() && info.path.compare(0, rel_prefix.size(), rel_prefix) != 0) continue;
+        result.push_back(info.path);
+    }
+    return result;
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool TrigramIndex::save() {
+    std::lock_guard lock(mutex_);
+    return save_locked();
+}
+
+bool TrigramIndex::save_locked() {
+    if (dead_count_ > 0) {
+        compact();
+    }
+
+    try {
+        fs::create_directories(index_path_.parent_path());
+        fs::path tmp = index_path_;
+        tmp += ".tmp";
+
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+
+            out.write(kMagic, sizeof(kMagic));
+            write_string(out, root_.string());
+
+            write_pod(out, static_cast<uint32_t>(files_.size()));
+            for (const auto& info : files_) {
+                write_string(out, info.path);
+                write_pod(out, info.size);
+                write_pod(out, info.mtime_ns);
+                write_pod(out, info.flags);
+            }
+
+            write_pod(out, static_cast<uint32_t>(postings_.size()));
+            for (const auto& [key, posting] : postings_) {
+                write_pod(out, key);
+                write_pod(out, posting.count);
+                write_pod(out, posting.last);
+                write_pod(out, static_cast<uint32_t>(posting.bytes.size()));
+                out.write(reinterpret_cast<const char*>(posting.bytes.data()),
+                          static_cast<std::streamsize>(posting.bytes.size()));
+            }
+
+            if (!out) return false;
+        }
+
+        fs::rename(tmp, index_path_);
+        unsaved_changes_ = 0;
+        last_save_ = std::chrono::steady_clock::now();
+        return true;
+
+    } catch (const std::exception& e) {
+        spdlog::warn("Failed to save trigram index {}: {}", index_path_.string(), e.what());
+        return false;
+    }
+}
+
+bool TrigramIndex::load() {
+    std::ifstream in(index_path_, std::ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kMagic)];
+    std::string root;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !read_string(in, root) || root != root_.string()) {
+        return false;
+    }
+
+    std::vector<FileInfo> files;
+    std::unordered_map<uint32_t, Posting> postings;
+
+    uint32_t file_count = 0;
+    if (!read_pod(in, file_count)) return false;
+    files.resize(file_count);
+    for (auto& info : files) {
+        if (!read_string(in, info.path) || !read_pod(in, info.size) ||
+            !read_pod(in, info.mtime_ns) || !read_pod(in, info.flags)) {
+            return false;
+        }
+    }
+
+    uint32_t posting_count = 0;
+    if (!read_pod(in, posting_count)) return false;
+    postings.reserve(posting_count);
+    for (uint32_t i = 0; i < posting_count; ++i) {
+        uint32_t key = 0;
+        uint32_t size = 0;
+        Posting posting;
+        if (!read_pod(in, key) || !read_pod(in, posting.count) ||
+            !read_pod(in, posting.last) || !read_pod(in, size)) {
+            return false;
+        }
+        posting.bytes.resize(size);
+        if (!in.read(reinterpret_cast<char*>(posting.bytes.data()), size)) return false;
+        postings.emplace(key, std::move(posting));
+    }
+
+    files_ = std::move(files);
+    postings_ = std::move(postings);
+    by_path_.clear();
+    for (uint32_t id = 0; id < files_.size(); ++id) {
+        by_path_.emplace(files_[id].path, id);
+    }
+    dead_count_ = 0;
+    last_save_ = std::chrono::steady_clock::now();
+    ready_.store(true);
+    return true;
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+std::shared_ptr<TrigramIndex> TrigramIndex::for_project(const fs::path& root,
+                                                        const fs::path& storage_dir) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::shared_ptr<TrigramIndex>> registry;
+
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(root, ec);
+    if (ec) canonical = root;
+
+    std::lock_guard lock(registry_mutex);
+    auto& index = registry[canonical.string()];
+    if (!index) {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx",
+                      static_cast<unsigned long long>(fnv1a(canonical.string())));
+        index = std::make_shared<TrigramIndex>(canonical, storage_dir / name / "trigram.idx");
+    }
+    return index;
+}
+
+}  // namespace gpagent::tools
@@ -209,19 +209,24 @@ void ChatBackend::newChat()
     setStatusMessage("");
 }
 
-QVariantList ChatBackend::getSessions()
+QVariantList ChatBackend::getSessions(int offset, int limit)
 {
     QVariantList result;
 
-    if (!m_memoryManager) {
+    if (!m_memoryManager || offset < 0 || limit <= 0) {
         return result;
     }
 
-    auto sessions = m_memoryManager->list_sessions();
+    memory::SessionCatalog::Query query;
+    query.offset = static_cast<size_t>(offset);
+    query.limit = static_cast<size_t>(limit);
+    auto sessions = m_memoryManager->list_sessions(query);
     for (const auto& session : sessions) {
         QVariantMap item;
         item["id"] = QString::fromStdString(session.id);
         item["preview"] = QString::fromStdString(session.preview);
+        item["messageCount"] = static_cast<qulonglong>(session.message_count);
+        item["tokens"] = static_cast<qulonglong>(session.tokens);
 
         // Format timestamps
         auto created = std::chrono::system_clock::to_time_t(session.created_at);
@@ -316,6 +321,14 @@ void ChatBackend::onAgentEvent(int eventType, const QString& message)
     case agent::AgentEvent::ToolExecuting:
         setStatusMessage(QString("Executing: %1").arg(message));
         break;
+    case agent::AgentEvent::ToolOutput: {
+        // Show the latest complete output line
+        QString line = message.trimmed().section('\n', -1);
+        if (!line.isEmpty()) {
+            setStatusMessage(line.left(200));
+        }
+        break;
+    }
     case agent::AgentEvent::ToolCompleted:
         setStatusMessage("Tool completed");
         break;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <string>
+
+namespace gpagent::test {
+
+// Fresh directory under the system temp dir, removed with everything in it
+// when the test scope ends
+struct TempDir {
+    std::filesystem::path path;
+
+    explicit TempDir(const std::string& prefix)
+        : path(std::filesystem::temp_directory_path() /
+               ("gpagent_" + prefix + "_" + std::to_string(std::random_device{}()))) {
+        std::filesystem::create_directories(path);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+};
+
+}  // namespace gpagent::test
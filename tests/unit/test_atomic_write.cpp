@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/atomic_write.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+#include <sstream>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+std::string slurp(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+}  // namespace
+
+TEST_CASE("Atomic write creates and replaces files", "[atomic_write]") {
+    TempDir dir("atomic");
+
+    // A target that does not exist yet is created
+    fs::path file = dir.path / "new.txt";
+    REQUIRE(write_file_atomic(file, {"hello ", "world"}).is_ok());
+    REQUIRE(slurp(file) == "hello world");
+
+    REQUIRE(write_file_atomic(file, {"replaced"}).is_ok());
+    REQUIRE(slurp(file) == "replaced");
+
+    // Writes through a symlink land in its target
+    fs::path link = dir.path / "link.txt";
+    fs::create_symlink(file, link);
+    REQUIRE(write_file_atomic(link, {"via link"}).is_ok());
+    REQUIRE(fs::is_symlink(link));
+    REQUIRE(slurp(file) == "via link");
+
+    // A dangling symlink is not followed to create its target
+    fs::path dangling = dir.path / "dangling.txt";
+    fs::create_symlink(dir.path / "missing" / "target.txt", dangling);
+    REQUIRE(write_file_atomic(dangling, {"lost"}).is_err());
+    REQUIRE(fs::is_symlink(dangling));
+    fs::remove(dangling);
+
+    // Hard links stay shared
+    fs::path hard = dir.path / "hard.txt";
+    fs::create_hard_link(file, hard);
+    REQUIRE(write_file_atomic(file, {"both"}).is_ok());
+    REQUIRE(slurp(hard) == "both");
+
+    // No temp files are left behind
+    size_t entries = 0;
+    for (const auto& entry : fs::directory_iterator(dir.path)) {
+        (void)entry;
+        ++entries;
+    }
+    REQUIRE(entries == 3);
+}
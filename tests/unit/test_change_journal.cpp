@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/change_journal.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+struct TempTree {
+    TempDir dir{"journal"};
+    const fs::path& root = dir.path;
+
+    void write(const std::string& rel, const std::string& content = "x") {
+        std::ofstream(root / rel) << content;
+    }
+};
+
+// Batches may be delivered by the journal's own thread
+bool eventually(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+bool contains(const std::vector<std::string>& paths, const std::string& path) {
+    return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
+}  // namespace
+
+TEST_CASE("Journal reports changes since a position", "[change_journal]") {
+    TempTree tree;
+    fs::create_directories(tree.root / "src");
+    auto journal = ChangeJournal::create(tree.root);
+    if (!journal) return;  // no inotify
+    REQUIRE(journal->watch(""));
+    REQUIRE(journal->watch("src"));
+
+    uint64_t start = journal->sequence();
+    tree.write("a.txt");
+    tree.write("src/b.cpp");
+    fs::create_directories(tree.root / "new_dir");
+
+    auto changes = journal->since(start);
+    REQUIRE_FALSE(changes.overflow);
+    REQUIRE(contains(changes.files, "a.txt"));
+    REQUIRE(contains(changes.files, "src/b.cpp"));
+    REQUIRE(contains(changes.dirs, "new_dir"));
+    REQUIRE(changes.sequence > start);
+
+    // Nothing new after the returned position; two consumers keep their own
+    REQUIRE(journal->since(changes.sequence).files.empty());
+    tree.write("a.txt", "changed");
+    REQUIRE(journal->since(changes.sequence).files == std::vector<std::string>{"a.txt"});
+    REQUIRE(journal->since(start).files.size() == 2);
+}
+
+TEST_CASE("Journal overflows when a consumer falls behind", "[change_journal]") {
+    TempTree tree;
+    auto journal = ChangeJournal::create(tree.root, 4);
+    if (!journal) return;
+    journal->watch("");
+
+    uint64_t start = journal->sequence();
+    for (int i = 0; i < 10; ++i) tree.write("f" + std::to_string(i));
+    auto behind = journal->since(start);
+    REQUIRE(behind.overflow);
+
+    // A position inside the retained history is still served
+    tree.write("late");
+    auto recent = journal->since(behind.sequence);
+    REQUIRE_FALSE(recent.overflow);
+    REQUIRE(recent.files == std::vector<std::string>{"late"});
+}
+
+TEST_CASE("Journal listeners receive batches", "[change_journal]") {
+    TempTree tree;
+    auto journal = ChangeJournal::create(tree.root);
+    if (!journal) return;
+    journal->watch("");
+
+    std::mutex mutex;
+    std::set<std::string> seen;
+    auto seen_count = [&] {
+        std::lock_guard lock(mutex);
+        return seen.size();
+    };
+    size_t id = journal->subscribe([&](const ChangeJournal::Changes& batch) {
+        std::lock_guard lock(mutex);
+        seen.insert(batch.files.begin(), batch.files.end());
+    });
+    tree.write("one");
+    journal->sequence();
+    REQUIRE(eventually([&] { return seen_count() == 1; }));
+
+    journal->unsubscribe(id);
+    tree.write("two");
+    journal->sequence();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(seen_count() == 1);
+}
+
+TEST_CASE("Project journals are shared and released with their last user", "[change_journal]") {
+    TempTree tree;
+    auto journal = ChangeJournal::for_project(tree.root);
+    if (!journal) return;
+
+    REQUIRE(ChangeJournal::for_project(tree.root) == journal);
+    std::weak_ptr<ChangeJournal> weak = journal;
+    journal.reset();
+    REQUIRE(weak.expired());
+
+    auto reopened = ChangeJournal::for_project(tree.root);
+    REQUIRE(reopened);
+    tree.write("after");
+    REQUIRE(eventually([&] { return !reopened->since(0).files.empty(); }));
+}
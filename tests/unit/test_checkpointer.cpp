@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/memory/checkpointer.hpp"
+#include "gpagent/memory/checkpoint_writer.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+
+using namespace gpagent::memory;
+using gpagent::test::TempDir;
+
+namespace {
+
+size_t object_files(const fs::path& dir) {
+    size_t count = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(dir / "objects")) {
+        if (entry.is_regular_file()) ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+TEST_CASE("Checkpoints share the chunks of unchanged messages", "[checkpointer]") {
+    TempDir dir("cp");
+    SessionState session("session-1");
+    ThreadMemory thread("thread-1");
+    CompressedHistory history;
+
+    CheckpointId first, second;
+    {
+        Checkpointer checkpointer(dir.path);
+        thread.append(Message::user("one"));
+        thread.append(Message::assistant("two"));
+        first = checkpointer.create(session, thread, history, "first").value();
+        // Two messages, the session state and the history
+        REQUIRE(checkpointer.chunk_count() == 4);
+
+        thread.append(Message::user("three"));
+        session.increment_turn();
+        second = checkpointer.create(session, thread, history, "second").value();
+        // Only the new message and the new session state are stored
+        REQUIRE(checkpointer.chunk_count() == 6);
+        REQUIRE(object_files(dir.path) == 6);
+
+        auto restored = checkpointer.restore(first);
+        REQUIRE(restored.is_ok());
+        REQUIRE(restored.value().thread_memory.size() == 2);
+        REQUIRE(restored.value().thread_memory.id() == "thread-1");
+        REQUIRE(restored.value().info.description == "first");
+    }
+
+    // References are rebuilt from the manifests on reopen
+    Checkpointer checkpointer(dir.path);
+    REQUIRE(checkpointer.chunk_count() == 6);
+
+    REQUIRE(checkpointer.remove(first).is_ok());
+    // Only the first session state was used by that checkpoint alone
+    REQUIRE(object_files(dir.path) == 5);
+
+    auto restored = checkpointer.restore(second);
+    REQUIRE(restored.is_ok());
+    REQUIRE(restored.value().thread_memory.size() == 3);
+    REQUIRE(restored.value().thread_memory.messages().back().content == "three");
+    REQUIRE(restored.value().session_state.conversation_turn() == 1);
+
+    REQUIRE(checkpointer.remove(second).is_ok());
+    REQUIRE(object_files(dir.path) == 0);
+}
+
+TEST_CASE("Checkpoints after a trim and orphaned chunks", "[checkpointer]") {
+    TempDir dir("cp");
+    SessionState session("session-1");
+    ThreadMemory thread("thread-1");
+    CompressedHistory history;
+    {
+        Checkpointer checkpointer(dir.path);
+        thread.append(Message::user("one"));
+        thread.append(Message::user("two"));
+        thread.append(Message::user("three"));
+        checkpointer.create(session, thread, history);
+
+        thread.trim(1);
+        thread.append(Message::user("four"));
+        auto id = checkpointer.create(session, thread, history).value();
+
+        auto restored = checkpointer.restore(id).value();
+        REQUIRE(restored.thread_memory.size() == 2);
+        REQUIRE(restored.thread_memory.messages().front().content == "three");
+        REQUIRE(restored.thread_memory.messages().back().content == "four");
+    }
+
+    // A chunk written before a crash, with no manifest naming it
+    fs::create_directories(dir.path / "objects" / "ab");
+    {
+        std::ofstream(dir.path / "objects" / "ab" / std::string(62, 'c')) << "orphan";
+    }
+    size_t before = object_files(dir.path);
+    Checkpointer checkpointer(dir.path);
+    REQUIRE(object_files(dir.path) == before - 1);
+}
+
+TEST_CASE("Checkpoints from thread deltas", "[checkpointer]") {
+    TempDir dir("cp");
+    SessionState session("session-1");
+    ThreadMemory thread("thread-1");
+    CompressedHistory history;
+    Checkpointer checkpointer(dir.path);
+
+    thread.append(Message::user("one"));
+    checkpointer.create(session, thread, history);
+
+    ThreadDelta delta{thread.id(), thread.revision(), 1, {Message::user("two"), Message::user("three")}};
+    auto id = checkpointer.create(session, delta, history, "delta", "auto");
+    REQUIRE(id.is_ok());
+    auto restored = checkpointer.restore(id.value()).value();
+    REQUIRE(restored.thread_memory.size() == 3);
+    REQUIRE(restored.thread_memory.messages()[0].content == "one");
+    REQUIRE(restored.thread_memory.messages()[2].content == "three");
+
+    // A delta past what was checkpointed, or of another thread, is refused
+    ThreadDelta gap{thread.id(), thread.revision(), 5, {Message::user("six")}};
+    REQUIRE(checkpointer.create(session, gap, history, "", "auto").is_err());
+    ThreadMemory rebuilt("thread-1");
+    ThreadDelta other{rebuilt.id(), rebuilt.revision(), 1, {Message::user("x")}};
+    REQUIRE(checkpointer.create(session, other, history, "", "auto").is_err());
+}
+
+TEST_CASE("Checkpoint writer persists jobs in order and flushes", "[checkpointer]") {
+    TempDir dir("cp");
+    SessionState session("session-1");
+    ThreadMemory thread("thread-1");
+    CompressedHistory history;
+    Checkpointer checkpointer(dir.path);
+    {
+        CheckpointWriter writer(checkpointer, 1);
+        thread.append(Message::user("one"));
+        writer.submit({session, history, thread, {}, "first", "auto"});
+
+        for (int i = 0; i < 5; ++i) {
+            ThreadDelta delta{thread.id(), thread.revision(), thread.size(), {Message::user(std::to_string(i))}};
+            thread.append(delta.messages.front());
+            writer.submit({session, history, std::nullopt, std::move(delta), "delta", "auto"});
+        }
+        REQUIRE(writer.flush().is_ok());
+        REQUIRE(checkpointer.list("session-1").size() == 6);
+        REQUIRE_FALSE(writer.needs_full_thread());
+
+        // A delta that does not extend the last checkpoint fails, and the
+        // writer asks for the whole thread next
+        writer.submit({session, history, std::nullopt, ThreadDelta{thread.id(), thread.revision(), 99, {}}, "", "auto"});
+        REQUIRE(writer.flush().is_err());
+        REQUIRE(writer.needs_full_thread());
+        writer.submit({session, history, thread, {}, "full", "auto"});
+
+        // The destructor writes what is still queued
+    }
+    REQUIRE(checkpointer.list("session-1").size() == 7);
+    for (const auto& info : checkpointer.list("session-1")) {
+        if (info.description == "full") {
+            REQUIRE(checkpointer.restore(info.id).value().thread_memory.size() == 6);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/dir_lister.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace gpagent::tools;
+using Type = DirListEntry::Type;
+using gpagent::test::TempDir;
+
+namespace {
+
+struct TempTree {
+    TempDir dir{"dir_lister"};
+    const fs::path& root = dir.path;
+
+    void file(const std::string& rel, size_t size = 1) {
+        fs::create_directories((root / rel).parent_path());
+        std::ofstream(root / rel) << std::string(size, 'x');
+    }
+};
+
+std::vector<std::string> paths(const DirListing& listing) {
+    std::vector<std::string> out;
+    for (const auto& entry : listing.entries) out.push_back(entry.rel_path);
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("Listing types, sizes and hidden entries", "[dir_lister]") {
+    TempTree tree;
+    tree.file("a.txt", 2048);
+    tree.file(".hidden");
+    tree.file("sub/b.txt", 3);
+    fs::create_symlink(tree.root / "sub", tree.root / "link");
+
+    auto listing = list_directory_tree(tree.root);
+    REQUIRE_FALSE(listing.truncated);
+    REQUIRE(listing.entries.size() == 3);
+    for (const auto& entry : listing.entries) {
+        if (entry.rel_path == "a.txt") {
+            REQUIRE(entry.type == Type::File);
+            REQUIRE(entry.size == 2048);
+        } else if (entry.rel_path == "sub") {
+            REQUIRE(entry.type == Type::Directory);
+        } else {
+            REQUIRE(entry.rel_path == "link");
+            REQUIRE(entry.type == Type::Symlink);
+        }
+    }
+
+    DirListOptions options;
+    options.include_hidden = true;
+    REQUIRE(list_directory_tree(tree.root, options).entries.size() == 4);
+}
+
+TEST_CASE("Recursive listings respect depth and entry caps", "[dir_lister]") {
+    TempTree tree;
+    tree.file("one/two/three/deep.txt");
+    tree.file("one/top.txt", 5);
+
+    DirListOptions options;
+    options.recursive = true;
+    options.max_depth = 1;
+    auto listing = list_directory_tree(tree.root, options);
+    REQUIRE_FALSE(listing.truncated);
+    auto listed = paths(listing);
+    std::sort(listed.begin(), listed.end());
+    REQUIRE(listed == std::vector<std::string>{"one", "one/top.txt", "one/two"});
+
+    // Pre-order: every directory precedes its contents
+    options.max_depth = 10;
+    listing = list_directory_tree(tree.root, options);
+    REQUIRE(listing.entries.size() == 5);
+    REQUIRE(listing.entries[0].rel_path == "one");
+    for (const auto& entry : listing.entries) {
+        REQUIRE(entry.depth == std::count(entry.rel_path.begin(), entry.rel_path.end(), '/'));
+        if (entry.rel_path == "one/top.txt") REQUIRE(entry.size == 5);
+    }
+
+    options.max_entries = 3;
+    listing = list_directory_tree(tree.root, options);
+    REQUIRE(listing.truncated);
+    REQUIRE(listing.entries.size() == 3);
+
+    // Exactly at the cap is not truncated
+    options.max_entries = 5;
+    REQUIRE_FALSE(list_directory_tree(tree.root, options).truncated);
+}
+
+TEST_CASE("Large listings stat files in parallel", "[dir_lister]") {
+    TempTree tree;
+    for (int i = 0; i < 1000; ++i) tree.file("d" + std::to_string(i % 4) + "/f" + std::to_string(i), i % 37);
+
+    DirListOptions options;
+    options.recursive = true;
+    options.max_entries = 5000;
+    options.num_threads = 4;
+    auto listing = list_directory_tree(tree.root, options);
+    REQUIRE(listing.entries.size() == 1004);
+    for (const auto& entry : listing.entries) {
+        if (entry.type != Type::File) continue;
+        int i = std::stoi(std::string(entry.name().substr(1)));
+        REQUIRE(entry.size == static_cast<uint64_t>(i % 37));
+    }
+}
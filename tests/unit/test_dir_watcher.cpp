@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/dir_watcher.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+bool contains(const std::vector<std::string>& paths, const std::string& path) {
+    return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
+}  // namespace
+
+TEST_CASE("Watcher reports file and directory changes", "[dir_watcher]") {
+    TempDir dir("watcher");
+    fs::create_directories(dir.path / "src");
+    auto watcher = DirWatcher::create(dir.path);
+    if (!watcher) return;  // no inotify
+    REQUIRE(watcher->watch(""));
+    REQUIRE(watcher->watch("src"));
+    REQUIRE(watcher->watching("src"));
+    REQUIRE_FALSE(watcher->watching("other"));
+    REQUIRE(watcher->watch_count() == 2);
+
+    // Idle: nothing pending
+    REQUIRE_FALSE(watcher->wait(0));
+    REQUIRE(watcher->poll().files.empty());
+
+    std::ofstream(dir.path / "a.txt") << "one";
+    std::ofstream(dir.path / "src" / "b.cpp") << "two";
+    fs::create_directories(dir.path / "new_dir");
+    REQUIRE(watcher->wait(1000));
+
+    // Several events per file collapse into one path
+    auto changes = watcher->poll();
+    REQUIRE_FALSE(changes.overflow);
+    REQUIRE(changes.files == std::vector<std::string>{"a.txt", "src/b.cpp"});
+    REQUIRE(changes.dirs == std::vector<std::string>{"new_dir"});
+
+    // Drained
+    REQUIRE(watcher->poll().files.empty());
+
+    fs::remove(dir.path / "a.txt");
+    REQUIRE(watcher->poll().files == std::vector<std::string>{"a.txt"});
+
+    // Directories that are not watched report nothing below them
+    std::ofstream(dir.path / "new_dir" / "c.txt") << "three";
+    REQUIRE(watcher->poll().files.empty());
+}
+
+TEST_CASE("Watcher drops watches of moved and deleted directories", "[dir_watcher]") {
+    TempDir dir("watcher");
+    fs::create_directories(dir.path / "tree" / "sub");
+    auto watcher = DirWatcher::create(dir.path);
+    if (!watcher) return;
+    REQUIRE(watcher->watch(""));
+    REQUIRE(watcher->watch("tree"));
+    REQUIRE(watcher->watch("tree/sub"));
+
+    // A moved directory is reported under both names, and its watches,
+    // which would report the old paths, are forgotten
+    fs::rename(dir.path / "tree", dir.path / "moved");
+    auto changes = watcher->poll();
+    REQUIRE(contains(changes.dirs, "tree"));
+    REQUIRE(contains(changes.dirs, "moved"));
+    REQUIRE_FALSE(watcher->watching("tree"));
+    REQUIRE_FALSE(watcher->watching("tree/sub"));
+    REQUIRE(watcher->watch_count() == 1);
+
+    std::ofstream(dir.path / "moved" / "sub" / "late.txt") << "x";
+    REQUIRE(watcher->poll().files.empty());
+
+    // A deleted directory's watch is released by the kernel
+    REQUIRE(watcher->watch("moved"));
+    fs::remove_all(dir.path / "moved");
+    changes = watcher->poll();
+    REQUIRE(contains(changes.dirs, "moved"));
+    REQUIRE_FALSE(watcher->watching("moved"));
+}
+
+TEST_CASE("Watcher stops at its watch limit", "[dir_watcher]") {
+    TempDir dir("watcher");
+    fs::create_directories(dir.path / "a");
+    fs::create_directories(dir.path / "b");
+    auto watcher = DirWatcher::create(dir.path, 2);
+    if (!watcher) return;
+
+    REQUIRE(watcher->watch(""));
+    REQUIRE(watcher->watch("a"));
+    REQUIRE(watcher->watch("a"));  // already watched
+    REQUIRE_FALSE(watcher->watch("b"));
+    REQUIRE(watcher->watch_count() == 2);
+
+    // A directory that vanished is not a failure: its parent reports it
+    REQUIRE(DirWatcher::create(dir.path)->watch("missing"));
+}
+
+TEST_CASE("Watcher overflows when its root goes away", "[dir_watcher]") {
+    TempDir dir("watcher");
+    fs::path root = dir.path / "root";
+    fs::create_directories(root);
+    auto watcher = DirWatcher::create(root);
+    if (!watcher) return;
+    REQUIRE(watcher->watch(""));
+
+    fs::rename(root, dir.path / "elsewhere");
+    REQUIRE(watcher->poll().overflow);
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/file_walker.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+using namespace gpagent::tools;
+using Verdict = IgnoreRules::Verdict;
+using gpagent::test::TempDir;
+
+namespace {
+
+void write_file(const fs::path& path, const std::string& content = "x") {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+}
+
+std::vector<std::string> walk_all(const fs::path& root, WalkOptions options = {}) {
+    std::vector<std::string> files;
+    std::mutex mutex;
+    FileWalker walker(options);
+    walker.walk(root, [&](const WalkEntry& entry) {
+        std::lock_guard lock(mutex);
+        files.emplace_back(entry.rel_path);
+        return true;
+    });
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+}  // namespace
+
+TEST_CASE("Ignore rules follow gitignore semantics", "[walker]") {
+    auto rules = IgnoreRules::parse(
+        "# comment\n"
+        "*.o\n"
+        "build/\n"
+        "/TODO\n"
+        "docs/*.html\n"
+        "**/generated\n"
+        "*.log\n"
+        "!keep.log\n");
+
+    REQUIRE(rules.match("main.o", false) == Verdict::Ignore);
+    REQUIRE(rules.match("src/util.o", false) == Verdict::Ignore);
+    REQUIRE(rules.match("build", true) == Verdict::Ignore);
+    REQUIRE(rules.match("build", false) == Verdict::None);
+    REQUIRE(rules.match("TODO", false) == Verdict::Ignore);
+    REQUIRE(rules.match("src/TODO", false) == Verdict::None);
+    REQUIRE(rules.match("docs/index.html", false) == Verdict::Ignore);
+    REQUIRE(rules.match("docs/api/index.html", false) == Verdict::None);
+    REQUIRE(rules.match("generated", true) == Verdict::Ignore);
+    REQUIRE(rules.match("a/b/generated", true) == Verdict::Ignore);
+    REQUIRE(rules.match("debug.log", false) == Verdict::Ignore);
+    REQUIRE(rules.match("keep.log", false) == Verdict::Include);
+    REQUIRE(rules.match("main.cpp", false) == Verdict::None);
+}
+
+TEST_CASE("Ignore rules share GlobMatcher's wildcards", "[walker]") {
+    auto rules = IgnoreRules::parse(
+        "out/**\n"
+        "{a,b}.txt\n"
+        "[0-9]*.tmp\n"
+        "docs/**/draft-?.md\n");
+
+    // "dir/**" ignores what is inside, so the directory itself is still walked
+    REQUIRE(rules.match("out", true) == Verdict::None);
+    REQUIRE(rules.match("out/x", false) == Verdict::Ignore);
+    REQUIRE(rules.match("out/x/y", false) == Verdict::Ignore);
+    // Braces are literal in gitignore
+    REQUIRE(rules.match("{a,b}.txt", false) == Verdict::Ignore);
+    REQUIRE(rules.match("a.txt", false) == Verdict::None);
+    REQUIRE(rules.match("src/7days.tmp", false) == Verdict::Ignore);
+    REQUIRE(rules.match("days.tmp", false) == Verdict::None);
+    REQUIRE(rules.match("docs/draft-1.md", false) == Verdict::Ignore);
+    REQUIRE(rules.match("docs/a/b/draft-2.md", false) == Verdict::Ignore);
+    REQUIRE(rules.match("docs/a/draft-10.md", false) == Verdict::None);
+}
+
+TEST_CASE("Walker honors ignore files and hidden filter", "[walker]") {
+    TempDir root("walker");
+
+    write_file(root.path / ".gitignore", "*.tmp\nout/\n");
+    write_file(root.path / "a.cpp");
+    write_file(root.path / "b.tmp");
+    write_file(root.path / "out" / "c.cpp");
+    write_file(root.path / ".hidden" / "d.cpp");
+    write_file(root.path / "node_modules" / "e.js");
+    write_file(root.path / "src" / ".gitignore", "!keep.tmp\n");
+    write_file(root.path / "src" / "keep.tmp");
+    write_file(root.path / "src" / "deep" / "f.cpp");
+
+    REQUIRE(walk_all(root.path) == std::vector<std::string>{"a.cpp", "src/deep/f.cpp", "src/keep.tmp"});
+
+    WalkOptions options;
+    options.include_hidden = true;
+    options.respect_ignore_files = false;
+    options.num_threads = 1;
+    auto all = walk_all(root.path, options);
+    REQUIRE(std::find(all.begin(), all.end(), ".hidden/d.cpp") != all.end());
+    REQUIRE(std::find(all.begin(), all.end(), "b.tmp") != all.end());
+    REQUIRE(std::find(all.begin(), all.end(), "node_modules/e.js") == all.end());
+}
+
+TEST_CASE("Walker stops when the visitor returns false", "[walker]") {
+    TempDir root("walker");
+    for (int i = 0; i < 200; ++i) {
+        write_file(root.path / ("d" + std::to_string(i % 10)) / ("f" + std::to_string(i)));
+    }
+
+    std::atomic<int> visited{0};
+    FileWalker walker;
+    walker.walk(root.path, [&](const WalkEntry&) {
+        return ++visited < 5;
+    });
+    REQUIRE(walker.stopped());
+    REQUIRE(visited.load() < 200);
+}
@@ -0,0 +1,303 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/git_porcelain.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace gpagent::tools;
+using namespace gpagent::tools::git;
+using gpagent::test::TempDir;
+
+namespace {
+
+// A repository built with the git command line, as the fixture for reads
+struct TempRepo {
+    TempDir dir{"git_repo"};
+    const fs::path& root = dir.path;
+
+    TempRepo() { git("init -q -b main"); }
+
+    std::string command(const std::string& args) const {
+        return "git -C '" + root.string() + "' -c user.name=test -c user.email=test@example.com " +
+               "-c advice.statusHints=false -c core.quotePath=false " + args;
+    }
+
+    bool git(const std::string& args) const {
+        return std::system((command(args) + " >/dev/null 2>&1").c_str()) == 0;
+    }
+
+    // stdout of a git command
+    std::string output(const std::string& args) const {
+        std::string out;
+        if (FILE* pipe = popen((command(args) + " 2>/dev/null").c_str(), "r")) {
+            char buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) out.append(buffer, n);
+            pclose(pipe);
+        }
+        return out;
+    }
+
+    void write(const std::string& rel, const std::string& content) const {
+        fs::create_directories((root / rel).parent_path());
+        std::ofstream(root / rel, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    void commit_all(const std::string& message = "commit") const {
+        REQUIRE(git("add -A"));
+        REQUIRE(git("commit -q -m '" + message + "'"));
+    }
+
+    std::shared_ptr<Repository> open() const {
+        auto repo = Repository::open(root);
+        REQUIRE(repo.is_ok());
+        return repo.value();
+    }
+};
+
+// Versions of one file that differ by a line, so packing deltifies them
+std::string version(int i) {
+    std::string text;
+    for (int line = 0; line < 40; ++line) {
+        text += "line " + std::to_string(line) + " of a file that is packed as deltas\n";
+    }
+    return text + "version " + std::to_string(i) + "\n";
+}
+
+void require_blob(Repository& repo, const std::string& content) {
+    auto object = repo.read_object(hash_object(ObjectType::Blob, content));
+    REQUIRE(object.is_ok());
+    REQUIRE(object.value().type == ObjectType::Blob);
+    REQUIRE(object.value().data == content);
+}
+
+// Deepest delta chain in the repository's packs, as verify-pack reports it
+size_t longest_chain(const TempRepo& fixture) {
+    size_t longest = 0;
+    for (const auto& entry : fs::directory_iterator(fixture.root / ".git" / "objects" / "pack")) {
+        if (entry.path().extension() != ".idx") continue;
+        std::istringstream lines(fixture.output("verify-pack -v '" + entry.path().string() + "'"));
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.rfind("chain length = ", 0) == 0) {
+                longest = std::max<size_t>(longest, std::stoul(line.substr(15)));
+            }
+        }
+    }
+    return longest;
+}
+
+}  // namespace
+
+TEST_CASE("Repository reads loose objects", "[git_repository]") {
+    TempRepo fixture;
+    fixture.write("a.txt", "hello\n");
+    fixture.write("dir/b.txt", "world\n");
+    fixture.commit_all("first commit\n\nbody");
+
+    auto repo = fixture.open();
+    require_blob(*repo, "hello\n");
+
+    auto head = repo->resolve_ref("HEAD");
+    REQUIRE(head.is_ok());
+    REQUIRE(head.value());
+    REQUIRE(to_hex(*head.value()) + "\n" == fixture.output("rev-parse HEAD"));
+    REQUIRE(repo->head_branch() == "main");
+
+    auto commit = repo->read_commit(*head.value());
+    REQUIRE(commit.is_ok());
+    REQUIRE(commit.value().subject() == "first commit");
+    REQUIRE(commit.value().author.name == "test");
+    REQUIRE(commit.value().parents.empty());
+
+    auto tree = repo->commit_tree(*head.value());
+    REQUIRE(tree.is_ok());
+    REQUIRE(tree.value()->size() == 2);
+    const FlatEntry* nested = find_entry(*tree.value(), "dir/b.txt");
+    REQUIRE(nested);
+    REQUIRE(nested->id == hash_object(ObjectType::Blob, "world\n"));
+
+    ObjectId missing{};
+    missing[0] = 0xAB;
+    REQUIRE(repo->read_object(missing).is_err());
+}
+
+TEST_CASE("Repository reads packed objects and offset deltas", "[git_repository]") {
+    TempRepo fixture;
+    for (int i = 0; i < 30; ++i) {
+        fixture.write("file.txt", version(i));
+        fixture.commit_all();
+    }
+    REQUIRE(fixture.git("repack -adq --depth=50 --window=50"));
+    REQUIRE(longest_chain(fixture) > 1);
+
+    auto repo = fixture.open();
+    for (int i = 0; i < 30; ++i) require_blob(*repo, version(i));
+
+    // Again, now from the delta base cache
+    for (int i = 29; i >= 0; --i) require_blob(*repo, version(i));
+}
+
+TEST_CASE("Repository follows long delta chains", "[git_repository]") {
+    // Version i has its first i lines edited, so each version's best delta
+    // base is its neighbour and packing chains them all
+    constexpr int kVersions = 300;
+    auto edited = [](int edits) {
+        std::string text;
+        for (int line = 0; line < kVersions; ++line) {
+            text += "line " + std::to_string(line) + (line < edits ? " edited\n" : " intact\n");
+        }
+        return text;
+    };
+
+    TempRepo fixture;
+    fixture.write("file.txt", edited(0));
+    fixture.commit_all();
+    for (int i = 1; i < kVersions; ++i) {
+        fixture.write("file.txt", edited(i));
+        REQUIRE(fixture.git("commit -q -a -m v"));
+    }
+    REQUIRE(fixture.git("repack -adfq --depth=4095 --window=" + std::to_string(kVersions)));
+    REQUIRE(longest_chain(fixture) > 100);
+
+    // Both ends of the chain with a cold cache, then every version
+    auto repo = fixture.open();
+    require_blob(*repo, edited(0));
+    require_blob(*repo, edited(kVersions - 1));
+    for (int i = 0; i < kVersions; ++i) require_blob(*repo, edited(i));
+}
+
+TEST_CASE("Repository reads reference deltas", "[git_repository]") {
+    TempRepo fixture;
+    for (int i = 0; i < 10; ++i) {
+        fixture.write("file.txt", version(i));
+        fixture.commit_all();
+    }
+    REQUIRE(fixture.git("-c repack.useDeltaBaseOffset=false repack -adq --depth=50 --window=50"));
+
+    auto repo = fixture.open();
+    for (int i = 0; i < 10; ++i) require_blob(*repo, version(i));
+}
+
+TEST_CASE("Repository parses the index", "[git_repository]") {
+    TempRepo fixture;
+    fixture.write("b.txt", "bee\n");
+    fixture.write("a/nested.txt", "nested\n");
+    fixture.write("run.sh", "#!/bin/sh\n");
+    fs::permissions(fixture.root / "run.sh", fs::perms::owner_exec, fs::perm_options::add);
+    fs::create_symlink("b.txt", fixture.root / "link");
+    fixture.commit_all();
+    fixture.write("later.txt", "later\n");
+    REQUIRE(fixture.git("add -N later.txt"));
+
+    for (const char* format : {"2", "3", "4"}) {
+        INFO("index version " << format);
+        REQUIRE(fixture.git(std::string("update-index --index-version ") + format));
+
+        auto index = fixture.open()->read_index();
+        REQUIRE(index.is_ok());
+        const auto& entries = index.value().entries;
+        REQUIRE(entries.size() == 5);
+
+        std::vector<std::string> paths;
+        for (const auto& entry : entries) paths.push_back(entry.path);
+        REQUIRE(paths == std::vector<std::string>{"a/nested.txt", "b.txt", "later.txt", "link", "run.sh"});
+
+        REQUIRE(entries[0].id == hash_object(ObjectType::Blob, "nested\n"));
+        REQUIRE(entries[0].mode == kModeFile);
+        REQUIRE(entries[0].size == 7);
+        REQUIRE(entries[2].intent_to_add);
+        REQUIRE_FALSE(entries[1].intent_to_add);
+        REQUIRE(entries[3].mode == kModeSymlink);
+        REQUIRE(entries[3].id == hash_object(ObjectType::Blob, "b.txt"));
+        REQUIRE(entries[4].mode == kModeExecutable);
+        REQUIRE(index.value().mtime_s > 0);
+    }
+}
+
+TEST_CASE("Status matches git status", "[git_repository]") {
+    TempRepo fixture;
+
+    // Before the first commit
+    fixture.write("new.txt", "new\n");
+    REQUIRE(format_status(read_status(*fixture.open()).value()) == fixture.output("status"));
+    REQUIRE(fixture.git("add new.txt"));
+    REQUIRE(format_status(read_status(*fixture.open()).value()) == fixture.output("status"));
+
+    fixture.write("keep.txt", "keep\n");
+    fixture.write("edit.txt", "edit\n");
+    fixture.write("gone.txt", "gone\n");
+    fixture.write("move.txt", version(1));
+    fixture.commit_all();
+    REQUIRE(format_status(read_status(*fixture.open()).value()) == fixture.output("status"));
+
+    // Staged, unstaged and untracked changes, including a rename
+    fixture.write("edit.txt", "edited\n");
+    fs::remove(fixture.root / "gone.txt");
+    REQUIRE(fixture.git("mv move.txt moved.txt"));
+    fixture.write("staged.txt", "staged\n");
+    REQUIRE(fixture.git("add staged.txt"));
+    fixture.write("build/out.o", "obj");
+    fixture.write("notes.txt", "notes\n");
+    REQUIRE(format_status(read_status(*fixture.open()).value()) == fixture.output("status"));
+
+    // Detached HEAD
+    fixture.commit_all();
+    REQUIRE(fixture.git("checkout -q --detach HEAD"));
+    REQUIRE(format_status(read_status(*fixture.open()).value()) == fixture.output("status"));
+}
+
+TEST_CASE("Status reports merge conflicts like git", "[git_repository]") {
+    TempRepo fixture;
+    fixture.write("both.txt", "base\n");
+    fixture.commit_all();
+    REQUIRE(fixture.git("checkout -q -b other"));
+    fixture.write("both.txt", "other\n");
+    fixture.commit_all();
+    REQUIRE(fixture.git("checkout -q main"));
+    fixture.write("both.txt", "main\n");
+    fixture.commit_all();
+    REQUIRE_FALSE(fixture.git("merge -q other"));
+
+    auto status = read_status(*fixture.open());
+    REQUIRE(status.is_ok());
+    REQUIRE(status.value().merging);
+    REQUIRE(status.value().unmerged.size() == 1);
+    REQUIRE(status.value().unmerged[0].stages == 0b111);
+    REQUIRE(format_status(status.value()) == fixture.output("status"));
+}
+
+TEST_CASE("Status formats upstream tracking", "[git_repository]") {
+    Status status;
+    status.branch = "main";
+    status.head = ObjectId{};
+    status.upstream = "origin/main";
+
+    REQUIRE(format_status(status) ==
+            "On branch main\n"
+            "Your branch is up to date with 'origin/main'.\n\n"
+            "nothing to commit, working tree clean\n");
+
+    status.ahead = 2;
+    REQUIRE(format_status(status).find("Your branch is ahead of 'origin/main' by 2 commits.\n") !=
+            std::string::npos);
+
+    status.ahead = 0;
+    status.behind = 1;
+    REQUIRE(format_status(status).find(
+                "Your branch is behind 'origin/main' by 1 commit, and can be fast-forwarded.\n") !=
+            std::string::npos);
+
+    status.ahead = 3;
+    REQUIRE(format_status(status).find("Your branch and 'origin/main' have diverged,\n"
+                                       "and have 3 and 1 different commits each, respectively.\n") !=
+            std::string::npos);
+
+    status.upstream_gone = true;
+    REQUIRE(format_status(status).find("Your branch is based on 'origin/main', but the upstream is gone.\n") !=
+            std::string::npos);
+}
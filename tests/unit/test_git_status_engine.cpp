@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/git_status_engine.hpp"
+#include "temp_dir.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+using namespace gpagent::tools;
+using namespace gpagent::tools::git;
+using gpagent::test::TempDir;
+
+namespace {
+
+// A work tree built with the git command line
+struct TempRepo {
+    TempDir dir{"status_engine"};
+    const fs::path& root = dir.path;
+
+    TempRepo() { git("init -q"); }
+
+    bool git(const std::string& args) const {
+        std::string command = "git -C '" + root.string() +
+                              "' -c user.name=test -c user.email=test@example.com " + args +
+                              " >/dev/null 2>&1";
+        return std::system(command.c_str()) == 0;
+    }
+
+    void write(const std::string& rel, const std::string& content) const {
+        fs::create_directories((root / rel).parent_path());
+        std::ofstream(root / rel, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    void commit(const std::string& rel, const std::string& content) const {
+        write(rel, content);
+        REQUIRE(git("add -A"));
+        REQUIRE(git("commit -q -m commit"));
+    }
+};
+
+std::vector<std::string> unstaged_paths(StatusEngine& engine) {
+    auto status = engine.status();
+    REQUIRE(status.is_ok());
+    std::vector<std::string> paths;
+    for (const auto& change : status.value().unstaged) paths.push_back(change.path);
+    return paths;
+}
+
+}  // namespace
+
+TEST_CASE("Status engine never trusts a hash from the same clock tick", "[status_engine]") {
+    TempRepo repo;
+    repo.commit("file.txt", "aaaa");
+    StatusEngine engine(Repository::for_work_tree(repo.root).value());
+
+    // Same-size rewrites in quick succession can leave identical stat data;
+    // a hash taken in the tick of the file's mtime must be taken again
+    for (int i = 0; i < 20; ++i) {
+        repo.write("file.txt", "bbbb");
+        REQUIRE(unstaged_paths(engine) == std::vector<std::string>{"file.txt"});
+        repo.write("file.txt", "aaaa");
+        REQUIRE(unstaged_paths(engine).empty());
+    }
+}
+
+TEST_CASE("Status engine reuses hashes of files touched without a change", "[status_engine]") {
+    TempRepo repo;
+    repo.commit("dir/file.txt", "content\n");
+    StatusEngine engine(Repository::for_work_tree(repo.root).value());
+    REQUIRE(unstaged_paths(engine).empty());
+
+    // New stat data: the content is hashed once and found unchanged
+    fs::path file = repo.root / "dir" / "file.txt";
+    auto touched = fs::last_write_time(file) - std::chrono::hours(1);
+    fs::last_write_time(file, touched);
+    size_t hashed = engine.hashed_files();
+    REQUIRE(unstaged_paths(engine).empty());
+    REQUIRE(engine.hashed_files() == hashed + 1);
+
+    // Checked again (its directory moved away and back) with the same stat
+    // data: the hash is reused
+    fs::rename(repo.root / "dir", repo.root / "away");
+    fs::rename(repo.root / "away", repo.root / "dir");
+    REQUIRE(unstaged_paths(engine).empty());
+    REQUIRE(engine.hashed_files() == hashed + 1);
+
+    // Touched again: hashed again
+    fs::last_write_time(file, touched - std::chrono::hours(1));
+    REQUIRE(unstaged_paths(engine).empty());
+    REQUIRE(engine.hashed_files() == hashed + 2);
+
+    // A real change is still seen
+    repo.write("dir/file.txt", "changed\n");
+    REQUIRE(unstaged_paths(engine) == std::vector<std::string>{"dir/file.txt"});
+}
+
+TEST_CASE("Status engine follows index rewrites and untracked files", "[status_engine]") {
+    TempRepo repo;
+    repo.commit("tracked.txt", "one\n");
+    StatusEngine engine(Repository::for_work_tree(repo.root).value());
+
+    repo.write("tracked.txt", "two\n");
+    repo.write("build/out.o", "obj");
+    auto status = engine.status();
+    REQUIRE(status.is_ok());
+    REQUIRE(status.value().unstaged.size() == 1);
+    REQUIRE(status.value().untracked == std::vector<std::string>{"build/"});
+
+    // Staging moves the change from unstaged to staged
+    REQUIRE(repo.git("add tracked.txt"));
+    status = engine.status();
+    REQUIRE(status.is_ok());
+    REQUIRE(status.value().unstaged.empty());
+    REQUIRE(status.value().staged.size() == 1);
+    REQUIRE(status.value().staged[0].path == "tracked.txt");
+
+    fs::remove_all(repo.root / "build");
+    status = engine.status();
+    REQUIRE(status.is_ok());
+    REQUIRE(status.value().untracked.empty());
+}
+
+TEST_CASE("Status engines are shared per work tree and evicted least recently used first",
+          "[status_engine]") {
+    std::vector<std::unique_ptr<TempRepo>> repos;
+    for (size_t i = 0; i <= StatusEngine::kMaxEngines; ++i) {
+        repos.push_back(std::make_unique<TempRepo>());
+    }
+    auto engine_for = [&](size_t i) { return StatusEngine::for_work_tree(repos[i]->root).value(); };
+
+    auto first = engine_for(0);
+    REQUIRE(engine_for(0) == first);
+    std::weak_ptr<StatusEngine> second = engine_for(1);
+    for (size_t i = 2; i < StatusEngine::kMaxEngines; ++i) engine_for(i);
+
+    // Using the first engine again makes the second the oldest
+    REQUIRE(engine_for(0) == first);
+    REQUIRE_FALSE(second.expired());
+    engine_for(StatusEngine::kMaxEngines);
+
+    REQUIRE(second.expired());
+    REQUIRE(engine_for(0) == first);
+}
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/glob_matcher.hpp"
+
+using namespace gpagent::tools;
+
+namespace {
+
+GlobMatcher glob(const std::string& pattern) {
+    auto compiled = GlobMatcher::compile(pattern);
+    REQUIRE(compiled.is_ok());
+    return compiled.value();
+}
+
+}  // namespace
+
+TEST_CASE("Single-segment wildcards", "[glob]") {
+    REQUIRE(wildcard_match("*.cpp", "main.cpp"));
+    REQUIRE_FALSE(wildcard_match("*.cpp", "main.hpp"));
+    REQUIRE(wildcard_match("test_?.py", "test_a.py"));
+    REQUIRE(wildcard_match("[a-c]*.txt", "bravo.txt"));
+    REQUIRE_FALSE(wildcard_match("[!a-c]*.txt", "bravo.txt"));
+    REQUIRE(wildcard_match("a*b*c", "axxbyyc"));
+    REQUIRE(wildcard_match("\\*", "*"));
+}
+
+TEST_CASE("Path globs with ** and braces", "[glob]") {
+    auto cpp = glob("src/**/*.cpp");
+    REQUIRE(cpp.matches("src/main.cpp"));
+    REQUIRE(cpp.matches("src/a/b/util.cpp"));
+    REQUIRE_FALSE(cpp.matches("lib/main.cpp"));
+    REQUIRE_FALSE(cpp.matches("src/main.hpp"));
+    REQUIRE(cpp.literal_prefix() == "src/");
+
+    auto top = glob("*.md");
+    REQUIRE(top.matches("README.md"));
+    REQUIRE_FALSE(top.matches("docs/guide.md"));
+    REQUIRE_FALSE(top.has_separator());
+
+    auto any = glob("**/*.{h,hpp}");
+    REQUIRE(any.matches("include/x.hpp"));
+    REQUIRE(any.matches("x.h"));
+    REQUIRE_FALSE(any.matches("x.cpp"));
+
+    auto nested = glob("{src,test{s,}}/*.py");
+    REQUIRE(nested.matches("src/a.py"));
+    REQUIRE(nested.matches("tests/a.py"));
+    REQUIRE(nested.matches("test/a.py"));
+    REQUIRE_FALSE(nested.matches("tes/a.py"));
+
+    REQUIRE(glob("docs/**").matches("docs/a/b.txt"));
+    REQUIRE(glob("./src/*.c").matches("src/x.c"));
+}
+
+TEST_CASE("Directory pruning", "[glob]") {
+    auto cpp = glob("src/**/*.cpp");
+    REQUIRE(cpp.could_match_within("src"));
+    REQUIRE(cpp.could_match_within("src/deep/er"));
+    REQUIRE_FALSE(cpp.could_match_within("node"));
+    REQUIRE_FALSE(cpp.could_match_within("lib/src"));
+
+    auto top = glob("*.md");
+    REQUIRE_FALSE(top.could_match_within("docs"));
+
+    auto alt = glob("{a,b}/x/*.txt");
+    REQUIRE(alt.could_match_within("b/x"));
+    REQUIRE_FALSE(alt.could_match_within("a/y"));
+    REQUIRE(alt.literal_prefix().empty());
+}
+
+TEST_CASE("Invalid glob patterns", "[glob]") {
+    REQUIRE(GlobMatcher::compile("").is_err());
+    REQUIRE(GlobMatcher::compile("{a,b}{c,d}{e,f}{g,h}{i,j}{k,l}{m,n}{o,p}{q,r}{s,t}{u,v}").is_err());
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/html_text.hpp"
+
+using namespace gpagent::tools;
+
+namespace {
+
+const char* kArticle = R"(<!DOCTYPE html>
+<html><head><title>Parsing &amp; Friends | Example</title>
+<style>p { color: red }</style>
+<script>if (a < b) document.write("<p>not text</p>");</script></head>
+<body>
+<nav><ul><li><a href="/">Home</a></li><li><a href="/blog">Blog</a></li></ul></nav>
+<div class="post-body">
+<h1>Parsing &amp; Friends</h1>
+<p>Tokenizers turn markup into a stream of tags and text, which is all an extractor needs to build blocks, score them, and render the result.</p>
+<p>Entities are decoded: &lt;p&gt; &#8212; &#x263A; caf&eacute; &copy 2024 &unknown;</p>
+<h2>Steps</h2>
+<ol><li>Read<li>Score<ul><li>nested</li></ul></li><li>Render</li></ol>
+<pre><code class="language-python">if x &lt; 2:
+    print(x)
+</code></pre>
+<blockquote><p>Quoted.<br>Twice.</p></blockquote>
+<table><tr><th>Name</th><th>Value</th></tr><tr><td>a</td><td>1</td></tr></table>
+<p hidden>hidden</p><p style="display: none">also hidden</p>
+<p>The last paragraph carries enough words, commas, and sentences to be counted as content.</p>
+</div>
+<aside class="sidebar"><p>Related reading, more links, and other things that are not the article.</p></aside>
+<footer><p>Copyright 2024, all rights reserved.</p></footer>
+</body></html>)";
+
+}  // namespace
+
+TEST_CASE("HTML structure becomes markdown-ish text", "[html_text]") {
+    std::string text = html_to_text(kArticle);
+
+    REQUIRE(text.rfind("# Parsing & Friends\n\nTokenizers turn markup", 0) == 0);
+    REQUIRE(text.find("<p> \xE2\x80\x94 \xE2\x98\xBA caf\xC3\xA9 \xC2\xA9 2024 &unknown;") != std::string::npos);
+    REQUIRE(text.find("## Steps\n\n1. Read\n2. Score\n  - nested\n3. Render") != std::string::npos);
+    REQUIRE(text.find("```python\nif x < 2:\n    print(x)\n```") != std::string::npos);
+    REQUIRE(text.find("> Quoted.\n> Twice.") != std::string::npos);
+    REQUIRE(text.find("Name | Value\na | 1") != std::string::npos);
+
+    REQUIRE(text.find("not text") == std::string::npos);
+    REQUIRE(text.find("color") == std::string::npos);
+    REQUIRE(text.find("hidden") == std::string::npos);
+}
+
+TEST_CASE("Main content leaves out navigation and sidebars", "[html_text]") {
+    std::string main = html_to_text(kArticle);
+    REQUIRE(main.find("Home") == std::string::npos);
+    REQUIRE(main.find("Related reading") == std::string::npos);
+    REQUIRE(main.find("Copyright") == std::string::npos);
+    REQUIRE(main.find("The last paragraph") != std::string::npos);
+
+    std::string all = html_to_text(kArticle, false);
+    REQUIRE(all.find("Home") != std::string::npos);
+    REQUIRE(all.find("Related reading") != std::string::npos);
+    REQUIRE(all.find("Copyright") != std::string::npos);
+}
+
+TEST_CASE("Chunked input extracts the same text", "[html_text]") {
+    std::string_view html(kArticle);
+    std::string whole = html_to_text(html);
+
+    for (size_t chunk : {1, 2, 3, 7, 64}) {
+        HtmlTextExtractor extractor;
+        for (size_t i = 0; i < html.size(); i += chunk) extractor.feed(html.substr(i, chunk));
+        REQUIRE(extractor.finish() == whole);
+        REQUIRE(extractor.title() == "Parsing & Friends | Example");
+    }
+}
+
+TEST_CASE("Malformed markup degrades to text", "[html_text]") {
+    REQUIRE(html_to_text("a < b && c > d") == "a < b && c > d");
+    REQUIRE(html_to_text("<p>one<p>two</div></p>three", false) == "one\n\ntwo\n\nthree");
+    REQUIRE(html_to_text("<!-- <p>comment</p> --><p>text</p><![CDATA[x]]>") == "text");
+    REQUIRE(html_to_text("<p>unterminated <script>never closed") == "unterminated");
+    REQUIRE(html_to_text("<p>x &amp y &#65 &#xZZ;</p>") == "x & y A &#xZZ;");
+}
@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/http_cache.hpp"
+#include "temp_dir.hpp"
+
+#include <map>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+constexpr int64_t kNow = 784111777;  // Sun, 06 Nov 1994 08:49:37 GMT
+
+HttpCache::HeaderLookup headers(std::map<std::string, std::string> values) {
+    return [values = std::move(values)](const std::string& name) {
+        auto it = values.find(name);
+        return it == values.end() ? std::string() : it->second;
+    };
+}
+
+}  // namespace
+
+TEST_CASE("HTTP dates in all three formats", "[http_cache]") {
+    REQUIRE(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT") == kNow);
+    REQUIRE(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT") == kNow);
+    REQUIRE(parse_http_date("Sun Nov  6 08:49:37 1994") == kNow);
+    REQUIRE(format_http_date(kNow) == "Sun, 06 Nov 1994 08:49:37 GMT");
+
+    REQUIRE_FALSE(parse_http_date("0").has_value());
+    REQUIRE_FALSE(parse_http_date("").has_value());
+    REQUIRE_FALSE(parse_http_date("Sun, 06 Nov 1994").has_value());
+}
+
+TEST_CASE("Freshness follows the caching headers", "[http_cache]") {
+    auto entry = HttpCache::from_response(200, headers({{"Cache-Control", "public, max-age=600"},
+                                                        {"Age", "100"},
+                                                        {"ETag", "\"v1\""}}), "body", kNow);
+    REQUIRE(entry);
+    REQUIRE(entry->fresh_until == kNow + 500);
+    REQUIRE(entry->etag == "\"v1\"");
+    REQUIRE(entry->body == "body");
+
+    // max-age wins over Expires; Expires counts from Date
+    REQUIRE(HttpCache::from_response(200, headers({{"Cache-Control", "max-age=60"},
+                                                   {"Expires", format_http_date(kNow + 3600)}}),
+                                     "", kNow)->fresh_until == kNow + 60);
+    REQUIRE(HttpCache::from_response(200, headers({{"Date", format_http_date(kNow - 100)},
+                                                   {"Expires", format_http_date(kNow + 3600)}}),
+                                     "", kNow)->fresh_until == kNow + 3700);
+    REQUIRE(HttpCache::from_response(200, headers({{"Expires", "0"}}), "", kNow)->fresh_until == kNow);
+
+    // Heuristic: a tenth of the time since the last change, capped
+    REQUIRE(HttpCache::from_response(200, headers({{"Last-Modified", format_http_date(kNow - 1000)}}),
+                                     "", kNow)->fresh_until == kNow + 100);
+    REQUIRE(HttpCache::from_response(200, headers({{"Last-Modified", format_http_date(kNow - 3000000)}}),
+                                     "", kNow)->fresh_until == kNow + HttpCache::kMaxHeuristicSeconds);
+
+    // Stored but always revalidated
+    auto no_cache = HttpCache::from_response(200, headers({{"Cache-Control", "no-cache, max-age=600"},
+                                                           {"Last-Modified", format_http_date(kNow - 1000)}}),
+                                             "", kNow);
+    REQUIRE(no_cache);
+    REQUIRE_FALSE(no_cache->fresh(kNow));
+    REQUIRE(no_cache->has_validators());
+
+    // Not stored at all
+    REQUIRE_FALSE(HttpCache::from_response(200, headers({{"Cache-Control", "private, No-Store"}}), "", kNow));
+    REQUIRE_FALSE(HttpCache::from_response(200, headers({{"Vary", "*"}}), "", kNow));
+    REQUIRE_FALSE(HttpCache::from_response(404, headers({}), "", kNow));
+}
+
+TEST_CASE("A 304 refreshes the stored entry", "[http_cache]") {
+    auto entry = HttpCache::from_response(200, headers({{"Cache-Control", "max-age=60"},
+                                                        {"ETag", "\"v1\""}}), "page", kNow);
+    REQUIRE(entry);
+
+    HttpCache::refresh(*entry, headers({{"Cache-Control", "max-age=120"}}), kNow + 1000);
+    REQUIRE(entry->fresh(kNow + 1100));
+    REQUIRE_FALSE(entry->fresh(kNow + 1120));
+    REQUIRE(entry->etag == "\"v1\"");
+    REQUIRE(entry->body == "page");
+
+    HttpCache::refresh(*entry, headers({{"ETag", "\"v2\""}}), kNow + 2000);
+    REQUIRE(entry->etag == "\"v2\"");
+    REQUIRE_FALSE(entry->fresh(kNow + 2000));
+}
+
+TEST_CASE("Entries persist and are evicted least recently used first", "[http_cache]") {
+    TempDir dir("http_cache");
+
+    HttpCache::Entry entry;
+    entry.content_type = "text/html";
+    entry.fresh_until = 42;
+    entry.body = std::string(1000, 'x') + std::string("\n\0tail", 6);
+    {
+        HttpCache cache(dir.path, 1 << 20);
+        REQUIRE_FALSE(cache.get("GET https://example.com/").has_value());
+        cache.put("GET https://example.com/", entry);
+    }
+    {
+        HttpCache cache(dir.path, 1 << 20);
+        auto loaded = cache.get("GET https://example.com/");
+        REQUIRE(loaded);
+        REQUIRE(loaded->body == entry.body);
+        REQUIRE(loaded->content_type == "text/html");
+        REQUIRE(loaded->fresh_until == 42);
+        REQUIRE_FALSE(cache.get("GET https://example.com/other").has_value());
+
+        cache.remove("GET https://example.com/");
+        REQUIRE_FALSE(cache.get("GET https://example.com/").has_value());
+        REQUIRE(cache.size_bytes() == 0);
+    }
+    {
+        // Room for about eight entries; touching "0" keeps it over newer ones
+        HttpCache cache(dir.path, 10000);
+        for (int i = 0; i < 12; ++i) {
+            cache.put(std::to_string(i), entry);
+            REQUIRE(cache.get("0").has_value());
+        }
+        REQUIRE(cache.size_bytes() <= 10000);
+        REQUIRE(cache.get("0").has_value());
+        REQUIRE(cache.get("11").has_value());
+        REQUIRE_FALSE(cache.get("1").has_value());
+
+        // Entries too large for the budget are not stored
+        HttpCache::Entry big;
+        big.body = std::string(2000, 'y');
+        cache.put("big", big);
+        REQUIRE_FALSE(cache.get("big").has_value());
+    }
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/image_cache.hpp"
+#include "gpagent/tools/base64.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+void write(const fs::path& path, const std::string& content) {
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+// Stands in for the Qt encoder: "encodes" by upper-casing, counting calls
+struct FakeEncoder {
+    int calls = 0;
+    ImageCache::Encoder fn() {
+        return [this](const std::string& content, int max_dimension) -> std::optional<ImageCache::Encoded> {
+            ++calls;
+            if (content == "broken") return std::nullopt;
+            std::string bytes = content;
+            for (char& c : bytes) c = static_cast<char>(std::toupper(c));
+            return ImageCache::Encoded{bytes, "image/png", max_dimension, max_dimension / 2, false};
+        };
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Images are encoded once per content", "[image_cache]") {
+    TempDir dir("image_cache");
+    ImageCache cache;
+    FakeEncoder encoder;
+
+    write(dir.path / "a.png", "pixels");
+    auto first = cache.load(dir.path / "a.png", 1568, encoder.fn());
+    REQUIRE(first.is_ok());
+    REQUIRE(*first.value()->base64 == base64_encode("PIXELS"));
+    REQUIRE(first.value()->encoded_size == 6);
+    REQUIRE(first.value()->width == 1568);
+
+    // Same file, and a copy under another name, share the payload
+    auto again = cache.load(dir.path / "a.png", 1568, encoder.fn());
+    fs::copy_file(dir.path / "a.png", dir.path / "b.png");
+    auto copy = cache.load(dir.path / "b.png", 1568, encoder.fn());
+    REQUIRE(encoder.calls == 1);
+    REQUIRE(again.value()->base64 == first.value()->base64);
+    REQUIRE(copy.value()->base64 == first.value()->base64);
+    REQUIRE(cache.find(first.value()->id) == first.value());
+
+    // A different size limit is a different image
+    auto smaller = cache.load(dir.path / "a.png", 800, encoder.fn());
+    REQUIRE(encoder.calls == 2);
+    REQUIRE(smaller.value()->id != first.value()->id);
+
+    // Rewritten content is re-encoded
+    write(dir.path / "a.png", "other pixels");
+    auto changed = cache.load(dir.path / "a.png", 1568, encoder.fn());
+    REQUIRE(encoder.calls == 3);
+    REQUIRE(*changed.value()->base64 == base64_encode("OTHER PIXELS"));
+}
+
+TEST_CASE("Image cache failures and eviction", "[image_cache]") {
+    TempDir dir("image_cache");
+    FakeEncoder encoder;
+
+    ImageCache cache(64);
+    REQUIRE(cache.load(dir.path / "missing.png", 1568, encoder.fn()).is_err());
+
+    write(dir.path / "broken.png", "broken");
+    REQUIRE(cache.load(dir.path / "broken.png", 1568, encoder.fn()).is_err());
+
+    // Each payload is 32 base64 bytes: only the two most recent fit
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3; ++i) {
+        auto path = dir.path / ("img" + std::to_string(i) + ".png");
+        write(path, std::string(22, 'a' + i));
+        auto image = cache.load(path, 1568, encoder.fn());
+        REQUIRE(image.is_ok());
+        ids.push_back(image.value()->id);
+    }
+    REQUIRE(cache.size_bytes() == 64);
+    REQUIRE(cache.find(ids[0]) == nullptr);
+    REQUIRE(cache.find(ids[1]) != nullptr);
+    REQUIRE(cache.find(ids[2]) != nullptr);
+}
@@ -0,0 +1,193 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/interpreter_pool.hpp"
+#include "temp_dir.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+using Language = InterpreterPool::Language;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kTimeoutMs = 10000;
+
+}  // namespace
+
+TEST_CASE("Interpreter pool runs Python snippets", "[interpreter_pool]") {
+    InterpreterPool pool;
+    auto first = pool.run(Language::Python, "print('hello')", "", {}, kTimeoutMs);
+    if (!first) return;  // no python3
+    REQUIRE(first->exit_code == 0);
+    REQUIRE(first->output == "hello\n");
+    REQUIRE_FALSE(first->timed_out);
+
+    REQUIRE(pool.run(Language::Python, "import sys; sys.exit(3)", "", {}, kTimeoutMs)->exit_code == 3);
+    REQUIRE(pool.run(Language::Python, "raise SystemExit", "", {}, kTimeoutMs)->exit_code == 0);
+
+    auto message = pool.run(Language::Python, "import sys; sys.exit('bad input')", "", {}, kTimeoutMs);
+    REQUIRE(message->exit_code == 1);
+    REQUIRE(message->output == "bad input\n");
+
+    auto error = pool.run(Language::Python, "def f():\n    raise ValueError('boom')\nf()", "", {},
+                          kTimeoutMs);
+    REQUIRE(error->exit_code == 1);
+    REQUIRE(error->output.find("ValueError: boom") != std::string::npos);
+    REQUIRE(error->output.find("<code>") != std::string::npos);
+
+    // stdout and stderr share one stream
+    auto both = pool.run(Language::Python, "import sys\nprint('out')\nprint('err', file=sys.stderr)",
+                         "", {}, kTimeoutMs);
+    REQUIRE(both->output == "out\nerr\n");
+}
+
+TEST_CASE("Interpreter pool frames large requests and responses", "[interpreter_pool]") {
+    InterpreterPool pool;
+    if (!pool.run(Language::Python, "pass", "", {}, kTimeoutMs)) return;
+
+    // A request well beyond a socket buffer, with text that needs escaping
+    std::string payload(1 << 20, 'x');
+    std::string code = "data = '" + payload + "'\nprint(len(data), '\"quoted\" \\\\ caf\xC3\xA9')";
+    auto large = pool.run(Language::Python, code, "", {}, kTimeoutMs);
+    REQUIRE(large->exit_code == 0);
+    REQUIRE(large->output == "1048576 \"quoted\" \\ caf\xC3\xA9\n");
+
+    // Output larger than the pipe is relayed while the snippet runs, and
+    // capped to its head and tail
+    auto chatty = pool.run(Language::Python, "print('a' * 300000)\nprint('end')", "", {}, kTimeoutMs);
+    REQUIRE(chatty->exit_code == 0);
+    REQUIRE(chatty->output.find("bytes omitted") != std::string::npos);
+    REQUIRE(chatty->output.size() < 120000);
+    REQUIRE(chatty->output.substr(chatty->output.size() - 4) == "end\n");
+
+    std::string streamed;
+    auto stream = pool.run(Language::Python, "print('one')\nprint('two')", "", {}, kTimeoutMs,
+                           [&](std::string_view chunk) { streamed.append(chunk); });
+    REQUIRE(stream->output == "one\ntwo\n");
+    REQUIRE(streamed == "one\ntwo\n");
+}
+
+TEST_CASE("Interpreter pool resets state between runs", "[interpreter_pool]") {
+    InterpreterPool pool;
+    if (!pool.run(Language::Python, "pass", "", {}, kTimeoutMs)) return;
+    TempDir dir("interpreter");
+
+    // Working directory and environment apply to one run only
+    auto env = pool.run(Language::Python, "import os\nprint(os.getcwd())\nprint(os.environ['GPAGENT_X'])",
+                        dir.path.string(), {{"GPAGENT_X", "set"}}, kTimeoutMs);
+    REQUIRE(env->output == fs::canonical(dir.path).string() + "\nset\n");
+    auto cleared = pool.run(Language::Python, "import os\nprint('GPAGENT_X' in os.environ)", "", {},
+                            kTimeoutMs);
+    REQUIRE(cleared->output == "False\n");
+
+    // Globals and builtins don't leak into the next snippet
+    pool.run(Language::Python, "import builtins\nbuiltins.leaked = 1\nglobal_value = 2", "", {}, kTimeoutMs);
+    auto fresh = pool.run(Language::Python,
+                          "import builtins\nprint(hasattr(builtins, 'leaked'), 'global_value' in globals())",
+                          "", {}, kTimeoutMs);
+    REQUIRE(fresh->output == "False False\n");
+
+    // Project modules are imported again, so edits between runs are seen
+    std::ofstream(dir.path / "helper.py") << "VALUE = 1\n";
+    auto before = pool.run(Language::Python, "import helper\nprint(helper.VALUE)", dir.path.string(), {},
+                           kTimeoutMs);
+    REQUIRE(before->output == "1\n");
+    std::ofstream(dir.path / "helper.py") << "VALUE = 2\n";
+    auto after = pool.run(Language::Python, "import helper\nprint(helper.VALUE)", dir.path.string(), {},
+                          kTimeoutMs);
+    REQUIRE(after->output == "2\n");
+}
+
+TEST_CASE("Interpreter pool recovers from timeouts and exits", "[interpreter_pool]") {
+    InterpreterPool pool;
+    if (!pool.run(Language::Python, "pass", "", {}, kTimeoutMs)) return;
+
+    auto start = std::chrono::steady_clock::now();
+    auto slow = pool.run(Language::Python, "print('started', flush=True)\nwhile True: pass", "", {}, 300);
+    REQUIRE(slow->timed_out);
+    REQUIRE(slow->output == "started\n");
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    // The interpreter ending itself loses only that worker
+    auto exited = pool.run(Language::Python, "import os\nos._exit(7)", "", {}, kTimeoutMs);
+    REQUIRE(exited->exit_code == 7);
+    REQUIRE_FALSE(exited->timed_out);
+
+    auto next = pool.run(Language::Python, "print('next')", "", {}, kTimeoutMs);
+    REQUIRE(next->exit_code == 0);
+    REQUIRE(next->output == "next\n");
+}
+
+TEST_CASE("Interpreter pool recycles workers that leave work running", "[interpreter_pool]") {
+    InterpreterPool pool;
+    if (!pool.run(Language::Python, "pass", "", {}, kTimeoutMs)) return;
+
+    SECTION("a background process") {
+        auto spawned = pool.run(Language::Python,
+                                "import subprocess\n"
+                                "subprocess.Popen(['sh', '-c', 'sleep 0.3; echo late'])\n"
+                                "print('spawned')",
+                                "", {}, kTimeoutMs);
+        REQUIRE(spawned->output == "spawned\n");
+    }
+
+    SECTION("a daemon thread") {
+        auto spawned = pool.run(Language::Python,
+                                "import threading, time\n"
+                                "def later():\n"
+                                "    time.sleep(0.3)\n"
+                                "    print('late')\n"
+                                "threading.Thread(target=later, daemon=True).start()\n"
+                                "print('spawned')",
+                                "", {}, kTimeoutMs);
+        REQUIRE(spawned->output == "spawned\n");
+    }
+
+    // Runs for longer than the leftover waits, on whichever worker is next
+    for (int i = 0; i < 3; ++i) {
+        auto next = pool.run(Language::Python, "import time\ntime.sleep(0.2)\nprint('clean')", "", {},
+                             kTimeoutMs);
+        REQUIRE(next->output == "clean\n");
+    }
+}
+
+TEST_CASE("Interpreter pool runs JavaScript snippets", "[interpreter_pool]") {
+    InterpreterPool pool;
+    auto first = pool.run(Language::JavaScript, "console.log('hello')", "", {}, kTimeoutMs);
+    if (!first) return;  // no node
+    REQUIRE(first->exit_code == 0);
+    REQUIRE(first->output == "hello\n");
+
+    REQUIRE(pool.run(Language::JavaScript, "process.exitCode = 4", "", {}, kTimeoutMs)->exit_code == 4);
+    auto thrown = pool.run(Language::JavaScript, "throw new Error('boom')", "", {}, kTimeoutMs);
+    REQUIRE(thrown->exit_code == 1);
+    REQUIRE(thrown->output.find("Error: boom") != std::string::npos);
+
+    // Timers and top-level await finish before the run does
+    auto timer = pool.run(Language::JavaScript,
+                          "setTimeout(() => console.log('timer'), 50);\n"
+                          "await new Promise((resolve) => setTimeout(resolve, 10));\n"
+                          "console.log('awaited');",
+                          "", {}, kTimeoutMs);
+    REQUIRE(timer->output == "awaited\ntimer\n");
+
+    // Project modules are loaded again on the next run
+    TempDir dir("interpreter");
+    std::ofstream(dir.path / "helper.js") << "module.exports = 1;\n";
+    auto before = pool.run(Language::JavaScript, "console.log(require('./helper.js'))",
+                           dir.path.string(), {}, kTimeoutMs);
+    REQUIRE(before->output == "1\n");
+    std::ofstream(dir.path / "helper.js") << "module.exports = 2;\n";
+    auto after = pool.run(Language::JavaScript, "console.log(require('./helper.js'))",
+                          dir.path.string(), {}, kTimeoutMs);
+    REQUIRE(after->output == "2\n");
+
+    auto slow = pool.run(Language::JavaScript, "while (true) {}", "", {}, 300);
+    REQUIRE(slow->timed_out);
+    REQUIRE(pool.run(Language::JavaScript, "console.log('next')", "", {}, kTimeoutMs)->output == "next\n");
+}
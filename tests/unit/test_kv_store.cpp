@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/memory/kv_store.hpp"
+#include "gpagent/memory/memory_manager.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace gpagent::memory;
+using gpagent::test::TempDir;
+
+namespace {
+
+std::vector<std::string> keys(const std::vector<KvStore::Item>& items) {
+    std::vector<std::string> out;
+    for (const auto& item : items) out.push_back(item.key);
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("Key-value store round trip and prefix scans", "[kv_store]") {
+    TempDir dir("kv");
+    {
+        auto opened = KvStore::open(dir.path / "memory.db");
+        REQUIRE(opened.is_ok());
+        auto store = opened.value();
+
+        // One store per file
+        REQUIRE(KvStore::open(dir.path / "." / "memory.db").value() == store);
+
+        REQUIRE(store->put("notes", "build", "cmake").is_ok());
+        REQUIRE(store->put("notes", "build_dir", "_build").is_ok());
+        REQUIRE(store->put("notes", "bug", "#12").is_ok());
+        REQUIRE(store->put("other", "build", "make").is_ok());
+        REQUIRE(store->put("notes", "build", std::string("ninja\0x", 7)).is_ok());
+
+        REQUIRE(*store->get("notes", "build").value() == std::string("ninja\0x", 7));
+        REQUIRE_FALSE(store->get("notes", "missing").value().has_value());
+
+        REQUIRE(keys(store->scan("notes").value()) == std::vector<std::string>{"bug", "build", "build_dir"});
+        REQUIRE(keys(store->scan("notes", "bui").value()) == std::vector<std::string>{"build", "build_dir"});
+        REQUIRE(keys(store->scan("notes", "", 1).value()) == std::vector<std::string>{"bug"});
+        REQUIRE(store->scan("notes", "x").value().empty());
+        REQUIRE(store->namespaces().value() == std::vector<std::string>{"notes", "other"});
+
+        REQUIRE(store->remove("notes", "bug").value());
+        REQUIRE_FALSE(store->remove("notes", "bug").value());
+
+        // A failed batch leaves nothing behind
+        auto rolled_back = store->batch([](KvStore& kv) {
+            kv.put("notes", "partial", "1");
+            return false;
+        });
+        REQUIRE(rolled_back.is_ok());
+        REQUIRE_FALSE(store->get("notes", "partial").value().has_value());
+
+        // As does one that throws, and later writes still commit
+        REQUIRE_THROWS(store->batch([](KvStore& kv) -> bool {
+            kv.put("notes", "thrown", "1");
+            throw std::runtime_error("import failed");
+        }));
+        REQUIRE_FALSE(store->get("notes", "thrown").value().has_value());
+        REQUIRE(store->batch([](KvStore& kv) { return kv.put("other", "after", "1").is_ok(); }).is_ok());
+    }
+    {
+        // Reopened from disk
+        auto store = KvStore::open(dir.path / "memory.db").value();
+        REQUIRE(keys(store->scan("notes").value()) == std::vector<std::string>{"build", "build_dir"});
+        REQUIRE(*store->get("other", "build").value() == "make");
+        REQUIRE(*store->get("other", "after").value() == "1");
+    }
+}
+
+TEST_CASE("Full-text search follows writes", "[kv_store]") {
+    TempDir dir("kv");
+    auto store = KvStore::open(dir.path / "memory.db").value();
+
+    store->put("project", "build_command", R"("Run cmake --build _build, then ctest")");
+    store->put("project", "style", R"("Four-space indent; snake_case functions")");
+    store->put("user", "editor", R"({"name": "Neovim", "plugins": ["telescope"]})");
+    store->put("user", "caf\xC3\xA9", "\"plain text with caf\xC3\xA9\"");
+
+    auto keys_of = [](const std::vector<KvStore::SearchHit>& hits) {
+        std::vector<std::string> out;
+        for (const auto& hit : hits) out.push_back(hit.key);
+        return out;
+    };
+
+    auto hits = store->search("how do I build?").value();
+    REQUIRE(hits.size() >= 1);
+    REQUIRE(hits[0].key == "build_command");
+    REQUIRE(hits[0].snippet.find("[cmake]") == std::string::npos);
+    REQUIRE(hits[0].snippet.find("[build]") != std::string::npos);
+
+    // Prefixes, JSON values, diacritics, namespaces and FTS syntax in the query
+    REQUIRE(keys_of(store->search("indent").value()) == std::vector<std::string>{"style"});
+    REQUIRE(keys_of(store->search("telesc").value()) == std::vector<std::string>{"editor"});
+    REQUIRE(keys_of(store->search("cafe").value()) == std::vector<std::string>{"caf\xC3\xA9"});
+    REQUIRE(store->search("build", "user").value().empty());
+    REQUIRE(store->search("\"NEAR(AND* -:").value().empty());
+    REQUIRE(store->search("  ").value().empty());
+
+    // All words when possible, otherwise the best partial matches
+    REQUIRE(keys_of(store->search("cmake ctest").value()) == std::vector<std::string>{"build_command"});
+    auto ranked = keys_of(store->search("snake_case indent build").value());
+    REQUIRE(ranked.size() == 2);
+    REQUIRE(ranked[0] == "style");
+
+    // Updates and deletes reach the index
+    store->put("project", "style", R"("Tabs")");
+    REQUIRE(store->search("indent").value().empty());
+    REQUIRE(keys_of(store->search("tabs").value()) == std::vector<std::string>{"style"});
+    store->remove("project", "style");
+    REQUIRE(store->search("tabs").value().empty());
+}
+
+TEST_CASE("Cross-thread memory imports its JSON file", "[kv_store]") {
+    TempDir dir("kv");
+    fs::create_directories(dir.path / "cross_thread");
+    std::ofstream(dir.path / "cross_thread" / "cross_thread.json")
+        << R"({"prefs": {"editor": "vim", "limits": {"lines": 80}}})";
+    {
+        CrossThreadMemory memory(dir.path);
+        REQUIRE(*memory.retrieve("prefs", "editor") == "vim");
+        REQUIRE((*memory.retrieve("prefs", "limits"))["lines"] == 80);
+        REQUIRE(memory.list_keys("prefs") == std::vector<std::string>{"editor", "limits"});
+        REQUIRE(fs::exists(dir.path / "cross_thread" / "cross_thread.json.imported"));
+
+        memory.store("prefs", "theme", "dark");
+        memory.remove("prefs", "editor");
+        REQUIRE(memory.save().is_ok());
+    }
+    {
+        CrossThreadMemory memory(dir.path);
+        REQUIRE(memory.list_keys("prefs") == std::vector<std::string>{"limits", "theme"});
+        REQUIRE(*memory.retrieve("prefs", "theme") == "dark");
+    }
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/line_diff.hpp"
+
+#include <random>
+
+using namespace gpagent::tools;
+
+TEST_CASE("Unified diff format", "[line_diff]") {
+    std::string a = "int main() {\n    one();\n    two();\n    three();\n    four();\n}\n";
+    std::string b = "int main() {\n    one();\n    TWO();\n    three();\n    four();\n}";
+
+    REQUIRE(unified_diff(a, a).empty());
+    REQUIRE(unified_diff(a, b, 1) ==
+            "@@ -2,5 +2,5 @@ int main() {\n"
+            "     one();\n"
+            "-    two();\n"
+            "+    TWO();\n"
+            "     three();\n"
+            "     four();\n"
+            "-}\n"
+            "+}\n"
+            "\\ No newline at end of file\n");
+
+    REQUIRE(unified_diff("", "x\n") == "@@ -0,0 +1 @@\n+x\n");
+    REQUIRE(unified_diff("x\n", "") == "@@ -1 +0,0 @@\n-x\n");
+}
+
+TEST_CASE("Line diff is a minimal edit script", "[line_diff]") {
+    std::mt19937 rng(7);
+    for (int round = 0; round < 200; ++round) {
+        std::string a, b;
+        int na = static_cast<int>(rng() % 30), nb = static_cast<int>(rng() % 30);
+        for (int i = 0; i < na; ++i) a += std::string(1, static_cast<char>('a' + rng() % 4)) + "\n";
+        for (int i = 0; i < nb; ++i) b += std::string(1, static_cast<char>('a' + rng() % 4)) + "\n";
+
+        LineDiff diff = diff_lines(a, b);
+
+        // Kept lines of both sides form the same sequence
+        std::vector<std::string_view> kept_a, kept_b;
+        size_t edits = 0;
+        for (size_t i = 0; i < diff.a.size(); ++i) {
+            if (diff.deleted[i]) ++edits; else kept_a.push_back(diff.a[i]);
+        }
+        for (size_t j = 0; j < diff.b.size(); ++j) {
+            if (diff.inserted[j]) ++edits; else kept_b.push_back(diff.b[j]);
+        }
+        REQUIRE(kept_a == kept_b);
+
+        // ...and are a longest common subsequence
+        std::vector<std::vector<size_t>> lcs(diff.a.size() + 1, std::vector<size_t>(diff.b.size() + 1, 0));
+        for (size_t i = diff.a.size(); i-- > 0;) {
+            for (size_t j = diff.b.size(); j-- > 0;) {
+                lcs[i][j] = diff.a[i] == diff.b[j] ? lcs[i + 1][j + 1] + 1
+                                                   : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+            }
+        }
+        REQUIRE(kept_a.size() == lcs[0][0]);
+        REQUIRE(edits == diff.a.size() + diff.b.size() - 2 * lcs[0][0]);
+    }
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/line_index.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+void write_file(const fs::path& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+std::vector<std::string> lines_of(LineIndex& index, size_t first, size_t count) {
+    std::vector<std::string> lines;
+    index.read_lines(first, count, [&](size_t, std::string_view text) {
+        lines.emplace_back(text);
+        return true;
+    });
+    return lines;
+}
+
+}  // namespace
+
+TEST_CASE("Line index reads line ranges", "[line_index]") {
+    TempDir dir("line_index");
+    fs::path file = dir.path / "lines.txt";
+
+    // Enough lines to need several checkpoints
+    std::string content;
+    const size_t total = LineIndex::kStride * 3 + 17;
+    for (size_t i = 0; i < total; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    content += "tail without newline";
+    write_file(file, content);
+
+    auto opened = LineIndex::open(file);
+    REQUIRE(opened.is_ok());
+    auto index = opened.value();
+    REQUIRE(index->size() == content.size());
+
+    REQUIRE(lines_of(*index, 0, 2) == std::vector<std::string>{"line 0", "line 1"});
+
+    // Around and across a stride boundary
+    size_t boundary = LineIndex::kStride * 2;
+    auto around = lines_of(*index, boundary - 1, 3);
+    REQUIRE(around == std::vector<std::string>{"line " + std::to_string(boundary - 1),
+                                               "line " + std::to_string(boundary),
+                                               "line " + std::to_string(boundary + 1)});
+
+    // Line numbers passed to the callback are absolute
+    std::vector<size_t> numbers;
+    index->read_lines(boundary + 5, 2, [&](size_t line, std::string_view) {
+        numbers.push_back(line);
+        return true;
+    });
+    REQUIRE(numbers == std::vector<size_t>{boundary + 5, boundary + 6});
+
+    // The last line has no newline; reads stop at the end
+    REQUIRE(lines_of(*index, total, 10) == std::vector<std::string>{"tail without newline"});
+    REQUIRE(index->read_lines(total + 1, 10, [](size_t, std::string_view) { return true; }) == 0);
+
+    // Returning false stops the visit
+    size_t visited = index->read_lines(0, 100, [](size_t line, std::string_view) { return line < 4; });
+    REQUIRE(visited == 5);
+}
+
+TEST_CASE("Line index handles empty lines and empty files", "[line_index]") {
+    TempDir dir("line_index");
+    fs::path file = dir.path / "sparse.txt";
+    write_file(file, "\n\nthird\n");
+
+    auto index = LineIndex::open(file).value();
+    REQUIRE(lines_of(*index, 0, 10) == std::vector<std::string>{"", "", "third"});
+
+    fs::path empty = dir.path / "empty.txt";
+    write_file(empty, "");
+    auto empty_index = LineIndex::open(empty).value();
+    REQUIRE(lines_of(*empty_index, 0, 10).empty());
+
+    REQUIRE(LineIndex::open(dir.path / "missing.txt").is_err());
+}
+
+TEST_CASE("Line index cache is keyed by the file stamp", "[line_index]") {
+    TempDir dir("line_index");
+    fs::path file = dir.path / "cached.txt";
+    write_file(file, "one\ntwo\n");
+
+    auto first = LineIndex::open(file).value();
+    auto again = LineIndex::open(file).value();
+    REQUIRE(first == again);
+
+    // A different spelling of the same path hits the same entry
+    auto relative = LineIndex::open(dir.path / "." / "cached.txt").value();
+    REQUIRE(relative == first);
+
+    SECTION("a size change rebuilds the index") {
+        write_file(file, "one\ntwo\nthree\n");
+        auto rebuilt = LineIndex::open(file).value();
+        REQUIRE(rebuilt != first);
+        REQUIRE(lines_of(*rebuilt, 2, 1) == std::vector<std::string>{"three"});
+        // The old index still reads the content it was built from
+        REQUIRE(lines_of(*first, 0, 10) == std::vector<std::string>{"one", "two"});
+    }
+
+    SECTION("an mtime change rebuilds the index") {
+        auto mtime = fs::last_write_time(file);
+        write_file(file, "ONE\nTWO\n");
+        fs::last_write_time(file, mtime + std::chrono::seconds(1));
+        auto rebuilt = LineIndex::open(file).value();
+        REQUIRE(rebuilt != first);
+        REQUIRE(lines_of(*rebuilt, 0, 1) == std::vector<std::string>{"ONE"});
+    }
+
+    SECTION("a same-size rename within one mtime rebuilds the index") {
+        fs::path replacement = dir.path / "replacement.txt";
+        write_file(replacement, "uno\ndos\n");
+        fs::last_write_time(replacement, fs::last_write_time(file));
+        fs::rename(replacement, file);
+
+        auto rebuilt = LineIndex::open(file).value();
+        REQUIRE(rebuilt != first);
+        REQUIRE(rebuilt->stamp().size == first->stamp().size);
+        REQUIRE(rebuilt->stamp().mtime_ns == first->stamp().mtime_ns);
+        REQUIRE(rebuilt->stamp().ino != first->stamp().ino);
+        REQUIRE(lines_of(*rebuilt, 0, 1) == std::vector<std::string>{"uno"});
+    }
+}
+
+TEST_CASE("Line index stamps compare every field", "[line_index]") {
+    LineIndex::Stamp base{100, 1'000'000'000, 1, 42};
+
+    auto size = base;
+    size.size++;
+    auto mtime = base;
+    mtime.mtime_ns++;
+    auto dev = base;
+    dev.dev++;
+    auto ino = base;
+    ino.ino++;
+
+    REQUIRE(base == LineIndex::Stamp{100, 1'000'000'000, 1, 42});
+    REQUIRE_FALSE(base == size);
+    REQUIRE_FALSE(base == mtime);
+    REQUIRE_FALSE(base == dev);
+    REQUIRE_FALSE(base == ino);
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/memory/message_journal.hpp"
+#include "gpagent/memory/transcript.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+#include <iterator>
+
+using namespace gpagent::memory;
+using gpagent::test::TempDir;
+
+namespace {
+
+std::vector<std::string> contents(const ThreadMemory& thread) {
+    std::vector<std::string> out;
+    for (const auto& msg : thread.messages()) out.push_back(msg.content);
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("Message journal replays appends on top of the snapshot", "[message_journal]") {
+    TempDir dir("wal");
+    uint64_t after_two = 0;
+    {
+        auto opened = MessageJournal::open(dir.path);
+        REQUIRE(opened.is_ok());
+        auto& journal = opened.value().journal;
+        REQUIRE(opened.value().thread.empty());
+
+        REQUIRE(journal->append(Message::user("one")).is_ok());
+        REQUIRE(journal->append(Message::assistant("two")).is_ok());
+        after_two = journal->journal_bytes();
+        REQUIRE(journal->sync().is_ok());
+
+        // Only the journal grows: the snapshot is untouched until compaction
+        REQUIRE_FALSE(fs::exists(dir.path / MessageJournal::kSnapshotFile));
+    }
+
+    auto reopened = MessageJournal::open(dir.path);
+    REQUIRE(reopened.is_ok());
+    REQUIRE(contents(reopened.value().thread) == std::vector<std::string>{"one", "two"});
+    REQUIRE(reopened.value().replayed == 2);
+    REQUIRE(reopened.value().discarded_bytes == 0);
+    REQUIRE(reopened.value().journal->journal_bytes() == after_two);
+
+    // Readers see the same thread without opening the journal
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"one", "two"});
+    REQUIRE(MessageJournal::read(dir.path / "missing").is_err());
+
+    reopened.value().journal.reset();
+}
+
+TEST_CASE("Message journal cuts a torn tail on recovery", "[message_journal]") {
+    TempDir dir("wal");
+    {
+        auto journal = std::move(MessageJournal::open(dir.path).value().journal);
+        journal->append(Message::user("kept"));
+        journal->append(Message::user("torn"));
+    }
+
+    // A crash in the middle of the last write
+    fs::path wal = dir.path / MessageJournal::kJournalFile;
+    auto full = fs::file_size(wal);
+    fs::resize_file(wal, full - 3);
+
+    {
+        auto recovered = MessageJournal::open(dir.path);
+        REQUIRE(recovered.is_ok());
+        REQUIRE(contents(recovered.value().thread) == std::vector<std::string>{"kept"});
+        REQUIRE(recovered.value().discarded_bytes > 0);
+
+        // Appends after recovery land right behind the last intact record
+        REQUIRE(recovered.value().journal->append(Message::user("after")).is_ok());
+    }
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"kept", "after"});
+
+    // A flipped byte fails the checksum and ends the replay there
+    {
+        std::fstream file(wal, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-2, std::ios::end);
+        file.put('X');
+    }
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"kept"});
+}
+
+TEST_CASE("Message journal snapshots fold the journal into a transcript", "[message_journal]") {
+    TempDir dir("wal");
+    MessageJournal::Options options;
+    options.snapshot_bytes = 200;
+    {
+        auto journal = std::move(MessageJournal::open(dir.path, options).value().journal);
+        ThreadMemory thread;
+        while (!journal->wants_snapshot()) {
+            thread.append(Message::user("message " + std::to_string(thread.size())));
+            REQUIRE(journal->append(thread.messages().back()).is_ok());
+        }
+
+        thread.trim(2);
+        REQUIRE(journal->snapshot(thread).is_ok());
+        REQUIRE_FALSE(journal->wants_snapshot());
+        REQUIRE(journal->append(Message::assistant("after snapshot")).is_ok());
+    }
+
+    // The snapshot is a transcript of the trimmed thread
+    REQUIRE(Transcript::open(dir.path / MessageJournal::kSnapshotFile).value().size() == 2);
+
+    auto recovered = MessageJournal::open(dir.path);
+    REQUIRE(recovered.is_ok());
+    REQUIRE(recovered.value().thread.size() == 3);
+    REQUIRE(recovered.value().replayed == 1);
+    REQUIRE(recovered.value().thread.messages().back().content == "after snapshot");
+    recovered.value().journal.reset();
+}
+
+TEST_CASE("Message journal drops records a newer snapshot already holds", "[message_journal]") {
+    TempDir dir("wal");
+    {
+        auto journal = std::move(MessageJournal::open(dir.path).value().journal);
+        journal->append(Message::user("one"));
+    }
+    std::string stale_journal;
+    {
+        std::ifstream in(dir.path / MessageJournal::kJournalFile, std::ios::binary);
+        stale_journal.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        auto recovered = MessageJournal::open(dir.path);
+        ThreadMemory thread = std::move(recovered.value().thread);
+        REQUIRE(recovered.value().journal->snapshot(thread).is_ok());
+    }
+
+    // A crash between writing the snapshot and resetting the journal
+    {
+        std::ofstream out(dir.path / MessageJournal::kJournalFile, std::ios::binary | std::ios::trunc);
+        out << stale_journal;
+    }
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"one"});
+
+    fs::remove(dir.path / MessageJournal::kJournalFile);
+    auto recovered = MessageJournal::open(dir.path);
+    REQUIRE(contents(recovered.value().thread) == std::vector<std::string>{"one"});
+    REQUIRE(fs::exists(dir.path / MessageJournal::kJournalFile));
+    recovered.value().journal.reset();
+}
+
+TEST_CASE("Message journal extends a thread.jsonl from before transcripts", "[message_journal]") {
+    TempDir dir("wal");
+    ThreadMemory legacy;
+    legacy.append(Message::user("old"));
+    REQUIRE(legacy.save(dir.path / MessageJournal::kLegacySnapshotFile).is_ok());
+
+    {
+        auto recovered = MessageJournal::open(dir.path);
+        REQUIRE(recovered.is_ok());
+        REQUIRE(contents(recovered.value().thread) == std::vector<std::string>{"old"});
+        REQUIRE(recovered.value().journal->append(Message::user("new")).is_ok());
+    }
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"old", "new"});
+
+    // The first snapshot replaces it with a transcript
+    {
+        auto recovered = MessageJournal::open(dir.path);
+        REQUIRE(recovered.value().journal->snapshot(recovered.value().thread).is_ok());
+    }
+    REQUIRE_FALSE(fs::exists(dir.path / MessageJournal::kLegacySnapshotFile));
+    REQUIRE(contents(MessageJournal::read(dir.path).value()) == std::vector<std::string>{"old", "new"});
+}
@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/output_buffer.hpp"
+
+#include <vector>
+
+using namespace gpagent::tools;
+
+namespace {
+
+std::string marker(size_t omitted) {
+    return "\n... [" + std::to_string(omitted) + " bytes omitted] ...\n";
+}
+
+}  // namespace
+
+TEST_CASE("Output buffer keeps head and tail", "[output_buffer]") {
+    SECTION("output that fits is kept whole") {
+        OutputBuffer buffer(4, 4);
+        REQUIRE(buffer.empty());
+        buffer.append("abcd");
+        buffer.append("efgh");
+        REQUIRE(buffer.total_size() == 8);
+        REQUIRE(buffer.omitted() == 0);
+        REQUIRE(buffer.str() == "abcdefgh");
+    }
+
+    SECTION("one byte over the limits is reported") {
+        OutputBuffer buffer(4, 4);
+        buffer.append("abcdefghi");
+        REQUIRE(buffer.omitted() == 1);
+        REQUIRE(buffer.str() == "abcd" + marker(1) + "fghi");
+    }
+
+    SECTION("a large write keeps only its last bytes") {
+        OutputBuffer buffer(4, 4);
+        buffer.append("abcd");
+        buffer.append("0123456789");
+        REQUIRE(buffer.omitted() == 6);
+        REQUIRE(buffer.str() == "abcd" + marker(6) + "6789");
+    }
+
+    SECTION("small writes wrap the tail ring in order") {
+        OutputBuffer buffer(2, 3);
+        for (std::string_view chunk : {"ab", "cde", "f", "gh", "i"}) {
+            buffer.append(chunk);
+        }
+        REQUIRE(buffer.total_size() == 9);
+        REQUIRE(buffer.omitted() == 4);
+        REQUIRE(buffer.str() == "ab" + marker(4) + "ghi");
+    }
+
+    SECTION("zero limits") {
+        OutputBuffer head_only(3, 0);
+        head_only.append("abcdef");
+        REQUIRE(head_only.str() == "abc" + marker(3));
+
+        OutputBuffer tail_only(0, 3);
+        tail_only.append("abc");
+        tail_only.append("def");
+        REQUIRE(tail_only.str() == marker(3) + "def");
+    }
+}
+
+TEST_CASE("Output buffer cuts at UTF-8 boundaries", "[output_buffer]") {
+    const std::string e_acute = "\xC3\xA9";
+    const std::string euro = "\xE2\x82\xAC";
+    const std::string grin = "\xF0\x9F\x98\x80";
+
+    SECTION("a character completed by the head cut is kept") {
+        OutputBuffer buffer(3, 2);
+        buffer.append("a" + e_acute + "0123456789");
+        REQUIRE(buffer.str() == "a" + e_acute + marker(8) + "89");
+
+        OutputBuffer wide(5, 1);
+        wide.append("a" + grin + "xyz");
+        REQUIRE(wide.str() == "a" + grin + marker(2) + "z");
+    }
+
+    SECTION("a character split by the head cut is dropped") {
+        OutputBuffer buffer(2, 2);
+        buffer.append("a" + e_acute + "bcdef");
+        REQUIRE(buffer.str() == "a" + marker(4) + "ef");
+
+        OutputBuffer wide(3, 1);
+        wide.append("a" + grin + "z");
+        REQUIRE(wide.str() == "a" + marker(2) + "z");
+    }
+
+    SECTION("a character split by the tail cut is dropped") {
+        OutputBuffer buffer(1, 3);
+        buffer.append("abbbb" + euro + "z");
+        REQUIRE(buffer.str() == "a" + marker(5) + "z");
+    }
+}
+
+TEST_CASE("Output batcher delivers batches", "[output_buffer]") {
+    std::vector<std::string> chunks;
+    auto collect = [&](std::string_view chunk) { chunks.emplace_back(chunk); };
+
+    SECTION("partial lines wait for the batch") {
+        OutputBatcher batcher(collect, std::chrono::hours(1));
+        REQUIRE(batcher.enabled());
+        REQUIRE(batcher.due_in_ms() == -1);
+
+        batcher.append("par");
+        batcher.append("tial\nline");
+        batcher.flush_if_due();
+        REQUIRE(chunks.empty());
+        REQUIRE(batcher.due_in_ms() > 0);
+
+        batcher.flush();
+        REQUIRE(chunks == std::vector<std::string>{"partial\nline"});
+        REQUIRE(batcher.due_in_ms() == -1);
+
+        // Nothing pending: no empty callback
+        batcher.flush();
+        REQUIRE(chunks.size() == 1);
+    }
+
+    SECTION("due batches are flushed") {
+        OutputBatcher batcher(collect, std::chrono::milliseconds(0));
+        batcher.append("now");
+        REQUIRE(batcher.due_in_ms() == 0);
+        batcher.flush_if_due();
+        REQUIRE(chunks == std::vector<std::string>{"now"});
+    }
+
+    SECTION("only the newest bytes are kept") {
+        OutputBatcher batcher(collect, std::chrono::hours(1), 4);
+        batcher.append("ab");
+        batcher.append("cdef");
+        batcher.flush();
+        REQUIRE(chunks == std::vector<std::string>{"cdef"});
+    }
+
+    SECTION("trimming does not start inside a character") {
+        OutputBatcher whole(collect, std::chrono::hours(1), 3);
+        whole.append("ab\xE2\x82\xAC");
+        whole.flush();
+
+        OutputBatcher split(collect, std::chrono::hours(1), 3);
+        split.append("\xE2\x82\xAC" "z");
+        split.flush();
+
+        REQUIRE(chunks == std::vector<std::string>{"\xE2\x82\xAC", "z"});
+    }
+
+    SECTION("a batcher without a callback is disabled") {
+        OutputBatcher batcher(nullptr);
+        REQUIRE_FALSE(batcher.enabled());
+        batcher.append("ignored");
+        REQUIRE(batcher.due_in_ms() == -1);
+    }
+}
@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/pdf_text.hpp"
+#include "temp_dir.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+void write(const fs::path& path, const std::string& content) {
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+// "PDF" whose content is its page count; page text names the page
+struct FakePdf : PdfSource {
+    int pages;
+    std::atomic<int>* extracted;
+    FakePdf(int pages, std::atomic<int>* extracted) : pages(pages), extracted(extracted) {}
+    int page_count() const override { return pages; }
+    std::string page_text(int page) override {
+        ++*extracted;
+        return "text of page " + std::to_string(page);
+    }
+};
+
+struct FakeOpener {
+    std::atomic<int> opened{0};
+    std::atomic<int> extracted{0};
+    PdfOpener fn() {
+        return [this](const std::string& content) -> std::unique_ptr<PdfSource> {
+            ++opened;
+            if (content == "broken") return nullptr;
+            return std::make_unique<FakePdf>(std::stoi(content), &extracted);
+        };
+    }
+};
+
+}  // namespace
+
+TEST_CASE("PDF pages are extracted once", "[pdf_text]") {
+    TempDir dir("pdf_text");
+    write(dir.path / "spec.pdf", "500");
+    FakeOpener opener;
+
+    PdfTextCache cache(dir.path / "cache", PdfTextCache::kDefaultMaxBytes);
+    auto first = cache.read(dir.path / "spec.pdf", 10, 40, opener.fn());
+    REQUIRE(first.is_ok());
+    REQUIRE(first.value().total_pages == 500);
+    REQUIRE(first.value().pages.size() == 40);
+    REQUIRE(first.value().pages.front().number == 10);
+    REQUIRE(first.value().pages.back().text == "text of page 49");
+    REQUIRE(first.value().extracted == 40);
+    REQUIRE(opener.extracted == 40);
+
+    // Overlapping range: only the new pages are extracted
+    auto overlap = cache.read(dir.path / "spec.pdf", 40, 20, opener.fn());
+    REQUIRE(overlap.value().extracted == 10);
+    REQUIRE(overlap.value().pages[0].text == "text of page 40");
+    REQUIRE(overlap.value().pages[19].text == "text of page 59");
+
+    // Cached pages need no parsing, after a restart or under another name
+    int opened = opener.opened;
+    PdfTextCache restarted(dir.path / "cache", PdfTextCache::kDefaultMaxBytes);
+    fs::copy_file(dir.path / "spec.pdf", dir.path / "copy.pdf");
+    auto again = restarted.read(dir.path / "copy.pdf", 20, 30, opener.fn());
+    REQUIRE(again.value().extracted == 0);
+    REQUIRE(again.value().pages[5].text == "text of page 25");
+    REQUIRE(opener.opened == opened);
+    REQUIRE(opener.extracted == 50);
+}
+
+TEST_CASE("PDF page ranges are clamped", "[pdf_text]") {
+    TempDir dir("pdf_text");
+    write(dir.path / "short.pdf", "3");
+    write(dir.path / "broken.pdf", "broken");
+    FakeOpener opener;
+
+    // No directory: nothing is stored, requested pages are still extracted
+    PdfTextCache cache("", PdfTextCache::kDefaultMaxBytes);
+    auto tail = cache.read(dir.path / "short.pdf", 1, 100, opener.fn());
+    REQUIRE(tail.value().pages.size() == 2);
+    REQUIRE(tail.value().total_pages == 3);
+    REQUIRE(cache.read(dir.path / "short.pdf", 7, 5, opener.fn()).value().pages.empty());
+    REQUIRE(cache.read(dir.path / "short.pdf", -4, 1, opener.fn()).value().pages[0].number == 0);
+
+    REQUIRE(cache.read(dir.path / "broken.pdf", 0, 1, opener.fn()).is_err());
+    REQUIRE(cache.read(dir.path / "missing.pdf", 0, 1, opener.fn()).is_err());
+}
+
+TEST_CASE("A worker that cannot parse the PDF fails the read", "[pdf_text]") {
+    TempDir dir("pdf_text");
+    write(dir.path / "spec.pdf", "100");
+    FakeOpener opener;
+
+    // Only the first parse succeeds, so every extra worker fails
+    std::atomic<int> opens{0};
+    PdfOpener first_only = [&](const std::string& content) -> std::unique_ptr<PdfSource> {
+        if (opens++ > 0) return nullptr;
+        return opener.fn()(content);
+    };
+
+    PdfTextCache cache(dir.path / "cache", PdfTextCache::kDefaultMaxBytes);
+    auto partial = cache.read(dir.path / "spec.pdf", 0, 100, first_only);
+    if (std::thread::hardware_concurrency() > 1) {
+        REQUIRE(partial.is_err());
+    }
+
+    // A retry extracts only what is still missing
+    int extracted = opener.extracted;
+    auto retried = cache.read(dir.path / "spec.pdf", 0, 100, opener.fn());
+    REQUIRE(retried.is_ok());
+    REQUIRE(retried.value().pages[99].text == "text of page 99");
+    REQUIRE(retried.value().extracted == 100 - extracted);
+}
+
+TEST_CASE("Least recently read PDFs are evicted", "[pdf_text]") {
+    TempDir dir("pdf_text");
+    FakeOpener opener;
+    PdfTextCache cache(dir.path / "cache", 400);
+
+    for (int pages : {10, 11, 12}) {
+        auto path = dir.path / (std::to_string(pages) + ".pdf");
+        write(path, std::to_string(pages));
+        REQUIRE(cache.read(path, 0, pages, opener.fn()).is_ok());
+    }
+    REQUIRE(cache.size_bytes() <= 400);
+
+    // The oldest document is gone and gets extracted again
+    auto oldest = cache.read(dir.path / "10.pdf", 0, 10, opener.fn());
+    REQUIRE(oldest.value().extracted == 10);
+    auto newest = cache.read(dir.path / "12.pdf", 0, 12, opener.fn());
+    REQUIRE(newest.value().extracted == 0);
+}
@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/piece_table.hpp"
+
+#include <random>
+
+using namespace gpagent::tools;
+
+TEST_CASE("Piece table edits", "[piece_table]") {
+    std::string original = "alpha beta gamma beta delta";
+    PieceTable doc(original);
+
+    doc.replace(doc.find("beta"), 4, "BETA");
+    REQUIRE(doc.to_string() == "alpha BETA gamma beta delta");
+
+    REQUIRE(doc.replace_all("a", "4") == 6);
+    REQUIRE(doc.to_string() == "4lph4 BETA g4mm4 bet4 delt4");
+
+    // Matches spanning pieces
+    REQUIRE(doc.find("4 BETA g4") == 4);
+    REQUIRE(doc.find("g4mm4 bet4") == 11);
+    REQUIRE(doc.find("missing") == std::string::npos);
+
+    doc.replace(0, 0, ">> ");
+    doc.replace(doc.size(), 0, " <<");
+    REQUIRE(doc.to_string() == ">> 4lph4 BETA g4mm4 bet4 delt4 <<");
+    REQUIRE(doc.size() == doc.to_string().size());
+}
+
+TEST_CASE("Piece table matches std::string under random edits", "[piece_table]") {
+    std::mt19937 rng(42);
+    auto random_text = [&](size_t n) {
+        std::string s;
+        for (size_t i = 0; i < n; ++i) s.push_back("abc\n"[rng() % 4]);
+        return s;
+    };
+
+    for (int round = 0; round < 200; ++round) {
+        std::string original = random_text(rng() % 64);
+        std::string expected = original;
+        PieceTable doc(original);
+
+        for (int step = 0; step < 12; ++step) {
+            std::string needle = random_text(1 + rng() % 3);
+            std::string text = random_text(rng() % 4);
+
+            REQUIRE(doc.find(needle) == expected.find(needle));
+
+            if (rng() % 2) {
+                size_t count = 0;
+                for (size_t pos = expected.find(needle); pos != std::string::npos;
+                     pos = expected.find(needle, pos + text.size())) {
+                    expected.replace(pos, needle.size(), text);
+                    count++;
+                }
+                REQUIRE(doc.replace_all(needle, text) == count);
+            } else if (size_t pos = expected.find(needle); pos != std::string::npos) {
+                expected.replace(pos, needle.size(), text);
+                doc.replace(pos, needle.size(), text);
+            }
+            REQUIRE(doc.to_string() == expected);
+        }
+    }
+}
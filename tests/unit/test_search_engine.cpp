@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/search_engine.hpp"
+
+#include <vector>
+
+using namespace gpagent::tools;
+
+namespace {
+
+std::vector<size_t> matching_lines(const std::string& pattern, const std::string& text) {
+    auto compiled = SearchPattern::compile(pattern);
+    REQUIRE(compiled.is_ok());
+
+    std::vector<size_t> lines;
+    Searcher searcher(compiled.value());
+    searcher.search(text, [&](size_t line, std::string_view) {
+        lines.push_back(line);
+        return true;
+    });
+    return lines;
+}
+
+}  // namespace
+
+TEST_CASE("Literal patterns use the prefilter", "[search]") {
+    auto compiled = SearchPattern::compile("needle");
+    REQUIRE(compiled.is_ok());
+    REQUIRE(compiled.value().is_literal());
+
+    auto lines = matching_lines("needle", "hay\nneedle here\nhay\nmore needle\n");
+    REQUIRE(lines == std::vector<size_t>{2, 4});
+}
+
+TEST_CASE("Regex features match like std::regex", "[search]") {
+    REQUIRE(matching_lines("^foo", "foo\nbarfoo\nfoo bar") == std::vector<size_t>{1, 3});
+    REQUIRE(matching_lines("bar$", "foobar\nbar baz\n") == std::vector<size_t>{1});
+    REQUIRE(matching_lines("\\bint\\b", "int x;\nprint(x)\nuint8_t\n(int)") == std::vector<size_t>{1, 4});
+    REQUIRE(matching_lines("colou?r", "color\ncolour\ncolr") == std::vector<size_t>{1, 2});
+    REQUIRE(matching_lines("[0-9]{3}-[0-9]{4}", "555-1234\n55-1234\n") == std::vector<size_t>{1});
+    REQUIRE(matching_lines("(get|set)_value", "get_value\nset_value\nput_value") == std::vector<size_t>{1, 2});
+    REQUIRE(matching_lines("^$", "a\n\nb\n") == std::vector<size_t>{2});
+}
+
+TEST_CASE("Pathological patterns do not backtrack", "[search]") {
+    std::string line(5000, 'a');
+    auto lines = matching_lines("(a*)*b", line);
+    REQUIRE(lines.empty());
+}
+
+TEST_CASE("Unsupported features fall back to std::regex", "[search]") {
+    auto compiled = SearchPattern::compile("(a)\\1");
+    REQUIRE(compiled.is_ok());
+    REQUIRE(compiled.value().uses_fallback());
+
+    REQUIRE(matching_lines("(a)\\1", "aa\nab") == std::vector<size_t>{1});
+}
+
+TEST_CASE("Invalid patterns are rejected", "[search]") {
+    REQUIRE(SearchPattern::compile("(unclosed").is_err());
+    REQUIRE(SearchPattern::compile("[z-a]").is_err());
+}
+
+TEST_CASE("Binary detection", "[search]") {
+    REQUIRE_FALSE(is_binary_content("plain text\n"));
+    REQUIRE(is_binary_content(std::string("abc\0def", 7)));
+}
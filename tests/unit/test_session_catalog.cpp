@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/memory/session_catalog.hpp"
+#include "gpagent/memory/memory_manager.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+
+using namespace gpagent::memory;
+using gpagent::test::TempDir;
+
+namespace {
+
+SessionCatalog::Entry entry(const std::string& id, int created, int updated, size_t messages) {
+    return SessionCatalog::Entry{id, TimePoint{std::chrono::seconds{created}}, TimePoint{std::chrono::seconds{updated}},
+                                 "preview " + id, messages, messages * 10};
+}
+
+std::vector<std::string> ids(const std::vector<SessionCatalog::Entry>& entries) {
+    std::vector<std::string> out;
+    for (const auto& e : entries) out.push_back(e.id);
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("Session catalog sorts and pages entries", "[session_catalog]") {
+    TempDir dir("catalog");
+    {
+        auto opened = SessionCatalog::open(dir.path / "sessions.db");
+        REQUIRE(opened.is_ok());
+        auto& catalog = *opened.value();
+
+        REQUIRE(catalog.put_all({entry("a", 1, 40, 3), entry("b", 2, 10, 9), entry("c", 3, 30, 1)}).is_ok());
+        REQUIRE(catalog.put(entry("d", 4, 20, 5)).is_ok());
+        REQUIRE(catalog.count().value() == 4);
+
+        REQUIRE(ids(catalog.list().value()) == std::vector<std::string>{"a", "c", "d", "b"});
+
+        SessionCatalog::Query page;
+        page.limit = 2;
+        REQUIRE(ids(catalog.list(page).value()) == std::vector<std::string>{"a", "c"});
+        page.offset = 2;
+        REQUIRE(ids(catalog.list(page).value()) == std::vector<std::string>{"d", "b"});
+        page.offset = 4;
+        REQUIRE(catalog.list(page).value().empty());
+
+        SessionCatalog::Query by_created;
+        by_created.sort = SessionCatalog::SortKey::CreatedAt;
+        by_created.descending = false;
+        REQUIRE(ids(catalog.list(by_created).value()) == std::vector<std::string>{"a", "b", "c", "d"});
+
+        SessionCatalog::Query by_messages;
+        by_messages.sort = SessionCatalog::SortKey::MessageCount;
+        REQUIRE(ids(catalog.list(by_messages).value()) == std::vector<std::string>{"b", "d", "a", "c"});
+
+        // Updates replace the entry in place
+        REQUIRE(catalog.put(entry("b", 2, 50, 10)).is_ok());
+        auto first = catalog.list().value().front();
+        REQUIRE(first.id == "b");
+        REQUIRE(first.message_count == 10);
+        REQUIRE(first.tokens == 100);
+        REQUIRE(first.preview == "preview b");
+        REQUIRE(first.updated_at == TimePoint{std::chrono::seconds{50}});
+
+        REQUIRE(catalog.remove("b").value());
+        REQUIRE_FALSE(catalog.remove("b").value());
+    }
+
+    auto reopened = SessionCatalog::open(dir.path / "sessions.db");
+    REQUIRE(reopened.value()->count().value() == 3);
+}
+
+TEST_CASE("Memory manager keeps the session catalog current", "[session_catalog]") {
+    TempDir dir("catalog");
+    MemoryConfig config;
+    config.storage_path = dir.path.string();
+    config.auto_checkpoint = false;
+    {
+        MemoryManager manager(config);
+        REQUIRE(manager.start_session("first").is_ok());
+        manager.append_message(Message::user("Fix the build"));
+        manager.append_message(Message::assistant("Done"));
+        REQUIRE(manager.end_session().is_ok());
+
+        REQUIRE(manager.start_session("second").is_ok());
+        REQUIRE(manager.session_count() == 2);
+        REQUIRE(manager.end_session().is_ok());
+
+        auto sessions = manager.list_sessions();
+        REQUIRE(sessions.size() == 2);
+        auto first = std::find_if(sessions.begin(), sessions.end(), [](const auto& s) { return s.id == "first"; });
+        REQUIRE(first != sessions.end());
+        REQUIRE(first->preview == "Fix the build");
+        REQUIRE(first->message_count == 2);
+        REQUIRE(first->tokens > 0);
+    }
+
+    // Sessions saved before the catalog existed are imported on first use
+    fs::remove(session_catalog_path(dir.path));
+    MemoryManager manager(config);
+    REQUIRE(manager.session_count() == 2);
+    SessionCatalog::Query query;
+    query.sort = SessionCatalog::SortKey::MessageCount;
+    query.limit = 1;
+    auto top = manager.list_sessions(query);
+    REQUIRE(top.size() == 1);
+    REQUIRE(top.front().id == "first");
+}
+
+TEST_CASE("Memory manager reconciles the catalog with the session directories", "[session_catalog]") {
+    TempDir dir("catalog");
+    MemoryConfig config;
+    config.storage_path = dir.path.string();
+    config.auto_checkpoint = false;
+    {
+        MemoryManager manager(config);
+        for (const char* id : {"first", "second"}) {
+            REQUIRE(manager.start_session(id).is_ok());
+            manager.append_message(Message::user(std::string("Session ") + id));
+            REQUIRE(manager.end_session().is_ok());
+        }
+    }
+
+    // Changed behind the catalog's back: one session copied in, one deleted
+    fs::path sessions = dir.path / "sessions";
+    fs::copy(sessions / "first", sessions / "copied", fs::copy_options::recursive);
+    fs::remove_all(sessions / "second");
+
+    MemoryManager manager(config);
+    REQUIRE(manager.session_count() == 2);
+    auto listed = manager.list_sessions();
+    std::vector<std::string> names;
+    for (const auto& s : listed) names.push_back(s.id);
+    std::sort(names.begin(), names.end());
+    REQUIRE(names == std::vector<std::string>{"copied", "first"});
+    auto copied = std::find_if(listed.begin(), listed.end(), [](const auto& s) { return s.id == "copied"; });
+    REQUIRE(copied->preview == "Session first");
+    REQUIRE(copied->message_count == 1);
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/shell_session.hpp"
+#include "temp_dir.hpp"
+
+#include <chrono>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+TEST_CASE("Shell session reports exit codes and output", "[shell_session]") {
+    ShellSession shell("", {{"GPAGENT_TEST_VAR", "from env"}});
+    if (!shell.start()) return;  // no PTY
+
+    auto ok = shell.run("echo hello", 5000);
+    REQUIRE(ok.exit_code == 0);
+    REQUIRE(ok.output == "hello\n");
+    REQUIRE_FALSE(ok.timed_out);
+    REQUIRE_FALSE(ok.session_lost);
+
+    REQUIRE(shell.run("false", 5000).exit_code == 1);
+    REQUIRE(shell.run("(exit 42)", 5000).exit_code == 42);
+    REQUIRE(shell.run("true", 5000).output.empty());
+
+    // Output is kept as printed, with or without a final newline
+    REQUIRE(shell.run("printf abc", 5000).output == "abc");
+    REQUIRE(shell.run("echo err >&2", 5000).output == "err\n");
+    REQUIRE(shell.run("printf 'one\\ntwo\\n'", 5000).output == "one\ntwo\n");
+
+    // Multi-line scripts with quotes run as written
+    auto script = shell.run("for i in 1 2; do\n  echo \"it's $i\"\ndone", 5000);
+    REQUIRE(script.output == "it's 1\nit's 2\n");
+
+    REQUIRE(shell.run("echo $GPAGENT_TEST_VAR", 5000).output == "from env\n");
+}
+
+TEST_CASE("Shell session is not fooled by marker-like output", "[shell_session]") {
+    ShellSession shell("", {});
+    if (!shell.start()) return;
+
+    // Without the session's nonce these are plain output
+    auto fake = shell.run("echo __GPAGENT_0123456789abcdef_1_0__; echo after", 5000);
+    REQUIRE(fake.exit_code == 0);
+    REQUIRE(fake.output == "__GPAGENT_0123456789abcdef_1_0__\nafter\n");
+
+    auto prefix = shell.run("printf __GPAGENT_; (exit 3)", 5000);
+    REQUIRE(prefix.exit_code == 3);
+    REQUIRE(prefix.output == "__GPAGENT_");
+}
+
+TEST_CASE("Shell session keeps state between commands", "[shell_session]") {
+    TempDir dir("shell");
+    fs::create_directories(dir.path / "sub");
+    ShellSession shell(dir.path.string(), {});
+    if (!shell.start()) return;
+
+    REQUIRE(shell.run("pwd", 5000).output == dir.path.string() + "\n");
+    REQUIRE(shell.run("cd sub", 5000).exit_code == 0);
+    REQUIRE(shell.run("pwd", 5000).output == (dir.path / "sub").string() + "\n");
+
+    shell.run("export GPAGENT_KEPT=yes; counter() { echo called; }", 5000);
+    REQUIRE(shell.run("echo $GPAGENT_KEPT", 5000).output == "yes\n");
+    REQUIRE(shell.run("counter", 5000).output == "called\n");
+}
+
+TEST_CASE("Shell session presents a non-interactive terminal", "[shell_session]") {
+    ShellSession shell("", {});
+    if (!shell.start()) return;
+
+    REQUIRE(shell.run("echo $TERM $PAGER $GIT_PAGER $NO_COLOR", 5000).output == "dumb cat cat 1\n");
+
+    // stdin is /dev/null, so prompts see end of input instead of waiting
+    auto read = shell.run("read answer; echo $?", 5000);
+    REQUIRE_FALSE(read.timed_out);
+    REQUIRE(read.output == "1\n");
+}
+
+TEST_CASE("Shell session interrupts commands that time out", "[shell_session]") {
+    ShellSession shell("", {});
+    if (!shell.start()) return;
+
+    auto start = std::chrono::steady_clock::now();
+    auto slow = shell.run("echo started; sleep 30", 300);
+    REQUIRE(slow.timed_out);
+    REQUIRE(slow.exit_code == 130);
+    REQUIRE_FALSE(slow.session_lost);
+    REQUIRE(slow.output.find("started") != std::string::npos);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+
+    // The shell survives and the interrupted command's marker is not reused
+    REQUIRE(shell.alive());
+    auto next = shell.run("echo next", 5000);
+    REQUIRE(next.exit_code == 0);
+    REQUIRE(next.output == "next\n");
+}
+
+TEST_CASE("Shell session restarts after the shell exits", "[shell_session]") {
+    ShellSession shell("", {});
+    if (!shell.start()) return;
+
+    shell.run("export GPAGENT_GONE=1", 5000);
+    auto exited = shell.run("exit 7", 5000);
+    REQUIRE(exited.session_lost);
+    REQUIRE(exited.exit_code == 7);
+    REQUIRE_FALSE(shell.alive());
+
+    // The next call starts a fresh shell
+    auto fresh = shell.run("echo \"[$GPAGENT_GONE]\"", 5000);
+    REQUIRE_FALSE(fresh.session_lost);
+    REQUIRE(fresh.output == "[]\n");
+}
+
+TEST_CASE("Shell session streams output", "[shell_session]") {
+    ShellSession shell("", {});
+    if (!shell.start()) return;
+
+    std::string streamed;
+    auto run = shell.run("echo one; echo two", 5000,
+                         [&](std::string_view chunk) { streamed.append(chunk); });
+    REQUIRE(run.output == "one\ntwo\n");
+    REQUIRE(streamed.find("one\ntwo") != std::string::npos);
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/memory/transcript.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+
+using namespace gpagent::memory;
+using gpagent::test::TempDir;
+
+TEST_CASE("Transcript round trip decodes records on request", "[transcript]") {
+    TempDir dir("transcript");
+    fs::path path = dir.path / "thread.bin";
+
+    ThreadMemory thread;
+    thread.append(Message::system("You are helpful"));
+    thread.append(Message::user("List the files"));
+    Message call = Message::assistant("");
+    call.tool_calls.push_back(ToolCall{"call_1", "list_directory", Json{{"path", "."}}});
+    call.tool_calls.push_back(ToolCall{"call_2", "list_directory", Json{{"path", "src"}}});
+    thread.append(call);
+    Message result = Message::tool_result("call_1", std::string("a\0b", 3));
+    result.name = "list_directory";
+    thread.append(result);
+
+    auto written = Transcript::write(path, thread);
+    REQUIRE(written.is_ok());
+
+    auto opened = Transcript::open(path);
+    REQUIRE(opened.is_ok());
+    const auto& transcript = opened.value();
+    REQUIRE(transcript.size() == 4);
+    REQUIRE(transcript.id() == written.value());
+
+    // Any record decodes on its own
+    auto tool = transcript.message(3).value();
+    REQUIRE(tool.role == Role::Tool);
+    REQUIRE(tool.content == std::string("a\0b", 3));
+    REQUIRE(tool.name == std::optional<std::string>("list_directory"));
+    REQUIRE(tool.tool_call_id == std::optional<std::string>("call_1"));
+    REQUIRE(tool.timestamp == result.timestamp);
+
+    auto assistant = transcript.message(2).value();
+    REQUIRE(assistant.tool_calls.size() == 2);
+    REQUIRE(assistant.tool_calls[1].id == "call_2");
+    REQUIRE(assistant.tool_calls[1].arguments["path"] == "src");
+    REQUIRE_FALSE(assistant.name);
+
+    REQUIRE(transcript.message(4).is_err());
+
+    auto all = transcript.read_all();
+    REQUIRE(all.is_ok());
+    REQUIRE(all.value().size() == 4);
+    REQUIRE(all.value().messages()[1].content == "List the files");
+}
+
+TEST_CASE("Transcript rejects truncated and foreign files", "[transcript]") {
+    TempDir dir("transcript");
+    fs::path path = dir.path / "thread.bin";
+
+    ThreadMemory thread;
+    thread.append(Message::user("hello"));
+    REQUIRE(Transcript::write(path, thread).is_ok());
+
+    fs::resize_file(path, fs::file_size(path) - 1);
+    REQUIRE(Transcript::open(path).is_err());
+
+    std::ofstream(path, std::ios::trunc) << "{\"role\":\"user\"}\n";
+    REQUIRE(Transcript::open(path).is_err());
+    REQUIRE(Transcript::open(dir.path / "missing.bin").is_err());
+}
+
+TEST_CASE("Transcript metadata tracks preview, times and tokens", "[transcript]") {
+    TempDir dir("transcript");
+
+    ThreadMemory thread;
+    thread.append(Message::system("system prompt"));
+    thread.append(Message::user(std::string(80, 'x')));
+    thread.append(Message::user("second"));
+
+    TranscriptMeta meta = TranscriptMeta::of(thread);
+    REQUIRE(meta.message_count == 3);
+    REQUIRE(meta.preview == std::string(50, 'x') + "...");
+    REQUIRE(meta.tokens > 0);
+
+    TranscriptMeta incremental;
+    for (const auto& msg : thread.messages()) incremental.add(msg);
+    REQUIRE(incremental.tokens == meta.tokens);
+
+    REQUIRE(meta.save(dir.path / TranscriptMeta::kFile).is_ok());
+    auto loaded = TranscriptMeta::load(dir.path / TranscriptMeta::kFile);
+    REQUIRE(loaded.is_ok());
+    REQUIRE(loaded.value().preview == meta.preview);
+    REQUIRE(loaded.value().message_count == 3);
+    REQUIRE(loaded.value().tokens == meta.tokens);
+}
+
+TEST_CASE("Transcript metadata previews keep UTF-8 intact", "[transcript]") {
+    TempDir dir("transcript");
+
+    std::string ni = "\xE4\xBD\xA0";  // U+4F60, three bytes
+    std::string text;
+    for (int i = 0; i < 30; ++i) text += ni;
+
+    ThreadMemory thread;
+    thread.append(Message::user(text));
+    TranscriptMeta meta = TranscriptMeta::of(thread);
+
+    // 50 bytes would end inside the 17th character
+    std::string expected;
+    for (int i = 0; i < 16; ++i) expected += ni;
+    REQUIRE(meta.preview == expected + "...");
+
+    REQUIRE(meta.save(dir.path / TranscriptMeta::kFile).is_ok());
+    auto loaded = TranscriptMeta::load(dir.path / TranscriptMeta::kFile);
+    REQUIRE(loaded.is_ok());
+    REQUIRE(loaded.value().preview == meta.preview);
+
+    // Content that is not valid UTF-8 to begin with is still saved
+    TranscriptMeta broken;
+    broken.add(Message::user("bad \xFF byte"));
+    REQUIRE(broken.save(dir.path / TranscriptMeta::kFile).is_ok());
+    REQUIRE(TranscriptMeta::load(dir.path / TranscriptMeta::kFile).is_ok());
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/trigram_index.hpp"
+#include "temp_dir.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace {
+
+void write_file(const fs::path& path, const std::string& content) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+}
+
+std::vector<std::string> sorted(std::vector<std::string> v) {
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+}  // namespace
+
+TEST_CASE("Trigram index narrows and tracks changes", "[trigram]") {
+    TempDir base("trigram");
+    fs::path root = base.path / "project";
+    fs::path index_file = base.path / "index" / "trigram.idx";
+
+    write_file(root / "a.cpp", "int parse_config();\n");
+    write_file(root / "src" / "b.cpp", "void parse_args();\nparse_config();\n");
+    write_file(root / "src" / "c.cpp", "nothing here\n");
+    write_file(root / "bin.dat", std::string("parse_config\0", 13));
+
+    {
+        TrigramIndex index(root, index_file);
+        REQUIRE(index.refresh());
+        REQUIRE(index.file_count() == 4);
+
+        REQUIRE(sorted(*index.candidates("parse_config")) == std::vector<std::string>{"a.cpp", "src/b.cpp"});
+        REQUIRE(*index.candidates("parse_config", "src/") == std::vector<std::string>{"src/b.cpp"});
+        REQUIRE(index.candidates("missing_symbol")->empty());
+        REQUIRE_FALSE(index.candidates("pa").has_value());
+        REQUIRE_FALSE(index.candidates("parse", "vendor/").has_value());
+
+        // Trigrams never span lines
+        REQUIRE(index.candidates(");p")->empty());
+
+        // Modified, added and deleted files are picked up on refresh
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        write_file(root / "src" / "c.cpp", "parse_config again\n");
+        fs::remove(root / "a.cpp");
+        REQUIRE(index.refresh());
+        REQUIRE(sorted(*index.candidates("parse_config")) == std::vector<std::string>{"src/b.cpp", "src/c.cpp"});
+        REQUIRE(index.save());
+    }
+
+    // Reload from disk
+    TrigramIndex reloaded(root, index_file);
+    REQUIRE(reloaded.file_count() == 3);
+    REQUIRE(sorted(*reloaded.candidates("parse_config")) == std::vector<std::string>{"src/b.cpp", "src/c.cpp"});
+}
+
+TEST_CASE("Trigram index picks up new files and directories between refreshes", "[trigram]") {
+    TempDir base("trigram");
+    fs::path root = base.path / "project";
+    write_file(root / "a.cpp", "alpha_symbol\n");
+
+    TrigramIndex index(root, base.path / "index" / "trigram.idx");
+    REQUIRE(index.refresh());
+    REQUIRE(index.refresh());  // nothing changed
+    REQUIRE(index.file_count() == 1);
+
+    write_file(root / "b.cpp", "alpha_symbol beta\n");
+    write_file(root / "lib" / "deep" / "c.cpp", "alpha_symbol gamma\n");
+    write_file(root / ".gitignore", "*.log\n");
+    write_file(root / "x.log", "alpha_symbol\n");
+    REQUIRE(index.refresh());
+    REQUIRE(sorted(*index.candidates("alpha_symbol")) ==
+            std::vector<std::string>{"a.cpp", "b.cpp", "lib/deep/c.cpp"});
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    write_file(root / "lib" / "deep" / "c.cpp", "renamed\n");
+    REQUIRE(index.refresh());
+    REQUIRE(sorted(*index.candidates("alpha_symbol")) == std::vector<std::string>{"a.cpp", "b.cpp"});
+}
@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include "gpagent/tools/tool_spec.hpp"
+#include "gpagent/core/config.hpp"
+#include "temp_dir.hpp"
+
+#include <httplib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+using namespace gpagent::tools;
+using gpagent::test::TempDir;
+
+namespace gpagent::tools::builtin {
+ToolResult web_fetch_handler(const Json& args, const ToolContext& ctx);
+ToolResult web_fetch_batch_handler(const Json& args, const ToolContext& ctx);
+std::vector<size_t> share_budget(const std::vector<size_t>& lengths, size_t budget);
+}
+
+TEST_CASE("web_fetch revalidates stale cache entries through redirects", "[web_fetch]") {
+    std::atomic<int> downloads{0};
+    std::atomic<int> revalidations{0};
+
+    // Always stale, so every fetch after the first sends If-None-Match
+    httplib::Server server;
+    server.Get("/page", [&](const httplib::Request& req, httplib::Response& res) {
+        res.set_header("ETag", "\"v1\"");
+        res.set_header("Cache-Control", "no-cache");
+        if (req.get_header_value("If-None-Match") == "\"v1\"") {
+            ++revalidations;
+            res.status = 304;
+            return;
+        }
+        ++downloads;
+        res.set_content("<html><body><p>cached page</p></body></html>", "text/html");
+    });
+    server.Get("/moved", [](const httplib::Request&, httplib::Response& res) {
+        res.set_redirect("/page");
+    });
+    int port = server.bind_to_any_port("127.0.0.1");
+    REQUIRE(port > 0);
+    std::thread listener([&] { server.listen_after_bind(); });
+    server.wait_until_ready();
+
+    gpagent::core::Config config;
+    TempDir storage("web_fetch");
+    config.memory.storage_path = storage.path;
+    config.tools.http_cache = true;
+    ToolContext ctx;
+    ctx.config = &config;
+
+    std::string base = "http://127.0.0.1:" + std::to_string(port);
+    for (const char* path : {"/page", "/page", "/moved"}) {
+        ToolResult result = builtin::web_fetch_handler(Json{{"url", base + path}}, ctx);
+        INFO(path << ": " << result.error_message);
+        REQUIRE(result.success);
+        REQUIRE(result.content.find("cached page") != std::string::npos);
+    }
+
+    // The second fetch is answered with 304; the redirected one is cached
+    // under its own URL and downloaded once
+    REQUIRE(revalidations == 1);
+    REQUIRE(downloads == 2);
+
+    REQUIRE(builtin::web_fetch_handler(Json{{"url", base + "/moved"}}, ctx).success);
+    REQUIRE(revalidations == 2);
+    REQUIRE(downloads == 2);
+
+    server.stop();
+    listener.join();
+}
+
+TEST_CASE("Batch fetches share the length budget", "[web_fetch]") {
+    using builtin::share_budget;
+    using Shares = std::vector<size_t>;
+
+    // Everything fits: nothing is cut
+    REQUIRE(share_budget({10, 20}, 100) == Shares{10, 20});
+    REQUIRE(share_budget({}, 100).empty());
+
+    // Short pages keep all their text; what they leave is split evenly
+    REQUIRE(share_budget({20000, 100, 5000}, 9000) == Shares{4450, 100, 4450});
+    REQUIRE(share_budget({5000, 5000, 5000}, 9000) == Shares{3000, 3000, 3000});
+    REQUIRE(share_budget({9, 7, 8}, 10) == Shares{4, 3, 3});
+    REQUIRE(share_budget({50, 60}, 0) == Shares{0, 0});
+
+    Shares lengths{300, 12, 90000, 4500, 0, 800};
+    Shares shares = share_budget(lengths, 10000);
+    REQUIRE(std::accumulate(shares.begin(), shares.end(), size_t{0}) <= 10000);
+    for (size_t i = 0; i < lengths.size(); ++i) REQUIRE(shares[i] <= lengths[i]);
+}
+
+TEST_CASE("Batch fetches reject entries that are not URLs", "[web_fetch]") {
+    ToolContext ctx;
+
+    // Nothing is fetched when any entry is invalid
+    ToolResult mixed = builtin::web_fetch_batch_handler(
+        Json{{"urls", Json::array({"http://127.0.0.1:1/", 42, "ftp://example.com/", nullptr})}}, ctx);
+    REQUIRE_FALSE(mixed.success);
+    REQUIRE(mixed.error_message.find("urls[1] = 42") != std::string::npos);
+    REQUIRE(mixed.error_message.find("urls[2] = \"ftp://example.com/\"") != std::string::npos);
+    REQUIRE(mixed.error_message.find("urls[3] = null") != std::string::npos);
+    REQUIRE(mixed.error_message.find("urls[0]") == std::string::npos);
+
+    ToolResult none = builtin::web_fetch_batch_handler(Json{{"urls", Json::array({"not a url"})}}, ctx);
+    REQUIRE_FALSE(none.success);
+    REQUIRE(none.content.find("Fetched") == std::string::npos);
+
+    REQUIRE_FALSE(builtin::web_fetch_batch_handler(Json{{"urls", Json::array()}}, ctx).success);
+    REQUIRE_FALSE(builtin::web_fetch_batch_handler(Json{{"urls", "http://127.0.0.1/"}}, ctx).success);
+}
+
+TEST_CASE("Batch fetches limit downloads per host", "[web_fetch]") {
+    // Slow pages, so the fetches of a batch overlap; counted by Host header
+    std::mutex mutex;
+    std::map<std::string, int> active;
+    std::map<std::string, int> peak;
+    int active_total = 0;
+    int peak_total = 0;
+
+    httplib::Server server;
+    server.Get("/page", [&](const httplib::Request& req, httplib::Response& res) {
+        std::string host = req.get_header_value("Host");
+        {
+            std::lock_guard lock(mutex);
+            peak[host] = std::max(peak[host], ++active[host]);
+            peak_total = std::max(peak_total, ++active_total);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        {
+            std::lock_guard lock(mutex);
+            --active[host];
+            --active_total;
+        }
+        res.set_content("<html><body><p>page " + req.get_param_value("n") + "</p></body></html>", "text/html");
+    });
+    int port = server.bind_to_any_port("127.0.0.1");
+    REQUIRE(port > 0);
+    std::thread listener([&] { server.listen_after_bind(); });
+    server.wait_until_ready();
+
+    // Two host names for the one server, four pages each
+    Json urls = Json::array();
+    for (const char* host : {"127.0.0.1", "localhost"}) {
+        for (int n = 0; n < 4; ++n) {
+            urls.push_back("http://" + std::string(host) + ":" + std::to_string(port) + "/page?n=" +
+                           std::to_string(n));
+        }
+    }
+    ToolContext ctx;
+    ToolResult result = builtin::web_fetch_batch_handler(Json{{"urls", urls}}, ctx);
+    server.stop();
+    listener.join();
+
+    INFO(result.content << result.error_message);
+    REQUIRE(result.success);
+    REQUIRE(result.content.rfind("Fetched 8 of 8 pages.\n", 0) == 0);
+    REQUIRE(result.content.find("page 3") != std::string::npos);
+
+    // Each host stays at its limit while the other host's pages download
+    REQUIRE(peak.size() == 2);
+    for (const auto& [host, count] : peak) {
+        INFO(host);
+        REQUIRE(count == 2);
+    }
+    REQUIRE(peak_total > 2);
+}